@@ -48,6 +48,9 @@ static const char *TAG = "can";
 #include "ovms_config.h"
 #include "ovms_command.h"
 #include "metrics_standard.h"
+#include "ovms_events.h"
+#include "ovms_utils.h"
+#include "esp_timer.h"
 
 can MyCan __attribute__ ((init_priority (4510)));
 
@@ -190,6 +193,7 @@ void can_tx(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const
 
   CAN_frame_t frame = {};
   frame.origin = sbus;
+  frame.timestamp = esp_timer_get_time();
   frame.FIR.U = 0;
   frame.FIR.B.DLC = argc-1;
   frame.FIR.B.FF = smode;
@@ -267,6 +271,12 @@ void can_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, c
     writer->printf("Wdg Timer: %20d sec(s)\n",monotonictime-sbus->m_watchdog_timer);
     }
   writer->printf("Err flags: 0x%08x\n",sbus->m_status.error_flags);
+  if (MyCan.m_dispatch_delivered[sbus->m_busnumber] || MyCan.m_dispatch_skipped[sbus->m_busnumber])
+    {
+    writer->printf("ID dlvrd:  %20d\n",MyCan.m_dispatch_delivered[sbus->m_busnumber]);
+    writer->printf("ID skipd:  %20d\n",MyCan.m_dispatch_skipped[sbus->m_busnumber]);
+    }
+  sbus->ShowStatus(writer);
   }
 
 void can_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
@@ -298,6 +308,8 @@ void can_clearstatus(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int ar
     }
 
   sbus->ClearStatus();
+  MyCan.m_dispatch_delivered[sbus->m_busnumber] = 0;
+  MyCan.m_dispatch_skipped[sbus->m_busnumber] = 0;
   writer->puts("Status cleared");
   }
 
@@ -470,6 +482,140 @@ std::string canfilter::Info()
   return buf.str();
   }
 
+////////////////////////////////////////////////////////////////////////
+// CAN ID dispatch index
+// The canidset object holds the (bus, frame format, ID range) subscriptions
+// of a CAN listener or callback
+////////////////////////////////////////////////////////////////////////
+
+canidset::canidset()
+  {
+  Clear();
+  }
+
+canidset::~canidset()
+  {
+  }
+
+void canidset::Clear()
+  {
+  OvmsMutexLock lock(&m_mutex);
+  memset(m_std, 0, sizeof(m_std));
+  for (int k=0; k<CAN_MAXBUSES; k++)
+    {
+    m_ranges[k][CAN_frame_std].clear();
+    m_ranges[k][CAN_frame_ext].clear();
+    }
+  m_empty = true;
+  }
+
+void canidset::Add(uint8_t bus, CAN_frame_format_t format, uint32_t id)
+  {
+  Add(bus, format, id, id);
+  }
+
+void canidset::Add(uint8_t bus, CAN_frame_format_t format, uint32_t id_from, uint32_t id_to)
+  {
+  if (format == CAN_frame_std && id_to > 0x7ff) id_to = 0x7ff;
+  if (id_to < id_from) return;
+  if (bus == 0)
+    {
+    for (int k=0; k<CAN_MAXBUSES; k++)
+      AddRange(k, format, id_from, id_to);
+    }
+  else if (bus <= CAN_MAXBUSES)
+    {
+    AddRange(bus-1, format, id_from, id_to);
+    }
+  }
+
+void canidset::AddRange(int busnumber, CAN_frame_format_t format, uint32_t id_from, uint32_t id_to)
+  {
+  OvmsMutexLock lock(&m_mutex);
+  CAN_idrange_list_t& ranges = m_ranges[busnumber][format];
+
+  // Already covered? (polling adds the same ranges repeatedly)
+  auto it = std::upper_bound(ranges.begin(), ranges.end(), id_from,
+    [](uint32_t id, const CAN_idrange_t& r) { return id < r.id_from; });
+  if (it != ranges.begin() && (it-1)->id_to >= id_to)
+    return;
+
+  // Standard ID bitmap:
+  if (format == CAN_frame_std)
+    {
+    for (uint32_t id = id_from; id <= id_to; id++)
+      m_std[busnumber][id >> 3] |= (1 << (id & 7));
+    }
+
+  // Insert & merge overlapping / adjacent ranges:
+  ranges.insert(it, { id_from, id_to });
+  std::sort(ranges.begin(), ranges.end(),
+    [](const CAN_idrange_t& a, const CAN_idrange_t& b) { return a.id_from < b.id_from; });
+  size_t n = 0;
+  for (size_t k=1; k<ranges.size(); k++)
+    {
+    if (ranges[k].id_from <= ranges[n].id_to || ranges[k].id_from - 1 == ranges[n].id_to)
+      {
+      if (ranges[k].id_to > ranges[n].id_to) ranges[n].id_to = ranges[k].id_to;
+      }
+    else
+      {
+      ranges[++n] = ranges[k];
+      }
+    }
+  ranges.resize(n+1);
+
+  m_empty = false;
+  }
+
+bool canidset::Contains(int busnumber, CAN_frame_format_t format, uint32_t id)
+  {
+  if (busnumber < 0 || busnumber >= CAN_MAXBUSES) return false;
+
+  if (format == CAN_frame_std)
+    return (id <= 0x7ff) && (m_std[busnumber][id >> 3] & (1 << (id & 7))) != 0;
+
+  OvmsMutexLock lock(&m_mutex);
+  CAN_idrange_list_t& ranges = m_ranges[busnumber][CAN_frame_ext];
+  auto it = std::upper_bound(ranges.begin(), ranges.end(), id,
+    [](uint32_t id, const CAN_idrange_t& r) { return id < r.id_from; });
+  return (it != ranges.begin() && (it-1)->id_to >= id);
+  }
+
+bool canidset::Contains(const CAN_frame_t* p_frame)
+  {
+  if (!p_frame->origin) return false;
+  return Contains(p_frame->origin->m_busnumber, p_frame->FIR.B.FF, p_frame->MsgID);
+  }
+
+/**
+ * Info: list subscriptions as <bus>:<id>[-<id>], standard IDs with 3,
+ *  extended IDs with 8 hex digits (as in the CRTD log format)
+ */
+std::string canidset::Info()
+  {
+  std::ostringstream buf;
+  OvmsMutexLock lock(&m_mutex);
+
+  for (int k=0; k<CAN_MAXBUSES; k++)
+    {
+    for (int format : { CAN_frame_std, CAN_frame_ext })
+      {
+      int width = (format == CAN_frame_std) ? 3 : 8;
+      for (CAN_idrange_t& r : m_ranges[k][format])
+        {
+        buf << std::setfill(' ') << std::dec << k+1 << ':';
+        buf << std::setfill('0') << std::hex << std::setw(width) << r.id_from;
+        if (r.id_from != r.id_to)
+          buf << '-' << std::setw(width) << r.id_to;
+        buf << ' ';
+        }
+      }
+    }
+
+  return buf.str();
+  }
+
 ////////////////////////////////////////////////////////////////////////
 // CAN logging and tracing
 // These structures are involved in formatting, logging and tracing of
@@ -495,32 +641,69 @@ const char* GetCanLogTypeName(CAN_log_type_t type)
 
 void can::LogFrame(canbus* bus, CAN_log_type_t type, const CAN_frame_t* frame)
   {
-  OvmsMutexLock lock(&m_loggermap_mutex);
+  canlogring* ring = m_logring;
+  if (!ring || !ring->HasReaders() || !bus || !frame) return;
 
-  for (canlog_map_t::iterator it=m_loggermap.begin(); it!=m_loggermap.end(); ++it)
+  CAN_log_message_t msg;
+  msg.type = type;
+  gettimeofday(&msg.timestamp,NULL);
+  if (type == CAN_LogFrame_RX && frame->timestamp)
     {
-    it->second->LogFrame(bus, type, frame);
+    // Log the capture time instead of the time of processing:
+    int64_t age = esp_timer_get_time() - frame->timestamp;
+    if (age > 0)
+      {
+      int64_t usec = (int64_t)msg.timestamp.tv_sec * 1000000 + msg.timestamp.tv_usec - age;
+      msg.timestamp.tv_sec = usec / 1000000;
+      msg.timestamp.tv_usec = usec % 1000000;
+      }
     }
+  msg.frame = *frame;
+  msg.frame.origin = bus;
+  ring->Push(msg);
   }
 
 void can::LogStatus(canbus* bus, CAN_log_type_t type, const CAN_status_t* status)
   {
-  OvmsMutexLock lock(&m_loggermap_mutex);
+  canlogring* ring = m_logring;
+  if (!ring || !ring->HasReaders() || !bus) return;
 
-  for (canlog_map_t::iterator it=m_loggermap.begin(); it!=m_loggermap.end(); ++it)
-    {
-    it->second->LogStatus(bus, type, status);
-    }
+  CAN_log_message_t msg;
+  msg.type = type;
+  gettimeofday(&msg.timestamp,NULL);
+  msg.origin = bus;
+  msg.status = *status;
+  ring->Push(msg);
   }
 
 void can::LogInfo(canbus* bus, CAN_log_type_t type, const char* text)
   {
-  OvmsMutexLock lock(&m_loggermap_mutex);
+  canlogring* ring = m_logring;
+  if (!ring || !ring->HasReaders() || !text) return;
+
+  CAN_log_message_t msg;
+  msg.type = type;
+  gettimeofday(&msg.timestamp,NULL);
+  msg.origin = bus;
+  msg.text = strdup(text);
+  ring->Push(msg);
+  }
 
-  for (canlog_map_t::iterator it=m_loggermap.begin(); it!=m_loggermap.end(); ++it)
+canlogring* can::GetLogRing()
+  {
+  if (m_logring == NULL)
     {
-    it->second->LogInfo(bus, type, text);
+    OvmsMutexLock lock(&m_loggermap_mutex);
+    if (m_logring == NULL)
+      m_logring = new canlogring(MyConfig.GetParamValueInt("can", "log.queuesize", 512));
     }
+  return m_logring;
+  }
+
+void can::LogEventListener(std::string event, void* data)
+  {
+  if (startsWith(event, "vehicle"))
+    LogInfo(NULL, CAN_LogInfo_Event, event.c_str());
   }
 
 void canbus::LogFrame(CAN_log_type_t type, const CAN_frame_t* frame)
@@ -580,6 +763,12 @@ uint32_t can::AddLogger(canlog* logger, int filterc, const char* const* filterv)
 
   OvmsMutexLock lock(&m_loggermap_mutex);
   uint32_t id = m_logger_id++;
+  if (m_loggermap.empty())
+    {
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    MyEvents.RegisterEvent("canlog", "*", std::bind(&can::LogEventListener, this, _1, _2));
+    }
   m_loggermap[id] = logger;
 
   return id;
@@ -612,6 +801,8 @@ bool can::RemoveLogger(uint32_t id)
     vTaskDelay(pdMS_TO_TICKS(100)); // give logger task time to finish
     delete k->second;
     m_loggermap.erase(k);
+    if (m_loggermap.empty())
+      MyEvents.DeregisterEvent("canlog");
     return true;
     }
   return false;
@@ -628,6 +819,7 @@ void can::RemoveLoggers()
     delete it->second;
     it = m_loggermap.erase(it);
     }
+  MyEvents.DeregisterEvent("canlog");
   }
 
 uint32_t can::AddPlayer(canplay* player, int filterc, const char* const* filterv)
@@ -645,6 +837,7 @@ uint32_t can::AddPlayer(canplay* player, int filterc, const char* const* filterv
   OvmsMutexLock lock(&m_playermap_mutex);
   uint32_t id = m_player_id++;
   m_playermap[id] = player;
+  player->Start();
 
   return id;
   }
@@ -674,9 +867,7 @@ bool can::RemovePlayer(uint32_t id)
   auto k = m_playermap.find(id);
   if (k != m_playermap.end())
     {
-    k->second->Close();
-    vTaskDelay(pdMS_TO_TICKS(100)); // give logger task time to finish
-    delete k->second;
+    delete k->second;  // stops the player task
     m_playermap.erase(k);
     return true;
     }
@@ -689,9 +880,7 @@ void can::RemovePlayers()
 
   for (canplay_map_t::iterator it=m_playermap.begin(); it!=m_playermap.end();)
     {
-    it->second->Close();
-    vTaskDelay(pdMS_TO_TICKS(100)); // give logger task time to finish
-    delete it->second;
+    delete it->second;  // stops the player task
     it = m_playermap.erase(it);
     }
   }
@@ -712,17 +901,25 @@ static void CAN_rxtask(void *pvParameters)
       switch(msg.type)
         {
         case CAN_frame:
+          msg.body.frame.timestamp = msg.timestamp;
           me->IncomingFrame(&msg.body.frame);
           break;
         case CAN_asyncinterrupthandler:
           {
           bool loop;
-          // Loop until all interrupts are handled
+          // Loop until all interrupts are handled; frames read in the first
+          // iteration have been captured before the interrupt, later frames
+          // before the interrupt line check of the previous iteration.
+          // The handler gets the capture time in the frame passed, and
+          // keeps the earlier one for frames read in a previous iteration:
+          int64_t captured = msg.timestamp;
           do {
             bool receivedFrame;
+            msg.body.frame.timestamp = captured;
             loop = msg.body.bus->AsynchronousInterruptHandler(&msg.body.frame, &receivedFrame);
             if (receivedFrame)
               me->IncomingFrame(&msg.body.frame);
+            captured = esp_timer_get_time();
             } while (loop);
           break;
           }
@@ -752,13 +949,19 @@ can::can()
   ESP_LOGI(TAG, "Initialising CAN (4510)");
 
   m_logger_id = 1;
+  m_logring = NULL;
   m_player_id = 1;
 
   MyConfig.RegisterParam("can", "CAN Configuration", true, true);
 
   OvmsCommand* cmd_can = MyCommandApp.RegisterCommand("can","CAN framework");
 
-  for (int k=0;k<CAN_MAXBUSES;k++) m_buslist[k] = NULL;
+  for (int k=0;k<CAN_MAXBUSES;k++)
+    {
+    m_buslist[k] = NULL;
+    m_dispatch_delivered[k] = 0;
+    m_dispatch_skipped[k] = 0;
+    }
 
   for (int k=1;k<5;k++)
     {
@@ -817,38 +1020,54 @@ void can::IncomingFrame(CAN_frame_t* p_frame)
   p_frame->origin->m_status.packets_rx++;
   p_frame->origin->m_watchdog_timer = monotonictime;
 
-  ExecuteCallbacks(p_frame, false, true /*ignored*/);
+  CAN_dispatch_t dispatch = { 0, 0 };
+  ExecuteCallbacks(p_frame, false, true /*ignored*/, &dispatch);
   p_frame->origin->LogFrame(CAN_LogFrame_RX, p_frame);
-  NotifyListeners(p_frame, false);
+  NotifyListeners(p_frame, false, &dispatch);
+
+  // Count per frame: delivered to any / skipped by all ID subscribers
+  if (dispatch.subscribers > 0)
+    {
+    if (dispatch.delivered > 0)
+      m_dispatch_delivered[p_frame->origin->m_busnumber]++;
+    else
+      m_dispatch_skipped[p_frame->origin->m_busnumber]++;
+    }
   }
 
-void can::RegisterListener(QueueHandle_t queue, bool txfeedback)
+void can::RegisterListener(QueueHandle_t queue, bool txfeedback, canidset* ids)
   {
-  m_listeners[queue] = txfeedback;
+  OvmsMutexLock lock(&m_listeners_mutex);
+  m_listeners[queue] = { txfeedback, ids };
   }
 
 void can::DeregisterListener(QueueHandle_t queue)
   {
+  OvmsMutexLock lock(&m_listeners_mutex);
   auto it = m_listeners.find(queue);
   if (it != m_listeners.end())
     m_listeners.erase(it);
   }
 
-void can::NotifyListeners(const CAN_frame_t* frame, bool tx)
+void can::NotifyListeners(const CAN_frame_t* frame, bool tx, CAN_dispatch_t* dispatch)
   {
+  OvmsMutexLock lock(&m_listeners_mutex);
   for (CanListenerMap_t::iterator it = m_listeners.begin(); it != m_listeners.end(); ++it)
     {
-    if (!tx || (tx && it->second))
-      xQueueSend(it->first,frame,0);
+    if (tx && !it->second.txfeedback)
+      continue;
+    if (!tx && it->second.ids && !Dispatch(it->second.ids, frame, dispatch))
+      continue;
+    xQueueSend(it->first,frame,0);
     }
   }
 
-void can::RegisterCallback(const char* caller, CanFrameCallback callback, bool txfeedback)
+void can::RegisterCallback(const char* caller, CanFrameCallback callback, bool txfeedback, canidset* ids)
   {
   if (txfeedback)
-    m_txcallbacks.push_back(new CanFrameCallbackEntry(caller, callback));
+    m_txcallbacks.push_back(new CanFrameCallbackEntry(caller, callback, ids));
   else
-    m_rxcallbacks.push_back(new CanFrameCallbackEntry(caller, callback));
+    m_rxcallbacks.push_back(new CanFrameCallbackEntry(caller, callback, ids));
   }
 
 void can::DeregisterCallback(const char* caller)
@@ -857,7 +1076,7 @@ void can::DeregisterCallback(const char* caller)
   m_txcallbacks.remove_if([caller](CanFrameCallbackEntry* entry){ return strcmp(entry->m_caller, caller)==0; });
   }
 
-void can::ExecuteCallbacks(const CAN_frame_t* frame, bool tx, bool success)
+void can::ExecuteCallbacks(const CAN_frame_t* frame, bool tx, bool success, CAN_dispatch_t* dispatch)
   {
   if (tx)
     {
@@ -872,8 +1091,30 @@ void can::ExecuteCallbacks(const CAN_frame_t* frame, bool tx, bool success)
   else
     {
     for (auto entry : m_rxcallbacks)
+      {
+      if (entry->m_ids && !Dispatch(entry->m_ids, frame, dispatch))
+        continue;
       entry->m_callback(frame, success);
+      }
+    }
+  }
+
+/**
+ * Dispatch: check frame against the ID subscriptions of a listener/callback
+ *  An empty set subscribes to all frames and is not counted. The per frame
+ *  result is accumulated in dispatch (if given) and counted by IncomingFrame().
+ */
+bool can::Dispatch(canidset* ids, const CAN_frame_t* frame, CAN_dispatch_t* dispatch)
+  {
+  if (ids->IsEmpty())
+    return true;
+  bool match = ids->Contains(frame);
+  if (dispatch)
+    {
+    dispatch->subscribers++;
+    if (match) dispatch->delivered++;
     }
+  return match;
   }
 
 ////////////////////////////////////////////////////////////////////////
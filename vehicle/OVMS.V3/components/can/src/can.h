@@ -42,9 +42,11 @@
 #include <stdint.h>
 #include <functional>
 #include <list>
+#include <vector>
 #include "pcp.h"
 #include <esp_err.h>
 #include "ovms_events.h"
+#include "ovms_mutex.h"
 
 ////////////////////////////////////////////////////////////////////////
 // Constant ESP_QUEUED to indicate a 'queued' response
@@ -134,6 +136,7 @@ struct CAN_frame_t
     uint32_t  u32[2];                   // Payload u32 access (Att: little endian!)
     uint64_t  u64;                      // Payload u64 access (Att: little endian!)
     } data;
+  int64_t     timestamp;                // RX: capture time [us] (esp_timer_get_time() in driver ISR/handler)
 
   esp_err_t Write(canbus* bus=NULL, TickType_t maxqueuewait=0);  // bus: NULL=origin
   };
@@ -174,6 +177,7 @@ typedef enum
 typedef struct
   {
   CAN_queue_type_t type;
+  int64_t timestamp;    // CAN_frame & CAN_asyncinterrupthandler: capture time [us] (esp_timer_get_time())
   union
     {
     CAN_frame_t frame;  // CAN_frame
@@ -216,6 +220,50 @@ class canfilter
     CAN_filter_list_t m_filters;
   };
 
+////////////////////////////////////////////////////////////////////////
+// CAN ID dispatch index
+// The canidset object holds the (bus, frame format, ID range) subscriptions
+// of a CAN listener or callback, so frames nobody is interested in can be
+// skipped before dispatch. Standard IDs are checked in O(1) via a per bus
+// bitmap, extended IDs by binary search on a sorted list of merged ranges.
+// An empty set subscribes to all frames.
+////////////////////////////////////////////////////////////////////////
+
+typedef struct
+  {
+  uint32_t id_from;
+  uint32_t id_to;
+  } CAN_idrange_t;
+
+typedef std::vector<CAN_idrange_t> CAN_idrange_list_t;
+
+class canidset
+  {
+  public:
+    canidset();
+    ~canidset();
+
+  public:
+    void Clear();
+    void Add(uint8_t bus, CAN_frame_format_t format, uint32_t id);    // bus: 1…CAN_MAXBUSES, 0=all
+    void Add(uint8_t bus, CAN_frame_format_t format, uint32_t id_from, uint32_t id_to);
+    bool IsEmpty() { return m_empty; }
+
+  public:
+    bool Contains(int busnumber, CAN_frame_format_t format, uint32_t id);
+    bool Contains(const CAN_frame_t* p_frame);
+    std::string Info();
+
+  protected:
+    void AddRange(int busnumber, CAN_frame_format_t format, uint32_t id_from, uint32_t id_to);
+
+  protected:
+    uint8_t m_std[CAN_MAXBUSES][256];             // Standard ID bitmap per bus
+    CAN_idrange_list_t m_ranges[CAN_MAXBUSES][2]; // Sorted ranges per bus & frame format
+    OvmsMutex m_mutex;
+    volatile bool m_empty;
+  };
+
 ////////////////////////////////////////////////////////////////////////
 // CAN logging and tracing
 // These structures are involved in formatting, logging and tracing of
@@ -262,7 +310,9 @@ extern const char* GetCanLogTypeName(CAN_log_type_t type);
 // canbus - the definition of a CAN bus
 ////////////////////////////////////////////////////////////////////////
 
+class OvmsWriter;
 class canlog;
+class canlogring;
 class canplay;
 class dbcfile;
 
@@ -277,6 +327,7 @@ class canbus : public pcp, public InternalRamAllocated
     virtual esp_err_t Start(CAN_mode_t mode, CAN_speed_t speed, dbcfile *dbcfile);
     virtual esp_err_t Stop();
     virtual void ClearStatus();
+    virtual void ShowStatus(OvmsWriter* writer) {}   // driver specific status details
     virtual esp_err_t ViewRegisters();
     virtual esp_err_t WriteReg( uint8_t reg, uint8_t value );
 
@@ -321,21 +372,34 @@ class canbus : public pcp, public InternalRamAllocated
 // can - the CAN system controller
 ////////////////////////////////////////////////////////////////////////
 
-typedef std::map<QueueHandle_t, bool> CanListenerMap_t;
+typedef struct
+  {
+  bool txfeedback;
+  canidset* ids;                    // NULL = all frames
+  } CanListener_t;
+typedef std::map<QueueHandle_t, CanListener_t> CanListenerMap_t;
+
+typedef struct
+  {
+  int subscribers;                  // ID subscribers checked
+  int delivered;                    // … of which matched the frame
+  } CAN_dispatch_t;
 
 
 class CanFrameCallbackEntry
   {
   public:
-    CanFrameCallbackEntry(const char* caller, CanFrameCallback callback)
+    CanFrameCallbackEntry(const char* caller, CanFrameCallback callback, canidset* ids=NULL)
       {
       m_caller = caller;
       m_callback = callback;
+      m_ids = ids;
       }
     ~CanFrameCallbackEntry() {}
   public:
     const char *m_caller;
     CanFrameCallback m_callback;
+    canidset* m_ids;                // NULL = all frames
   };
 typedef std::list<CanFrameCallbackEntry*> CanFrameCallbackList_t;
 
@@ -352,14 +416,14 @@ class can : public InternalRamAllocated
     QueueHandle_t m_rxqueue;
 
   public:
-    void RegisterListener(QueueHandle_t queue, bool txfeedback=false);
+    void RegisterListener(QueueHandle_t queue, bool txfeedback=false, canidset* ids=NULL);
     void DeregisterListener(QueueHandle_t queue);
-    void NotifyListeners(const CAN_frame_t* frame, bool tx);
+    void NotifyListeners(const CAN_frame_t* frame, bool tx, CAN_dispatch_t* dispatch=NULL);
 
   public:
-    void RegisterCallback(const char* caller, CanFrameCallback callback, bool txfeedback=false);
+    void RegisterCallback(const char* caller, CanFrameCallback callback, bool txfeedback=false, canidset* ids=NULL);
     void DeregisterCallback(const char* caller);
-    void ExecuteCallbacks(const CAN_frame_t* frame, bool tx, bool success);
+    void ExecuteCallbacks(const CAN_frame_t* frame, bool tx, bool success, CAN_dispatch_t* dispatch=NULL);
 
   public:
     uint32_t AddLogger(canlog* logger, int filterc=0, const char* const* filterv=NULL);
@@ -379,15 +443,25 @@ class can : public InternalRamAllocated
     void LogFrame(canbus* bus, CAN_log_type_t type, const CAN_frame_t* frame);
     void LogStatus(canbus* bus, CAN_log_type_t type, const CAN_status_t* status);
     void LogInfo(canbus* bus, CAN_log_type_t type, const char* text);
+    canlogring* GetLogRing();
+
+  protected:
+    void LogEventListener(std::string event, void* data);
 
   public:
     canbus* GetBus(int busnumber);
 
+  public:
+    bool Dispatch(canidset* ids, const CAN_frame_t* frame, CAN_dispatch_t* dispatch);
+    uint32_t m_dispatch_delivered[CAN_MAXBUSES];   // Frames passed to at least one ID subscriber
+    uint32_t m_dispatch_skipped[CAN_MAXBUSES];     // Frames skipped by all ID subscribers
+
   public:
     typedef std::map<uint32_t, canlog*> canlog_map_t;
     canlog_map_t m_loggermap;
     OvmsMutex m_loggermap_mutex;
     uint32_t m_logger_id;
+    canlogring* volatile m_logring;   // shared log message ring, created on first use
 
   public:
     typedef std::map<uint32_t, canplay*> canplay_map_t;
@@ -398,6 +472,7 @@ class can : public InternalRamAllocated
   private:
     canbus* m_buslist[CAN_MAXBUSES];
     CanListenerMap_t m_listeners;
+    OvmsMutex m_listeners_mutex;
     CanFrameCallbackList_t m_rxcallbacks;
     CanFrameCallbackList_t m_txcallbacks;
     TaskHandle_t m_rxtask;            // Task to handle reception
@@ -28,6 +28,7 @@
 static const char *TAG = "canformat";
 
 #include "canformat.h"
+#include "esp_timer.h"
 
 canformat::canformat_serve_mode_t GetFormatModeType(std::string name)
   {
@@ -91,9 +92,22 @@ const char* canformat::type()
   return m_type;
   }
 
+/**
+ * get: format message into the caller buffer
+ *  Returns the number of bytes written (no NUL termination),
+ *  0 if the message is not supported by the format or does not fit.
+ *  A buffer of CANFORMAT_GET_MAXLEN bytes is sufficient for all messages.
+ */
+size_t canformat::get(CAN_log_message_t* message, char* buffer, size_t len)
+  {
+  return 0;
+  }
+
 std::string canformat::get(CAN_log_message_t* message)
   {
-  return std::string("");
+  char buf[CANFORMAT_GET_MAXLEN];
+  size_t len = get(message, buf, sizeof(buf));
+  return std::string(buf, len);
   }
 
 std::string canformat::getheader(struct timeval *time)
@@ -136,6 +150,7 @@ size_t canformat::Serve(uint8_t *buffer, size_t len, void* userdata)
       switch (m_servemode)
         {
         case Simulate:
+          msg.frame.timestamp = esp_timer_get_time();
           MyCan.IncomingFrame(&msg.frame);
           break;
         case Transmit:
@@ -159,6 +174,14 @@ size_t canformat::Stuff(uint8_t *buffer, size_t len)
   return consumed;
   }
 
+/**
+ * GetBuffered: number of input bytes stuffed but not yet converted by put()
+ */
+size_t canformat::GetBuffered()
+  {
+  return m_buf.UsedSpace();
+  }
+
 canformat::canformat_serve_mode_t canformat::GetServeMode()
   {
   return m_servemode;
@@ -38,6 +38,7 @@
 using namespace std;
 
 #define CANFORMAT_SERVE_BUFFERSIZE 1024
+#define CANFORMAT_GET_MAXLEN 256    // buffer size sufficient for any single message
 
 typedef void (*canformat_put_write_fn)(uint8_t *buffer, size_t len, void* data);
 
@@ -54,7 +55,8 @@ class canformat
     const char* type();
 
   public: // Conversion from OVMS CAN log messages to specific format
-    virtual std::string get(CAN_log_message_t* message);
+    virtual size_t get(CAN_log_message_t* message, char* buffer, size_t len);
+    std::string get(CAN_log_message_t* message);
     virtual std::string getheader(struct timeval *time = NULL);
 
   public: // Conversion from specific format to OVMS CAN log messages
@@ -72,6 +74,7 @@ class canformat
     void SetPutCallback(canformat_put_write_fn callback);
     virtual size_t Serve(uint8_t *buffer, size_t len, void* userdata=NULL);
     virtual size_t Stuff(uint8_t *buffer, size_t len);
+    size_t GetBuffered();
 
   protected:
     canformat_put_write_fn m_putcallback_fn;
@@ -53,10 +53,10 @@ canformat_crtd::~canformat_crtd()
   {
   }
 
-std::string canformat_crtd::get(CAN_log_message_t* message)
+size_t canformat_crtd::get(CAN_log_message_t* message, char* buffer, size_t len)
   {
-  char buf[CANFORMAT_CRTD_MAXLEN];
   char *p;
+  int n;
 
   char busnumber;
   if (message->origin != NULL)
@@ -64,29 +64,33 @@ std::string canformat_crtd::get(CAN_log_message_t* message)
   else
     { busnumber = '1'; }
 
+  if (len < 2) return 0;
+  len--;  // reserve space for the newline
+
   switch (message->type)
     {
     case CAN_LogFrame_RX:
     case CAN_LogFrame_TX:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %c%c%s %0*X",
+      n = snprintf(buffer,len,"%ld.%06ld %c%c%s %0*X",
         message->timestamp.tv_sec, message->timestamp.tv_usec,
         busnumber,
         (message->type == CAN_LogFrame_RX) ? 'R' : 'T',
         (message->frame.FIR.B.FF == CAN_frame_std) ? "11":"29",
         (message->frame.FIR.B.FF == CAN_frame_std) ? 3 : 8,
         message->frame.MsgID);
-      p = buf+strlen(buf);
+      if (n < 0 || n + 3*message->frame.FIR.B.DLC >= len) return 0;
+      p = buffer+n;
       for (int k=0; k<message->frame.FIR.B.DLC; k++)
         {
         *p++ = ' ';
         p = HexByte(p,message->frame.data.u8[k]);
         }
-      *p = 0;
+      n = p-buffer;
       break;
 
     case CAN_LogFrame_TX_Queue:
     case CAN_LogFrame_TX_Fail:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %cCER %s %c%s %0*X",
+      n = snprintf(buffer,len,"%ld.%06ld %cCER %s %c%s %0*X",
         message->timestamp.tv_sec, message->timestamp.tv_usec,
         busnumber,
         GetCanLogTypeName(message->type),
@@ -94,18 +98,19 @@ std::string canformat_crtd::get(CAN_log_message_t* message)
         (message->frame.FIR.B.FF == CAN_frame_std) ? "11":"29",
         (message->frame.FIR.B.FF == CAN_frame_std) ? 3 : 8,
         message->frame.MsgID);
-        p = buf+strlen(buf);
-        for (int k=0; k<message->frame.FIR.B.DLC; k++)
-          {
-          *p++ = ' ';
-          p = HexByte(p,message->frame.data.u8[k]);
-          }
-        *p = 0;
+      if (n < 0 || n + 3*message->frame.FIR.B.DLC >= len) return 0;
+      p = buffer+n;
+      for (int k=0; k<message->frame.FIR.B.DLC; k++)
+        {
+        *p++ = ' ';
+        p = HexByte(p,message->frame.data.u8[k]);
+        }
+      n = p-buffer;
       break;
 
     case CAN_LogStatus_Error:
     case CAN_LogStatus_Statistics:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %c%s %s intr=%d rxpkt=%d txpkt=%d errflags=%#x rxerr=%d txerr=%d rxovr=%d txovr=%d txdelay=%d wdgreset=%d errreset=%d",
+      n = snprintf(buffer,len,"%ld.%06ld %c%s %s intr=%d rxpkt=%d txpkt=%d errflags=%#x rxerr=%d txerr=%d rxovr=%d txovr=%d txdelay=%d wdgreset=%d errreset=%d",
         message->timestamp.tv_sec, message->timestamp.tv_usec,
         busnumber,
         (message->type == CAN_LogStatus_Error) ? "CER" : "CST",
@@ -115,12 +120,11 @@ std::string canformat_crtd::get(CAN_log_message_t* message)
         message->status.txbuf_overflow, message->status.txbuf_delay, message->status.watchdog_resets,
         message->status.error_resets);
       break;
-      break;
 
     case CAN_LogInfo_Comment:
     case CAN_LogInfo_Config:
     case CAN_LogInfo_Event:
-      snprintf(buf,sizeof(buf),"%ld.%06ld %c%s %s %s",
+      n = snprintf(buffer,len,"%ld.%06ld %c%s %s %s",
         message->timestamp.tv_sec, message->timestamp.tv_usec,
         busnumber,
         (message->type == CAN_LogInfo_Event) ? "CEV" : "CXX",
@@ -129,12 +133,14 @@ std::string canformat_crtd::get(CAN_log_message_t* message)
       break;
 
     default:
-      buf[0] = 0;
+      n = 0;
       break;
     }
 
-  strcat(buf,"\n");
-  return std::string(buf);
+  if (n < 0) return 0;
+  if (n >= len) n = len-1;  // truncated
+  buffer[n++] = '\n';
+  return n;
   }
 
 std::string canformat_crtd::getheader(struct timeval *time)
@@ -156,12 +162,12 @@ std::string canformat_crtd::getheader(struct timeval *time)
 
 size_t canformat_crtd::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
   {
-  if (m_buf.FreeSpace()==0) SetServeDiscarding(true); // Buffer full, so discard from now on
+  if ((m_buf.FreeSpace()==0)&&(m_buf.HasLine()<0)) SetServeDiscarding(true); // Buffer full without a line, so discard from now on
   if (IsServeDiscarding()) return len;  // Quick return if discarding
 
   size_t consumed = Stuff(buffer,len);  // Stuff m_buf with as much as possible
 
-  if (!m_buf.HasLine())
+  if (m_buf.HasLine() < 0)
     {
     return consumed; // No line, so quick exit
     }
@@ -173,6 +179,23 @@ size_t canformat_crtd::put(CAN_log_message_t* message, uint8_t *buffer, size_t l
     // We look for something like
     // 1524311386.811100 1R11 100 01 02 03
     if (!isdigit(b[0])) return consumed;    // Discard invalid line
+
+    // Timestamp: <seconds>[.<fraction>]
+    message->timestamp.tv_sec = strtol(b, NULL, 10);
+    const char *f = strchr(b, '.');
+    const char *sp = strchr(b, ' ');
+    if (f && sp && f < sp)
+      {
+      long usec = 0;
+      int digits = 0;
+      for (f++; isdigit(*f); f++)
+        {
+        if (digits < 6) { usec = usec*10 + (*f-'0'); digits++; }
+        }
+      while (digits++ < 6) usec *= 10;
+      message->timestamp.tv_usec = usec;
+      }
+
     for (;((*b != 0)&&(*b != ' '));b++) {}
     if (*b == 0) return consumed;           // Discard invalid line
     b++;
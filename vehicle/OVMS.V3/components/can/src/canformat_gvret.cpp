@@ -31,6 +31,7 @@ static const char *TAG = "canformat-gvret";
 #include <errno.h>
 #include <endian.h>
 #include "pcp.h"
+#include "esp_timer.h"
 
 ////////////////////////////////////////////////////////////////////////
 // Initialisation and Registration
@@ -62,9 +63,9 @@ canformat_gvret::~canformat_gvret()
   {
   }
 
-std::string canformat_gvret::get(CAN_log_message_t* message)
+size_t canformat_gvret::get(CAN_log_message_t* message, char* buffer, size_t len)
   {
-  return std::string("");
+  return 0;
   }
 
 std::string canformat_gvret::getheader(struct timeval *time)
@@ -86,56 +87,61 @@ canformat_gvret_ascii::canformat_gvret_ascii(const char* type)
   {
   }
 
-std::string canformat_gvret_ascii::get(CAN_log_message_t* message)
+size_t canformat_gvret_ascii::get(CAN_log_message_t* message, char* buffer, size_t len)
   {
-  char buf[CANFORMAT_GVRET_MAXLEN];
+  char *p;
 
   if ((message->type != CAN_LogFrame_RX)&&
       (message->type != CAN_LogFrame_TX))
     {
-    return std::string("");
+    return 0;
     }
+  if (len < CANFORMAT_GVRET_MAXLEN) return 0;
 
   char busnumber = (message->origin != NULL)?message->origin->m_busnumber + '0':'0';
 
-  sprintf(buf,"%u - %x %s %c %d",
+  p = buffer + sprintf(buffer,"%u - %x %s %c %d",
     (uint32_t)((message->timestamp.tv_sec * 1000000) + message->timestamp.tv_usec),
     message->frame.MsgID,
     (message->frame.FIR.B.FF == CAN_frame_std) ? "S" : "X",
     busnumber,
     message->frame.FIR.B.DLC);
-    for (int k=0; k<message->frame.FIR.B.DLC; k++)
-      sprintf(buf+strlen(buf)," %02x", message->frame.data.u8[k]);
+  for (int k=0; k<message->frame.FIR.B.DLC; k++)
+    {
+    *p++ = ' ';
+    p = HexByte(p, message->frame.data.u8[k]);
+    }
 
-  strcat(buf,"\n");
-  return std::string(buf);
+  *p++ = '\n';
+  return p - buffer;
   }
 
 size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
   {
-  if (m_buf.FreeSpace()==0) SetServeDiscarding(true); // Buffer full, so discard from now on
+  if ((m_buf.FreeSpace()==0)&&(m_buf.HasLine()<0)) SetServeDiscarding(true); // Buffer full without a line, so discard from now on
   if (IsServeDiscarding()) return len;  // Quick return if discarding
 
   size_t consumed = Stuff(buffer,len);  // Stuff m_buf with as much as possible
 
-  if (!m_buf.HasLine())
+  if (m_buf.HasLine() < 0)
     {
     return consumed; // No line, so quick exit
     }
   else
     {
     std::string line = m_buf.ReadLine();
-    char *b = strdup(line.c_str());
+    char *s = strdup(line.c_str());
+    char *b = s;
 
     // We look for something like
     // 1000 - 100 S 0 4 01 02 03 04
-    // timestamp, message ID (hex), S or X, length, data bytes
+    // timestamp (us), message ID (hex), S or X, bus, length, data bytes
 
     message->type = CAN_LogFrame_RX;
 
-    uint32_t timestamp = strtol(b,&b,10);
-    message->timestamp.tv_sec = timestamp % 1000000;
-    message->timestamp.tv_usec = timestamp / 1000000;
+    uint32_t timestamp = strtoul(b,&b,10);
+    message->timestamp.tv_sec = timestamp / 1000000;
+    message->timestamp.tv_usec = timestamp % 1000000;
 
     b += 2; // Skip the '-'
 
@@ -151,7 +157,7 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
     else
       {
       // Bad frame type - discard
-      free(b);
+      free(s);
       return consumed;
       }
 
@@ -163,7 +169,7 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
     if (message->frame.FIR.B.DLC > 8)
       {
       // Bad frame length - discard
-      free(b);
+      free(s);
       return consumed;
       }
 
@@ -172,9 +178,9 @@ size_t canformat_gvret_ascii::put(CAN_log_message_t* message, uint8_t *buffer, s
       message->frame.data.u8[x] = strtol(b,&b,16);
       }
 
-    message->origin = MyCan.GetBus(busnumber-'0');
+    message->origin = MyCan.GetBus(busnumber);
 
-    free(b);
+    free(s);
     return consumed;
     }
   }
@@ -188,7 +194,7 @@ canformat_gvret_binary::canformat_gvret_binary(const char* type)
   {
   }
 
-std::string canformat_gvret_binary::get(CAN_log_message_t* message)
+size_t canformat_gvret_binary::get(CAN_log_message_t* message, char* buffer, size_t len)
   {
   gvret_binary_frame_t frame;
   memset(&frame,0,sizeof(frame));
@@ -196,9 +202,12 @@ std::string canformat_gvret_binary::get(CAN_log_message_t* message)
   if ((message->type != CAN_LogFrame_RX)&&
       (message->type != CAN_LogFrame_TX))
     {
-    return std::string("");
+    return 0;
     }
 
+  size_t size = 12 + message->frame.FIR.B.DLC;
+  if (len < size) return 0;
+
   char busnumber = (message->origin != NULL)?message->origin->m_busnumber:0;
 
   frame.startbyte = GVRET_START_BYTE;
@@ -209,7 +218,8 @@ std::string canformat_gvret_binary::get(CAN_log_message_t* message)
   frame.lenbus = message->frame.FIR.B.DLC + (busnumber<<4);
   for (int k=0; k<message->frame.FIR.B.DLC; k++)
     frame.data[k] = message->frame.data.u8[k];
-  return std::string((const char*)&frame,12 + message->frame.FIR.B.DLC);
+  memcpy(buffer, &frame, size);
+  return size;
   }
 
 size_t canformat_gvret_binary::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
@@ -269,6 +279,7 @@ size_t canformat_gvret_binary::put(CAN_log_message_t* message, uint8_t *buffer,
                 if (msg.origin) msg.origin->Write(&msg);
                 break;
               case Simulate:
+                msg.timestamp = esp_timer_get_time();
                 if (msg.origin) MyCan.IncomingFrame(&msg);
                 break;
               default:
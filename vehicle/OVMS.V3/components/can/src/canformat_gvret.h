@@ -29,7 +29,7 @@
 
 #include "canformat.h"
 
-#define CANFORMAT_GVRET_MAXLEN 48
+#define CANFORMAT_GVRET_MAXLEN 64
 
 #define GVRET_SET_BINARY 0xe7
 #define GVRET_START_BYTE 0xf1
@@ -167,7 +167,8 @@ class canformat_gvret : public canformat
     virtual ~canformat_gvret();
 
   public:
-    virtual std::string get(CAN_log_message_t* message);
+    using canformat::get;
+    virtual size_t get(CAN_log_message_t* message, char* buffer, size_t len);
     virtual std::string getheader(struct timeval *time);
     virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
   };
@@ -176,7 +177,8 @@ class canformat_gvret_ascii : public canformat_gvret
   {
   public:
     canformat_gvret_ascii(const char* type);
-    virtual std::string get(CAN_log_message_t* message);
+    using canformat::get;
+    virtual size_t get(CAN_log_message_t* message, char* buffer, size_t len);
     virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
   };
 
@@ -184,7 +186,8 @@ class canformat_gvret_binary : public canformat_gvret
   {
   public:
     canformat_gvret_binary(const char* type);
-    virtual std::string get(CAN_log_message_t* message);
+    using canformat::get;
+    virtual size_t get(CAN_log_message_t* message, char* buffer, size_t len);
     virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
   };
 
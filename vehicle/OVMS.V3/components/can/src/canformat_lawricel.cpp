@@ -60,31 +60,32 @@ canformat_lawricel::~canformat_lawricel()
   {
   }
 
-std::string canformat_lawricel::get(CAN_log_message_t* message)
+size_t canformat_lawricel::get(CAN_log_message_t* message, char* buffer, size_t len)
   {
-  char buf[CANFORMAT_LAWRICEL_MAXLEN];
+  char *p;
 
   if ((message->type != CAN_LogFrame_RX)&&
       (message->type != CAN_LogFrame_TX))
     {
-    return std::string("");
+    return 0;
     }
+  if (len < CANFORMAT_LAWRICEL_MAXLEN) return 0;
 
   if (message->frame.FIR.B.FF == CAN_frame_std)
     {
-    sprintf(buf,"t%03x%01d",message->frame.MsgID, message->frame.FIR.B.DLC);
+    p = buffer + sprintf(buffer,"t%03x%01d",message->frame.MsgID, message->frame.FIR.B.DLC);
     }
   else
     {
-    sprintf(buf,"T%08x%01d",message->frame.MsgID, message->frame.FIR.B.DLC);
+    p = buffer + sprintf(buffer,"T%08x%01d",message->frame.MsgID, message->frame.FIR.B.DLC);
     }
 
   for (int k=0; k<message->frame.FIR.B.DLC; k++)
-    sprintf(buf+strlen(buf),"%02x", message->frame.data.u8[k]);
-  sprintf(buf+strlen(buf),"%04lx", message->timestamp.tv_usec/1000);
+    p = HexByte(p, message->frame.data.u8[k]);
+  p += sprintf(p,"%04lx", message->timestamp.tv_usec/1000);
 
-  strcat(buf,"\n");
-  return std::string(buf);
+  *p++ = '\n';
+  return p - buffer;
   }
 
 std::string canformat_lawricel::getheader(struct timeval *time)
@@ -94,12 +95,12 @@ std::string canformat_lawricel::getheader(struct timeval *time)
 
 size_t canformat_lawricel::put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata)
   {
-  if (m_buf.FreeSpace()==0) SetServeDiscarding(true); // Buffer full, so discard from now on
+  if ((m_buf.FreeSpace()==0)&&(m_buf.HasLine()<0)) SetServeDiscarding(true); // Buffer full without a line, so discard from now on
   if (IsServeDiscarding()) return len;  // Quick return if discarding
 
   size_t consumed = Stuff(buffer,len);  // Stuff m_buf with as much as possible
 
-  if (!m_buf.HasLine())
+  if (m_buf.HasLine() < 0)
     {
     return consumed; // No line, so quick exit
     }
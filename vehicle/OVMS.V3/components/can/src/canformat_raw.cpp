@@ -53,12 +53,31 @@ canformat_raw::~canformat_raw()
   {
   }
 
-std::string canformat_raw::get(CAN_log_message_t* message)
+size_t canformat_raw::get(CAN_log_message_t* message, char* buffer, size_t len)
   {
-  CAN_log_message_t raw;
-  memcpy(&raw,message,sizeof(raw));
-  raw.origin = (canbus*)raw.origin->m_busnumber;
-  return std::string((const char*)&raw,sizeof(CAN_log_message_t));
+  if (len < sizeof(canformat_raw_record_t)) return 0;
+  // The buffer may be unaligned: build the record, then copy it bytewise
+  canformat_raw_record_t raw;
+  memset(&raw,0,sizeof(raw));
+  raw.type = message->type;
+  raw.timestamp = message->timestamp;
+  raw.origin = (canbus*)(intptr_t)((message->origin) ? message->origin->m_busnumber : 0);
+  switch (message->type)
+    {
+    case CAN_LogFrame_RX:
+    case CAN_LogFrame_TX:
+    case CAN_LogFrame_TX_Queue:
+    case CAN_LogFrame_TX_Fail:
+      raw.frame.FIR = message->frame.FIR;
+      raw.frame.MsgID = message->frame.MsgID;
+      raw.frame.data.u64 = message->frame.data.u64;
+      break;
+    default:
+      raw.status = message->status;
+      break;
+    }
+  memcpy(buffer,&raw,sizeof(raw));
+  return sizeof(raw);
   }
 
 std::string canformat_raw::getheader(struct timeval *time)
@@ -73,9 +92,26 @@ size_t canformat_raw::put(CAN_log_message_t* message, uint8_t *buffer, size_t le
 
   size_t consumed = Stuff(buffer,len);  // Stuff m_buf with as much as possible
 
-  if (m_buf.UsedSpace() < sizeof(CAN_log_message_t)) return consumed; // Insufficient data so far
+  if (m_buf.UsedSpace() < sizeof(canformat_raw_record_t)) return consumed; // Insufficient data so far
 
-  m_buf.Pop(sizeof(CAN_log_message_t), (uint8_t*)message);
-  message->origin = MyCan.GetBus((int)message->origin);
+  canformat_raw_record_t raw;
+  m_buf.Pop(sizeof(raw), (uint8_t*)&raw);
+  message->type = raw.type;
+  message->timestamp = raw.timestamp;
+  switch (raw.type)
+    {
+    case CAN_LogFrame_RX:
+    case CAN_LogFrame_TX:
+    case CAN_LogFrame_TX_Queue:
+    case CAN_LogFrame_TX_Fail:
+      message->frame.FIR = raw.frame.FIR;
+      message->frame.MsgID = raw.frame.MsgID;
+      message->frame.data.u64 = raw.frame.data.u64;
+      break;
+    default:
+      message->status = raw.status;
+      break;
+    }
+  message->origin = MyCan.GetBus((int)(intptr_t)raw.origin);
   return consumed;
   }
@@ -29,6 +29,40 @@
 
 #include "canformat.h"
 
+// Raw record: the in-memory CAN_log_message_t layout as it was before
+// frames carried their capture timestamp. Records are converted to/from
+// this fixed layout, so changes to CAN_frame_t do not alter the format.
+typedef struct
+  {
+  CAN_log_type_t type;
+  struct timeval timestamp;
+  union
+    {
+    struct
+      {
+      canbus* origin;                   // bus number
+      void* callback;                   // unused, 0
+      CAN_FIR_t FIR;
+      uint32_t MsgID;
+      union
+        {
+        uint8_t u8[8];
+        uint32_t u32[2];
+        uint64_t u64;
+        } data;
+      } frame;
+    struct
+      {
+      canbus* origin;                   // bus number
+      union
+        {
+        CAN_status_t status;
+        char* text;
+        };
+      };
+    };
+  } canformat_raw_record_t;
+
 class canformat_raw : public canformat
   {
   public:
@@ -36,7 +70,8 @@ class canformat_raw : public canformat
     virtual ~canformat_raw();
 
   public:
-    virtual std::string get(CAN_log_message_t* message);
+    using canformat::get;
+    virtual size_t get(CAN_log_message_t* message, char* buffer, size_t len);
     virtual std::string getheader(struct timeval *time);
     virtual size_t put(CAN_log_message_t* message, uint8_t *buffer, size_t len, void* userdata=NULL);
   };
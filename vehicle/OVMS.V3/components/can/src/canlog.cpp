@@ -35,6 +35,7 @@ static const char *TAG = "canlog";
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include "ovms_malloc.h"
 #include "ovms_utils.h"
 #include "ovms_config.h"
 #include "ovms_command.h"
@@ -152,6 +153,220 @@ OvmsCanLogInit::OvmsCanLogInit()
   cmd_canlog->RegisterCommand("start", "CAN logging start framework");
   }
 
+////////////////////////////////////////////////////////////////////////
+// CAN Log Ring
+////////////////////////////////////////////////////////////////////////
+
+static inline bool canlogring_istext(CAN_log_type_t type)
+  {
+  return (type == CAN_LogInfo_Comment || type == CAN_LogInfo_Config || type == CAN_LogInfo_Event);
+  }
+
+canlogring::canlogring(uint32_t size)
+  {
+  m_size = 16;
+  while (m_size < size) m_size <<= 1;
+  m_mask = m_size - 1;
+  m_entries = (entry_t*) ExternalRamMalloc(m_size * sizeof(entry_t));
+  if (!m_entries)
+    {
+    ESP_LOGE(TAG, "canlogring: cannot allocate %u entries, CAN logging disabled", m_size);
+    m_size = 0;
+    m_mask = 0;
+    }
+  for (uint32_t k = 0; k < m_size; k++)
+    {
+    // mark all slots as not matching any cursor:
+    m_entries[k].seq = CANLOGRING_SEQ_INVALID;
+    m_entries[k].msg.type = CAN_LogFrame_RX;
+    }
+  m_head = 0;
+  m_mux = portMUX_INITIALIZER_UNLOCKED;
+  m_readermask = 0;
+  m_sleepers = 0;
+  m_sleepseq = 0;
+  m_wakeup = m_size / 4;
+  for (int k = 0; k < CANLOGRING_MAXREADERS; k++)
+    m_readertask[k] = NULL;
+  }
+
+canlogring::~canlogring()
+  {
+  for (uint32_t k = 0; k < m_size; k++)
+    {
+    if (m_entries[k].seq & 1) continue;
+    if (canlogring_istext(m_entries[k].msg.type))
+      free(m_entries[k].msg.text);
+    }
+  free(m_entries);
+  }
+
+/**
+ * Push: store a message (takes ownership of the text of info messages)
+ *  The slot is written seqlock style: the slot sequence is odd while the
+ *  message is written, then set to the (even) slot sequence of the cursor.
+ */
+void canlogring::Push(CAN_log_message_t& msg)
+  {
+  char* oldtext = NULL;
+  uint32_t wake;
+
+  if (m_size == 0)
+    {
+    // ring disabled:
+    if (canlogring_istext(msg.type))
+      free(msg.text);
+    return;
+    }
+
+  portENTER_CRITICAL(&m_mux);
+  uint32_t seq = m_head;
+  entry_t* e = &m_entries[seq & m_mask];
+  if ((e->seq & 1) == 0 && canlogring_istext(e->msg.type))
+    oldtext = e->msg.text;
+  __atomic_store_n(&e->seq, CANLOGRING_SEQ_INVALID, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  e->msg = msg;
+  __atomic_store_n(&e->seq, CANLOGRING_SEQ(seq), __ATOMIC_RELEASE);
+  m_head = seq + 1;
+  wake = 0;
+  if (m_sleepers && (seq + 1 - m_sleepseq) >= m_wakeup)
+    {
+    wake = m_sleepers;
+    m_sleepers = 0;
+    }
+  portEXIT_CRITICAL(&m_mux);
+
+  if (oldtext)
+    free(oldtext);
+
+  for (int k = 0; wake; k++, wake >>= 1)
+    {
+    if ((wake & 1) && m_readertask[k])
+      xTaskNotifyGive(m_readertask[k]);
+    }
+  }
+
+/**
+ * AddReader: allocate a reader slot, cursor starts at the current head
+ *  Returns the slot number or -1 if all slots are in use.
+ */
+int canlogring::AddReader(uint32_t& cursor)
+  {
+  int reader = -1;
+  portENTER_CRITICAL(&m_mux);
+  for (int k = 0; k < CANLOGRING_MAXREADERS; k++)
+    {
+    if ((m_readermask & (1U << k)) == 0)
+      {
+      reader = k;
+      m_readermask |= (1U << k);
+      m_readertask[k] = NULL;
+      cursor = m_head;
+      break;
+      }
+    }
+  portEXIT_CRITICAL(&m_mux);
+  return reader;
+  }
+
+void canlogring::RemoveReader(int reader)
+  {
+  if (reader < 0 || reader >= CANLOGRING_MAXREADERS) return;
+  portENTER_CRITICAL(&m_mux);
+  m_readermask &= ~(1U << reader);
+  m_sleepers &= ~(1U << reader);
+  m_readertask[reader] = NULL;
+  portEXIT_CRITICAL(&m_mux);
+  }
+
+/**
+ * Read: fetch the next message for the cursor
+ *  Info texts are copied into textbuf (CANLOG_TEXT_MAXLEN), msg.text
+ *  points to textbuf on return. Messages lost by being lapped are added
+ *  to dropped. Returns false if no message is pending.
+ */
+bool canlogring::Read(uint32_t& cursor, CAN_log_message_t& msg, char* textbuf, uint32_t& dropped)
+  {
+  while (1)
+    {
+    uint32_t head = m_head;
+    if (cursor == head)
+      return false;
+    if (head - cursor > m_size)
+      {
+      dropped += head - m_size - cursor;
+      cursor = head - m_size;
+      }
+
+    entry_t* e = &m_entries[cursor & m_mask];
+    uint32_t expect = CANLOGRING_SEQ(cursor);
+    bool valid;
+    if (canlogring_istext(e->msg.type))
+      {
+      portENTER_CRITICAL(&m_mux);
+      valid = (e->seq == expect);
+      if (valid)
+        {
+        msg = e->msg;
+        if (canlogring_istext(msg.type))
+          {
+          strlcpy(textbuf, e->msg.text, CANLOG_TEXT_MAXLEN);
+          msg.text = textbuf;
+          }
+        }
+      portEXIT_CRITICAL(&m_mux);
+      }
+    else
+      {
+      // seqlock read: the slot must hold the message before & after the copy
+      uint32_t before = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+      msg = e->msg;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      uint32_t after = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+      valid = (before == expect && after == expect && !canlogring_istext(msg.type));
+      }
+
+    if (valid)
+      {
+      cursor++;
+      return true;
+      }
+
+    // overwritten while reading:
+    dropped++;
+    cursor++;
+    }
+  }
+
+/**
+ * Wait: block the reader task until new messages are pushed (or timeout)
+ *  To batch reader wakeups, the producer only notifies sleepers after a
+ *  quarter of the ring has been filled, so the timeout defines the
+ *  maximum latency for low message rates.
+ */
+void canlogring::Wait(int reader, uint32_t cursor, TickType_t timeout)
+  {
+  if (reader < 0 || reader >= CANLOGRING_MAXREADERS) return;
+  portENTER_CRITICAL(&m_mux);
+  bool idle = (cursor == m_head);
+  if (idle)
+    {
+    m_readertask[reader] = xTaskGetCurrentTaskHandle();
+    if (m_sleepers == 0) m_sleepseq = m_head;
+    m_sleepers |= (1U << reader);
+    }
+  portEXIT_CRITICAL(&m_mux);
+  if (idle)
+    ulTaskNotifyTake(pdTRUE, timeout);
+  }
+
+uint32_t canlogring::Pending(uint32_t cursor)
+  {
+  uint32_t pending = m_head - cursor;
+  return (pending > m_size) ? m_size : pending;
+  }
+
 ////////////////////////////////////////////////////////////////////////
 // CAN Logger class
 ////////////////////////////////////////////////////////////////////////
@@ -168,47 +383,31 @@ canlog::canlog(const char* type, std::string format, canformat::canformat_serve_
   m_dropcount = 0;
   m_filtercount = 0;
 
-  using std::placeholders::_1;
-  using std::placeholders::_2;
-  MyEvents.RegisterEvent(IDTAG, "*", std::bind(&canlog::EventListener, this, _1, _2));
-
-  int queuesize = MyConfig.GetParamValueInt("can", "log.queuesize",100);
-  m_queue = xQueueCreate(queuesize, sizeof(CAN_log_message_t));
-  xTaskCreatePinnedToCore(RxTask, "OVMS CanLog", 4096, (void*)this, 10, &m_task, CORE(1));
+  m_batch = (char*) ExternalRamMalloc(CANLOG_BATCH_SIZE);
+  m_batchlen = 0;
+  m_batchcount = 0;
+  m_text = (char*) ExternalRamMalloc(CANLOG_TEXT_MAXLEN);
+
+  m_task = NULL;
+  m_taskstop = false;
+  m_ring = MyCan.GetLogRing();
+  m_reader = m_ring->AddReader(m_cursor);
+  if (m_reader < 0)
+    ESP_LOGE(TAG, "%s: too many loggers, log ring reader slots exhausted", m_type);
+  else if (m_ring->GetSize() == 0 || !m_batch || !m_text)
+    ESP_LOGE(TAG, "%s: out of memory, logger disabled", m_type);
+  else
+    xTaskCreatePinnedToCore(RxTask, "OVMS CanLog", 4096, (void*)this, 10, &m_task, CORE(1));
   }
 
 canlog::~canlog()
   {
-  MyEvents.DeregisterEvent(IDTAG);
+  StopTask();
 
-  if (m_task)
+  if (m_reader >= 0)
     {
-    TaskHandle_t t = m_task;
-    m_task = NULL;
-
-    vTaskDelete(t);
-    }
-
-  if (m_queue)
-    {
-    QueueHandle_t q = m_queue;
-    m_queue = NULL;
-
-    CAN_log_message_t msg;
-    while (xQueueReceive(q, &msg, 0) == pdTRUE)
-      {
-      switch (msg.type)
-        {
-        case CAN_LogInfo_Comment:
-        case CAN_LogInfo_Config:
-        case CAN_LogInfo_Event:
-          free(msg.text);
-          break;
-        default:
-          break;
-        }
-      }
-    vQueueDelete(q);
+    m_ring->RemoveReader(m_reader);
+    m_reader = -1;
     }
 
   if (m_formatter)
@@ -222,36 +421,84 @@ canlog::~canlog()
     delete m_filter;
     m_filter = NULL;
     }
+
+  if (m_batch)
+    {
+    free(m_batch);
+    m_batch = NULL;
+    }
+
+  if (m_text)
+    {
+    free(m_text);
+    m_text = NULL;
+    }
+  }
+
+/**
+ * StopTask: let the logger task exit & wait for it
+ *  Sub classes feeding their own buffers from OutputBatch() should call this
+ *  in their destructor, before releasing these.
+ */
+void canlog::StopTask()
+  {
+  if (m_task == NULL)
+    return;
+  m_taskstop = true;
+  xTaskNotifyGive(m_task);
+  while (m_task)
+    vTaskDelay(1);
   }
 
 void canlog::RxTask(void *context)
   {
   canlog* me = (canlog*) context;
   CAN_log_message_t msg;
-  while (1)
+  while (!me->m_taskstop)
     {
-    if (xQueueReceive(me->m_queue, &msg, (portTickType)portMAX_DELAY) == pdTRUE)
+    me->m_ring->Wait(me->m_reader, me->m_cursor, pdMS_TO_TICKS(CANLOGRING_WAKEUP_MS));
+
+    // Drain the ring into the batch, then pass it on:
+    uint32_t count = 0;
+    uint32_t dropped = me->m_dropcount;
+    while (me->m_ring->Read(me->m_cursor, msg, me->m_text, me->m_dropcount))
       {
-      switch (msg.type)
+      if (!me->IsOpen())
+        continue;
+      if (me->IsDiscarded(msg))
         {
-        case CAN_LogInfo_Comment:
-        case CAN_LogInfo_Config:
-        case CAN_LogInfo_Event:
-          me->OutputMsg(msg);
-          free(msg.text);
-          break;
-        default:
-          me->OutputMsg(msg);
-          break;
+        me->m_filtercount++;
+        continue;
         }
+      me->m_msgcount++;
+      me->OutputMsg(msg);
+      count++;
       }
+    me->m_msgcount += me->m_dropcount - dropped;
+    if (count)
+      me->FlushBatch();
     }
+  me->m_task = NULL;
+  vTaskDelete(NULL);
   }
 
-void canlog::EventListener(std::string event, void* data)
+/**
+ * IsDiscarded: consumer side message filter, true = message filtered out
+ */
+bool canlog::IsDiscarded(CAN_log_message_t& msg)
   {
-  if (startsWith(event, "vehicle"))
-    LogInfo(NULL, CAN_LogInfo_Event, event.c_str());
+  if (m_filter == NULL)
+    return false;
+  switch (msg.type)
+    {
+    case CAN_LogFrame_RX:
+    case CAN_LogFrame_TX:
+    case CAN_LogFrame_TX_Queue:
+    case CAN_LogFrame_TX_Fail:
+      return !m_filter->IsFiltered(&msg.frame);
+    default:
+      return !m_filter->IsFiltered(msg.origin);
+    }
   }
 
 const char* canlog::GetType()
@@ -265,9 +512,32 @@ const char* canlog::GetFormat()
   }
 
 void canlog::OutputMsg(CAN_log_message_t& msg)
+  {
+  if (m_formatter == NULL || m_batch == NULL) return;
+
+  if (CANLOG_BATCH_SIZE - m_batchlen < CANFORMAT_GET_MAXLEN)
+    FlushBatch();
+
+  size_t len = m_formatter->get(&msg, m_batch + m_batchlen, CANLOG_BATCH_SIZE - m_batchlen);
+  if (len > 0)
+    {
+    m_batchlen += len;
+    m_batchcount++;
+    }
+  }
+
+void canlog::OutputBatch(const char* data, size_t len, uint32_t msgcount)
   {
   }
 
+void canlog::FlushBatch()
+  {
+  if (m_batchlen > 0)
+    OutputBatch(m_batch, m_batchlen, m_batchcount);
+  m_batchlen = 0;
+  m_batchcount = 0;
+  }
+
 std::string canlog::GetInfo()
   {
   std::ostringstream buf;
@@ -297,7 +567,7 @@ std::string canlog::GetStats()
   std::ostringstream buf;
 
   float droprate = (m_msgcount > 0) ? ((float) m_dropcount/m_msgcount*100) : 0;
-  uint32_t waiting = uxQueueMessagesWaiting(m_queue);
+  uint32_t waiting = m_ring->Pending(m_cursor);
 
   buf << "total messages: " << m_msgcount
     << ", dropped: " << m_dropcount
@@ -327,63 +597,3 @@ void canlog::ClearFilter()
     m_filter = NULL;
     }
   }
-
-void canlog::LogFrame(canbus* bus, CAN_log_type_t type, const CAN_frame_t* frame)
-  {
-  if (!IsOpen() || !bus || !frame) return;
-
-  if (((m_filter == NULL)||(m_filter->IsFiltered(frame)))&&(m_queue))
-    {
-    CAN_log_message_t msg;
-    msg.type = type;
-    gettimeofday(&msg.timestamp,NULL);
-    memcpy(&msg.frame,frame,sizeof(CAN_frame_t));
-    msg.frame.origin = bus;
-    m_msgcount++;
-    if (xQueueSend(m_queue, &msg, 0) != pdTRUE) m_dropcount++;
-    }
-  else
-    {
-    m_filtercount++;
-    }
-  }
-
-void canlog::LogStatus(canbus* bus, CAN_log_type_t type, const CAN_status_t* status)
-  {
-  if (!IsOpen() || !bus) return;
-
-  if (((m_filter == NULL)||(m_filter->IsFiltered(bus)))&&(m_queue))
-    {
-    CAN_log_message_t msg;
-    msg.type = type;
-    gettimeofday(&msg.timestamp,NULL);
-    msg.origin = bus;
-    memcpy(&msg.status,status,sizeof(CAN_status_t));
-    m_msgcount++;
-    if (xQueueSend(m_queue, &msg, 0) != pdTRUE) m_dropcount++;
-    }
-  else
-    {
-    m_filtercount++;
-    }
-  }
-
-void canlog::LogInfo(canbus* bus, CAN_log_type_t type, const char* text)
-  {
-  if (!IsOpen() || !text) return;
-
-  if (((m_filter == NULL)||(m_filter->IsFiltered(bus)))&&(m_queue))
-    {
-    CAN_log_message_t msg;
-    msg.type = type;
-    gettimeofday(&msg.timestamp,NULL);
-    msg.origin = bus;
-    msg.text = strdup(text);
-    m_msgcount++;
-    if (xQueueSend(m_queue, &msg, 0) != pdTRUE) m_dropcount++;
-    }
-  else
-    {
-    m_filtercount++;
-    }
-  }
@@ -31,6 +31,72 @@
 #include "can.h"
 #include "canformat.h"
 
+#define CANLOG_BATCH_SIZE 2048
+#define CANLOG_TEXT_MAXLEN 256          // Info text size limit per consumer copy
+#define CANLOGRING_MAXREADERS 32        // Max concurrent loggers (sleeper bitmask)
+#define CANLOGRING_WAKEUP_MS 20         // Max idle reader latency [ms]
+
+// Slot sequence: even = message of cursor seq stored, odd = being written / unused
+#define CANLOGRING_SEQ(cursor)    ((uint32_t)(cursor) << 1)
+#define CANLOGRING_SEQ_INVALID    1
+
+/**
+ * canlogring: the shared log message ring of the CAN framework.
+ *
+ *  Log messages are timestamped and stored once, regardless of the number
+ *  of loggers. Each logger task reads the ring through its own cursor, so
+ *  producers (mostly the CanRx task) never copy a message more than once
+ *  and never wait for a slow logger. A reader that gets lapped by the
+ *  producer loses the overwritten messages and counts them as dropped.
+ *
+ *  Producers are serialized by a spinlock. Frame and status entries are
+ *  read lock free (seqlock: the slot sequence is odd while being written,
+ *  and must match the cursor before and after the copy), info texts are
+ *  copied out under the spinlock, as the producer frees them on overwrite.
+ *
+ *  Idle readers block on their task notification with a short timeout,
+ *  the producer only notifies sleeping readers when a quarter of the ring
+ *  has been filled, so wakeups are batched at high message rates.
+ */
+class canlogring
+  {
+  public:
+    canlogring(uint32_t size);
+    ~canlogring();
+
+  public:
+    bool HasReaders() { return m_readermask != 0; }
+    uint32_t GetSize() { return m_size; }
+    uint32_t GetHead() { return m_head; }
+    void Push(CAN_log_message_t& msg);
+
+  public:
+    int AddReader(uint32_t& cursor);
+    void RemoveReader(int reader);
+    bool Read(uint32_t& cursor, CAN_log_message_t& msg, char* textbuf, uint32_t& dropped);
+    void Wait(int reader, uint32_t cursor, TickType_t timeout);
+    uint32_t Pending(uint32_t cursor);
+
+  protected:
+    typedef struct
+      {
+      volatile uint32_t seq;            // CANLOGRING_SEQ of the message stored
+      CAN_log_message_t msg;
+      } entry_t;
+
+  protected:
+    entry_t*            m_entries;
+    uint32_t            m_size;         // power of 2
+    uint32_t            m_mask;
+    volatile uint32_t   m_head;         // sequence number of next message
+    portMUX_TYPE        m_mux;
+    volatile uint32_t   m_readermask;   // bit set = reader slot in use
+    volatile uint32_t   m_sleepers;     // bit set = reader waits for notification
+    uint32_t            m_sleepseq;     // head at first sleeper
+    uint32_t            m_wakeup;       // fill level to notify sleepers at
+    TaskHandle_t        m_readertask[CANLOGRING_MAXREADERS];
+  };
+
 /**
  * canlog is the general interface and base implementation for all can loggers.
  *  It provides standard methods to open files and configure message filters
@@ -40,13 +106,18 @@
  *  to the type list & method Instantiate(). See canlog_trace & canlog_crtd
  *  for examples & reference.
  *
- * Log messages are sent to a canlog through a queue handled by a separate
- *  task for the logger, so logging doesn't affect CAN framework speed and
- *  a log can be written/streamed to a slow medium.
+ * Log messages are read by a separate task for the logger from the shared
+ *  log ring (see canlogring), so logging doesn't affect CAN framework speed
+ *  and a log can be written/streamed to a slow medium. Filters are applied
+ *  by the logger task.
  *
  * Log entries can be frames, status or info messages (see CAN_LogEntry_t).
  * The timestamp of the original event is preserved.
  *
+ * The default OutputMsg() formats messages into a reusable batch buffer,
+ *  which is passed to OutputBatch() when full or when the queue has been
+ *  drained. Stream loggers only need to implement OutputBatch().
+ *
  * Note: loggers get messages for all interfaces, if a log format does not
  *  allow multiple buses within a file, the logger needs to manage a set
  *  of files or may return false on Open() without a bus filter.
@@ -59,7 +130,6 @@ class canlog : public InternalRamAllocated
 
   public:
     static void RxTask(void* context);
-    void EventListener(std::string event, void* data);
 
   public:
     const char* GetType();
@@ -73,16 +143,16 @@ class canlog : public InternalRamAllocated
     virtual bool IsOpen() = 0;
     virtual std::string GetInfo();
     virtual void OutputMsg(CAN_log_message_t& msg);
+    virtual void OutputBatch(const char* data, size_t len, uint32_t msgcount);
+    void FlushBatch();
 
   public:
     virtual void SetFilter(canfilter* filter);
     virtual void ClearFilter();
 
-  public:
-    // Logging API:
-    virtual void LogFrame(canbus* bus, CAN_log_type_t type, const CAN_frame_t* p_frame);
-    virtual void LogStatus(canbus* bus, CAN_log_type_t type, const CAN_status_t* status);
-    virtual void LogInfo(canbus* bus, CAN_log_type_t type, const char* text);
+  protected:
+    bool IsDiscarded(CAN_log_message_t& msg);
+    void StopTask();
 
   public:
     const char*         m_type;
@@ -92,10 +162,19 @@ class canlog : public InternalRamAllocated
 
   public:
     TaskHandle_t        m_task;
-    QueueHandle_t       m_queue;
+    volatile bool       m_taskstop;         // RxTask shall exit
+    canlogring*         m_ring;
+    int                 m_reader;
+    uint32_t            m_cursor;
     uint32_t            m_msgcount;
     uint32_t            m_dropcount;
     uint32_t            m_filtercount;
+
+  protected:
+    char*               m_batch;
+    size_t              m_batchlen;
+    uint32_t            m_batchcount;
+    char*               m_text;
   };
 
 #endif // __CANLOG_H__
@@ -208,24 +208,18 @@ std::string canlog_tcpclient::GetInfo()
   return result;
   }
 
-void canlog_tcpclient::OutputMsg(CAN_log_message_t& msg)
+void canlog_tcpclient::OutputBatch(const char* data, size_t len, uint32_t msgcount)
   {
-  if (m_formatter == NULL) return;
-
   if ((m_mgconn != NULL)&&(m_isopen))
     {
-    std::string result = m_formatter->get(&msg);
-    if (result.length()>0)
+    OvmsMutexLock lock(&m_mgmutex);
+    if (m_mgconn->send_mbuf.len < 4096)
       {
-      OvmsMutexLock lock(&m_mgmutex);
-      if (m_mgconn->send_mbuf.len < 4096)
-        {
-        mg_send(m_mgconn, (const char*)result.c_str(), result.length());
-        }
-      else
-        {
-        m_dropcount++;
-        }
+      mg_send(m_mgconn, data, len);
+      }
+    else
+      {
+      m_dropcount += msgcount;
       }
     }
   }
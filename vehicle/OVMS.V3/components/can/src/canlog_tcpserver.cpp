@@ -30,10 +30,13 @@
 #include "ovms_log.h"
 static const char *TAG = "canlog-tcpserver";
 
+#include <sstream>
+#include <iomanip>
 #include "can.h"
 #include "canformat.h"
 #include "canlog_tcpserver.h"
 #include "ovms_config.h"
+#include "ovms_malloc.h"
 #include "ovms_peripherals.h"
 
 canlog_tcpserver* MyCanLogTcpServer = NULL;
@@ -143,6 +146,96 @@ void tsPutCallback(uint8_t *buffer, size_t len, void* data)
   mg_send(nc, buffer, len);
   }
 
+static void tsReleaseBlock(canlog_tcpserver_block_t* block)
+  {
+  if (--block->refs <= 0)
+    free(block);
+  }
+
+canlog_tcpserver_client::canlog_tcpserver_client(size_t ringsize)
+  {
+  m_ringsize = ringsize;
+  m_ring = new canlog_tcpserver_block_t*[ringsize];
+  m_head = 0;
+  m_count = 0;
+  m_queued = 0;
+  m_queued_max = 0;
+  m_lag = 0;
+  m_lag_max = 0;
+  m_sent = 0;
+  m_dropped = 0;
+  }
+
+canlog_tcpserver_client::~canlog_tcpserver_client()
+  {
+  Clear();
+  delete [] m_ring;
+  }
+
+void canlog_tcpserver_client::Push(canlog_tcpserver_block_t* block)
+  {
+  block->refs++;
+  m_ring[(m_head + m_count) % m_ringsize] = block;
+  m_count++;
+  m_queued += block->len;
+  if (m_queued > m_queued_max)
+    m_queued_max = m_queued;
+  }
+
+/**
+ * DropOldest: discard the oldest queued block, returns its message count
+ */
+uint32_t canlog_tcpserver_client::DropOldest()
+  {
+  if (m_count == 0)
+    return 0;
+  canlog_tcpserver_block_t* block = m_ring[m_head];
+  uint32_t msgcount = block->msgcount;
+  m_head = (m_head + 1) % m_ringsize;
+  m_count--;
+  m_queued -= block->len;
+  m_dropped += msgcount;
+  tsReleaseBlock(block);
+  return msgcount;
+  }
+
+/**
+ * Drain: move queued blocks into the connection send buffer while it is
+ *  below CANLOG_TCPSERVER_SENDLOW
+ */
+void canlog_tcpserver_client::Drain(struct mg_connection *nc)
+  {
+  while (m_count > 0 && nc->send_mbuf.len < CANLOG_TCPSERVER_SENDLOW)
+    {
+    canlog_tcpserver_block_t* block = m_ring[m_head];
+    mg_send(nc, block->Data(), block->len);
+    m_sent += block->len;
+    m_head = (m_head + 1) % m_ringsize;
+    m_count--;
+    m_queued -= block->len;
+    tsReleaseBlock(block);
+    }
+  UpdateLag(nc);
+  }
+
+void canlog_tcpserver_client::Clear()
+  {
+  while (m_count > 0)
+    {
+    tsReleaseBlock(m_ring[m_head]);
+    m_head = (m_head + 1) % m_ringsize;
+    m_count--;
+    }
+  m_queued = 0;
+  }
+
+void canlog_tcpserver_client::UpdateLag(struct mg_connection *nc)
+  {
+  m_lag = (m_count > 0) ? esp_log_timestamp() - m_ring[m_head]->time : 0;
+  if (m_lag > m_lag_max)
+    m_lag_max = m_lag;
+  }
+
 canlog_tcpserver::canlog_tcpserver(std::string path, std::string format, canformat::canformat_serve_mode_t mode)
   : canlog("tcpserver", format, mode)
   {
@@ -155,6 +248,13 @@ canlog_tcpserver::canlog_tcpserver(std::string path, std::string format, canform
   m_isopen = false;
   m_mgconn = NULL;
 
+  m_ringsize = MyConfig.GetParamValueInt("can", "log.tcpserver.ring", 16);
+  if (m_ringsize < 1) m_ringsize = 1;
+  m_policy = (MyConfig.GetParamValue("can", "log.tcpserver.policy", "drop") == "pause") ? Pause : DropOldest;
+  m_pausetime = MyConfig.GetParamValueInt("can", "log.tcpserver.pausetime", 500);
+  m_pausecount = 0;
+  m_pausetime_total = 0;
+
   if (m_formatter)
     {
     m_formatter->SetPutCallback(tsPutCallback);
@@ -206,11 +306,13 @@ void canlog_tcpserver::Close()
   {
   if (m_isopen)
     {
+    OvmsMutexLock lock(&m_mgmutex);
     if (m_smap.size() > 0)
       {
       for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
         {
         it->first->flags |= MG_F_CLOSE_IMMEDIATELY;
+        delete it->second;
         }
       m_smap.clear();
       }
@@ -234,27 +336,114 @@ std::string canlog_tcpserver::GetInfo()
   return result;
   }
 
-void canlog_tcpserver::OutputMsg(CAN_log_message_t& msg)
+std::string canlog_tcpserver::GetStats()
   {
-  if (m_formatter == NULL) return;
+  std::ostringstream buf;
+  buf << canlog::GetStats();
 
-  std::string result = m_formatter->get(&msg);
-  if (result.length()>0)
+  OvmsMutexLock lock(&m_mgmutex);
+  buf << ", clients: " << m_smap.size()
+    << ", policy: " << ((m_policy == Pause) ? "pause" : "drop")
+    << " (" << m_ringsize << " blocks)";
+  if (m_pausecount > 0)
+    buf << ", paused: " << m_pausecount << "x " << m_pausetime_total << " ms";
+  for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
     {
-    OvmsMutexLock lock(&m_mgmutex);
-    for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
+    canlog_tcpserver_client* c = it->second;
+    c->UpdateLag(it->first);
+    buf << "\n    " << c->m_addr
+      << ": sent " << (uint32_t)(c->m_sent / 1024) << " kB"
+      << ", queued " << (c->m_queued + it->first->send_mbuf.len)
+      << " B (ring max " << c->m_queued_max << ")"
+      << ", lag " << c->m_lag << " ms (max " << c->m_lag_max << ")"
+      << ", dropped " << c->m_dropped;
+    }
+  return buf.str();
+  }
+
+/**
+ * ClientsFull: check if any client ring is full
+ */
+bool canlog_tcpserver::ClientsFull()
+  {
+  for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
+    {
+    it->second->Drain(it->first);
+    if (it->second->IsFull())
+      return true;
+    }
+  return false;
+  }
+
+void canlog_tcpserver::OutputBatch(const char* data, size_t len, uint32_t msgcount)
+  {
+  m_mgmutex.Lock();
+
+  if (m_policy == Pause && ClientsFull())
+    {
+    // Backpressure: wait for the clients to catch up
+    uint32_t start = esp_log_timestamp();
+    m_pausecount++;
+    do
+      {
+      m_mgmutex.Unlock();
+      vTaskDelay(pdMS_TO_TICKS(10));
+      m_mgmutex.Lock();
+      } while (ClientsFull() && esp_log_timestamp() - start < m_pausetime);
+    m_pausetime_total += esp_log_timestamp() - start;
+    }
+
+  canlog_tcpserver_block_t* block = NULL;
+  for (ts_map_t::iterator it=m_smap.begin(); it!=m_smap.end(); ++it)
+    {
+    struct mg_connection* nc = it->first;
+    canlog_tcpserver_client* c = it->second;
+    c->Drain(nc);
+    if (c->IsEmpty() && nc->send_mbuf.len < CANLOG_TCPSERVER_SENDLOW)
       {
-      if (it->first->send_mbuf.len < 4096)
+      // Client is keeping up, pass the batch on directly:
+      mg_send(nc, data, len);
+      c->m_sent += len;
+      continue;
+      }
+
+    if (block == NULL)
+      {
+      block = (canlog_tcpserver_block_t*) ExternalRamMalloc(sizeof(canlog_tcpserver_block_t) + len);
+      if (block == NULL)
+        {
+        c->m_dropped += msgcount;
+        m_dropcount += msgcount;
+        continue;
+        }
+      block->refs = 0;
+      block->time = esp_log_timestamp();
+      block->msgcount = msgcount;
+      block->len = len;
+      memcpy(block->Data(), data, len);
+      }
+
+    if (c->IsFull())
+      {
+      if (m_policy == DropOldest)
         {
-        // Limit to 4KB queue on output buffer
-        mg_send(it->first, (const char*)result.c_str(), result.length());
+        m_dropcount += c->DropOldest();
         }
       else
         {
-        m_dropcount++;
+        // Pause timed out: discard the new batch for this client
+        c->m_dropped += msgcount;
+        m_dropcount += msgcount;
+        continue;
         }
       }
+    c->Push(block);
     }
+
+  if (block && block->refs == 0)
+    free(block);
+
+  m_mgmutex.Unlock();
   }
 
 void canlog_tcpserver::MongooseHandler(struct mg_connection *nc, int ev, void *p)
@@ -270,7 +459,9 @@ void canlog_tcpserver::MongooseHandler(struct mg_connection *nc, int ev, void *p
       // New network connection has arrived
       mg_sock_addr_to_str(&nc->sa, addr, sizeof(addr), MG_SOCK_STRINGIFY_IP);
       ESP_LOGI(TAG, "Log service connection from %s",addr);
-      m_smap[nc] = 1;
+      canlog_tcpserver_client* c = new canlog_tcpserver_client(m_ringsize);
+      c->m_addr = addr;
+      m_smap[nc] = c;
       if (m_formatter != NULL)
         {
         std::string result = m_formatter->getheader();
@@ -290,11 +481,22 @@ void canlog_tcpserver::MongooseHandler(struct mg_connection *nc, int ev, void *p
         {
         mg_sock_addr_to_str(&nc->sa, addr, sizeof(addr), MG_SOCK_STRINGIFY_IP);
         ESP_LOGI(TAG, "Log service disconnection from %s",addr);
+        delete k->second;
         m_smap.erase(k);
         }
       break;
       }
 
+    case MG_EV_SEND:
+    case MG_EV_POLL:
+      {
+      // Refill the send buffer from the client ring
+      auto k = m_smap.find(nc);
+      if (k != m_smap.end() && !k->second->IsEmpty())
+        k->second->Drain(nc);
+      break;
+      }
+
     case MG_EV_RECV:
       {
       // Receive data on the network connection
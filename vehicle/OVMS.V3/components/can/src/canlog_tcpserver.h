@@ -36,6 +36,61 @@
 #include "ovms_netmanager.h"
 #include "ovms_mutex.h"
 
+#define CANLOG_TCPSERVER_SENDLOW 4096  // refill client send buffer below this level
+
+/**
+ * canlog_tcpserver fans out the formatted log batches to all connected
+ *  clients. Each batch is copied once into a reference counted block,
+ *  which is queued in a bounded ring per client. The rings are drained
+ *  into the mongoose send buffers as the clients consume the data
+ *  (MG_EV_SEND / MG_EV_POLL), so a slow client does not affect others.
+ *
+ * Ring overflow policy (config can log.tcpserver.policy):
+ *  - "drop": discard the oldest queued block (default)
+ *  - "pause": stall the logger until all clients have room again, for at
+ *    most log.tcpserver.pausetime ms, then discard the new batch; this
+ *    moves the backpressure to the log queue
+ *
+ * All block & ring operations are protected by m_mgmutex.
+ */
+typedef struct canlog_tcpserver_block
+  {
+  int refs;
+  uint32_t time;              // creation time (ms)
+  uint32_t msgcount;
+  size_t len;
+  char* Data() { return (char*)(this + 1); }
+  } canlog_tcpserver_block_t;
+
+class canlog_tcpserver_client
+  {
+  public:
+    canlog_tcpserver_client(size_t ringsize);
+    ~canlog_tcpserver_client();
+
+  public:
+    bool IsEmpty() { return m_count == 0; }
+    bool IsFull() { return m_count == m_ringsize; }
+    void Push(canlog_tcpserver_block_t* block);
+    uint32_t DropOldest();
+    void Drain(struct mg_connection *nc);
+    void Clear();
+    void UpdateLag(struct mg_connection *nc);
+
+  public:
+    std::string m_addr;
+    canlog_tcpserver_block_t** m_ring;
+    size_t m_ringsize;
+    size_t m_head;
+    size_t m_count;
+    size_t m_queued;            // bytes in ring
+    size_t m_queued_max;
+    uint32_t m_lag;             // age of oldest unsent block (ms)
+    uint32_t m_lag_max;
+    uint64_t m_sent;            // bytes passed to mongoose
+    uint32_t m_dropped;         // messages dropped
+  };
+
 class canlog_tcpserver : public canlog
   {
   public:
@@ -47,23 +102,35 @@ class canlog_tcpserver : public canlog
     virtual void Close();
     virtual bool IsOpen();
     virtual std::string GetInfo();
+    virtual std::string GetStats();
 
   public:
-    virtual void OutputMsg(CAN_log_message_t& msg);
+    virtual void OutputBatch(const char* data, size_t len, uint32_t msgcount);
 
   public:
     void MongooseHandler(struct mg_connection *nc, int ev, void *p);
 
+  protected:
+    bool ClientsFull();
+
   public:
-    typedef std::map<mg_connection*, uint8_t> ts_map_t;
+    typedef enum { DropOldest, Pause } drop_policy_t;
+    typedef std::map<mg_connection*, canlog_tcpserver_client*> ts_map_t;
     OvmsMutex m_mgmutex;
     ts_map_t m_smap;
     bool m_isopen;
     struct mg_connection *m_mgconn;
+    size_t m_ringsize;
+    drop_policy_t m_policy;
+    uint32_t m_pausetime;
+    uint32_t m_pausecount;
+    uint32_t m_pausetime_total;
 
   public:
     std::string         m_path;
   };
 
+extern canlog_tcpserver* MyCanLogTcpServer;
+
 #endif // #ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
 #endif // __CANLOG_TCP_SERVER_H__
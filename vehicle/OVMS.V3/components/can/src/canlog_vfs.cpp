@@ -33,6 +33,11 @@ static const char *TAG = "canlog-vfs";
 #include "ovms_utils.h"
 #include "ovms_config.h"
 #include "ovms_peripherals.h"
+#include "ovms_malloc.h"
+#include "esp_timer.h"
+#include <sys/stat.h>
+#include <sstream>
+#include <iomanip>
 
 void can_log_vfs_start(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
@@ -92,6 +97,36 @@ canlog_vfs::canlog_vfs(std::string path, std::string format)
   {
   m_file = NULL;
   m_path = path;
+
+  int blocksize = MyConfig.GetParamValueInt("can", "log.vfs.blocksize", 8);
+  if (blocksize < 4) blocksize = 4;
+  if (blocksize > 16) blocksize = 16;
+  m_blocksize = blocksize * 1024;
+  m_flushtime = MyConfig.GetParamValueInt("can", "log.vfs.flushtime", 2) * 1000;
+  if (m_flushtime == 0) m_flushtime = 1000;
+  m_maxsize = MyConfig.GetParamValueInt("can", "log.vfs.maxsize", 0) * 1024;
+  m_maxage = MyConfig.GetParamValueInt("can", "log.vfs.maxage", 0) * 60000;
+
+  m_block[0] = (char*) ExternalRamMalloc(m_blocksize);
+  m_block[1] = (char*) ExternalRamMalloc(m_blocksize);
+  m_blocklen[0] = m_blocklen[1] = 0;
+  m_active = 0;
+  m_pending = false;
+
+  m_fileseq = 0;
+  m_filesize = 0;
+  m_fileopened = 0;
+  m_opened = 0;
+  m_byteswritten = 0;
+  m_flushcount = 0;
+  m_flushtimesum = 0;
+  m_flushtimemax = 0;
+  m_blockdropcount = 0;
+  m_writeerrors = 0;
+
+  m_writerstop = false;
+  xTaskCreatePinnedToCore(WriterTask, "OVMS CanLogVFS", 4096, (void*)this, 9, &m_writertask, CORE(1));
+
   using std::placeholders::_1;
   using std::placeholders::_2;
   MyEvents.RegisterEvent(IDTAG, "sd.mounted", std::bind(&canlog_vfs::MountListener, this, _1, _2));
@@ -102,14 +137,47 @@ canlog_vfs::~canlog_vfs()
   {
   MyEvents.DeregisterEvent(IDTAG);
 
+  // Stop the logger task first, as it feeds our blocks:
+  StopTask();
+
+  if (m_writertask)
+    {
+    m_writerstop = true;
+    xTaskNotifyGive(m_writertask);
+    while (m_writertask)
+      vTaskDelay(1);
+    }
+
   if (m_file != NULL)
     {
     Close();
     }
+
+  free(m_block[0]);
+  free(m_block[1]);
+  }
+
+std::string canlog_vfs::GetFilePath(int seq)
+  {
+  if (seq == 0)
+    return m_path;
+
+  // Insert sequence number before the extension:
+  char num[8];
+  snprintf(num, sizeof(num), "-%04d", seq);
+  size_t dot = m_path.find_last_of('.');
+  size_t slash = m_path.find_last_of('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return m_path + num;
+  std::string path = m_path;
+  path.insert(dot, num);
+  return path;
   }
 
 bool canlog_vfs::Open()
   {
+  OvmsMutexLock lock(&m_filemutex);
+
   if (m_file)
     {
     fclose(m_file);
@@ -130,30 +198,77 @@ bool canlog_vfs::Open()
     }
 #endif // #ifdef CONFIG_OVMS_COMP_SDCARD
 
-  m_file = fopen(m_path.c_str(), "w");
+  // Rotation: continue with the next free sequence number
+  m_fileseq = 0;
+  if (m_maxsize || m_maxage)
+    {
+    struct stat st;
+    for (m_fileseq = 1; m_fileseq < 9999; m_fileseq++)
+      {
+      if (stat(GetFilePath(m_fileseq).c_str(), &st) != 0)
+        break;
+      }
+    }
+
+  if (!OpenFile())
+    return false;
+
+  m_opened = m_fileopened;
+  m_byteswritten = 0;
+  m_flushcount = 0;
+  m_flushtimesum = 0;
+  m_flushtimemax = 0;
+  m_blockdropcount = 0;
+
+  return true;
+  }
+
+/**
+ * OpenFile: open m_fileseq log file & write header (m_filemutex locked by caller)
+ */
+bool canlog_vfs::OpenFile()
+  {
+  m_filepath = GetFilePath(m_fileseq);
+  m_file = fopen(m_filepath.c_str(), "w");
   if (!m_file)
     {
-    ESP_LOGE(TAG, "Error: Can't write to '%s'", m_path.c_str());
+    ESP_LOGE(TAG, "Error: Can't write to '%s'", m_filepath.c_str());
     return false;
     }
 
-  ESP_LOGI(TAG, "Now logging CAN messages to '%s'", m_path.c_str());
+  ESP_LOGI(TAG, "Now logging CAN messages to '%s'", m_filepath.c_str());
+
+  m_filesize = 0;
+  m_fileopened = esp_timer_get_time();
 
   std::string header = m_formatter->getheader();
   if (header.length()>0)
-    fwrite(header.c_str(),header.length(),1,m_file);
+    {
+    if (fwrite(header.c_str(),1,header.length(),m_file) == header.length())
+      m_filesize += header.length();
+    else
+      {
+      m_writeerrors++;
+      ESP_LOGE(TAG, "Error: header write to '%s' failed", m_filepath.c_str());
+      }
+    }
 
   return true;
   }
 
 void canlog_vfs::Close()
   {
+  // Write pending & active block:
+  WriteBlock(true);
+  WriteBlock(true);
+
+  OvmsMutexLock lock(&m_filemutex);
   if (m_file)
     {
     fclose(m_file);
     m_file = NULL;
     ESP_LOGI(TAG, "Closed vfs log '%s': %s",
-      m_path.c_str(), GetStats().c_str());
+      m_filepath.c_str(), GetStats().c_str());
     }
   }
 
@@ -167,9 +282,38 @@ std::string canlog_vfs::GetInfo()
   std::string result = canlog::GetInfo();
   result.append(" Path:");
   result.append(m_path);
+  if (m_fileseq)
+    {
+    result.append(" File:");
+    result.append(m_filepath);
+    }
   return result;
   }
 
+std::string canlog_vfs::GetStats()
+  {
+  std::ostringstream buf;
+
+  buf << canlog::GetStats();
+
+  int64_t elapsed = (m_opened) ? (esp_timer_get_time() - m_opened) : 0;
+  buf << ", written: " << m_byteswritten << " bytes";
+  if (elapsed > 0)
+    buf << " = " << (uint32_t)(m_byteswritten * 1000000 / elapsed) << " B/s";
+  if (m_flushcount > 0)
+    {
+    buf << ", flush avg: " << std::fixed << std::setprecision(1)
+      << (float) m_flushtimesum / m_flushcount / 1000 << " ms"
+      << ", max: " << (float) m_flushtimemax / 1000 << " ms";
+    }
+  if (m_blockdropcount > 0)
+    buf << ", writer lag drops: " << m_blockdropcount;
+  if (m_writeerrors > 0)
+    buf << ", write errors: " << m_writeerrors;
+
+  return buf.str();
+  }
+
 void canlog_vfs::MountListener(std::string event, void* data)
   {
   if (event == "sd.unmounting" && startsWith(m_path, "/sd"))
@@ -178,12 +322,101 @@ void canlog_vfs::MountListener(std::string event, void* data)
     Open();
   }
 
-void canlog_vfs::OutputMsg(CAN_log_message_t& msg)
+void canlog_vfs::OutputBatch(const char* data, size_t len, uint32_t msgcount)
   {
   if (m_file == NULL) return;
-  if (m_formatter == NULL) return;
 
-  std::string result = m_formatter->get(&msg);
-  if (result.length()>0)
-    fwrite(result.c_str(),result.length(),1,m_file);
+  OvmsMutexLock lock(&m_blockmutex);
+  if (m_blocklen[m_active] + len > m_blocksize)
+    {
+    if (m_pending)
+      {
+      // Writer still busy with the other block:
+      m_dropcount += msgcount;
+      m_blockdropcount += msgcount;
+      return;
+      }
+    m_pending = true;
+    m_active = 1 - m_active;
+    if (m_writertask)
+      xTaskNotifyGive(m_writertask);
+    }
+  memcpy(m_block[m_active] + m_blocklen[m_active], data, len);
+  m_blocklen[m_active] += len;
+  }
+
+void canlog_vfs::WriterTask(void *context)
+  {
+  canlog_vfs* me = (canlog_vfs*) context;
+  while (!me->m_writerstop)
+    {
+    // Woken for a full block, else write partial data after the flush time:
+    bool full = (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(me->m_flushtime)) > 0);
+    if (!me->m_writerstop)
+      me->WriteBlock(!full);
+    }
+  me->m_writertask = NULL;
+  vTaskDelete(NULL);
+  }
+
+/**
+ * WriteBlock: write the pending block, if partial also a non-empty active block,
+ *  then check for file rotation
+ *  The file lock is held until the block is released, so concurrent callers
+ *  (writer task, Close()) cannot write the same block twice.
+ */
+void canlog_vfs::WriteBlock(bool partial)
+  {
+  OvmsMutexLock filelock(&m_filemutex);
+
+  m_blockmutex.Lock();
+  if (!m_pending && partial && m_blocklen[m_active] > 0)
+    {
+    m_pending = true;
+    m_active = 1 - m_active;
+    }
+  bool pending = m_pending;
+  int idx = 1 - m_active;
+  m_blockmutex.Unlock();
+
+  if (pending)
+    {
+    size_t len = m_blocklen[idx];
+    if (m_file && len > 0)
+      {
+      int64_t started = esp_timer_get_time();
+      bool ok = (fwrite(m_block[idx], 1, len, m_file) == len);
+      ok = (fflush(m_file) == 0) && ok;
+      uint32_t elapsed = esp_timer_get_time() - started;
+      m_flushcount++;
+      m_flushtimesum += elapsed;
+      if (elapsed > m_flushtimemax) m_flushtimemax = elapsed;
+      if (ok)
+        {
+        m_filesize += len;
+        m_byteswritten += len;
+        }
+      else
+        {
+        m_writeerrors++;
+        ESP_LOGE(TAG, "Error: write of %u bytes to '%s' failed", (unsigned)len, m_filepath.c_str());
+        }
+      }
+
+    m_blockmutex.Lock();
+    m_blocklen[idx] = 0;
+    m_pending = false;
+    m_blockmutex.Unlock();
+    }
+
+  if (m_file && m_fileseq &&
+      ((m_maxsize && m_filesize >= m_maxsize) ||
+       (m_maxage && esp_timer_get_time() - m_fileopened >= (int64_t)m_maxage * 1000)))
+    {
+    // m_file stays non-NULL while rotating, so OutputBatch() keeps filling blocks:
+    fclose(m_file);
+    ESP_LOGI(TAG, "Rotating vfs log '%s' (%u bytes)", m_filepath.c_str(), (unsigned)m_filesize);
+    m_fileseq++;
+    OpenFile();
+    }
   }
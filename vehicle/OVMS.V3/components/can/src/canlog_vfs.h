@@ -29,7 +29,21 @@
 #define __CANLOG_VFS_H__
 
 #include "canlog.h"
+#include "ovms_mutex.h"
 
+/**
+ * canlog_vfs writes log output through a pair of blocks (write behind):
+ *  the logger task fills the active block, a separate writer task writes
+ *  full blocks (or partial blocks after the flush time) to the file.
+ *  Optionally the log is rotated by size and/or age, files are then
+ *  numbered sequentially (<path-base>-<nnnn>.<ext>).
+ *
+ * Config (section "can"):
+ *  log.vfs.blocksize   block size in KB (4-16, default 8)
+ *  log.vfs.flushtime   max time to hold data in seconds (default 2)
+ *  log.vfs.maxsize     rotate after file size in KB (default 0 = off)
+ *  log.vfs.maxage      rotate after file age in minutes (default 0 = off)
+ */
 class canlog_vfs : public canlog
   {
   public:
@@ -41,9 +55,18 @@ class canlog_vfs : public canlog
     virtual void Close();
     virtual bool IsOpen();
     virtual std::string GetInfo();
+    virtual std::string GetStats();
 
   public:
-    virtual void OutputMsg(CAN_log_message_t& msg);
+    virtual void OutputBatch(const char* data, size_t len, uint32_t msgcount);
+
+  public:
+    static void WriterTask(void* context);
+
+  protected:
+    bool OpenFile();
+    void WriteBlock(bool partial);
+    std::string GetFilePath(int seq);
 
   public:
     virtual void MountListener(std::string event, void* data);
@@ -51,6 +74,33 @@ class canlog_vfs : public canlog
   public:
     std::string         m_path;
     FILE*               m_file;
+
+  protected:
+    OvmsMutex           m_blockmutex;       // protects block switching
+    OvmsMutex           m_filemutex;        // protects file access
+    TaskHandle_t        m_writertask;
+    volatile bool       m_writerstop;       // WriterTask shall exit
+    char*               m_block[2];
+    size_t              m_blocklen[2];
+    size_t              m_blocksize;
+    int                 m_active;           // block being filled
+    bool                m_pending;          // other block waiting to be written
+    uint32_t            m_flushtime;        // [ms]
+    size_t              m_maxsize;          // [bytes], 0 = no size rotation
+    uint32_t            m_maxage;           // [ms], 0 = no age rotation
+
+  protected:
+    std::string         m_filepath;         // current file
+    int                 m_fileseq;          // current file sequence number, 0 = no rotation
+    size_t              m_filesize;
+    int64_t             m_fileopened;       // [us]
+    int64_t             m_opened;           // [us]
+    uint64_t            m_byteswritten;
+    uint32_t            m_flushcount;
+    int64_t             m_flushtimesum;     // [us]
+    uint32_t            m_flushtimemax;     // [us]
+    uint32_t            m_blockdropcount;   // messages dropped due to writer lagging
+    uint32_t            m_writeerrors;      // failed block writes
   };
 
 #endif // __CANLOG_VFS_H__
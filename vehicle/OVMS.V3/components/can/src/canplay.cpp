@@ -35,6 +35,7 @@ static const char *TAG = "canplay";
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include "esp_timer.h"
 #include "ovms_config.h"
 #include "ovms_command.h"
 #include "ovms_events.h"
@@ -182,7 +183,8 @@ OvmsCanPlayInit::OvmsCanPlayInit()
 
   OvmsCommand* cmd_canplay = cmd_can->RegisterCommand("play", "CAN play framework");
   cmd_canplay->RegisterCommand("stop", "Stop playing", can_play_stop,"[<id>]",0,1);
-  cmd_canplay->RegisterCommand("speed", "Set playback speed", can_play_speed,"<speed> [<id>]",1,2);
+  cmd_canplay->RegisterCommand("speed", "Set playback speed", can_play_speed,"<speed> [<id>]\n"
+    "Speed: 1..n = time scale factor, 0 = as fast as possible",1,2);
   cmd_canplay->RegisterCommand("status", "Playing status", can_play_status,"[<id>]",0,1);
   cmd_canplay->RegisterCommand("list", "Playing list", can_play_list);
   cmd_canplay->RegisterCommand("start", "CAN play start framework");
@@ -202,16 +204,23 @@ canplay::canplay(const char* type, std::string format, canformat::canformat_serv
   m_speed = 1;
 
   m_msgcount = 0;
+  m_filtercount = 0;
+  m_rebase = true;
+  m_starttime = 0;
+  m_endtime = 0;
+  m_jittersum = 0;
+  m_jittercount = 0;
+  m_jittermax = 0;
+  m_task = NULL;
+  m_taskstop = false;
+  m_playstop = false;
+  m_playing = false;
   xTaskCreatePinnedToCore(PlayTask, "OVMS CanPlay", 4096, (void*)this, 10, &m_task, CORE(1));
   }
 
 canplay::~canplay()
   {
-  if (m_task)
-    {
-    vTaskDelete(m_task);
-    m_task = NULL;
-    }
+  StopTask();
 
   if (m_formatter)
     {
@@ -228,19 +237,138 @@ canplay::~canplay()
 
 void canplay::PlayTask(void *context)
   {
-//  canplay* me = (canplay*) context;
+  canplay* me = (canplay*) context;
+  while (!me->m_taskstop)
+    {
+    // Wait for Start():
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (me->m_playing)
+      {
+      me->PlayMessages();
+      me->m_playing = false;
+      }
+    }
+  me->m_task = NULL;
+  vTaskDelete(NULL);
+  }
 
-//  CAN_log_message_t msg;
-//  while (me->InputMsg(&msg))
-//    {
-//    vTaskDelay(pdMS_TO_TICKS(1000));
-//    }
+void canplay::Start()
+  {
+  if (m_task == NULL)
+    return;
+  m_playstop = false;
+  m_playing = true;
+  xTaskNotifyGive(m_task);
+  }
 
-//  me->Close();
-  while(1)
+/**
+ * Stop: let the player task return from PlayMessages() & wait for it
+ *  The player task closes the input on return.
+ */
+void canplay::Stop()
+  {
+  if (m_task == NULL)
+    return;
+  m_playstop = true;
+  xTaskNotifyGive(m_task);
+  while (m_playing)
+    vTaskDelay(1);
+  }
+
+/**
+ * StopTask: stop playing, let the player task exit & wait for it
+ */
+void canplay::StopTask()
+  {
+  if (m_task == NULL)
+    return;
+  Stop();
+  m_taskstop = true;
+  xTaskNotifyGive(m_task);
+  while (m_task)
+    vTaskDelay(1);
+  }
+
+void canplay::PlayMessages()
+  {
+  CAN_log_message_t msg;
+  int64_t base_ts = 0, base_time = 0, last_yield;
+
+  m_msgcount = 0;
+  m_filtercount = 0;
+  m_jittersum = 0;
+  m_jittercount = 0;
+  m_jittermax = 0;
+  m_rebase = true;
+  m_endtime = 0;
+  m_starttime = last_yield = esp_timer_get_time();
+
+  while (!m_playstop && InputMsg(&msg))
     {
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    if ((msg.type != CAN_LogFrame_RX && msg.type != CAN_LogFrame_TX) || msg.frame.origin == NULL)
+      continue;
+    if (m_filter && !m_filter->IsFiltered(&msg.frame))
+      {
+      m_filtercount++;
+      continue;
+      }
+
+    int64_t now = esp_timer_get_time();
+    uint32_t speed = m_speed;
+    if (speed > 0)
+      {
+      // Pace by recorded timestamp; re-sync on speed change & timestamp wrap:
+      int64_t ts = (int64_t)msg.timestamp.tv_sec * 1000000 + msg.timestamp.tv_usec;
+      if (m_rebase || ts < base_ts)
+        {
+        base_ts = ts;
+        base_time = now;
+        m_rebase = false;
+        }
+      int64_t due = base_time + (ts - base_ts) / speed;
+      // Delay by the nearest number of ticks, limiting the deviation to half
+      // a tick (truncating would send frames up to a full tick early).
+      // Stop() wakes us up early:
+      while (due - now >= CANPLAY_TICK_US/2 && !m_playstop)
+        {
+        ulTaskNotifyTake(pdTRUE, (due - now + CANPLAY_TICK_US/2) / CANPLAY_TICK_US);
+        now = last_yield = esp_timer_get_time();
+        }
+      if (m_playstop)
+        break;
+      uint32_t jitter = (now > due) ? (now - due) : (due - now);
+      m_jittersum += jitter;
+      m_jittercount++;
+      if (jitter > m_jittermax) m_jittermax = jitter;
+      }
+    else
+      {
+      // Max speed: let lower priority tasks run once per 100 ms:
+      m_rebase = true;
+      if (now - last_yield > 100000)
+        {
+        vTaskDelay(1);
+        last_yield = esp_timer_get_time();
+        }
+      }
+
+    switch (m_formatter->GetServeMode())
+      {
+      case canformat::Simulate:
+        msg.frame.timestamp = esp_timer_get_time();
+        MyCan.IncomingFrame(&msg.frame);
+        break;
+      case canformat::Transmit:
+        msg.frame.origin->Write(&msg.frame);
+        break;
+      default:
+        break;
+      }
+    m_msgcount++;
     }
+
+  m_endtime = esp_timer_get_time();
+  Close();
   }
 
 const char* canplay::GetType()
@@ -256,6 +384,7 @@ const char* canplay::GetFormat()
 void canplay::SetSpeed(uint32_t speed)
   {
   m_speed = speed;
+  m_rebase = true;
   }
 
 bool canplay::InputMsg(CAN_log_message_t* msg)
@@ -273,7 +402,10 @@ std::string canplay::GetInfo()
     buf << "(" << m_formatter->GetServeModeName() << ")";
     }
 
-  buf << " Speed:" << m_speed << "x";
+  if (m_speed)
+    buf << " Speed:" << m_speed << "x";
+  else
+    buf << " Speed:max";
 
   if (m_filter)
     {
@@ -291,7 +423,17 @@ std::string canplay::GetStats()
   {
   std::ostringstream buf;
 
-  buf << "total messages: " << m_msgcount;
+  int64_t elapsed = (m_endtime ? m_endtime : esp_timer_get_time()) - m_starttime;
+  float rate = (m_starttime && elapsed > 0) ? ((float) m_msgcount * 1000000 / elapsed) : 0;
+
+  buf << "total messages: " << m_msgcount
+    << ", filtered: " << m_filtercount
+    << ", rate: " << std::fixed << std::setprecision(1) << rate << " fps";
+  if (m_jittercount > 0)
+    {
+    buf << ", jitter avg: " << (uint32_t)(m_jittersum / m_jittercount) << " us"
+      << ", max: " << m_jittermax << " us";
+    }
 
   return buf.str();
   }
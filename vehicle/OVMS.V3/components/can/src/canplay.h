@@ -31,8 +31,15 @@
 #include "can.h"
 #include "canformat.h"
 
+#define CANPLAY_TICK_US (portTICK_PERIOD_MS * 1000)
+
 /**
  * canplay is the general interface and base implementation for all can players.
+ *
+ * Messages are read by the player task through InputMsg() and paced by their
+ *  recorded timestamps, scaled by the playback speed (1 = real time, 0 = as
+ *  fast as possible). Frames passing the filter are injected according to the
+ *  formatter serve mode (simulate = MyCan.IncomingFrame, transmit = bus write).
  */
 class canplay : public InternalRamAllocated
   {
@@ -42,6 +49,12 @@ class canplay : public InternalRamAllocated
 
   public:
     static void PlayTask(void* context);
+    void Start();
+    void Stop();
+    void StopTask();
+
+  protected:
+    void PlayMessages();
 
   public:
     const char* GetType();
@@ -70,7 +83,17 @@ class canplay : public InternalRamAllocated
 
   public:
     TaskHandle_t        m_task;
+    volatile bool       m_taskstop;         // PlayTask shall exit
+    volatile bool       m_playstop;         // PlayMessages shall return
+    volatile bool       m_playing;          // PlayMessages started / running
     uint32_t            m_msgcount;
+    uint32_t            m_filtercount;
+    bool                m_rebase;           // re-sync pacing on next frame
+    int64_t             m_starttime;        // playback start [us]
+    int64_t             m_endtime;          // playback end [us], 0 = running
+    int64_t             m_jittersum;        // sum of pacing deviations [us]
+    uint32_t            m_jittercount;      // number of paced frames
+    uint32_t            m_jittermax;        // max pacing deviation [us]
   };
 
 #endif // __CANPLAY_H__
@@ -91,6 +91,8 @@ canplay_vfs::canplay_vfs(std::string path, std::string format)
   {
   m_file = NULL;
   m_path = path;
+  m_rdpos = 0;
+  m_rdlen = 0;
   using std::placeholders::_1;
   using std::placeholders::_2;
   MyEvents.RegisterEvent(IDTAG, "sd.mounted", std::bind(&canplay_vfs::MountListener, this, _1, _2));
@@ -101,6 +103,9 @@ canplay_vfs::~canplay_vfs()
   {
   MyEvents.DeregisterEvent(IDTAG);
 
+  // Stop the player task first, as it reads from our file:
+  StopTask();
+
   if (m_file != NULL)
     {
     Close();
@@ -129,6 +134,8 @@ bool canplay_vfs::Open()
     }
 #endif // #ifdef CONFIG_OVMS_COMP_SDCARD
 
+  m_rdpos = 0;
+  m_rdlen = 0;
   m_file = fopen(m_path.c_str(), "r");
   if (!m_file)
     {
@@ -168,9 +175,15 @@ std::string canplay_vfs::GetInfo()
 void canplay_vfs::MountListener(std::string event, void* data)
   {
   if (event == "sd.unmounting" && startsWith(m_path, "/sd"))
-    Close();
+    {
+    // The player task closes the file:
+    Stop();
+    }
   else if (event == "sd.mounted" && startsWith(m_path, "/sd"))
-    Open();
+    {
+    if (!m_playing && Open())
+      Start();
+    }
   }
 
 bool canplay_vfs::InputMsg(CAN_log_message_t* msg)
@@ -178,5 +191,29 @@ bool canplay_vfs::InputMsg(CAN_log_message_t* msg)
   if (m_file == NULL) return false;
   if (m_formatter == NULL) return false;
 
-  return false;
+  while (1)
+    {
+    // put() converts at most one record per call, so keep calling it while
+    // it makes progress (input consumed or a buffered record converted), and
+    // only read more from the file once its buffer holds no complete record.
+    // This also drains the frames still buffered when reaching EOF:
+    size_t buffered = m_formatter->GetBuffered();
+    memset(msg, 0, sizeof(*msg));
+    size_t used = m_formatter->put(msg, m_rdbuf + m_rdpos, m_rdlen - m_rdpos);
+    m_rdpos += used;
+    if (msg->frame.origin != NULL)
+      return true;
+    if (used > 0 || m_formatter->GetBuffered() != buffered)
+      continue;
+    if (m_rdpos < m_rdlen)
+      return false; // formatter stalled
+    if (m_formatter->IsServeDiscarding())
+      return false;
+
+    // The formatter needs more input:
+    if (m_file == NULL) return false;
+    m_rdlen = fread(m_rdbuf, 1, sizeof(m_rdbuf), m_file);
+    m_rdpos = 0;
+    if (m_rdlen == 0) return false;
+    }
   }
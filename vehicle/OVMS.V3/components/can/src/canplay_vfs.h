@@ -30,6 +30,8 @@
 
 #include "canplay.h"
 
+#define CANPLAY_VFS_READSIZE 512
+
 class canplay_vfs : public canplay
   {
   public:
@@ -51,6 +53,11 @@ class canplay_vfs : public canplay
   public:
     std::string         m_path;
     FILE*               m_file;
+
+  protected:
+    uint8_t             m_rdbuf[CANPLAY_VFS_READSIZE];
+    size_t              m_rdpos;
+    size_t              m_rdlen;
   };
 
 #endif // __CANPLAY_VFS_H__
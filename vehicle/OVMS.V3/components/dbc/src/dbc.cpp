@@ -935,6 +935,224 @@ void dbcSignal::WriteFileValues(dbcOutputCallback callback,
     }
   }
 
+////////////////////////////////////////////////////////////////////////
+// dbcDecodePlan
+
+dbcDecodePlan::dbcDecodePlan(dbcMessage* message)
+  {
+  m_plain = 0;
+  m_hasmux = false;
+  Compile(message);
+  }
+
+dbcDecodePlan::~dbcDecodePlan()
+  {
+  }
+
+void dbcDecodePlan::Compile(dbcMessage* message)
+  {
+  dbcSignal* mux = message->GetMultiplexorSignal();
+  if (mux)
+    {
+    m_hasmux = true;
+    CompileStep(mux, &m_mux);
+    }
+
+  // Plain signals (including the multiplexor):
+  std::vector<dbcSignal*> muxed;
+  for (dbcSignal* sig : message->m_signals)
+    {
+    if (mux && sig->IsMultiplexSwitch())
+      {
+      muxed.push_back(sig);
+      }
+    else
+      {
+      dbcDecodeStep_t step;
+      CompileStep(sig, &step);
+      m_steps.push_back(step);
+      }
+    }
+  m_plain = m_steps.size();
+
+  // Multiplexed signals grouped by switch value:
+  std::stable_sort(muxed.begin(), muxed.end(), [](dbcSignal* a, dbcSignal* b)
+    { return a->GetMultiplexSwitchvalue() < b->GetMultiplexSwitchvalue(); });
+  for (dbcSignal* sig : muxed)
+    {
+    uint32_t switchvalue = sig->GetMultiplexSwitchvalue();
+    if (m_groups.empty() || m_groups.back().switchvalue != switchvalue)
+      m_groups.push_back({ switchvalue, (uint16_t)m_steps.size(), 0 });
+    m_groups.back().count++;
+    dbcDecodeStep_t step;
+    CompileStep(sig, &step);
+    m_steps.push_back(step);
+    }
+  }
+
+void dbcDecodePlan::CompileStep(dbcSignal* signal, dbcDecodeStep_t* step)
+  {
+  memset(step, 0, sizeof(*step));
+  step->signal = signal;
+
+  int size = signal->GetSignalSize();
+  int start = signal->GetStartBit();
+  int shift;
+  step->bigendian = (signal->GetByteOrder() == DBC_BYTEORDER_BIG_ENDIAN);
+  if (step->bigendian)
+    {
+    // Motorola: start bit is the MSB, count from the LSB of the big endian payload:
+    int msb = (7 - start / 8) * 8 + (start % 8);
+    shift = msb - size + 1;
+    }
+  else
+    {
+    shift = start;
+    }
+  if (size < 1 || size > 64 || shift < 0 || shift + size > 64)
+    {
+    step->generic = true;
+    return;
+    }
+
+  step->shift = shift;
+  step->mask = (size == 64) ? UINT64_MAX : ((1ULL << size) - 1);
+  if (signal->GetValueType() == DBC_VALUETYPE_SIGNED)
+    step->signbit = 1ULL << (size - 1);
+
+  dbcNumber factor = signal->GetFactor();
+  dbcNumber offset = signal->GetOffset();
+  step->dfactor = factor.GetDouble();
+  step->doffset = offset.GetDouble();
+  step->ifactor = factor.GetSignedInteger();
+  step->ioffset = offset.GetSignedInteger();
+  step->isdouble = (size > 32 || factor.IsDouble() || offset.IsDouble());
+
+  // Use the integer path only if the scaled value range fits 32 bits:
+  if (!step->isdouble)
+    {
+    double range = (double)step->mask * fabs(step->dfactor) + fabs(step->doffset);
+    if (step->signbit || step->ifactor < 0 || step->ioffset < 0)
+      step->isdouble = (range > (double)INT32_MAX);
+    else
+      step->isdouble = (range > (double)UINT32_MAX);
+    }
+  }
+
+inline dbcNumber dbcDecodePlan::Extract(const dbcDecodeStep_t* step, CAN_frame_t* frame, uint64_t le, uint64_t be)
+  {
+  if (step->generic)
+    return step->signal->Decode(frame);
+
+  uint64_t raw = ((step->bigendian ? be : le) >> step->shift) & step->mask;
+  if (step->isdouble)
+    {
+    double val = (step->signbit && (raw & step->signbit))
+      ? (double)(int64_t)(raw | ~step->mask)
+      : (double)raw;
+    return dbcNumber(val * step->dfactor + step->doffset);
+    }
+  else if (step->signbit || step->ifactor < 0 || step->ioffset < 0)
+    {
+    int32_t val = (int32_t)(uint32_t)raw;
+    if (step->signbit && (raw & step->signbit))
+      val = (int32_t)(uint32_t)(raw | ~step->mask);
+    return dbcNumber((int32_t)(val * step->ifactor + step->ioffset));
+    }
+  else
+    {
+    return dbcNumber((uint32_t)((uint32_t)raw * step->ifactor + step->ioffset));
+    }
+  }
+
+const dbcDecodeGroup_t* dbcDecodePlan::FindGroup(uint32_t switchvalue)
+  {
+  auto it = std::lower_bound(m_groups.begin(), m_groups.end(), switchvalue,
+    [](const dbcDecodeGroup_t& g, uint32_t v) { return g.switchvalue < v; });
+  if (it == m_groups.end() || it->switchvalue != switchvalue)
+    return NULL;
+  return &(*it);
+  }
+
+/**
+ * Decode: decode all signals applicable to the frame, pass results to callback
+ *  Returns the number of signals decoded.
+ */
+int dbcDecodePlan::Decode(CAN_frame_t* frame, dbcDecodeCallback callback, void* param)
+  {
+  uint64_t le = frame->data.u64;
+  uint64_t be = __builtin_bswap64(le);
+  dbcNumber value;
+  int count = 0;
+
+  for (int k = 0; k < m_plain; k++)
+    {
+    value = Extract(&m_steps[k], frame, le, be);
+    callback(param, m_steps[k].signal, value);
+    count++;
+    }
+
+  if (m_hasmux)
+    {
+    uint32_t switchvalue = Extract(&m_mux, frame, le, be).GetUnsignedInteger();
+    const dbcDecodeGroup_t* group = FindGroup(switchvalue);
+    if (group)
+      {
+      for (int k = group->first; k < group->first + group->count; k++)
+        {
+        value = Extract(&m_steps[k], frame, le, be);
+        callback(param, m_steps[k].signal, value);
+        count++;
+        }
+      }
+    }
+
+  return count;
+  }
+
+/**
+ * DecodeMetrics: decode signals with assigned metrics & set the metric values
+ *  Returns the number of metrics set.
+ */
+int dbcDecodePlan::DecodeMetrics(CAN_frame_t* frame)
+  {
+  uint64_t le = frame->data.u64;
+  uint64_t be = __builtin_bswap64(le);
+  OvmsMetric* m;
+  dbcNumber value;
+  int count = 0;
+
+  for (int k = 0; k < m_plain; k++)
+    {
+    if ((m = m_steps[k].signal->GetMetric()) != NULL)
+      {
+      value = Extract(&m_steps[k], frame, le, be);
+      m->SetValue(value);
+      count++;
+      }
+    }
+
+  if (m_hasmux)
+    {
+    uint32_t switchvalue = Extract(&m_mux, frame, le, be).GetUnsignedInteger();
+    const dbcDecodeGroup_t* group = FindGroup(switchvalue);
+    if (group)
+      {
+      for (int k = group->first; k < group->first + group->count; k++)
+        {
+        if ((m = m_steps[k].signal->GetMetric()) != NULL)
+          {
+          value = Extract(&m_steps[k], frame, le, be);
+          m->SetValue(value);
+          count++;
+          }
+        }
+      }
+    }
+
+  return count;
+  }
+
 ////////////////////////////////////////////////////////////////////////
 // dbcMessage...
 
@@ -943,17 +1161,21 @@ dbcMessage::dbcMessage()
   m_id = 0;
   m_size = 0;
   m_multiplexor = NULL;
+  m_plan = NULL;
   }
 
 dbcMessage::dbcMessage(uint32_t id)
   {
   m_size = 0;
   m_multiplexor = NULL;
+  m_plan = NULL;
   m_id = id;
   }
 
 dbcMessage::~dbcMessage()
   {
+  if (m_plan)
+    delete m_plan;
   }
 
 void dbcMessage::AddComment(const std::string& comment)
@@ -1101,6 +1323,28 @@ void dbcMessage::SetMultiplexorSignal(dbcSignal* signal)
     }
   }
 
+/**
+ * GetPlan: get the precompiled decoder, NULL if not compiled yet
+ *  Plans are built by dbcMessageTable::Compile(), which needs to be called
+ *  after any message or signal change. Signals referenced by the current
+ *  plan must not be freed before the recompilation.
+ */
+dbcDecodePlan* dbcMessage::GetPlan()
+  {
+  return m_plan;
+  }
+
+/**
+ * SwapPlan: install a new plan, returns the previous one
+ *  Called by dbcMessageTable::Compile() with the table locked.
+ */
+dbcDecodePlan* dbcMessage::SwapPlan(dbcDecodePlan* plan)
+  {
+  dbcDecodePlan* old = m_plan;
+  m_plan = plan;
+  return old;
+  }
+
 void dbcMessage::WriteFile(dbcOutputCallback callback, void* param)
   {
   std::ostringstream ss;
@@ -1153,6 +1397,7 @@ void dbcMessage::WriteFileValues(dbcOutputCallback callback, void* param)
 
 dbcMessageTable::dbcMessageTable()
   {
+  m_indexvalid = false;
   }
 
 dbcMessageTable::~dbcMessageTable()
@@ -1162,11 +1407,17 @@ dbcMessageTable::~dbcMessageTable()
 
 void dbcMessageTable::AddMessage(uint32_t id, dbcMessage* message)
   {
+  OvmsMutexLock lock(&m_mutex);
+  m_indexvalid = false;
+  m_index.clear();
   m_entrymap[id] = message;
   }
 
 void dbcMessageTable::RemoveMessage(uint32_t id, bool free)
   {
+  OvmsMutexLock lock(&m_mutex);
+  m_indexvalid = false;
+  m_index.clear();
   auto search = m_entrymap.find(id);
   if (search != m_entrymap.end())
     {
@@ -1191,13 +1442,86 @@ dbcMessage* dbcMessageTable::FindMessage(CAN_frame_format_t format, uint32_t id)
   else
     id &= 0x7FFFFFFF;
 
-  auto search = m_entrymap.find(id);
-  if (search != m_entrymap.end())
-    return search->second;
+  OvmsMutexLock lock(&m_mutex);
+  return LookupMessage(id);
+  }
+
+/**
+ * LookupMessage: find message by table key, caller needs to hold the lock
+ *  Uses the sorted index, falls back to the map while the index is invalid.
+ */
+dbcMessage* dbcMessageTable::LookupMessage(uint32_t key)
+  {
+  if (!m_indexvalid)
+    {
+    auto search = m_entrymap.find(key);
+    return (search != m_entrymap.end()) ? search->second : NULL;
+    }
+
+  auto it = std::lower_bound(m_index.begin(), m_index.end(), key,
+    [](const std::pair<uint32_t, dbcMessage*>& e, uint32_t id) { return e.first < id; });
+  if (it != m_index.end() && it->first == key)
+    return it->second;
   else
     return NULL;
   }
 
+/**
+ * DecodeMetrics: decode a frame into the metrics assigned to its signals
+ *  The table stays locked while decoding, so Compile() cannot free the plan
+ *  in use. Returns the number of metrics set, -1 if the message is unknown
+ *  or has not been compiled yet.
+ */
+int dbcMessageTable::DecodeMetrics(CAN_frame_t* frame)
+  {
+  uint32_t key = (frame->FIR.B.FF == CAN_frame_ext)
+    ? (frame->MsgID | 0x80000000) : (frame->MsgID & 0x7FFFFFFF);
+
+  OvmsMutexLock lock(&m_mutex);
+  dbcMessage* msg = LookupMessage(key);
+  if (msg == NULL || msg->GetPlan() == NULL)
+    return -1;
+  return msg->GetPlan()->DecodeMetrics(frame);
+  }
+
+/**
+ * Compile: build the lookup index & decode plans for all messages
+ *  Needs to be called after any message or signal change. The new index and
+ *  plans are built unlocked, then swapped in under the lock; the old plans
+ *  are freed after the swap, when no decoder can still use them.
+ */
+void dbcMessageTable::Compile()
+  {
+  std::vector< std::pair<uint32_t, dbcMessage*> > index;
+  std::vector<dbcDecodePlan*> plans;
+  index.reserve(m_entrymap.size());
+  plans.reserve(m_entrymap.size());
+  for (dbcMessageEntry_t::iterator it = m_entrymap.begin(); it != m_entrymap.end(); ++it)
+    {
+    index.push_back(*it);
+    plans.push_back(new dbcDecodePlan(it->second));
+    }
+
+  m_mutex.Lock();
+  for (size_t k = 0; k < index.size(); k++)
+    plans[k] = index[k].second->SwapPlan(plans[k]);
+  m_index.swap(index);
+  m_indexvalid = true;
+  m_mutex.Unlock();
+
+  for (dbcDecodePlan* plan : plans)
+    {
+    if (plan) delete plan;
+    }
+  }
+
+void dbcMessageTable::InvalidateIndex()
+  {
+  OvmsMutexLock lock(&m_mutex);
+  m_indexvalid = false;
+  m_index.clear();
+  }
+
 void dbcMessageTable::Count(int* messages, int* signals, int* bits, int* covered)
   {
   *messages = 0;
@@ -1219,6 +1543,9 @@ void dbcMessageTable::Count(int* messages, int* signals, int* bits, int* covered
 
 void dbcMessageTable::EmptyContent()
   {
+  OvmsMutexLock lock(&m_mutex);
+  m_indexvalid = false;
+  m_index.clear();
   dbcMessageEntry_t::iterator it=m_entrymap.begin();
   while (it!=m_entrymap.end())
     {
@@ -1324,6 +1651,7 @@ bool dbcfile::LoadFile(const char* name, const char* path, FILE* fd)
     fseek(fd,0,SEEK_SET);
     }
 
+  if (result) m_messages.Compile();
   return result;
   }
 
@@ -1339,6 +1667,7 @@ bool dbcfile::LoadString(const char* name, const char* source, size_t length)
   bool result = (yyparse (this) == 0);
   yy_delete_buffer(buffer);
 
+  if (result) m_messages.Compile();
   return result;
   }
 
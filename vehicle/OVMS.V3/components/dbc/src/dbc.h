@@ -34,11 +34,13 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include <functional>
 #include <iostream>
 #include "dbc_number.h"
 #include "can.h"
 #include "ovms_metrics.h"
+#include "ovms_mutex.h"
 
 #define DBC_MAX_LINELENGTH 2048
 
@@ -332,6 +334,62 @@ class dbcSignal
   };
 
 typedef std::list<dbcSignal*> dbcSignalList_t;
+
+////////////////////////////////////////////////////////////////////////
+// dbcDecodePlan: flat precompiled decoder for the signals of a message
+// Each signal is reduced to a shift & mask on the 64 bit frame payload
+// (little or big endian view), with an integer fast path for integral
+// factor/offset. Multiplexed signals are grouped by switch value.
+
+typedef struct
+  {
+  dbcSignal* signal;
+  uint64_t mask;
+  uint64_t signbit;       // 0 = unsigned
+  uint8_t shift;
+  bool bigendian;
+  bool isdouble;          // factor/offset not integral, or value > 32 bits
+  bool generic;           // not compilable, use dbcSignal::Decode()
+  int32_t ifactor;
+  int32_t ioffset;
+  double dfactor;
+  double doffset;
+  } dbcDecodeStep_t;
+
+typedef struct
+  {
+  uint32_t switchvalue;
+  uint16_t first;
+  uint16_t count;
+  } dbcDecodeGroup_t;
+
+typedef void (*dbcDecodeCallback)(void* param, dbcSignal* signal, dbcNumber& value);
+
+class dbcMessage;
+class dbcDecodePlan
+  {
+  public:
+    dbcDecodePlan(dbcMessage* message);
+    ~dbcDecodePlan();
+
+  public:
+    int Decode(CAN_frame_t* frame, dbcDecodeCallback callback, void* param);
+    int DecodeMetrics(CAN_frame_t* frame);
+
+  protected:
+    void Compile(dbcMessage* message);
+    void CompileStep(dbcSignal* signal, dbcDecodeStep_t* step);
+    inline dbcNumber Extract(const dbcDecodeStep_t* step, CAN_frame_t* frame, uint64_t le, uint64_t be);
+    const dbcDecodeGroup_t* FindGroup(uint32_t switchvalue);
+
+  protected:
+    std::vector<dbcDecodeStep_t> m_steps;     // plain signals first, then mux groups
+    std::vector<dbcDecodeGroup_t> m_groups;   // sorted by switch value
+    uint16_t m_plain;                         // number of plain signals
+    bool m_hasmux;
+    dbcDecodeStep_t m_mux;
+  };
+
 class dbcMessage
   {
   public:
@@ -368,6 +426,10 @@ class dbcMessage
     dbcSignal* GetMultiplexorSignal();
     void SetMultiplexorSignal(dbcSignal* signal);
 
+  public:
+    dbcDecodePlan* GetPlan();
+    dbcDecodePlan* SwapPlan(dbcDecodePlan* plan);
+
   public:
     void WriteFile(dbcOutputCallback callback, void* param);
     void WriteFileComments(dbcOutputCallback callback, void* param);
@@ -378,6 +440,7 @@ class dbcMessage
     dbcCommentTable m_comments;
 
   protected:
+    dbcDecodePlan* m_plan;
     dbcSignal* m_multiplexor;
     uint32_t m_id;
     std::string m_name;
@@ -397,8 +460,13 @@ class dbcMessageTable
     void RemoveMessage(uint32_t id, bool free=false);
     dbcMessage* FindMessage(uint32_t id);
     dbcMessage* FindMessage(CAN_frame_format_t format, uint32_t id);
+    int DecodeMetrics(CAN_frame_t* frame);
     void Count(int* messages, int* signals, int* bits, int* covered);
 
+  public:
+    void Compile();
+    void InvalidateIndex();
+
   public:
     void EmptyContent();
 
@@ -410,6 +478,14 @@ class dbcMessageTable
 
   public:
     dbcMessageEntry_t m_entrymap;
+
+  protected:
+    dbcMessage* LookupMessage(uint32_t key);
+
+  protected:
+    OvmsMutex m_mutex;                                          // Protects index & plans vs. decoding
+    std::vector< std::pair<uint32_t, dbcMessage*> > m_index;   // Sorted by id for binary search
+    bool m_indexvalid;
   };
 
 class dbcfile
@@ -333,6 +333,7 @@ void dbc_message_add(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int ar
   msg->SetSize(atoi(argv[2]));
   msg->SetTransmitterNode(argv[3]);
   MyDBC.m_selected->m_messages.AddMessage(msgid,msg);
+  MyDBC.m_selected->m_messages.Compile();
   writer->printf("DBC: Added message %s\n",argv[0]);
   }
 
@@ -349,6 +350,7 @@ void dbc_message_remove(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
   if (msg != NULL)
     {
     MyDBC.m_selected->m_messages.RemoveMessage(msg->GetID(),true);
+    MyDBC.m_selected->m_messages.Compile();
     writer->printf("DBC: Message %s removed\n",argv[0]);
     }
   else
@@ -376,6 +378,7 @@ void dbc_message_set_mux(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, in
   if (argc == 1)
     {
     msg->SetMultiplexorSignal(NULL);
+    MyDBC.m_selected->m_messages.Compile();
     writer->printf("DBC: Cleared mux for %s\n",argv[0]);
     return;
     }
@@ -388,6 +391,7 @@ void dbc_message_set_mux(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, in
     }
 
   msg->SetMultiplexorSignal(signal);
+  MyDBC.m_selected->m_messages.Compile();
   writer->printf("DBC: Set mux for message %s to %s\n",argv[0],argv[1]);
   }
 
@@ -408,8 +412,13 @@ void dbc_signal_clear(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int a
     }
   else
     {
-    msg->RemoveAllSignals(true);
+    // Free the signals after the recompilation, the current plan may use them:
+    dbcSignalList_t signals;
+    signals.swap(msg->m_signals);
     msg->SetMultiplexorSignal(NULL);
+    MyDBC.m_selected->m_messages.Compile();
+    for (dbcSignal* signal : signals)
+      delete signal;
     writer->printf("DBC: Cleared all signals for %s\n",argv[0]);
     }
   }
@@ -449,6 +458,7 @@ void dbc_signal_add(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int arg
   signal->SetUnit(argv[10]);
   signal->AddReceiver(argv[11]);
   msg->AddSignal(signal);
+  MyDBC.m_selected->m_messages.Compile();
   writer->printf("DBC: Added signal %s on message %s\n",argv[1],argv[0]);
   }
 
@@ -476,7 +486,10 @@ void dbc_signal_remove(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
     }
   else
     {
-    msg->RemoveSignal(signal, true);
+    // Free the signal after the recompilation, the current plan may use it:
+    msg->RemoveSignal(signal, false);
+    MyDBC.m_selected->m_messages.Compile();
+    delete signal;
     writer->printf("DBC: Removed signal %s on message %s\n",argv[1],argv[0]);
     }
   }
@@ -514,6 +527,7 @@ void dbc_signal_set_mux(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int
     signal->ClearMultiplexed();
     writer->printf("DBC: Cleared mux for signal %s on message %s\n",argv[1],argv[0]);
     }
+  MyDBC.m_selected->m_messages.Compile();
   }
 
 dbc::dbc()
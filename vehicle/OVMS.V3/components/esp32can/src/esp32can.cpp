@@ -42,6 +42,7 @@ static const char *TAG = "esp32can";
 #include "esp32can.h"
 #include "esp32can_regdef.h"
 #include "ovms_peripherals.h"
+#include "esp_timer.h"
 
 esp32can* MyESP32can = NULL;
 
@@ -51,7 +52,7 @@ static portMUX_TYPE esp32can_spinlock = portMUX_INITIALIZER_UNLOCKED;
 #define ESP32CAN_ENTER_CRITICAL_ISR()   portENTER_CRITICAL_ISR(&esp32can_spinlock)
 #define ESP32CAN_EXIT_CRITICAL_ISR()    portEXIT_CRITICAL_ISR(&esp32can_spinlock)
 
-static inline uint32_t ESP32CAN_rxframe(esp32can *me, BaseType_t* task_woken)
+static inline uint32_t ESP32CAN_rxframe(esp32can *me, int64_t captured, BaseType_t* task_woken)
   {
   static CAN_queue_msg_t msg;
   uint32_t error_irqs = 0;
@@ -118,6 +119,7 @@ static inline uint32_t ESP32CAN_rxframe(esp32can *me, BaseType_t* task_woken)
       // Valid frame in receive buffer: record the origin
       memset(&msg,0,sizeof(msg));
       msg.type = CAN_frame;
+      msg.timestamp = captured;
       msg.body.frame.origin = me;
 
       // get FIR
@@ -158,6 +160,7 @@ static IRAM_ATTR void ESP32CAN_isr(void *pvParameters)
   esp32can *me = (esp32can*)pvParameters;
   BaseType_t task_woken = pdFALSE;
   uint32_t interrupt;
+  int64_t captured = esp_timer_get_time();
 
   ESP32CAN_ENTER_CRITICAL_ISR();
 
@@ -169,7 +172,7 @@ static IRAM_ATTR void ESP32CAN_isr(void *pvParameters)
     // Handle RX frame(s) available & FIFO overflow interrupts:
     if ((interrupt & (__CAN_IRQ_RX|__CAN_IRQ_DATA_OVERRUN)) != 0)
       {
-      interrupt |= ESP32CAN_rxframe(me, &task_woken);
+      interrupt |= ESP32CAN_rxframe(me, captured, &task_woken);
       }
 
     // Handle TX complete interrupt:
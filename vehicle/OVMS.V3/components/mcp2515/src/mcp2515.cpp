@@ -37,6 +37,9 @@ static const char *TAG = "mcp2515";
 #include "driver/gpio.h"
 #include "esp_intr.h"
 #include "soc/dport_reg.h"
+#include "esp_timer.h"
+#include "ovms_config.h"
+#include "ovms_command.h"
 
 static IRAM_ATTR void MCP2515_isr(void *pvParameters)
   {
@@ -49,6 +52,7 @@ static IRAM_ATTR void MCP2515_isr(void *pvParameters)
   // so we let AsynchronousInterruptHandler() figure out what to do.
   CAN_queue_msg_t msg = {};
   msg.type = CAN_asyncinterrupthandler;
+  msg.timestamp = esp_timer_get_time();
   msg.body.bus = me;
 
   //send callback request to main CAN processor task
@@ -69,6 +73,11 @@ mcp2515::mcp2515(const char* name, spi* spibus, spi_nodma_host_device_t host, in
   m_clockspeed = clockspeed;
   m_cspin = cspin;
   m_intpin = intpin;
+  m_rxdrain = false;
+  m_rxfifo_count = 0;
+  m_rxfifo_next = 0;
+  m_rx_frames = 0;
+  m_rx_spi = 0;
 
   memset(&m_devcfg, 0, sizeof(spi_nodma_device_interface_config_t));
   m_devcfg.clock_speed_hz=m_clockspeed;     // Clock speed (in hz)
@@ -86,8 +95,7 @@ mcp2515::mcp2515(const char* name, spi* spibus, spi_nodma_host_device_t host, in
     }
   m_devcfg.queue_size=7;                    // We want to be able to queue 7 transactions at a time
 
-  esp_err_t ret = spi_nodma_bus_add_device(m_host, &m_spibus->m_buscfg, &m_devcfg, &m_spi);
-  assert(ret==ESP_OK);
+  ESP_ERROR_CHECK(spi_nodma_bus_add_device(m_host, &m_spibus->m_buscfg, &m_devcfg, &m_spi));
 
   gpio_set_intr_type((gpio_num_t)m_intpin, GPIO_INTR_NEGEDGE);
   gpio_isr_handler_add((gpio_num_t)m_intpin, MCP2515_isr, (void*)this);
@@ -150,6 +158,8 @@ esp_err_t mcp2515::Start(CAN_mode_t mode, CAN_speed_t speed)
 
   m_mode = mode;
   m_speed = speed;
+  m_rxdrain = MyConfig.GetParamValueBool("can", "mcp2515.rxdrain", false);
+  m_rxfifo_count = m_rxfifo_next = 0;
 
   // RESET commmand
   m_spibus->spi_cmd(m_spi, buf, 0, 1, CMD_RESET);
@@ -282,6 +292,21 @@ esp_err_t mcp2515::Stop()
   return ESP_OK;
   }
 
+void mcp2515::ClearStatus()
+  {
+  canbus::ClearStatus();
+  m_rx_frames = 0;
+  m_rx_spi = 0;
+  }
+
+void mcp2515::ShowStatus(OvmsWriter* writer)
+  {
+  writer->printf("RX mode:   %20s\n", m_rxdrain ? "drain" : "single");
+  writer->printf("RX SPI tx: %20u\n", m_rx_spi);
+  if (m_rx_frames)
+    writer->printf("SPI/frame: %20.2f\n", (float)m_rx_spi / m_rx_frames);
+  }
+
 esp_err_t mcp2515::ViewRegisters()
   {
   uint8_t buf[16];
@@ -394,6 +419,66 @@ esp_err_t mcp2515::Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait /*=
   }
 
 
+/**
+ * ReadRxBuffer: read & decode RX buffer 0/1, the RX interrupt flag is cleared by the read
+ */
+void mcp2515::ReadRxBuffer(uint8_t rxbuf, CAN_frame_t* frame)
+  {
+  uint8_t buf[16];
+
+  int64_t timestamp = frame->timestamp;
+  memset(frame,0,sizeof(*frame));
+  frame->origin = this;
+  frame->timestamp = timestamp;
+
+  uint8_t *p = m_spibus->spi_cmd(m_spi, buf, 13, 1, CMD_READ_RXBUF + (rxbuf ? 4 : 0));
+  m_rx_spi++;
+  m_rx_frames++;
+
+  if (p[1] & 0x08) //check for extended mode=1, or std mode=0
+    {
+    frame->FIR.B.FF = CAN_frame_ext;           // Extended mode
+    frame->MsgID = ((uint32_t)p[0]<<21)
+                  + (((uint32_t)p[1]&0xe0)<<13)
+                  + (((uint32_t)p[1]&0x03)<<16)
+                  + ((uint32_t)p[2]<<8)
+                  + ((uint32_t)p[3]);
+    }
+  else
+    {
+    frame->FIR.B.FF = CAN_frame_std;
+    frame->MsgID = ((uint32_t)p[0] << 3) + (p[1] >> 5);  // Standard mode
+    }
+
+  frame->FIR.B.DLC = p[4] & 0x0f;
+
+  memcpy(&frame->data,p+5,8);
+  }
+
+/**
+ * DrainRxBuffers: RX drain mode, read all full RX buffers into the RX FIFO
+ *  One READ STATUS plus one READ RX BUFFER per frame, RXB0 is read first
+ *  (RXB1 receives on rollover). Returns the READ STATUS result.
+ */
+uint8_t mcp2515::DrainRxBuffers(int64_t captured)
+  {
+  uint8_t buf[16];
+
+  uint8_t status = m_spibus->spi_cmd(m_spi, buf, 1, 1, CMD_READ_STATUS)[0];
+  m_rx_spi++;
+
+  m_rxfifo_count = m_rxfifo_next = 0;
+  for (uint8_t rxbuf = 0; rxbuf < 2; rxbuf++)
+    {
+    if ((status & (STATUS_RX0IF << rxbuf)) == 0)
+      continue;
+    CAN_frame_t* frame = &m_rxfifo[m_rxfifo_count++];
+    frame->timestamp = captured;
+    ReadRxBuffer(rxbuf, frame);
+    }
+  return status;
+  }
+
 // This function serves as asynchronous interrupt handler for both rx and tx tasks as well as error states
 // Returns true if this function needs to be called again (another frame may need handling or all error interrupts are not yet handled)
 bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameReceived)
@@ -402,11 +487,34 @@ bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameRecei
 
   *frameReceived = false;
 
+  if (m_rxdrain)
+    {
+    // Drain mode: read all full RX buffers in one pass, deliver the frames
+    // one per call, handle the other interrupt sources when no RX buffer is full:
+    if (m_rxfifo_next == m_rxfifo_count)
+      {
+      uint8_t status = DrainRxBuffers(frame->timestamp);
+      if (m_rxfifo_count == 0 && (status & STATUS_TXIF) == 0 && gpio_get_level((gpio_num_t)m_intpin))
+        return false;
+      }
+    if (m_rxfifo_next < m_rxfifo_count)
+      {
+      *frame = m_rxfifo[m_rxfifo_next++];
+      *frameReceived = true;
+      return (m_rxfifo_next < m_rxfifo_count) || !gpio_get_level((gpio_num_t)m_intpin);
+      }
+    }
+
   // read interrupts (CANINTF 0x2c) and errors (EFLG 0x2d):
   uint8_t *p = m_spibus->spi_cmd(m_spi, buf, 2, 2, CMD_READ, REG_CANINTF);
+  m_rx_spi++;
   uint8_t intstat = p[0];
   uint8_t errflag = p[1];
 
+  // Drain mode: RX buffers filled since READ STATUS are left for the next pass:
+  if (m_rxdrain)
+    intstat &= ~0x03;
+
   // handle RX buffers and other interrupts sequentially:
   int intflag;
   if (intstat & 0x01)
@@ -428,38 +536,15 @@ bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameRecei
   if (intflag == 0)
     {
     // all interrupts handled
-    return false;
+    return (m_rxdrain) ? !gpio_get_level((gpio_num_t)m_intpin) : false;
     }
 
   m_status.error_flags = (intstat << 24) | (errflag << 16) | intflag;
 
   if (intflag <= 2)
     {
-    // The indicated RX buffer has a message to be read
-    memset(frame,0,sizeof(*frame));
-    frame->origin = this;
-
-    // read RX buffer and clear interrupt flag:
-    uint8_t *p = m_spibus->spi_cmd(m_spi, buf, 13, 1, CMD_READ_RXBUF + ((intflag==1) ? 0 : 4));
-
-    if (p[1] & 0x08) //check for extended mode=1, or std mode=0
-      {
-      frame->FIR.B.FF = CAN_frame_ext;           // Extended mode
-      frame->MsgID = ((uint32_t)p[0]<<21)
-                    + (((uint32_t)p[1]&0xe0)<<13)
-                    + (((uint32_t)p[1]&0x03)<<16)
-                    + ((uint32_t)p[2]<<8)
-                    + ((uint32_t)p[3]);
-      }
-    else
-      {
-      frame->FIR.B.FF = CAN_frame_std;
-      frame->MsgID = ((uint32_t)p[0] << 3) + (p[1] >> 5);  // Standard mode
-      }
-
-    frame->FIR.B.DLC = p[4] & 0x0f;
-
-    memcpy(&frame->data,p+5,8);
+    // The indicated RX buffer has a message to be read, read it & clear the interrupt flag:
+    ReadRxBuffer((intflag==1) ? 0 : 1, frame);
     *frameReceived=true;
     }
 
@@ -469,6 +554,7 @@ bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameRecei
     {
     // some TX buffers have become available; clear IRQs and fill up:
     m_spibus->spi_cmd(m_spi, buf, 0, 4, CMD_BITMODIFY, 0x2c, intstat & 0b00011100, 0x00);
+    m_rx_spi++;
     m_status.error_flags |= 0x0100;
 
     // send "tx success" callback request to main CAN processor task
@@ -496,6 +582,7 @@ bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameRecei
       }
     // read error counters:
     uint8_t *p = m_spibus->spi_cmd(m_spi, buf, 2, 2, CMD_READ, REG_TEC);
+    m_rx_spi++;
     if ( (intstat & 0b10000000) && (p[0] > m_status.errors_tx) )
       {
       ESP_LOGE(TAG, "AsynchronousInterruptHandler: error while sending frame. msgId 0x%x", m_tx_frame.MsgID);
@@ -518,6 +605,7 @@ bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameRecei
     {
     m_status.error_flags |= 0x0800;
     m_spibus->spi_cmd(m_spi, buf, 0, 4, CMD_BITMODIFY, REG_EFLG, errflag & 0b11000000, 0x00);
+    m_rx_spi++;
     }
 
   // log bus error flags:
@@ -542,6 +630,7 @@ bool mcp2515::AsynchronousInterruptHandler(CAN_frame_t* frame, bool * frameRecei
     {
     m_status.error_flags |= 0x1000;
     m_spibus->spi_cmd(m_spi, buf, 0, 4, CMD_BITMODIFY, REG_CANINTF, intstat & 0b11100000, 0x00);
+    m_rx_spi++;
     }
 
   // Read the interrupt pin status and if it's still active (low), require another interrupt handling iteration
@@ -47,6 +47,11 @@
 #define CMD_LOAD_TXBUF    0b01000000
 #define CMD_READ_STATUS   0b10100000
 
+// READ STATUS result bits
+#define STATUS_RX0IF        0b00000001
+#define STATUS_RX1IF        0b00000010
+#define STATUS_TXIF         0b10101000  // TX0IF, TX1IF, TX2IF
+
 // CANSTAT register
 #define CANSTAT_MODE_CONFIG     0x10000000
 #define CANSTAT_MODE_LISTEN     0b01100000
@@ -86,6 +91,8 @@ class mcp2515 : public canbus
   public:
     esp_err_t Start(CAN_mode_t mode, CAN_speed_t speed);
     esp_err_t Stop();
+    void ClearStatus();
+    void ShowStatus(OvmsWriter* writer);
     esp_err_t WriteReg( uint8_t reg, uint8_t value );
     esp_err_t WriteRegAndVerify( uint8_t reg, uint8_t value, uint8_t read_back_mask = 0xff);
     esp_err_t ChangeMode( uint8_t mode );
@@ -98,6 +105,8 @@ class mcp2515 : public canbus
 
   protected:
     esp_err_t WriteFrame(const CAN_frame_t* p_frame);
+    void ReadRxBuffer(uint8_t rxbuf, CAN_frame_t* frame);
+    uint8_t DrainRxBuffers(int64_t captured);
 
   public:
     void SetPowerMode(PowerMode powermode);
@@ -114,6 +123,12 @@ class mcp2515 : public canbus
     int m_intpin;
     uint8_t m_last_errflag = 0;
     OvmsMutex m_write_mutex;
+    bool m_rxdrain;                   // RX drain mode: read all full RX buffers per pass
+    CAN_frame_t m_rxfifo[2];          // Drain mode: frames read by the last pass
+    uint8_t m_rxfifo_count;
+    uint8_t m_rxfifo_next;
+    uint32_t m_rx_frames;             // Frames read by the interrupt handler
+    uint32_t m_rx_spi;                // SPI transactions issued by the interrupt handler
   };
 
 #endif //#ifndef __MCP2515_H__
@@ -2272,7 +2272,8 @@ void OvmsScripts::DukTapeTask()
             duk_pop_2(m_dukctx);
             }
           }
-          free((void*)msg.body.dt_event.name);
+          if (msg.body.dt_event.freename)
+            free((void*)msg.body.dt_event.name);
           break;
         case DUKTAPE_autoinit:
           {
@@ -2516,7 +2517,43 @@ void OvmsScripts::AllScripts(std::string path)
     }
   }
 
-void OvmsScripts::EventScript(std::string event, void* data)
+/**
+ * EventScriptDirsLoad: index the event script folders
+ *  Avoids probing the file system for every event. The index is reloaded
+ *  on file system changes and once per minute to catch changes not
+ *  signalled by an event.
+ */
+void OvmsScripts::EventScriptDirsLoad()
+  {
+  DIR *dir;
+  struct dirent *dp;
+
+  m_eventdirs_store.clear();
+  if ((dir = opendir("/store/events")) != NULL)
+    {
+    while ((dp = readdir(dir)) != NULL)
+      m_eventdirs_store.insert(dp->d_name);
+    closedir(dir);
+    }
+
+#ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+  m_eventdirs_sd.clear();
+  if ((dir = opendir("/sd/events")) != NULL)
+    {
+    while ((dp = readdir(dir)) != NULL)
+      m_eventdirs_sd.insert(dp->d_name);
+    closedir(dir);
+    }
+#endif // #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+
+  m_eventdirs_valid = true;
+  }
+
+/**
+ * EventScript: run the scripts for an event
+ *  interned: event name stays valid (see OvmsEvents::GetEventId), else copied
+ */
+void OvmsScripts::EventScript(const char* event, void* data, bool interned /*=true*/)
   {
   std::string path;
 
@@ -2525,28 +2562,45 @@ void OvmsScripts::EventScript(std::string event, void* data)
   duktape_queue_t dmsg;
   memset(&dmsg, 0, sizeof(dmsg));
   dmsg.type = DUKTAPE_event;
-  dmsg.body.dt_event.name = strdup(event.c_str());
+  dmsg.body.dt_event.name = interned ? event : strdup(event);
   dmsg.body.dt_event.data = NULL; // data unused, may also be invalid in async script execution
-  if (!DuktapeDispatch(&dmsg, 0))
+  dmsg.body.dt_event.freename = !interned;
+  if (!DuktapeDispatch(&dmsg, 0) && !interned)
     {
     free((void*)dmsg.body.dt_event.name);
     }
 #endif // #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
 
+  // invalidate the event script folder index on file system changes:
+  if (strcmp(event, "ticker.60") == 0 ||
+      strcmp(event, "system.vfs.file.changed") == 0 ||
+      strcmp(event, "config.mounted") == 0 ||
+      strcmp(event, "sd.mounted") == 0 ||
+      strcmp(event, "sd.unmounted") == 0)
+    m_eventdirs_valid = false;
+  if (!m_eventdirs_valid)
+    EventScriptDirsLoad();
+
 #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
   // run event scripts on external storage:
-  path=std::string("/sd/events/");
-  path.append(event);
-  AllScripts(path);
+  if (m_eventdirs_sd.count(event))
+    {
+    path=std::string("/sd/events/");
+    path.append(event);
+    AllScripts(path);
+    }
 #endif // #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
 
   // run event scripts on internal storage:
-  path=std::string("/store/events/");
-  path.append(event);
-  AllScripts(path);
+  if (m_eventdirs_store.count(event))
+    {
+    path=std::string("/store/events/");
+    path.append(event);
+    AllScripts(path);
+    }
 
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
-  if (event == "ticker.60")
+  if (strcmp(event, "ticker.60") == 0)
     {
     // request garbage collection once per minute:
     DuktapeCompact(false);
@@ -2557,6 +2611,7 @@ void OvmsScripts::EventScript(std::string event, void* data)
 OvmsScripts::OvmsScripts()
   {
   ESP_LOGI(TAG, "Initialising SCRIPTS (1600)");
+  m_eventdirs_valid = false;
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   m_dukctx = NULL;
   m_duktaskid = NULL;
@@ -33,6 +33,7 @@
 
 #include "ovms_command.h"
 #include "ovms_utils.h"
+#include <set>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -138,6 +139,7 @@ typedef struct
       {
       const char* name;
       void* data;
+      bool freename;
       } dt_event;
     struct
       {
@@ -323,9 +325,19 @@ class OvmsScripts
     ~OvmsScripts();
 
   public:
-    void EventScript(std::string event, void* data);
+    void EventScript(const char* event, void* data, bool interned=true);
     void AllScripts(std::string path);
 
+  protected:
+    void EventScriptDirsLoad();
+
+  protected:
+    std::set<std::string> m_eventdirs_store;  // event script folder index of /store/events
+#ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+    std::set<std::string> m_eventdirs_sd;     // event script folder index of /sd/events
+#endif // #ifdef CONFIG_OVMS_DEV_SDCARDSCRIPTS
+    bool m_eventdirs_valid;
+
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
   public:
     void RegisterDuktapeFunction(duk_c_function func, duk_idx_t nargs, const char* name);
@@ -44,9 +44,14 @@ static const char *TAG = "ovms-server-v2";
 #include "ovms_netmanager.h"
 #include "vehicle.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "ovms_utils.h"
 #include "ovms_boot.h"
 #include "ovms_tls.h"
+#ifdef CONFIG_HEAP_TRACING
+#include "esp_heap_trace.h"
+#define SERVER_V2_BENCH_TRACE 200       // heap trace records for "server v2 bench"
+#endif // #ifdef CONFIG_HEAP_TRACING
 
 // should this go in the .h or in the .cpp?
 typedef union {
@@ -296,11 +301,12 @@ void OvmsServerV2::ProcessServerMsg()
       std::string msg("MP-0 ET");
       msg.append(m_ptoken);
       Transmit(msg);
-      m_ptoken_ready = true;
 
       // Generate, and store, the digest for future use
       std::string modpass = MyConfig.GetParamValue("password","module");
       hmac_md5((uint8_t*) token, OVMS_PROTOCOL_V2_TOKENSIZE, (uint8_t*)modpass.c_str(), modpass.length(), m_pdigest);
+      ParanoidSetup();
+      m_ptoken_ready = true;
       }
 
     m_pending_notify_info = true;
@@ -345,15 +351,10 @@ void OvmsServerV2::ProcessServerMsg()
     uint8_t *d = new uint8_t[line.length()-6];
     len = base64decode(line.c_str()+7,d+1);
 
-    RC4_CTX1* pm_crypto1 = new RC4_CTX1;
-    RC4_CTX2* pm_crypto2 = new RC4_CTX2;
-    RC4_setup(pm_crypto1, pm_crypto2, m_pdigest, OVMS_MD5_SIZE);
-    for (int k=0;k<1024;k++)
-      {
-      uint8_t zero = 0;
-      RC4_crypt(pm_crypto1, pm_crypto2, &zero, 1);
-      }
-    RC4_crypt(pm_crypto1, pm_crypto2, d, len);
+    // Each paranoid message starts from the post-discard cipher state:
+    RC4_CTX1 pm_crypto1 = m_pcrypto1;
+    RC4_CTX2 pm_crypto2 = m_pcrypto2;
+    RC4_crypt(&pm_crypto1, &pm_crypto2, d, len);
 
     line.erase(5);
     line = std::string("MP-0 ");
@@ -361,9 +362,7 @@ void OvmsServerV2::ProcessServerMsg()
     line.append((char*)d);
     len = line.length();
 
-    delete pm_crypto1;
-    delete pm_crypto2;
-    delete d;
+    delete [] d;
     ESP_LOGI(TAG, "Decoded Paranoid Msg: %s",line.c_str());
     }
 
@@ -721,18 +720,57 @@ void OvmsServerV2::ProcessCommand(const char* payload)
   delete buffer;
   }
 
-void OvmsServerV2::Transmit(const std::string& message)
+/**
+ * ParanoidSetup: derive the paranoid mode cipher state from m_pdigest
+ *  and run the 1024 byte keystream discard once per session. Every
+ *  paranoid message (both directions) restarts from this snapshot.
+ */
+void OvmsServerV2::ParanoidSetup()
   {
-  OvmsMutexLock mg(&m_mgconn_mutex);
-  if (!m_mgconn)
+  uint8_t zero[64];
+  RC4_setup(&m_pcrypto1, &m_pcrypto2, m_pdigest, OVMS_MD5_SIZE);
+  for (int k=0;k<1024;k+=sizeof(zero))
+    {
+    memset(zero, 0, sizeof(zero));
+    RC4_crypt(&m_pcrypto1, &m_pcrypto2, zero, sizeof(zero));
+    }
+  }
+
+/**
+ * TransmitBuffers: make sure the scratch buffers can encode a message
+ *  of len bytes. Worst case is a paranoid message: "MP-0 EM" + code +
+ *  base64(payload), then base64 of that plus "\r\n" and the terminator.
+ */
+void OvmsServerV2::TransmitBuffers(size_t len)
+  {
+  size_t inner = 8 + ((len+2)/3)*4;
+  size_t need = ((inner+2)/3)*4 + 3;
+  if (need <= m_txbuf_size)
     return;
+  need = (need + 255) & ~255;
+  if (m_txbuf1) delete [] m_txbuf1;
+  if (m_txbuf2) delete [] m_txbuf2;
+  m_txbuf1 = new char[need];
+  m_txbuf2 = new char[need];
+  m_txbuf_size = need;
+  m_txbuf_allocs += 2;
+  }
 
-  int len = message.length();
-  char* s = new char[(len*2)+4];
-  memcpy(s,message.c_str(),len);
-  ESP_LOGI(TAG, "Send %s",message.c_str());
+/**
+ * EncodeMessage: encrypt & encode a message into m_txbuf2, ready to send.
+ *  Call with m_mgconn_mutex held. Returns the encoded length (including
+ *  the "\r\n" line end).
+ */
+size_t OvmsServerV2::EncodeMessage(const std::string& message)
+  {
+  size_t len = message.length();
+  TransmitBuffers(len);
+  char* s = m_txbuf1;
+  memcpy(s,message.data(),len);
+  s[len] = 0;
 
   if ((m_ptoken_ready)&&
+      (len >= 6)&&
       (s[5] != 'E')&&
       (s[5] != 'A')&&
       (s[5] != 'a')&&
@@ -742,39 +780,140 @@ void OvmsServerV2::Transmit(const std::string& message)
     // We must convert the message to a paranoid one...
     // The message is of the form MP-0 X...
     // Where X is the code and ... is the (optional) data
-    char code[2]; code[0] = s[5]; code[1] = 0;
-    uint8_t* d = new uint8_t[len-6];
+    char code = s[5];
+    uint8_t* d = (uint8_t*)m_txbuf2;
     memcpy(d,s+6,len-6);
 
     // Paranoid encrypt the message part of the transaction
-    RC4_CTX1* pm_crypto1 = new RC4_CTX1;
-    RC4_CTX2* pm_crypto2 = new RC4_CTX2;
-    RC4_setup(pm_crypto1, pm_crypto2, m_pdigest, OVMS_MD5_SIZE);
-    for (int k=0;k<1024;k++)
-      {
-      uint8_t zero = 0;
-      RC4_crypt(pm_crypto1, pm_crypto2, &zero, 1);
-      }
-    RC4_crypt(pm_crypto1, pm_crypto2, d, len-6);
-
-    strcpy(s,"MP-0 EM");
-    strcat(s,code);
-    base64encode(d, len-6, (uint8_t*)s+8);
-    // The messdage is now in paranoid mode...
-    delete d;
-    delete pm_crypto1;
-    delete pm_crypto2;
+    RC4_CTX1 pm_crypto1 = m_pcrypto1;
+    RC4_CTX2 pm_crypto2 = m_pcrypto2;
+    RC4_crypt(&pm_crypto1, &pm_crypto2, d, len-6);
+
+    memcpy(s,"MP-0 EM",7);
+    s[7] = code;
+    char* end = base64encode(d, len-6, (uint8_t*)s+8);
+    // The message is now in paranoid mode...
+    len = end - s;
     }
 
   RC4_crypt(&m_crypto_tx1, &m_crypto_tx2, (uint8_t*)s, len);
 
-  char* buf = new char[(len*2)+4];
-  base64encode((uint8_t*)s, len, (uint8_t*)buf);
-  strcat(buf,"\r\n");
-  mg_send(m_mgconn, buf, strlen(buf));
+  char* buf = m_txbuf2;
+  char* end = base64encode((uint8_t*)s, len, (uint8_t*)buf);
+  *end++ = '\r';
+  *end++ = '\n';
+  *end = 0;
+  return end - buf;
+  }
+
+void OvmsServerV2::Transmit(const std::string& message)
+  {
+  OvmsMutexLock mg(&m_mgconn_mutex);
+  if (!m_mgconn)
+    return;
+
+  ESP_LOGI(TAG, "Send %s",message.c_str());
+  size_t len = EncodeMessage(message);
+  mg_send(m_mgconn, m_txbuf2, len);
+  }
+
+/**
+ * TransmitBenchmark: build the current stat, environment & gps messages
+ *  and measure the encoding throughput (plain & paranoid). The live
+ *  cipher states are saved and restored, nothing is sent, and the
+ *  metric modification flags are not touched.
+ *  Heap allocations per message are counted if heap tracing is enabled.
+ */
+void OvmsServerV2::TransmitBenchmark(OvmsWriter* writer, int count)
+  {
+  std::vector<std::string> msgs;
+
+  // Build messages:
+  int64_t t0 = esp_timer_get_time();
+  msgs.push_back(BuildMsgStat());
+  msgs.push_back(BuildMsgEnvironment());
+  msgs.push_back(BuildMsgGPS());
+  int64_t t_build = esp_timer_get_time() - t0;
+
+  size_t bytes = 0;
+  for (auto& m : msgs) bytes += m.length();
+  writer->printf("Messages: %u, %u bytes, build %lld us\n",
+    (unsigned)msgs.size(), (unsigned)bytes, (long long)t_build);
+
+  OvmsMutexLock mg(&m_mgconn_mutex);
+  RC4_CTX1 tx1 = m_crypto_tx1;
+  RC4_CTX2 tx2 = m_crypto_tx2;
+  RC4_CTX1 p1 = m_pcrypto1;
+  RC4_CTX2 p2 = m_pcrypto2;
+  bool ptoken_ready = m_ptoken_ready;
+  uint8_t pdigest[OVMS_MD5_SIZE];
+  memcpy(pdigest, m_pdigest, sizeof(pdigest));
+
+  if (!ptoken_ready)
+    {
+    // Fake a paranoid key for the benchmark:
+    memset(m_pdigest, 0x5a, sizeof(m_pdigest));
+    ParanoidSetup();
+    }
+
+#ifdef CONFIG_HEAP_TRACING
+  heap_trace_record_t* trace = (heap_trace_record_t*)
+    InternalRamMalloc(sizeof(heap_trace_record_t) * SERVER_V2_BENCH_TRACE);
+#endif // #ifdef CONFIG_HEAP_TRACING
+
+  for (int paranoid=0; paranoid<2; paranoid++)
+    {
+    m_ptoken_ready = paranoid;
+    size_t outbytes = 0;
+#ifdef CONFIG_HEAP_TRACING
+    // Note: this also records allocations by other tasks during the run
+    bool tracing = (trace != NULL &&
+      heap_trace_init_standalone(trace, SERVER_V2_BENCH_TRACE) == ESP_OK &&
+      heap_trace_start(HEAP_TRACE_ALL) == ESP_OK);
+#endif // #ifdef CONFIG_HEAP_TRACING
+    t0 = esp_timer_get_time();
+    for (int i=0; i<count; i++)
+      {
+      for (auto& m : msgs)
+        outbytes += EncodeMessage(m);
+      }
+    int64_t t = esp_timer_get_time() - t0;
+    unsigned n = count * msgs.size();
+    writer->printf("%-8s: %u msgs in %lld us = %.0f msgs/s, %.1f us/msg, %u bytes out",
+      paranoid ? "paranoid" : "plain", n, (long long)t,
+      (t > 0) ? (double)n * 1000000.0 / t : 0.0,
+      (double)t / n, (unsigned)outbytes);
+#ifdef CONFIG_HEAP_TRACING
+    if (tracing)
+      {
+      heap_trace_stop();
+      size_t allocs = heap_trace_get_count();
+      writer->printf(", %s%.3f heap allocs/msg\n",
+        (allocs >= SERVER_V2_BENCH_TRACE) ? ">=" : "", (double)allocs / n);
+      }
+    else
+      writer->puts(", heap allocs/msg: tracing unavailable");
+#else
+    writer->puts(", heap allocs/msg: n/a (needs CONFIG_HEAP_TRACING)");
+#endif // #ifdef CONFIG_HEAP_TRACING
+    }
 
-  delete [] buf;
-  delete [] s;
+#ifdef CONFIG_HEAP_TRACING
+  if (trace)
+    {
+    heap_trace_init_standalone(NULL, 0);
+    free(trace);
+    }
+#endif // #ifdef CONFIG_HEAP_TRACING
+
+  m_crypto_tx1 = tx1;
+  m_crypto_tx2 = tx2;
+  m_pcrypto1 = p1;
+  m_pcrypto2 = p2;
+  memcpy(m_pdigest, pdigest, sizeof(pdigest));
+  m_ptoken_ready = ptoken_ready;
+  writer->printf("Scratch buffers: 2 x %u bytes, %u buffer allocations total\n",
+    (unsigned)m_txbuf_size, m_txbuf_allocs);
   }
 
 void OvmsServerV2::SetStatus(const char* status, bool fault, State newstate)
@@ -987,6 +1126,14 @@ void OvmsServerV2::TransmitMsgStat(bool always)
   // Quick exit if nothing modified
   if ((!always)&&(!modified)) return;
 
+  Transmit(BuildMsgStat());
+  }
+
+/**
+ * BuildMsgStat: build the current stat (S) message
+ */
+std::string OvmsServerV2::BuildMsgStat()
+  {
   int mins_range = StandardMetrics.ms_v_charge_duration_range->AsInt();
   int mins_soc = StandardMetrics.ms_v_charge_duration_soc->AsInt();
   bool charging = StandardMetrics.ms_v_charge_inprogress->AsBool();
@@ -1069,7 +1216,7 @@ void OvmsServerV2::TransmitMsgStat(bool always)
     << StandardMetrics.ms_v_charge_efficiency->AsFloat()
     ;
 
-  Transmit(buffer.str().c_str());
+  return buffer.str().c_str();
   }
 
 void OvmsServerV2::TransmitMsgGPS(bool always)
@@ -1093,6 +1240,14 @@ void OvmsServerV2::TransmitMsgGPS(bool always)
   // Quick exit if nothing modified
   if ((!always)&&(!modified)) return;
 
+  Transmit(BuildMsgGPS());
+  }
+
+/**
+ * BuildMsgGPS: build the current location (L) message
+ */
+std::string OvmsServerV2::BuildMsgGPS()
+  {
   bool stale =
     StandardMetrics.ms_v_pos_latitude->IsStale() ||
     StandardMetrics.ms_v_pos_longitude->IsStale() ||
@@ -1132,7 +1287,7 @@ void OvmsServerV2::TransmitMsgGPS(bool always)
     << StandardMetrics.ms_v_inv_efficiency->AsFloat()
     ;
 
-  Transmit(buffer.str().c_str());
+  return buffer.str().c_str();
   }
 
 void OvmsServerV2::TransmitMsgTPMS(bool always)
@@ -1337,6 +1492,14 @@ void OvmsServerV2::TransmitMsgEnvironment(bool always)
   // Quick exit if nothing modified
   if ((!always)&&(!modified)) return;
 
+  Transmit(BuildMsgEnvironment());
+  }
+
+/**
+ * BuildMsgEnvironment: build the current environment (D) message
+ */
+std::string OvmsServerV2::BuildMsgEnvironment()
+  {
   // v2 has one "stale" flag for all temperatures, we say they're stale only if
   // all are stale, IE one valid temperature makes them all valid
   bool stale_temps =
@@ -1393,7 +1556,7 @@ void OvmsServerV2::TransmitMsgEnvironment(bool always)
     << StandardMetrics.ms_v_env_cabintemp->AsString("0")
     ;
 
-  Transmit(buffer.str().c_str());
+  return buffer.str().c_str();
   }
 
 void OvmsServerV2::TransmitMsgCapabilities(bool always)
@@ -1836,6 +1999,11 @@ OvmsServerV2::OvmsServerV2(const char* name)
   m_peers = 0;
   m_connretry = 0;
   m_mgconn = NULL;
+  m_ptoken_ready = false;
+  m_txbuf1 = NULL;
+  m_txbuf2 = NULL;
+  m_txbuf_size = 0;
+  m_txbuf_allocs = 0;
 
   m_pending_notify_info = false;
   m_pending_notify_error = false;
@@ -1898,6 +2066,8 @@ OvmsServerV2::~OvmsServerV2()
     delete m_buffer;
     m_buffer = NULL;
     }
+  if (m_txbuf1) delete [] m_txbuf1;
+  if (m_txbuf2) delete [] m_txbuf2;
   MyEvents.SignalEvent("server.v2.stopped", NULL);
   }
 
@@ -1977,6 +2147,22 @@ void ovmsv2_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc
     }
   }
 
+void ovmsv2_bench(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyOvmsServerV2 == NULL)
+    {
+    writer->puts("OVMS v2 server has not been started");
+    return;
+    }
+  int count = (argc > 0) ? atoi(argv[0]) : 1000;
+  if (count <= 0)
+    {
+    writer->puts("Error: invalid count");
+    return;
+    }
+  MyOvmsServerV2->TransmitBenchmark(writer, count);
+  }
+
 OvmsServerV2Init MyOvmsServerV2Init  __attribute__ ((init_priority (6100)));
 
 OvmsServerV2Init::OvmsServerV2Init()
@@ -1988,6 +2174,7 @@ OvmsServerV2Init::OvmsServerV2Init()
   cmd_v2->RegisterCommand("start","Start an OVMS V2 Server Connection",ovmsv2_start);
   cmd_v2->RegisterCommand("stop","Stop an OVMS V2 Server Connection",ovmsv2_stop);
   cmd_v2->RegisterCommand("status","Show OVMS V2 Server connection status",ovmsv2_status);
+  cmd_v2->RegisterCommand("bench","Benchmark OVMS V2 message encoding",ovmsv2_bench,"[<count>]",0,1);
 
   MyConfig.RegisterParam("server.v2", "V2 Server Configuration", true, true);
   // Our instances:
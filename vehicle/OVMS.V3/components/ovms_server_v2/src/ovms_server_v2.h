@@ -33,6 +33,7 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 #include <iostream>
 #include <iomanip>
 #include <sys/time.h>
@@ -44,6 +45,7 @@
 #include "ovms_metrics.h"
 #include "ovms_notify.h"
 #include "ovms_mutex.h"
+#include "ovms_command.h"
 
 #define OVMS_PROTOCOL_V2_TOKENSIZE 22
 
@@ -65,8 +67,17 @@ class OvmsServerV2 : public OvmsServer
     void ProcessServerMsg();
     void ProcessCommand(const char* payload);
     void Transmit(const std::string& message);
+    size_t EncodeMessage(const std::string& message);
+    void TransmitBuffers(size_t len);
+    void ParanoidSetup();
+
+  public:
+    void TransmitBenchmark(OvmsWriter* writer, int count);
 
   protected:
+    std::string BuildMsgStat();
+    std::string BuildMsgGPS();
+    std::string BuildMsgEnvironment();
     void TransmitMsgStat(bool always = false);
     void TransmitMsgGPS(bool always = false);
     void TransmitMsgTPMS(bool always = false);
@@ -136,6 +147,13 @@ class OvmsServerV2 : public OvmsServer
     uint8_t m_pdigest[OVMS_MD5_SIZE];
     std::string m_ptoken;
     bool m_ptoken_ready;
+    RC4_CTX1 m_pcrypto1;                  // paranoid cipher state after 1024 byte discard
+    RC4_CTX2 m_pcrypto2;
+
+    char* m_txbuf1;                       // transmit scratch buffers, grown to largest message
+    char* m_txbuf2;
+    size_t m_txbuf_size;
+    uint32_t m_txbuf_allocs;
 
     bool m_now_stat;
     bool m_now_gps;
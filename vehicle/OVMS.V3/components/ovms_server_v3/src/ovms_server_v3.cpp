@@ -42,6 +42,7 @@ static const char *TAG = "ovms-server-v3";
 
 OvmsServerV3 *MyOvmsServerV3 = NULL;
 size_t MyOvmsServerV3Modifier = 0;
+OvmsMetricJournal* MyOvmsServerV3Journal = NULL;
 size_t MyOvmsServerV3Reader = 0;
 
 bool OvmsServerV3ReaderCallback(OvmsNotifyType* type, OvmsNotifyEntry* entry)
@@ -178,16 +179,19 @@ static void OvmsServerV3MongooseCallback(struct mg_connection *nc, int ev, void
     }
   }
 
-OvmsServerV3::OvmsServerV3(const char* name)
+OvmsServerV3::OvmsServerV3(const char* name, OvmsServerV3Loopback* loopback /*=NULL*/)
   : OvmsServer(name)
   {
   if (MyOvmsServerV3Modifier == 0)
     {
     MyOvmsServerV3Modifier = MyMetrics.RegisterModifier();
     ESP_LOGI(TAG, "OVMS Server V3 registered metric modifier is #%d",MyOvmsServerV3Modifier);
+    MyOvmsServerV3Journal = MyMetrics.RegisterJournal(TAG, MyOvmsServerV3Modifier);
     }
 
-  SetStatus("Server has been started", false, WaitNetwork);
+  m_loopback = loopback;
+  if (!m_loopback)
+    SetStatus("Server has been started", false, WaitNetwork);
   m_connretry = 0;
   m_mgconn = NULL;
   m_sendall = false;
@@ -204,6 +208,25 @@ OvmsServerV3::OvmsServerV3(const char* name)
   m_notify_data_waitcomp = 0;
   m_notify_data_waittype = NULL;
   m_notify_data_waitentry = NULL;
+  m_metric_interval = 0;
+  m_metric_batch = false;
+  m_stat_publish = 0;
+  m_stat_bytes = 0;
+  m_stat_coalesced = 0;
+  m_stat_batches = 0;
+  m_stat_publish_last = 0;
+  m_stat_bytes_last = 0;
+  m_stat_publish_rate = 0;
+  m_stat_bytes_rate = 0;
+
+  if (m_loopback)
+    {
+    // Test instance: no connection, event or metric listeners
+    m_state = Undefined;
+    m_msgid = 1;
+    m_topic_prefix = "ovms/loopback/";
+    return;
+    }
 
   ESP_LOGI(TAG, "OVMS Server v3 running");
 
@@ -246,6 +269,8 @@ OvmsServerV3::OvmsServerV3(const char* name)
 
 OvmsServerV3::~OvmsServerV3()
   {
+  if (m_loopback)
+    return;
   MyMetrics.DeregisterListener(TAG);
   MyEvents.DeregisterEvent(TAG);
   MyNotify.ClearReader(MyOvmsServerV3Reader);
@@ -259,6 +284,9 @@ void OvmsServerV3::TransmitAllMetrics()
   if (!m_mgconn)
     return;
 
+  if (MyOvmsServerV3Journal)
+    MyOvmsServerV3Journal->Clear();
+
   OvmsMetric* metric = MyMetrics.m_first;
   while (metric != NULL)
     {
@@ -274,19 +302,102 @@ void OvmsServerV3::TransmitModifiedMetrics()
   if (!m_mgconn)
     return;
 
-  OvmsMetric* metric = MyMetrics.m_first;
-  while (metric != NULL)
+  OvmsMetric* metric;
+  if (MyOvmsServerV3Journal)
     {
-    if (metric->IsModifiedAndClear(MyOvmsServerV3Modifier))
+    // Only check the metrics changed since the last round:
+    while ((metric = MyOvmsServerV3Journal->NextModified()) != NULL)
       {
-      TransmitMetric(metric);
+      if (m_metric_batch)
+        BatchMetric(metric);
+      else
+        TransmitMetric(metric);
       }
-    metric = metric->m_next;
     }
+  else
+    {
+    metric = MyMetrics.m_first;
+    while (metric != NULL)
+      {
+      if (metric->IsModifiedAndClear(MyOvmsServerV3Modifier))
+        {
+        if (m_metric_batch)
+          BatchMetric(metric);
+        else
+          TransmitMetric(metric);
+        }
+      metric = metric->m_next;
+      }
+    }
+
+  if (m_metric_batch)
+    TransmitPendingMetrics(true);
+  }
+
+/**
+ * Publish: send an MQTT message, count the traffic.
+ *  Call with m_mgconn_mutex held. Returns the message id.
+ */
+int OvmsServerV3::Publish(const std::string& topic, const char* payload, size_t len, int flags)
+  {
+  int id = m_msgid++;
+  if (m_loopback)
+    m_loopback->push_back(std::make_pair(topic, std::string(payload, len)));
+  else
+    mg_mqtt_publish(m_mgconn, topic.c_str(), id, flags, payload, len);
+  m_stat_publish++;
+  m_stat_bytes += topic.length() + len;
+  return id;
+  }
+
+/**
+ * MetricTxState: get the transmission state of a metric, building the
+ *  topic on first use. Returns NULL for metrics without a journal slot.
+ *  Call with m_mgconn_mutex held.
+ */
+OvmsServerV3MetricTx* OvmsServerV3::MetricTxState(OvmsMetric* metric)
+  {
+  int slot = metric->m_slot;
+  if (slot < 0)
+    return NULL;
+  if ((size_t)slot >= m_metric_tx.size())
+    m_metric_tx.resize(slot + 32, { NULL, std::string(), 0, false });
+
+  OvmsServerV3MetricTx* tx = &m_metric_tx[slot];
+  if (tx->metric != metric)
+    {
+    // New metric or slot reused:
+    tx->metric = metric;
+    tx->lasttx = 0;
+    tx->pending = false;
+    tx->topic.reserve(m_topic_prefix.length() + 7 + strlen(metric->m_name));
+    tx->topic.assign(m_topic_prefix);
+    tx->topic.append("metric/");
+    tx->topic.append(metric->m_name);
+    // Replace '.' inside the metric name by '/' for MQTT like namespacing.
+    for (size_t i = m_topic_prefix.length(); i < tx->topic.length(); i++)
+      {
+      if (tx->topic[i] == '.')
+        tx->topic[i] = '/';
+      }
+    }
+  return tx;
   }
 
 void OvmsServerV3::TransmitMetric(OvmsMetric* metric)
   {
+  std::string val = metric->AsString();
+
+  OvmsServerV3MetricTx* tx = MetricTxState(metric);
+  if (tx)
+    {
+    Publish(tx->topic, val.c_str(), val.length(), MG_MQTT_QOS(0) | MG_MQTT_RETAIN);
+    tx->lasttx = esp_log_timestamp();
+    tx->pending = false;
+    ESP_LOGD(TAG,"Tx metric %s=%s",tx->topic.c_str(),val.c_str());
+    return;
+    }
+
   std::string topic(m_topic_prefix);
   topic.append("metric/");
   topic.append(metric->m_name);
@@ -298,11 +409,111 @@ void OvmsServerV3::TransmitMetric(OvmsMetric* metric)
         topic[i] = '/';
     }
 
-  std::string val = metric->AsString();
+  Publish(topic, val.c_str(), val.length(), MG_MQTT_QOS(0) | MG_MQTT_RETAIN);
+  ESP_LOGD(TAG,"Tx metric %s=%s",topic.c_str(),val.c_str());
+  }
+
+/**
+ * QueueMetric: streaming update of a metric. The metric is published
+ *  immediately if its last publish is older than the metric interval,
+ *  else it is marked pending and sent by the next TransmitPendingMetrics()
+ *  round with its then current value (coalescing intermediate changes).
+ *  In batch mode, all updates are deferred to the next round.
+ */
+void OvmsServerV3::QueueMetric(OvmsMetric* metric)
+  {
+  OvmsServerV3MetricTx* tx = MetricTxState(metric);
+  if (!tx)
+    {
+    TransmitMetric(metric);
+    return;
+    }
+  if (tx->pending)
+    {
+    m_stat_coalesced++;
+    return;
+    }
+  if (!m_metric_batch &&
+      (m_metric_interval <= 0 || esp_log_timestamp() - tx->lasttx >= (uint32_t)m_metric_interval))
+    {
+    TransmitMetric(metric);
+    return;
+    }
+  tx->pending = true;
+  m_metric_pending.push_back(metric->m_slot);
+  }
+
+/**
+ * TransmitPendingMetrics: publish pending metrics with an expired
+ *  interval (force: all pending metrics), then send the batch if any.
+ *  Call with m_mgconn_mutex held.
+ */
+void OvmsServerV3::TransmitPendingMetrics(bool force)
+  {
+  uint32_t now = esp_log_timestamp();
+  size_t keep = 0;
+  for (size_t i = 0; i < m_metric_pending.size(); i++)
+    {
+    int slot = m_metric_pending[i];
+    OvmsServerV3MetricTx* tx = &m_metric_tx[slot];
+    if (!tx->pending || MyMetrics.GetBySlot(slot) != tx->metric)
+      continue; // already sent or metric deregistered
+    if (m_metric_batch)
+      BatchMetric(tx->metric);
+    else if (force || m_metric_interval <= 0 || now - tx->lasttx >= (uint32_t)m_metric_interval)
+      TransmitMetric(tx->metric);
+    else
+      m_metric_pending[keep++] = slot;
+    }
+  m_metric_pending.resize(keep);
+  TransmitBatch();
+  }
+
+/**
+ * BatchMetric: add a metric to the JSON batch, sending the batch first
+ *  if it would exceed MQTT_BATCH_SIZE.
+ *  Call with m_mgconn_mutex held.
+ */
+void OvmsServerV3::BatchMetric(OvmsMetric* metric)
+  {
+  size_t start = m_batch.length();
+  m_batch.append(m_batch.empty() ? "{\"" : ",\"");
+  m_batch.append(metric->m_name);
+  m_batch.append("\":");
+  metric->AppendJSON(m_batch);
+  if (m_batch.length() + 1 > MQTT_BATCH_SIZE && start > 0)
+    {
+    // Move this entry to the next batch:
+    std::string entry = m_batch.substr(start + 1);
+    m_batch.resize(start);
+    TransmitBatch();
+    m_batch.assign("{");
+    m_batch.append(entry);
+    }
 
-  mg_mqtt_publish(m_mgconn, topic.c_str(), m_msgid++,
-    MG_MQTT_QOS(0) | MG_MQTT_RETAIN, val.c_str(), val.length());
-  ESP_LOGI(TAG,"Tx metric %s=%s",topic.c_str(),val.c_str());
+  OvmsServerV3MetricTx* tx = MetricTxState(metric);
+  if (tx)
+    {
+    tx->lasttx = esp_log_timestamp();
+    tx->pending = false;
+    }
+  }
+
+/**
+ * TransmitBatch: send the JSON batch to <prefix>metrics.
+ *  Call with m_mgconn_mutex held.
+ */
+void OvmsServerV3::TransmitBatch()
+  {
+  if (m_batch.empty())
+    return;
+  m_batch.append("}");
+  std::string topic(m_topic_prefix);
+  topic.append("metrics");
+  Publish(topic, m_batch.data(), m_batch.length(), MG_MQTT_QOS(0));
+  ESP_LOGD(TAG,"Tx metrics batch %u bytes",(unsigned)m_batch.length());
+  m_stat_batches++;
+  m_batch.clear();
   }
 
 int OvmsServerV3::TransmitNotificationInfo(OvmsNotifyEntry* entry)
@@ -313,9 +524,7 @@ int OvmsServerV3::TransmitNotificationInfo(OvmsNotifyEntry* entry)
 
   const extram::string result = mp_encode(entry->GetValue());
 
-  int id = m_msgid++;
-  mg_mqtt_publish(m_mgconn, topic.c_str(), id,
-    MG_MQTT_QOS(1), result.c_str(), result.length());
+  int id = Publish(topic, result.c_str(), result.length(), MG_MQTT_QOS(1));
   ESP_LOGI(TAG,"Tx notify %s=%s",topic.c_str(),result.c_str());
   return id;
   }
@@ -328,9 +537,7 @@ int OvmsServerV3::TransmitNotificationError(OvmsNotifyEntry* entry)
 
   const extram::string result = mp_encode(entry->GetValue());
 
-  int id = m_msgid++;
-  mg_mqtt_publish(m_mgconn, topic.c_str(), id,
-    MG_MQTT_QOS(1), result.c_str(), result.length());
+  int id = Publish(topic, result.c_str(), result.length(), MG_MQTT_QOS(1));
   ESP_LOGI(TAG,"Tx notify %s=%s",topic.c_str(),result.c_str());
   return id;
   }
@@ -343,9 +550,7 @@ int OvmsServerV3::TransmitNotificationAlert(OvmsNotifyEntry* entry)
 
   const extram::string result = mp_encode(entry->GetValue());
 
-  int id = m_msgid++;
-  mg_mqtt_publish(m_mgconn, topic.c_str(), id,
-    MG_MQTT_QOS(1), result.c_str(), result.length());
+  int id = Publish(topic, result.c_str(), result.length(), MG_MQTT_QOS(1));
   ESP_LOGI(TAG,"Tx notify %s=%s",topic.c_str(),result.c_str());
   return id;
   }
@@ -370,9 +575,7 @@ int OvmsServerV3::TransmitNotificationData(OvmsNotifyEntry* entry)
 
   const char* result = msg.c_str();
 
-  int id = m_msgid++;
-  mg_mqtt_publish(m_mgconn, topic.c_str(), id,
-    MG_MQTT_QOS(2), result, strlen(result));
+  int id = Publish(topic, result, strlen(result), MG_MQTT_QOS(2));
   ESP_LOGI(TAG,"Tx notify %s=%s",topic.c_str(),result);
   return id;
   }
@@ -525,8 +728,7 @@ void OvmsServerV3::IncomingEvent(std::string event, void* data)
   topic.append("event");
 
   ESP_LOGI(TAG,"Tx event %s",event.c_str());
-  mg_mqtt_publish(m_mgconn, topic.c_str(), m_msgid++,
-    MG_MQTT_QOS(0), event.c_str(), event.length());
+  Publish(topic, event.c_str(), event.length(), MG_MQTT_QOS(0));
   }
 
 void OvmsServerV3::RunCommand(std::string client, std::string id, std::string command)
@@ -545,8 +747,7 @@ void OvmsServerV3::RunCommand(std::string client, std::string id, std::string co
   topic.append(client);
   topic.append("/response/");
   topic.append(id);
-  mg_mqtt_publish(m_mgconn, topic.c_str(), m_msgid++,
-    MG_MQTT_QOS(1), val.c_str(), val.length());
+  Publish(topic, val.c_str(), val.length(), MG_MQTT_QOS(1));
   }
 
 void OvmsServerV3::AddClient(std::string id)
@@ -664,6 +865,10 @@ void OvmsServerV3::Connect()
 
   SetStatus("Connecting...", false, Connecting);
   OvmsMutexLock mg(&m_mgconn_mutex);
+  // Topic prefix may have changed:
+  m_metric_tx.clear();
+  m_metric_pending.clear();
+  m_batch.clear();
   struct mg_mgr* mgr = MyNetManager.GetMongooseMgr();
   struct mg_connect_opts opts;
   const char* err;
@@ -746,7 +951,7 @@ void OvmsServerV3::MetricModified(OvmsMetric* metric)
     if (!m_mgconn)
       return;
     metric->ClearModified(MyOvmsServerV3Modifier);
-    TransmitMetric(metric);
+    QueueMetric(metric);
     }
   }
 
@@ -812,6 +1017,8 @@ void OvmsServerV3::ConfigChanged(OvmsConfigParam* param)
   m_streaming = MyConfig.GetParamValueInt("vehicle", "stream", 0);
   m_updatetime_connected = MyConfig.GetParamValueInt("server.v3", "updatetime.connected", 60);
   m_updatetime_idle = MyConfig.GetParamValueInt("server.v3", "updatetime.idle", 600);
+  m_metric_interval = MyConfig.GetParamValueInt("server.v3", "metric.interval", 0);
+  m_metric_batch = MyConfig.GetParamValueBool("server.v3", "metrics.batch", false);
   }
 
 void OvmsServerV3::NetUp(std::string event, void* data)
@@ -898,6 +1105,12 @@ void OvmsServerV3::Ticker1(std::string event, void* data)
     if ((m_notify_data_pending)&&(m_notify_data_waitcomp==0))
       TransmitPendingNotificationsData();
 
+      {
+      OvmsMutexLock mg(&m_mgconn_mutex);
+      if (m_mgconn && !m_metric_pending.empty())
+        TransmitPendingMetrics(false);
+      }
+
     bool caron = StandardMetrics.ms_v_env_on->AsBool();
     int now = StandardMetrics.ms_m_monotonic->AsInt();
     int next = (m_peers==0) ? m_updatetime_idle : m_updatetime_connected;
@@ -917,6 +1130,11 @@ void OvmsServerV3::Ticker1(std::string event, void* data)
 void OvmsServerV3::Ticker60(std::string event, void* data)
   {
   CountClients();
+
+  m_stat_publish_rate = (float)(m_stat_publish - m_stat_publish_last) / 60;
+  m_stat_bytes_rate = (float)(m_stat_bytes - m_stat_bytes_last) / 60;
+  m_stat_publish_last = m_stat_publish;
+  m_stat_bytes_last = m_stat_bytes;
   }
 
 void OvmsServerV3::SetPowerMode(PowerMode powermode)
@@ -990,7 +1208,180 @@ void ovmsv3_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc
         break;
       }
     writer->printf("       %s\n",MyOvmsServerV3->m_status.c_str());
+    writer->printf("Publish: %u messages, %u bytes (last minute: %.1f/s, %.0f bytes/s)\n",
+      MyOvmsServerV3->m_stat_publish, MyOvmsServerV3->m_stat_bytes,
+      MyOvmsServerV3->m_stat_publish_rate, MyOvmsServerV3->m_stat_bytes_rate);
+    writer->printf("Metrics: interval %d ms, %u updates coalesced, %u batches%s\n",
+      MyOvmsServerV3->m_metric_interval, MyOvmsServerV3->m_stat_coalesced,
+      MyOvmsServerV3->m_stat_batches, MyOvmsServerV3->m_metric_batch ? " (batch mode)" : "");
+    }
+  }
+
+/**
+ * ovmsv3_loopback: test metric streaming on a loopback connection:
+ *  interval coalescing (publish rate, no lost final values), batch
+ *  splitting and immediate mode.
+ */
+void ovmsv3_loopback(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int count = (argc > 0) ? atoi(argv[0]) : 50;
+  if (count < 1 || count > 1000)
+    {
+    writer->puts("Error: 1..1000 metrics");
+    return;
+    }
+  if (MyOvmsServerV3 != NULL)
+    {
+    writer->puts("Error: stop the V3 server first");
+    return;
+    }
+
+  OvmsServerV3Loopback sent;
+  OvmsServerV3* server = new OvmsServerV3("oscv3-loopback", &sent);
+  std::string prefix = server->m_topic_prefix;
+  char* names = (char*) ExternalRamCalloc(count, 32);
+  std::vector<OvmsMetricInt*> metrics;
+  for (int i = 0; i < count; i++)
+    {
+    char* name = names + i * 32;
+    snprintf(name, 32, "x.v3test.loopback.m%04d", i);
+    metrics.push_back(new OvmsMetricInt(name));
+    }
+  int value = 0;
+  int errors = 0;
+
+  // Interval mode: change all metrics every tick for 2 seconds,
+  //  run the pending queue every 100 ms (standing in for Ticker1):
+  const int interval = 200;
+  server->m_metric_interval = interval;
+  uint32_t changes = 0;
+  uint32_t started = esp_log_timestamp();
+  uint32_t lastticker = started;
+  while (esp_log_timestamp() - started < 2000)
+    {
+    for (OvmsMetricInt* m : metrics)
+      {
+      m->SetValue(++value);
+      OvmsMutexLock mg(&server->m_mgconn_mutex);
+      server->QueueMetric(m);
+      changes++;
+      }
+    if (esp_log_timestamp() - lastticker >= 100)
+      {
+      OvmsMutexLock mg(&server->m_mgconn_mutex);
+      server->TransmitPendingMetrics(false);
+      lastticker = esp_log_timestamp();
+      }
+    vTaskDelay(1);
+    }
+  uint32_t elapsed = esp_log_timestamp() - started;
+  server->m_mgconn_mutex.Lock();
+  server->TransmitPendingMetrics(true);
+  server->m_mgconn_mutex.Unlock();
+
+  int stale = 0;
+  for (OvmsMetricInt* m : metrics)
+    {
+    std::string topic = prefix + "metric/" + m->m_name;
+    for (size_t i = prefix.length(); i < topic.length(); i++)
+      if (topic[i] == '.') topic[i] = '/';
+    std::string last;
+    for (auto& msg : sent)
+      if (msg.first == topic) last = msg.second;
+    if (last != m->AsString())
+      stale++;
+    }
+  uint32_t published = sent.size();
+  writer->printf("Interval %d ms: %u changes, %u publishes (%.1f/s), %u coalesced, %d stale\n",
+    interval, changes, published, (float)published * 1000 / elapsed,
+    server->m_stat_coalesced, stale);
+  if (published + server->m_stat_coalesced != changes)
+    {
+    writer->puts("Error: publishes + coalesced != changes");
+    errors++;
+    }
+  if (published > (uint32_t)count * (elapsed / interval + 2))
+    {
+    writer->puts("Error: publish rate exceeds the metric interval");
+    errors++;
     }
+  if (stale)
+    {
+    writer->puts("Error: final values not published");
+    errors++;
+    }
+
+  // Batch mode: one change per metric, split into MQTT_BATCH_SIZE publishes:
+  sent.clear();
+  server->m_metric_batch = true;
+  for (OvmsMetricInt* m : metrics)
+    {
+    m->SetValue(++value);
+    OvmsMutexLock mg(&server->m_mgconn_mutex);
+    server->QueueMetric(m);
+    }
+  server->m_mgconn_mutex.Lock();
+  server->TransmitPendingMetrics(false);
+  server->m_mgconn_mutex.Unlock();
+  size_t maxlen = 0;
+  int missing = 0;
+  for (auto& msg : sent)
+    {
+    if (msg.first != prefix + "metrics" || msg.second.length() > MQTT_BATCH_SIZE
+      || msg.second.front() != '{' || msg.second.back() != '}')
+      errors++;
+    if (msg.second.length() > maxlen)
+      maxlen = msg.second.length();
+    }
+  for (OvmsMetricInt* m : metrics)
+    {
+    std::string entry = std::string("\"") + m->m_name + "\":" + m->AsString();
+    int found = 0;
+    for (auto& msg : sent)
+      {
+      size_t pos = msg.second.find(entry);
+      if (pos != std::string::npos
+        && (msg.second[pos + entry.length()] == ',' || msg.second[pos + entry.length()] == '}'))
+        found++;
+      }
+    if (found != 1)
+      missing++;
+    }
+  writer->printf("Batch: %d metrics in %u publishes, max payload %u bytes, %d missing/duplicate\n",
+    count, (unsigned)sent.size(), (unsigned)maxlen, missing);
+  if (missing || (maxlen > MQTT_BATCH_SIZE))
+    {
+    writer->puts("Error: batch incomplete or oversized");
+    errors++;
+    }
+
+  // Immediate mode (interval 0): every change is published:
+  sent.clear();
+  server->m_metric_batch = false;
+  server->m_metric_interval = 0;
+  uint32_t coalesced = server->m_stat_coalesced;
+  for (int k = 0; k < 3; k++)
+    {
+    for (OvmsMetricInt* m : metrics)
+      {
+      m->SetValue(++value);
+      OvmsMutexLock mg(&server->m_mgconn_mutex);
+      server->QueueMetric(m);
+      }
+    }
+  writer->printf("Immediate: %d changes, %u publishes, %u coalesced\n",
+    count * 3, (unsigned)sent.size(), server->m_stat_coalesced - coalesced);
+  if (sent.size() != (size_t)count * 3)
+    {
+    writer->puts("Error: immediate mode did not publish every change");
+    errors++;
+    }
+
+  delete server;
+  for (OvmsMetricInt* m : metrics)
+    MyMetrics.DeregisterMetric(m);
+  free(names);
+  writer->puts(errors ? "Loopback test FAILED" : "Loopback test OK");
   }
 
 OvmsServerV3Init MyOvmsServerV3Init  __attribute__ ((init_priority (6200)));
@@ -1004,6 +1395,7 @@ OvmsServerV3Init::OvmsServerV3Init()
   cmd_v3->RegisterCommand("start","Start an OVMS V3 Server Connection",ovmsv3_start);
   cmd_v3->RegisterCommand("stop","Stop an OVMS V3 Server Connection",ovmsv3_stop);
   cmd_v3->RegisterCommand("status","Show OVMS V3 Server connection status",ovmsv3_status);
+  cmd_v3->RegisterCommand("loopback","Test metric streaming on a loopback connection",ovmsv3_loopback,"[<#metrics>]",0,1);
 
   using std::placeholders::_1;
   using std::placeholders::_2;
@@ -1014,6 +1406,8 @@ OvmsServerV3Init::OvmsServerV3Init()
   //   'server': The server name/ip
   //   'user': The server username
   //   'port': The port to connect to (default: 1883)
+  //   'metric.interval': Min ms between streamed updates of a metric (default: 0=off)
+  //   'metrics.batch': Send metric changes as JSON on <prefix>metrics (default: no)
   // Also note:
   //  Parameter "vehicle", instance "id", is the vehicle ID
   //  Parameter "password", instance "server.v3", is the server password
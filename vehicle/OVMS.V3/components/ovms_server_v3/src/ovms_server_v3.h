@@ -33,6 +33,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include "ovms_server.h"
 #include "ovms_netmanager.h"
 #include "ovms_metrics.h"
@@ -43,11 +44,28 @@
 typedef std::map<std::string, uint32_t> OvmsServerV3ClientMap;
 
 #define MQTT_CONN_NTOPICS 2
+#define MQTT_BATCH_SIZE 1024          // max payload size of a batched metrics publish
+
+/**
+ * Per metric transmission state, indexed by the metric journal slot:
+ *  the precomputed topic, the time of the last publish (ms) and the
+ *  coalescing flag (value changed, publish deferred to the next window).
+ */
+typedef struct
+  {
+  OvmsMetric* metric;
+  std::string topic;
+  uint32_t lasttx;
+  bool pending;
+  } OvmsServerV3MetricTx;
+
+// Loopback stand-in for the MQTT connection (testing): topic & payload of each publish
+typedef std::vector< std::pair<std::string, std::string> > OvmsServerV3Loopback;
 
 class OvmsServerV3 : public OvmsServer
   {
   public:
-    OvmsServerV3(const char* name);
+    OvmsServerV3(const char* name, OvmsServerV3Loopback* loopback=NULL);
     ~OvmsServerV3();
 
   public:
@@ -110,6 +128,22 @@ class OvmsServerV3 : public OvmsServer
     OvmsNotifyEntry* m_notify_data_waitentry;
     OvmsServerV3ClientMap m_clients;
 
+    OvmsServerV3Loopback* m_loopback;     // test instance: publish into this, no connection
+    int m_metric_interval;                // min ms between publishes of a metric (0=off)
+    bool m_metric_batch;                  // send changes as JSON batch on <prefix>metrics
+    std::vector<OvmsServerV3MetricTx> m_metric_tx;
+    std::vector<int> m_metric_pending;    // slots with pending publish
+    std::string m_batch;
+
+    uint32_t m_stat_publish;
+    uint32_t m_stat_bytes;
+    uint32_t m_stat_coalesced;
+    uint32_t m_stat_batches;
+    uint32_t m_stat_publish_last;
+    uint32_t m_stat_bytes_last;
+    float m_stat_publish_rate;            // publish/s over the last minute
+    float m_stat_bytes_rate;              // bytes/s over the last minute
+
   public:
     virtual void SetPowerMode(PowerMode powermode);
     void Connect();
@@ -133,7 +167,15 @@ class OvmsServerV3 : public OvmsServer
     void CountClients();
 
   private:
+    int Publish(const std::string& topic, const char* payload, size_t len, int flags);
+    OvmsServerV3MetricTx* MetricTxState(OvmsMetric* metric);
     void TransmitMetric(OvmsMetric* metric);
+    void QueueMetric(OvmsMetric* metric);
+    void TransmitPendingMetrics(bool force);
+    void BatchMetric(OvmsMetric* metric);
+    void TransmitBatch();
+
+  friend void ovmsv3_loopback(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv);
   };
 
 class OvmsServerV3Init
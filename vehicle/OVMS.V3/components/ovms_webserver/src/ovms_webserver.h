@@ -412,6 +412,7 @@ class WebSocketHandler : public MgHandler, public OvmsWriter
   public:
     size_t                    m_slot = 0;
     size_t                    m_modifier = 0;         // "our" metrics modifier
+    OvmsMetricJournal*        m_journal = NULL;       // "our" metrics change journal
     size_t                    m_reader = 0;           // "our" notification reader id
     QueueHandle_t             m_jobqueue = NULL;
     uint32_t                  m_jobqueue_overflow_status = 0;
@@ -421,6 +422,8 @@ class WebSocketHandler : public MgHandler, public OvmsWriter
     WebSocketTxJob            m_job = {};
     int                       m_sent = 0;
     int                       m_ack = 0;
+    OvmsMetricCursor          m_cursor;               // metrics job position
+    bool                      m_metrics_done = false; // metrics job: all collected
     std::set<std::string>     m_subscriptions;
 };
 
@@ -64,6 +64,7 @@ WebSocketHandler::WebSocketHandler(mg_connection* nc, size_t slot, size_t modifi
   
   m_slot = slot;
   m_modifier = modifier;
+  m_journal = MyMetrics.RegisterJournal(TAG, modifier);
   m_reader = reader;
   m_jobqueue = xQueueCreate(50, sizeof(WebSocketTxJob));
   m_jobqueue_overflow_status = 0;
@@ -116,29 +117,39 @@ void WebSocketHandler::ProcessTxJob()
     case WSTX_MetricsAll:
     case WSTX_MetricsUpdate:
     {
-      // Note: this loops over the metrics by index, keeping the checked count
-      //  in m_sent. It will not detect new metrics added between polls if they are
-      //  inserted before m_sent, so new metrics may not be sent until first changed.
+      // Note: MetricsAll loops over the metrics using a resumable cursor, so every
+      //  chunk continues where the last one stopped. New metrics inserted before the
+      //  cursor position will not be sent until first changed.
       //  The Metrics set normally is static, so this should be no problem.
-      
-      // find start:
-      int i;
-      OvmsMetric* m;
-      for (i=0, m=MyMetrics.m_first; i < m_sent && m != NULL; m=m->m_next, i++);
+      //  MetricsUpdate only checks the metrics marked in our change journal.
       
       // build msg:
+      int i = 0;
+      OvmsMetric* m;
       std::string msg;
       msg.reserve(2*XFER_CHUNK_SIZE+128);
       msg = "{\"metrics\":{";
-      for (i=0; m && msg.size() < XFER_CHUNK_SIZE; m=m->m_next) {
-        if (m->IsModifiedAndClear(m_modifier) || m_job.type == WSTX_MetricsAll) {
-          if (i) msg += ',';
-          msg += '\"';
-          msg += m->m_name;
-          msg += "\":";
-          msg += m->AsJSON();
-          i++;
+      while (!m_metrics_done && msg.size() < XFER_CHUNK_SIZE) {
+        if (m_job.type == WSTX_MetricsUpdate && m_journal) {
+          m = m_journal->NextModified();
+        } else {
+          m = m_cursor.Get();
+          if (m) {
+            m_cursor.Next();
+            if (!m->IsModifiedAndClear(m_modifier) && m_job.type != WSTX_MetricsAll)
+              continue;
+          }
+        }
+        if (!m) {
+          m_metrics_done = true;
+          break;
         }
+        if (i) msg += ',';
+        msg += '\"';
+        msg += m->m_name;
+        msg += "\":";
+        m->AppendJSON(msg);
+        i++;
       }
       
       // send msg:
@@ -150,7 +161,7 @@ void WebSocketHandler::ProcessTxJob()
       }
       
       // done?
-      if (!m && m_ack == m_sent) {
+      if (m_metrics_done && m_ack == m_sent) {
         if (m_sent)
           ESP_EARLY_LOGV(TAG, "WebSocketHandler[%p]: ProcessTxJob type=%d done, sent=%d metrics", m_nc, m_job.type, m_sent);
         ClearTxJob(m_job);
@@ -301,6 +312,10 @@ bool WebSocketHandler::GetNextTxJob()
   if (xQueueReceive(m_jobqueue, &m_job, 0) == pdTRUE) {
     // init new job state:
     m_sent = m_ack = 0;
+    m_cursor.Reset();
+    m_metrics_done = false;
+    if (m_job.type == WSTX_MetricsAll && m_journal)
+      m_journal->Clear();
     return true;
   } else {
     return false;
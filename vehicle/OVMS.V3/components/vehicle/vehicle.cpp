@@ -32,7 +32,9 @@
 static const char *TAG = "vehicle";
 
 #include <stdio.h>
+#include <math.h>
 #include <algorithm>
+#include "esp_timer.h"
 #include <ovms_command.h>
 #include <ovms_script.h>
 #include <ovms_metrics.h>
@@ -43,6 +45,7 @@ static const char *TAG = "vehicle";
 #endif // #ifdef CONFIG_OVMS_COMP_WEBSERVER
 #include <ovms_peripherals.h>
 #include <string_writer.h>
+#include <ovms_malloc.h>
 #include "vehicle.h"
 
 #undef SQR
@@ -64,6 +67,16 @@ static const char *TAG = "vehicle";
 
 OvmsVehicleFactory MyVehicleFactory __attribute__ ((init_priority (2000)));
 
+// Config values read by the tickers & BMS sweeps:
+static OvmsConfigFloat cfg_12v_ref("vehicle", "12v.ref", 12.6);
+static OvmsConfigFloat cfg_12v_alert("vehicle", "12v.alert", 1.6);
+static OvmsConfigInt cfg_minsoc("vehicle", "minsoc", 0);
+static OvmsConfigBool cfg_bms_alerts_enabled("vehicle", "bms.alerts.enabled", true);
+static OvmsConfigFloat cfg_bms_dev_vwarn("vehicle", "bms.dev.voltage.warn");
+static OvmsConfigFloat cfg_bms_dev_valert("vehicle", "bms.dev.voltage.alert");
+static OvmsConfigFloat cfg_bms_dev_twarn("vehicle", "bms.dev.temp.warn");
+static OvmsConfigFloat cfg_bms_dev_talert("vehicle", "bms.dev.temp.alert");
+
 void vehicle_module(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   if (argc == 0)
@@ -97,6 +110,18 @@ void vehicle_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int arg
     }
   }
 
+void vehicle_poll_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  if (MyVehicleFactory.m_currentvehicle != NULL)
+    {
+    MyVehicleFactory.m_currentvehicle->PollerStatus(verbosity, writer);
+    }
+  else
+    {
+    writer->puts("No vehicle module selected");
+    }
+  }
+
 void vehicle_wakeup(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
   if (MyVehicleFactory.m_currentvehicle==NULL)
@@ -806,6 +831,8 @@ OvmsVehicleFactory::OvmsVehicleFactory()
   cmd_vehicle->RegisterCommand("module","Set (or clear) vehicle module",vehicle_module,"<type>",0,1);
   cmd_vehicle->RegisterCommand("list","Show list of available vehicle modules",vehicle_list);
   cmd_vehicle->RegisterCommand("status","Show vehicle module status",vehicle_status);
+  OvmsCommand* cmd_poll = cmd_vehicle->RegisterCommand("poll","Vehicle OBD/UDS poller");
+  cmd_poll->RegisterCommand("status","Show poller status & statistics",vehicle_poll_status);
 
   MyCommandApp.RegisterCommand("wakeup","Wake up vehicle",vehicle_wakeup);
   MyCommandApp.RegisterCommand("homelink","Activate specified homelink button",vehicle_homelink,"<homelink><durationms>",1,2);
@@ -976,6 +1003,20 @@ OvmsVehicle::OvmsVehicle()
   m_poll_sequence_max = 1;
   m_poll_sequence_cnt = 0;
   m_poll_fc_septime = 25;       // response default timing: 25 milliseconds
+  m_poll_scheduled = false;
+  m_poll_concurrency = 1;
+  m_poll_timeout_ms = VEHICLE_POLL_TIMEOUT_MS;
+  m_poll_timebase = 0;
+  m_poll_slot = NULL;
+  m_poll_rxtime = 0;
+  m_poll_rxbuf = NULL;
+  m_poll_index = -1;
+  m_poll_sent_time = 0;
+  m_poll_error = false;
+  m_poll_count = 0;
+  m_poll_stats = NULL;
+  memset(m_poll_slots, 0, sizeof(m_poll_slots));
+  PollerResetSlots();
 
   m_bms_voltages = NULL;
   m_bms_vmins = NULL;
@@ -993,8 +1034,10 @@ OvmsVehicle::OvmsVehicle()
   m_bms_talerts_new = 0;
   m_bms_has_temperatures = false;
 
-  m_bms_bitset_v.clear();
-  m_bms_bitset_t.clear();
+  m_bms_bitset_v = NULL;
+  m_bms_bitset_t = NULL;
+  memset(&m_bms_vstats, 0, sizeof(m_bms_vstats));
+  memset(&m_bms_tstats, 0, sizeof(m_bms_tstats));
   m_bms_bitset_cv = 0;
   m_bms_bitset_ct = 0;
   m_bms_readings_v = 0;
@@ -1030,6 +1073,7 @@ OvmsVehicle::OvmsVehicle()
   m_brakelight_basepwr = 0;
   m_brakelight_ignftbrk = false;
 
+  m_rxtrace = NULL;
   m_rxqueue = xQueueCreate(CONFIG_OVMS_VEHICLE_CAN_RX_QUEUE_SIZE,sizeof(CAN_frame_t));
   xTaskCreatePinnedToCore(OvmsVehicleRxTask, "OVMS Vehicle",
     CONFIG_OVMS_VEHICLE_RXTASK_STACK, (void*)this, 10, &m_rxtask, CORE(1));
@@ -1053,55 +1097,27 @@ OvmsVehicle::~OvmsVehicle()
 
   if (m_bms_voltages != NULL)
     {
+    // cell store block, see BmsAllocCells()
     delete [] m_bms_voltages;
     m_bms_voltages = NULL;
     }
-  if (m_bms_vmins != NULL)
-    {
-    delete [] m_bms_vmins;
-    m_bms_vmins = NULL;
-    }
-  if (m_bms_vmaxs != NULL)
-    {
-    delete [] m_bms_vmaxs;
-    m_bms_vmaxs = NULL;
-    }
-  if (m_bms_vdevmaxs != NULL)
-    {
-    delete [] m_bms_vdevmaxs;
-    m_bms_vdevmaxs = NULL;
-    }
-  if (m_bms_valerts != NULL)
-    {
-    delete [] m_bms_valerts;
-    m_bms_valerts = NULL;
-    }
+  m_bms_vmins = NULL;
+  m_bms_vmaxs = NULL;
+  m_bms_vdevmaxs = NULL;
+  m_bms_valerts = NULL;
+  m_bms_bitset_v = NULL;
 
   if (m_bms_temperatures != NULL)
     {
+    // cell store block, see BmsAllocCells()
     delete [] m_bms_temperatures;
     m_bms_temperatures = NULL;
     }
-  if (m_bms_tmins != NULL)
-    {
-    delete [] m_bms_tmins;
-    m_bms_tmins = NULL;
-    }
-  if (m_bms_tmaxs != NULL)
-    {
-    delete [] m_bms_tmaxs;
-    m_bms_tmaxs = NULL;
-    }
-  if (m_bms_tdevmaxs != NULL)
-    {
-    delete [] m_bms_tdevmaxs;
-    m_bms_tdevmaxs = NULL;
-    }
-  if (m_bms_talerts != NULL)
-    {
-    delete [] m_bms_talerts;
-    m_bms_talerts = NULL;
-    }
+  m_bms_tmins = NULL;
+  m_bms_tmaxs = NULL;
+  m_bms_tdevmaxs = NULL;
+  m_bms_talerts = NULL;
+  m_bms_bitset_t = NULL;
 
   if (m_registeredlistener)
     {
@@ -1112,6 +1128,16 @@ OvmsVehicle::~OvmsVehicle()
   vQueueDelete(m_rxqueue);
   vTaskDelete(m_rxtask);
 
+  if (m_poll_rxbuf)
+    free(m_poll_rxbuf);
+  if (m_poll_stats)
+    free(m_poll_stats);
+  for (int i = 0; i < VEHICLE_POLL_MAX_SLOTS; i++)
+    {
+    if (m_poll_slots[i].rxbuf)
+      free(m_poll_slots[i].rxbuf);
+    }
+
   MyEvents.DeregisterEvent(TAG);
   MyMetrics.DeregisterListener(TAG);
   }
@@ -1127,11 +1153,23 @@ void OvmsVehicle::RxTask()
 
   while(1)
     {
-    if (xQueueReceive(m_rxqueue, &frame, (portTickType)portMAX_DELAY)==pdTRUE)
+    if (xQueueReceive(m_rxqueue, &frame, PollerTimeoutTicks())==pdTRUE)
       {
       if (!m_ready)
         continue;
-      if (m_poll_wait && frame.origin == m_poll_bus && m_poll_plist)
+      OvmsVehicleRxTrace* trace = m_rxtrace;
+      int64_t started = trace ? esp_timer_get_time() : 0;
+      if (m_poll_scheduled)
+        {
+        // Scheduled poller: quick check against the response ID range of all requests
+        // in flight, PollerReceive() looks up the matching slot after locking the mutex.
+        if (m_poll_slots_busy && m_poll_plist &&
+            frame.MsgID >= m_poll_slots_low && frame.MsgID <= m_poll_slots_high)
+          {
+          PollerReceive(&frame);
+          }
+        }
+      else if (m_poll_wait && frame.origin == m_poll_bus && m_poll_plist)
         {
         // This is a quick filter check to see if the frame is possibly intended for our poller.
         // The filter will be checked again in PollerReceive() after locking the mutex.
@@ -1145,6 +1183,14 @@ void OvmsVehicle::RxTask()
       else if (m_can2 == frame.origin) IncomingFrameCan2(&frame);
       else if (m_can3 == frame.origin) IncomingFrameCan3(&frame);
       else if (m_can4 == frame.origin) IncomingFrameCan4(&frame);
+      if (trace)
+        trace->RxFrame(&frame, started, esp_timer_get_time(), uxQueueMessagesWaiting(m_rxqueue));
+      }
+
+    // Scheduled poller: send due polls, abandon timed out requests
+    if (m_ready && m_poll_scheduled && m_poll_plist && esp_timer_get_time() >= m_poll_wakeup)
+      {
+      PollerSend(false);
       }
     }
   }
@@ -1173,6 +1219,17 @@ void OvmsVehicle::IncomingPollError(canbus* bus, uint16_t type, uint16_t pid, ui
   {
   }
 
+/**
+ * IncomingPollResponse: complete poll response payload
+ *  Called after the last IncomingPollReply() of a response with the reassembled payload
+ *  (excluding the response type & PID). The payload buffer is owned by the poller and
+ *  only valid during the call. Override this instead of IncomingPollReply() if you don't
+ *  need to process multi frame responses frame by frame.
+ */
+void OvmsVehicle::IncomingPollResponse(canbus* bus, uint16_t type, uint16_t pid, const uint8_t* payload, size_t length)
+  {
+  }
+
 void OvmsVehicle::Status(int verbosity, OvmsWriter* writer)
   {
   writer->puts("Vehicle module loaded and running");
@@ -1209,10 +1266,28 @@ void OvmsVehicle::RegisterCanBus(int bus, CAN_mode_t mode, CAN_speed_t speed, db
   if (!m_registeredlistener)
     {
     m_registeredlistener = true;
-    MyCan.RegisterListener(m_rxqueue);
+    MyCan.RegisterListener(m_rxqueue, false, &m_rxids);
     }
   }
 
+/**
+ * RegisterCanId: subscribe to a CAN ID or ID range on a bus (1-4, 0=all)
+ *  By default, the vehicle receives all frames of its buses. Once an ID has been
+ *  registered, only subscribed frames (plus poll responses) are queued for the
+ *  vehicle task, all others are discarded by the CAN task.
+ *  The listener refers to m_rxids from RegisterCanBus() on, so subscriptions
+ *  can be added at any time without touching the CAN listener registry.
+ */
+void OvmsVehicle::RegisterCanId(int bus, CAN_frame_format_t format, uint32_t id)
+  {
+  RegisterCanId(bus, format, id, id);
+  }
+
+void OvmsVehicle::RegisterCanId(int bus, CAN_frame_format_t format, uint32_t id_from, uint32_t id_to)
+  {
+  m_rxids.Add(bus, format, id_from, id_to);
+  }
+
 bool OvmsVehicle::PinCheck(char* pin)
   {
   if (!MyConfig.IsDefined("password","pin")) return false;
@@ -1281,10 +1356,10 @@ void OvmsVehicle::VehicleTicker1(std::string event, void* data)
     float volt = StandardMetrics.ms_v_bat_12v_voltage->AsFloat();
     // …against the maximum of default and measured reference voltage, so alerts will also
     //  be triggered if the measured ref follows a degrading battery:
-    float dref = MyConfig.GetParamValueFloat("vehicle", "12v.ref", 12.6);
+    float dref = cfg_12v_ref.Get();
     float vref = MAX(StandardMetrics.ms_v_bat_12v_voltage_ref->AsFloat(), dref);
     bool alert_on = StandardMetrics.ms_v_bat_12v_voltage_alert->AsBool();
-    float alert_threshold = MyConfig.GetParamValueFloat("vehicle", "12v.alert", 1.6);
+    float alert_threshold = cfg_12v_alert.Get();
     if (!alert_on && volt > 0 && vref > 0 && vref-volt > alert_threshold)
       {
       StandardMetrics.ms_v_bat_12v_voltage_alert->SetValue(true);
@@ -1303,7 +1378,7 @@ void OvmsVehicle::VehicleTicker1(std::string event, void* data)
     {
     // Check MINSOC
     int soc = (int)StandardMetrics.ms_v_bat_soc->AsFloat();
-    m_minsoc = MyConfig.GetParamValueInt("vehicle", "minsoc", 0);
+    m_minsoc = cfg_minsoc.Get();
     if (m_minsoc <= 0)
       {
       m_minsoc_triggered = 0;
@@ -1328,7 +1403,7 @@ void OvmsVehicle::VehicleTicker1(std::string event, void* data)
     {
     ESP_LOGW(TAG, "BMS new alerts: %d voltages, %d temperatures", m_bms_valerts_new, m_bms_talerts_new);
     MyEvents.SignalEvent("vehicle.alert.bms", NULL);
-    if (m_autonotifications && MyConfig.GetParamValueBool("vehicle", "bms.alerts.enabled", true))
+    if (m_autonotifications && cfg_bms_alerts_enabled.Get())
       NotifyBmsAlerts();
     m_bms_valerts_new = 0;
     m_bms_talerts_new = 0;
@@ -1434,7 +1509,7 @@ void OvmsVehicle::NotifyAlarmStopped()
 void OvmsVehicle::Notify12vCritical()
   {
   float volt = StandardMetrics.ms_v_bat_12v_voltage->AsFloat();
-  float dref = MyConfig.GetParamValueFloat("vehicle", "12v.ref", 12.6);
+  float dref = cfg_12v_ref.Get();
   float vref = MAX(StandardMetrics.ms_v_bat_12v_voltage_ref->AsFloat(), dref);
 
   MyNotify.NotifyStringf("alert", "batt.12v.alert", "12V Battery critical: %.1fV (ref=%.1fV)", volt, vref);
@@ -1443,7 +1518,7 @@ void OvmsVehicle::Notify12vCritical()
 void OvmsVehicle::Notify12vRecovered()
   {
   float volt = StandardMetrics.ms_v_bat_12v_voltage->AsFloat();
-  float dref = MyConfig.GetParamValueFloat("vehicle", "12v.ref", 12.6);
+  float dref = cfg_12v_ref.Get();
   float vref = MAX(StandardMetrics.ms_v_bat_12v_voltage_ref->AsFloat(), dref);
 
   MyNotify.NotifyStringf("alert", "batt.12v.recovered", "12V Battery restored: %.1fV (ref=%.1fV)", volt, vref);
@@ -2030,6 +2105,18 @@ void OvmsVehicle::PollSetPidList(canbus* bus, const poll_pid_t* plist)
   m_poll_sequence_cnt = 0;
   m_poll_wait = 0;
   m_poll_plcur = NULL;
+  PollerResetSlots();
+
+  // Statistics:
+  int count = 0;
+  while (plist && plist[count].txmoduleid != 0) count++;
+  if (count != m_poll_count)
+    {
+    if (m_poll_stats) free(m_poll_stats);
+    m_poll_stats = (count > 0) ? (poll_stats_t*) ExternalRamCalloc(count, sizeof(poll_stats_t)) : NULL;
+    m_poll_count = m_poll_stats ? count : 0;
+    }
+  PollerResetStats();
   }
 
 void OvmsVehicle::PollSetState(uint8_t state)
@@ -2042,6 +2129,8 @@ void OvmsVehicle::PollSetState(uint8_t state)
     m_poll_sequence_cnt = 0;
     m_poll_wait = 0;
     m_poll_plcur = NULL;
+    PollerResetSlots();
+    PollerResetStats();
     }
   }
 
@@ -2064,12 +2153,79 @@ void OvmsVehicle::PollSetResponseSeparationTime(uint8_t septime)
   m_poll_fc_septime = septime;
   }
 
+/**
+ * PollSetConcurrency: keep multiple poll requests in flight (enables the scheduler)
+ *  
+ *  @param slots
+ *    Maximum number of requests in flight at once, 1 = sequential polling (default).
+ *    Requests are only sent concurrently to different ECUs: an entry addressing a bus & ECU
+ *    that still has a request in flight is deferred until that request has completed or
+ *    timed out, so the entry order per ECU is kept. Max: VEHICLE_POLL_MAX_SLOTS
+ *  @param timeout_ms
+ *    Default response timeout in milliseconds for entries without a timeout_ms of their own.
+ *    The timeout restarts with every response frame (multi frame responses, NRC 0x78).
+ *  
+ *  With concurrency enabled, due entries are sent as fast as the ECUs respond, limited by
+ *  the throttling (PollSetThrottling()). Use this only if your vehicle code does not depend
+ *  on the global request sequence across ECUs.
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+void OvmsVehicle::PollSetConcurrency(uint8_t slots, uint16_t timeout_ms /*=VEHICLE_POLL_TIMEOUT_MS*/)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  m_poll_concurrency = (slots < 1) ? 1 : LIMIT_MAX(slots, VEHICLE_POLL_MAX_SLOTS);
+  m_poll_timeout_ms = (timeout_ms > 0) ? timeout_ms : VEHICLE_POLL_TIMEOUT_MS;
+  m_poll_scheduled = (m_poll_concurrency > 1 || m_poll_timebase > 0);
+  m_poll_sequence_cnt = 0;
+  m_poll_wait = 0;
+  m_poll_plcur = NULL;
+  PollerResetSlots();
+  }
+
+/**
+ * PollSetTimeBase: set the poll interval unit (enables the scheduler)
+ *  
+ *  @param timebase_ms
+ *    Unit of the poll_pid_t.polltime[] intervals in milliseconds, e.g. 250 = polltime 1
+ *    polls every 250 ms, polltime 4 every second. 1 = polltime is given in milliseconds.
+ *    0 = seconds, back to the sequential ticker poller (if concurrency is 1).
+ *  
+ *  The scheduler keeps the list entries in a queue ordered by their due times and sends
+ *  them from the vehicle RX task as soon as they are due, independent of the ticker.
+ *  Entries due at the same time are sent in list order. Due times are kept aligned to
+ *  the list start, so entries of different intervals stay in sync; an overrun skips the
+ *  missed polls. The throttling (PollSetThrottling()) still applies per second, you will
+ *  normally want to disable it (0) for sub second intervals.
+ *  The configuration is kept unchanged over calls to PollSetPidList() or PollSetState().
+ */
+void OvmsVehicle::PollSetTimeBase(uint16_t timebase_ms)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+  m_poll_timebase = timebase_ms;
+  m_poll_scheduled = (m_poll_concurrency > 1 || m_poll_timebase > 0);
+  m_poll_sequence_cnt = 0;
+  m_poll_wait = 0;
+  m_poll_plcur = NULL;
+  PollerResetSlots();
+  PollerResetStats();
+  }
+
 void OvmsVehicle::PollerSend(bool fromTicker)
   {
   OvmsRecMutexLock lock(&m_poll_mutex);
 
   // Don't do anything with no bus, no list or an empty list
-  if (!m_poll_bus_default || !m_poll_plist || m_poll_plist->txmoduleid == 0) return;
+  if (!m_poll_bus_default || !m_poll_plist || m_poll_plist->txmoduleid == 0)
+    {
+    m_poll_wakeup = INT64_MAX;
+    return;
+    }
+
+  if (m_poll_scheduled)
+    {
+    PollerSendScheduled(fromTicker);
+    return;
+    }
 
   if (m_poll_plcur == NULL) m_poll_plcur = m_poll_plist;
 
@@ -2082,6 +2238,11 @@ void OvmsVehicle::PollerSend(bool fromTicker)
     // Timer ticker call: reset throttling counter, check response timeout
     m_poll_sequence_cnt = 0;
     if (m_poll_wait > 0) m_poll_wait--;
+    if (m_poll_wait == 0 && m_poll_index >= 0)
+      {
+      PollerStatsDone(m_poll_index, m_poll_sent_time, true);
+      m_poll_index = -1;
+      }
     }
   if (m_poll_wait > 0) return;
 
@@ -2091,82 +2252,17 @@ void OvmsVehicle::PollerSend(bool fromTicker)
         ((m_poll_ticker % m_poll_plcur->polltime[m_poll_state]) == 0))
       {
       // We need to poll this one...
-      m_poll_type = m_poll_plcur->type;
-      m_poll_pid = m_poll_plcur->pid;
-      if (m_poll_plcur->rxmoduleid != 0)
-        {
-        // send to <moduleid>, listen to response from <rmoduleid>:
-        m_poll_moduleid_sent = m_poll_plcur->txmoduleid;
-        m_poll_moduleid_low = m_poll_plcur->rxmoduleid;
-        m_poll_moduleid_high = m_poll_plcur->rxmoduleid;
-        }
-      else
-        {
-        // broadcast: send to 0x7df, listen to all responses:
-        m_poll_moduleid_sent = 0x7df;
-        m_poll_moduleid_low = 0x7e8;
-        m_poll_moduleid_high = 0x7ef;
-        }
-
-      switch (m_poll_plcur->pollbus)
-        {
-        case 1:
-          m_poll_bus = m_can1;
-          break;
-        case 2:
-          m_poll_bus = m_can2;
-          break;
-        case 3:
-          m_poll_bus = m_can3;
-          break;
-        case 4:
-          m_poll_bus = m_can4;
-          break;
-        default:
-          m_poll_bus = m_poll_bus_default;
-        }
+      PollerSelect(m_poll_plcur);
 
       ESP_LOGD(TAG, "PollerSend(%d): send [bus=%d, type=%02X, pid=%X], expecting %03x/%03x-%03x",
                fromTicker, m_poll_plcur->pollbus, m_poll_type, m_poll_pid, m_poll_moduleid_sent,
                m_poll_moduleid_low, m_poll_moduleid_high);
 
-      CAN_frame_t txframe;
-      memset(&txframe,0,sizeof(txframe));
-      txframe.origin = m_poll_bus;
-      txframe.MsgID = m_poll_moduleid_sent;
-      txframe.FIR.B.FF = CAN_frame_std;
-      txframe.FIR.B.DLC = 8;
-
-      if (POLL_TYPE_HAS_16BIT_PID(m_poll_plcur->type))
-        {
-        uint8_t datalen = LIMIT_MAX(m_poll_plcur->args.datalen, 4);
-        txframe.data.u8[0] = (ISOTP_FT_SINGLE << 4) + 3 + datalen;
-        txframe.data.u8[1] = m_poll_type;
-        txframe.data.u8[2] = m_poll_pid >> 8;
-        txframe.data.u8[3] = m_poll_pid & 0xff;
-        memcpy(&txframe.data.u8[4], m_poll_plcur->args.data, datalen);
-        }
-      else if (POLL_TYPE_HAS_8BIT_PID(m_poll_plcur->type))
-        {
-        uint8_t datalen = LIMIT_MAX(m_poll_plcur->args.datalen, 5);
-        txframe.data.u8[0] = (ISOTP_FT_SINGLE << 4) + 2 + datalen;
-        txframe.data.u8[1] = m_poll_type;
-        txframe.data.u8[2] = m_poll_pid;
-        memcpy(&txframe.data.u8[3], m_poll_plcur->args.data, datalen);
-        }
-      else
-        {
-        uint8_t datalen = LIMIT_MAX(m_poll_plcur->args.datalen, 6);
-        txframe.data.u8[0] = (ISOTP_FT_SINGLE << 4) + 1 + datalen;
-        txframe.data.u8[1] = m_poll_type;
-        memcpy(&txframe.data.u8[2], m_poll_plcur->args.data, datalen);
-        }
-
-      m_poll_bus->Write(&txframe);
-      m_poll_ml_frame = 0;
-      m_poll_ml_offset = 0;
-      m_poll_ml_remain = 0;
+      PollerTransmit(m_poll_plcur);
       m_poll_wait = 2;
+      m_poll_index = m_poll_plcur - m_poll_plist;
+      m_poll_sent_time = esp_timer_get_time();
+      PollerStatsSent(m_poll_index, m_poll_sent_time, 0);
       m_poll_plcur++;
       m_poll_sequence_cnt++;
 
@@ -2184,11 +2280,105 @@ void OvmsVehicle::PollerSend(bool fromTicker)
   if (m_poll_ticker > 3600) m_poll_ticker -= 3600;
   }
 
+/**
+ * PollerSelect: set the poll context (bus, module IDs, type & PID) from a poll list entry
+ */
+void OvmsVehicle::PollerSelect(const poll_pid_t* entry)
+  {
+  m_poll_type = entry->type;
+  m_poll_pid = entry->pid;
+  if (entry->rxmoduleid != 0)
+    {
+    // send to <moduleid>, listen to response from <rmoduleid>:
+    m_poll_moduleid_sent = entry->txmoduleid;
+    m_poll_moduleid_low = entry->rxmoduleid;
+    m_poll_moduleid_high = entry->rxmoduleid;
+    }
+  else
+    {
+    // broadcast: send to 0x7df, listen to all responses:
+    m_poll_moduleid_sent = 0x7df;
+    m_poll_moduleid_low = 0x7e8;
+    m_poll_moduleid_high = 0x7ef;
+    }
+
+  switch (entry->pollbus)
+    {
+    case 1:
+      m_poll_bus = m_can1;
+      break;
+    case 2:
+      m_poll_bus = m_can2;
+      break;
+    case 3:
+      m_poll_bus = m_can3;
+      break;
+    case 4:
+      m_poll_bus = m_can4;
+      break;
+    default:
+      m_poll_bus = m_poll_bus_default;
+    }
+  }
+
+/**
+ * PollerTransmit: send the request for a poll list entry using the current poll context
+ */
+void OvmsVehicle::PollerTransmit(const poll_pid_t* entry)
+  {
+  // Let the responses pass an ID subscription:
+  if (m_poll_bus && !m_rxids.IsEmpty())
+    m_rxids.Add(m_poll_bus->m_busnumber+1, CAN_frame_std, m_poll_moduleid_low, m_poll_moduleid_high);
+
+  CAN_frame_t txframe;
+  memset(&txframe,0,sizeof(txframe));
+  txframe.origin = m_poll_bus;
+  txframe.MsgID = m_poll_moduleid_sent;
+  txframe.FIR.B.FF = CAN_frame_std;
+  txframe.FIR.B.DLC = 8;
+
+  if (POLL_TYPE_HAS_16BIT_PID(entry->type))
+    {
+    uint8_t datalen = LIMIT_MAX(entry->args.datalen, 4);
+    txframe.data.u8[0] = (ISOTP_FT_SINGLE << 4) + 3 + datalen;
+    txframe.data.u8[1] = m_poll_type;
+    txframe.data.u8[2] = m_poll_pid >> 8;
+    txframe.data.u8[3] = m_poll_pid & 0xff;
+    memcpy(&txframe.data.u8[4], entry->args.data, datalen);
+    }
+  else if (POLL_TYPE_HAS_8BIT_PID(entry->type))
+    {
+    uint8_t datalen = LIMIT_MAX(entry->args.datalen, 5);
+    txframe.data.u8[0] = (ISOTP_FT_SINGLE << 4) + 2 + datalen;
+    txframe.data.u8[1] = m_poll_type;
+    txframe.data.u8[2] = m_poll_pid;
+    memcpy(&txframe.data.u8[3], entry->args.data, datalen);
+    }
+  else
+    {
+    uint8_t datalen = LIMIT_MAX(entry->args.datalen, 6);
+    txframe.data.u8[0] = (ISOTP_FT_SINGLE << 4) + 1 + datalen;
+    txframe.data.u8[1] = m_poll_type;
+    memcpy(&txframe.data.u8[2], entry->args.data, datalen);
+    }
+
+  m_poll_bus->Write(&txframe);
+  m_poll_ml_frame = 0;
+  m_poll_ml_offset = 0;
+  m_poll_ml_remain = 0;
+  }
+
 
 void OvmsVehicle::PollerReceive(CAN_frame_t* frame)
   {
   OvmsRecMutexLock lock(&m_poll_mutex);
-  char *hexdump = NULL;
+  m_poll_rxtime = frame->timestamp;
+
+  if (m_poll_scheduled)
+    {
+    PollerReceiveScheduled(frame);
+    return;
+    }
 
   // After locking the mutex, check again for poll expectance match:
   if (!m_poll_wait || !m_poll_plist || frame->origin != m_poll_bus ||
@@ -2198,6 +2388,33 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame)
     return;
     }
 
+  PollerProcessFrame(frame);
+  if (m_poll_wait == 0 && m_poll_index >= 0)
+    {
+    PollerStatsDone(m_poll_index, m_poll_sent_time, false, frame->timestamp);
+    m_poll_index = -1;
+    }
+
+  // Immediately send the next poll for this tick if…
+  // - we are not waiting for another frame
+  // - the poll was no broadcast (with potential further responses from other devices)
+  // - poll throttling is unlimited or limit isn't reached yet
+  if (m_poll_wait == 0 &&
+      m_poll_moduleid_sent != 0x7df &&
+      (!m_poll_sequence_max || m_poll_sequence_cnt < m_poll_sequence_max))
+    {
+    PollerSend(false);
+    }
+  }
+
+/**
+ * PollerProcessFrame: process a response frame in the current poll context
+ *  m_poll_wait is set to 0 when the response is complete.
+ */
+void OvmsVehicle::PollerProcessFrame(CAN_frame_t* frame)
+  {
+  char *hexdump = NULL;
+  m_poll_error = false;
 
   // 
   // Get & validate ISO-TP meta data
@@ -2330,6 +2547,7 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame)
                frame->MsgID, m_poll_type, m_poll_pid, error_code);
       IncomingPollError(frame->origin, m_poll_type, m_poll_pid, error_code);
       // abort:
+      m_poll_error = true;
       m_poll_ml_remain = 0;
       }
     }
@@ -2341,6 +2559,31 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame)
              frame->MsgID, m_poll_type, m_poll_pid,
              m_poll_ml_frame, response_datalen, m_poll_ml_offset, m_poll_ml_remain);
     IncomingPollReply(frame->origin, m_poll_type, m_poll_pid, response_data, response_datalen, m_poll_ml_remain);
+
+    // Reassemble the complete payload (single frames are passed on directly),
+    // skip on length underflow from an invalid header:
+    if (response_datalen <= tp_datalen)
+      {
+      if (tp_frametype == ISOTP_FT_SINGLE)
+        {
+        IncomingPollResponse(frame->origin, m_poll_type, m_poll_pid, response_data, response_datalen);
+        }
+      else if (m_poll_ml_offset + response_datalen <= VEHICLE_POLL_RXBUF_SIZE)
+        {
+        uint8_t* rxbuf = PollerResponseBuffer();
+        if (rxbuf)
+          {
+          memcpy(rxbuf + m_poll_ml_offset, response_data, response_datalen);
+          if (m_poll_ml_remain == 0)
+            IncomingPollResponse(frame->origin, m_poll_type, m_poll_pid, rxbuf, m_poll_ml_offset + response_datalen);
+          }
+        else if (m_poll_ml_remain == 0)
+          {
+          ESP_LOGE(TAG, "PollerReceive[%03X]: no reassembly buffer, dropped %d byte response %02X(%X)",
+                   frame->MsgID, m_poll_ml_offset + response_datalen, m_poll_type, m_poll_pid);
+          }
+        }
+      }
     }
   else
     {
@@ -2396,17 +2639,406 @@ void OvmsVehicle::PollerReceive(CAN_frame_t* frame)
     // Request response complete:
     m_poll_wait = 0;
     }
+  }
 
 
-  // Immediately send the next poll for this tick if…
-  // - we are not waiting for another frame
-  // - the poll was no broadcast (with potential further responses from other devices)
-  // - poll throttling is unlimited or limit isn't reached yet
-  if (m_poll_wait == 0 &&
-      m_poll_moduleid_sent != 0x7df &&
-      (!m_poll_sequence_max || m_poll_sequence_cnt < m_poll_sequence_max))
+/**
+ * Scheduled poller:
+ *  The list entries are kept in a min-heap ordered by their next due time (ties in list
+ *  order). Every request in flight has a slot holding its poll context (module IDs, type,
+ *  PID, multi frame state) and a response deadline. Responses are matched to their slot
+ *  by bus & ID, the slot context is then loaded into the m_poll_* members, so the ISO-TP
+ *  processing and the vehicle's IncomingPollReply() see the same context as with the
+ *  sequential poller. The RX task wakes up at the next due time / deadline (m_poll_wakeup).
+ */
+static bool PollSchedLater(const OvmsVehicle::poll_sched_t& a, const OvmsVehicle::poll_sched_t& b)
+  {
+  return (a.due != b.due) ? (a.due > b.due) : (a.index > b.index);
+  }
+
+void OvmsVehicle::PollerSendScheduled(bool fromTicker)
+  {
+  if (fromTicker)
     {
-    PollerSend(false);
+    // Timer ticker call: reset throttling counter
+    m_poll_sequence_cnt = 0;
+    }
+  PollerCheckTimeouts();
+
+  int64_t now = esp_timer_get_time();
+  int64_t timebase = (m_poll_timebase > 0) ? m_poll_timebase : 1000;
+
+  if (!m_poll_queue_valid)
+    {
+    // (Re)start: all entries polled in this state are due now
+    m_poll_queue.clear();
+    for (int i = 0; m_poll_plist[i].txmoduleid != 0; i++)
+      {
+      if (m_poll_plist[i].polltime[m_poll_state] > 0)
+        m_poll_queue.push_back({ now, (uint16_t)i });
+      }
+    std::make_heap(m_poll_queue.begin(), m_poll_queue.end(), PollSchedLater);
+    m_poll_queue_valid = true;
+    }
+
+  while (!m_poll_queue.empty() && m_poll_queue.front().due <= now)
+    {
+    if (m_poll_slots_busy >= m_poll_concurrency ||
+        (m_poll_sequence_max && m_poll_sequence_cnt >= m_poll_sequence_max))
+      break;
+
+    std::pop_heap(m_poll_queue.begin(), m_poll_queue.end(), PollSchedLater);
+    poll_sched_t next = m_poll_queue.back();
+    m_poll_queue.pop_back();
+    const poll_pid_t* entry = &m_poll_plist[next.index];
+
+    // Defer if the ECU still has a request in flight:
+    PollerSelect(entry);
+    if (PollerFindSlot(m_poll_bus, m_poll_moduleid_sent, m_poll_moduleid_low, m_poll_moduleid_high))
+      {
+      m_poll_deferred.push_back(next);
+      continue;
+      }
+
+    poll_slot_t* slot = m_poll_slots;
+    while (slot->bus) slot++;
+
+    ESP_LOGD(TAG, "PollerSend(%d): send [bus=%d, type=%02X, pid=%X], expecting %03x/%03x-%03x, %u in flight",
+             fromTicker, entry->pollbus, m_poll_type, m_poll_pid, m_poll_moduleid_sent,
+             m_poll_moduleid_low, m_poll_moduleid_high, m_poll_slots_busy);
+
+    PollerTransmit(entry);
+    slot->bus = m_poll_bus;
+    slot->moduleid_sent = m_poll_moduleid_sent;
+    slot->moduleid_low = m_poll_moduleid_low;
+    slot->moduleid_high = m_poll_moduleid_high;
+    slot->type = m_poll_type;
+    slot->pid = m_poll_pid;
+    slot->ml_remain = 0;
+    slot->ml_offset = 0;
+    slot->ml_frame = 0;
+    slot->timeout_ms = entry->timeout_ms ? entry->timeout_ms : m_poll_timeout_ms;
+    slot->sent = esp_timer_get_time();
+    slot->deadline = slot->sent + slot->timeout_ms * 1000LL;
+    slot->index = next.index;
+    PollerUpdateSlots();
+    PollerStatsSent(next.index, slot->sent, slot->sent - next.due);
+    m_poll_sequence_cnt++;
+
+    // Schedule the next poll, skip missed polls on overrun:
+    int64_t interval = entry->polltime[m_poll_state] * timebase * 1000;
+    next.due += interval;
+    if (next.due <= now)
+      {
+      int64_t missed = (now - next.due) / interval + 1;
+      next.due += missed * interval;
+      if (m_poll_stats && next.index < m_poll_count)
+        m_poll_stats[next.index].skipped += missed;
+      }
+    m_poll_queue.push_back(next);
+    std::push_heap(m_poll_queue.begin(), m_poll_queue.end(), PollSchedLater);
+    }
+
+  for (poll_sched_t& next : m_poll_deferred)
+    {
+    m_poll_queue.push_back(next);
+    std::push_heap(m_poll_queue.begin(), m_poll_queue.end(), PollSchedLater);
+    }
+  m_poll_deferred.clear();
+
+  // Next RX task wakeup: next due time, if an entry is due but blocked by requests
+  // in flight (or throttling), the next response deadline (or the next ticker):
+  int64_t wakeup = INT64_MAX;
+  if (!m_poll_queue.empty() && m_poll_queue.front().due > now)
+    wakeup = m_poll_queue.front().due;
+  for (poll_slot_t* slot = m_poll_slots; slot < m_poll_slots + VEHICLE_POLL_MAX_SLOTS; slot++)
+    {
+    if (slot->bus && slot->deadline < wakeup)
+      wakeup = slot->deadline;
+    }
+  m_poll_wakeup = wakeup;
+  }
+
+void OvmsVehicle::PollerReceiveScheduled(CAN_frame_t* frame)
+  {
+  poll_slot_t* slot = m_poll_plist ? PollerFindSlot(frame->origin, 0, frame->MsgID, frame->MsgID) : NULL;
+  if (!slot)
+    {
+    ESP_LOGD(TAG, "PollerReceive[%03X]: dropping expired poll response", frame->MsgID);
+    return;
+    }
+
+  // Load the slot context:
+  m_poll_slot = slot;
+  m_poll_bus = slot->bus;
+  m_poll_moduleid_sent = slot->moduleid_sent;
+  m_poll_moduleid_low = slot->moduleid_low;
+  m_poll_moduleid_high = slot->moduleid_high;
+  m_poll_type = slot->type;
+  m_poll_pid = slot->pid;
+  m_poll_ml_remain = slot->ml_remain;
+  m_poll_ml_offset = slot->ml_offset;
+  m_poll_ml_frame = slot->ml_frame;
+  m_poll_wait = 2;
+
+  PollerProcessFrame(frame);
+  m_poll_slot = NULL;
+
+  if (m_poll_wait == 0)
+    {
+    // Request complete, free the slot and send the next poll if throttling allows:
+    PollerStatsDone(slot->index, slot->sent, false, frame->timestamp);
+    slot->bus = NULL;
+    PollerUpdateSlots();
+    if (!m_poll_sequence_max || m_poll_sequence_cnt < m_poll_sequence_max)
+      PollerSend(false);
+    return;
+    }
+
+  // More to come; restart the timeout on progress or a response pending notice (wait > 2):
+  if (m_poll_wait > 2 || m_poll_ml_frame != slot->ml_frame)
+    slot->deadline = esp_timer_get_time() + slot->timeout_ms * 1000LL;
+  slot->moduleid_low = m_poll_moduleid_low;
+  slot->moduleid_high = m_poll_moduleid_high;
+  slot->ml_remain = m_poll_ml_remain;
+  slot->ml_offset = m_poll_ml_offset;
+  slot->ml_frame = m_poll_ml_frame;
+  m_poll_wait = 0;
+  PollerUpdateSlots();
+  }
+
+/**
+ * PollerFindSlot: find the request in flight on a bus matching a sent ID or a response ID range
+ */
+OvmsVehicle::poll_slot_t* OvmsVehicle::PollerFindSlot(canbus* bus, uint32_t moduleid_sent,
+  uint32_t moduleid_low, uint32_t moduleid_high)
+  {
+  for (poll_slot_t* slot = m_poll_slots; slot < m_poll_slots + VEHICLE_POLL_MAX_SLOTS; slot++)
+    {
+    if (slot->bus != bus || bus == NULL)
+      continue;
+    if (slot->moduleid_sent == moduleid_sent ||
+        (moduleid_low <= slot->moduleid_high && moduleid_high >= slot->moduleid_low))
+      return slot;
+    }
+  return NULL;
+  }
+
+/**
+ * PollerUpdateSlots: update the in flight count & RX filter range after slot changes
+ */
+void OvmsVehicle::PollerUpdateSlots()
+  {
+  m_poll_slots_busy = 0;
+  m_poll_slots_low = UINT32_MAX;
+  m_poll_slots_high = 0;
+  for (poll_slot_t* slot = m_poll_slots; slot < m_poll_slots + VEHICLE_POLL_MAX_SLOTS; slot++)
+    {
+    if (!slot->bus) continue;
+    m_poll_slots_busy++;
+    if (slot->moduleid_low < m_poll_slots_low) m_poll_slots_low = slot->moduleid_low;
+    if (slot->moduleid_high > m_poll_slots_high) m_poll_slots_high = slot->moduleid_high;
+    }
+  }
+
+/**
+ * PollerResponseBuffer: get the reassembly buffer for the response being processed
+ *  Returns NULL if the buffer could not be allocated by PollerAllocBuffers().
+ */
+uint8_t* OvmsVehicle::PollerResponseBuffer()
+  {
+  return m_poll_slot ? m_poll_slot->rxbuf : m_poll_rxbuf;
+  }
+
+/**
+ * PollerAllocBuffers: allocate the reassembly buffers for the poller mode
+ *  (sequential: one, scheduled: one per slot up to the concurrency),
+ *  so the RX path does not need to allocate. Buffers are kept until
+ *  the vehicle is destroyed.
+ */
+void OvmsVehicle::PollerAllocBuffers()
+  {
+  if (!m_poll_plist)
+    return;
+  if (!m_poll_scheduled)
+    {
+    if (!m_poll_rxbuf)
+      m_poll_rxbuf = (uint8_t*) ExternalRamMalloc(VEHICLE_POLL_RXBUF_SIZE);
+    if (!m_poll_rxbuf)
+      ESP_LOGE(TAG, "PollerAllocBuffers: out of memory, multi frame responses will be dropped");
+    return;
+    }
+  for (int i = 0; i < m_poll_concurrency; i++)
+    {
+    if (!m_poll_slots[i].rxbuf)
+      m_poll_slots[i].rxbuf = (uint8_t*) ExternalRamMalloc(VEHICLE_POLL_RXBUF_SIZE);
+    if (!m_poll_slots[i].rxbuf)
+      {
+      ESP_LOGE(TAG, "PollerAllocBuffers: out of memory for slot %d, multi frame responses will be dropped", i);
+      break;
+      }
+    }
+  }
+
+void OvmsVehicle::PollerResetSlots()
+  {
+  for (poll_slot_t* slot = m_poll_slots; slot < m_poll_slots + VEHICLE_POLL_MAX_SLOTS; slot++)
+    {
+    // keep the reassembly buffers:
+    uint8_t* rxbuf = slot->rxbuf;
+    memset(slot, 0, sizeof(poll_slot_t));
+    slot->rxbuf = rxbuf;
+    }
+  m_poll_queue.clear();
+  m_poll_deferred.clear();
+  m_poll_queue_valid = false;
+  m_poll_wakeup = 0;
+  m_poll_index = -1;
+  PollerUpdateSlots();
+  PollerAllocBuffers();
+  }
+
+/**
+ * PollerCheckTimeouts: abandon requests in flight that passed their deadline
+ *  Returns true if a slot has been freed.
+ */
+bool OvmsVehicle::PollerCheckTimeouts()
+  {
+  int64_t now = esp_timer_get_time();
+  bool freed = false;
+  for (poll_slot_t* slot = m_poll_slots; slot < m_poll_slots + VEHICLE_POLL_MAX_SLOTS; slot++)
+    {
+    if (slot->bus && slot->deadline <= now)
+      {
+      ESP_LOGD(TAG, "PollerSend: timeout waiting for %03x-%03x response %02X(%X) after %u ms",
+               slot->moduleid_low, slot->moduleid_high, slot->type, slot->pid, slot->timeout_ms);
+      PollerStatsDone(slot->index, slot->sent, true);
+      slot->bus = NULL;
+      freed = true;
+      }
+    }
+  if (freed)
+    PollerUpdateSlots();
+  return freed;
+  }
+
+/**
+ * PollerTimeoutTicks: RX task queue wait time, until the next scheduled poll or deadline
+ *  The wait is limited to 100 ms, as the schedule may get changed from other tasks.
+ */
+TickType_t OvmsVehicle::PollerTimeoutTicks()
+  {
+  if (!m_poll_scheduled)
+    return portMAX_DELAY;
+  int64_t wait = m_poll_wakeup - esp_timer_get_time();
+  if (!m_ready || !m_poll_plist || wait > 100000)
+    return pdMS_TO_TICKS(100);
+  if (wait <= 0)
+    return 0;
+  return pdMS_TO_TICKS((wait + 999) / 1000) + 1;
+  }
+
+
+/**
+ * Poller statistics
+ */
+void OvmsVehicle::PollerResetStats()
+  {
+  if (m_poll_stats)
+    memset(m_poll_stats, 0, m_poll_count * sizeof(poll_stats_t));
+  }
+
+void OvmsVehicle::PollerStatsSent(int index, int64_t now, int64_t jitter)
+  {
+  if (!m_poll_stats || index < 0 || index >= m_poll_count)
+    return;
+  poll_stats_t* st = &m_poll_stats[index];
+  uint32_t now_ms = now / 1000;
+  uint32_t jitter_ms = (jitter > 0) ? jitter / 1000 : 0;
+  if (st->sent == 0)
+    st->first_sent = now_ms;
+  st->last_sent = now_ms;
+  st->sent++;
+  st->jitter_sum += jitter_ms;
+  if (jitter_ms > st->jitter_max)
+    st->jitter_max = jitter_ms;
+  }
+
+/**
+ * PollerStatsDone: account a completed or abandoned request
+ *  received = capture time of the final response frame (0 = unknown)
+ */
+void OvmsVehicle::PollerStatsDone(int index, int64_t sent, bool timeout, int64_t received /*=0*/)
+  {
+  if (!m_poll_stats || index < 0 || index >= m_poll_count)
+    return;
+  poll_stats_t* st = &m_poll_stats[index];
+  if (timeout)
+    {
+    st->timeouts++;
+    return;
+    }
+  int64_t now = esp_timer_get_time();
+  if (received <= 0 || received > now)
+    received = now;
+  uint32_t latency_ms = (received > sent) ? (received - sent) / 1000 : 0;
+  uint32_t rxdelay_us = now - received;
+  st->responses++;
+  if (m_poll_error)
+    st->errors++;
+  st->latency_sum += latency_ms;
+  if (latency_ms > st->latency_max)
+    st->latency_max = latency_ms;
+  st->rxdelay_sum += rxdelay_us;
+  if (rxdelay_us > st->rxdelay_max)
+    st->rxdelay_max = rxdelay_us;
+  }
+
+/**
+ * PollerStatus: output poller configuration & per entry statistics
+ *  Intervals, jitter & latency in milliseconds, averages over the requests sent/completed.
+ *  Latency is measured up to the capture of the response, RX delay (in microseconds)
+ *  from the capture to the processing of the response by the poller.
+ */
+void OvmsVehicle::PollerStatus(int verbosity, OvmsWriter* writer)
+  {
+  OvmsRecMutexLock lock(&m_poll_mutex);
+
+  if (!m_poll_plist)
+    {
+    writer->puts("Poller: no poll list");
+    return;
+    }
+  uint32_t timebase = (m_poll_timebase > 0) ? m_poll_timebase : 1000;
+  int rxbufs = (m_poll_scheduled) ? 0 : (m_poll_rxbuf != NULL);
+  for (int i = 0; m_poll_scheduled && i < m_poll_concurrency; i++)
+    rxbufs += (m_poll_slots[i].rxbuf != NULL);
+  if (m_poll_scheduled)
+    writer->printf("Poller: scheduled, state %u, time base %u ms, %u of %u requests in flight, throttling %u/s, %d rx buffers\n",
+      m_poll_state, timebase, m_poll_slots_busy, m_poll_concurrency, m_poll_sequence_max, rxbufs);
+  else
+    writer->printf("Poller: sequential, state %u, throttling %u/s, %d rx buffers\n",
+      m_poll_state, m_poll_sequence_max, rxbufs);
+
+  if (!m_poll_stats || verbosity < COMMAND_RESULT_NORMAL)
+    return;
+
+  writer->puts("Bus TxID RxID Type  PID | Interval  Achieved | Jitter avg/max | Latency avg/max | RxDelay avg/max |  Sent  Resp   Err  T/O  Skip");
+  for (int i = 0; i < m_poll_count; i++)
+    {
+    const poll_pid_t* entry = &m_poll_plist[i];
+    const poll_stats_t* st = &m_poll_stats[i];
+    uint32_t interval = entry->polltime[m_poll_state] * timebase;
+    if (interval == 0 && st->sent == 0)
+      continue;
+    uint32_t achieved = (st->sent > 1) ? (st->last_sent - st->first_sent) / (st->sent - 1) : 0;
+    writer->printf("%3u %4x %4x  %02x %5x | %8u %9u | %6u %7u | %7u %7u | %7u %7u | %5u %5u %5u %4u %5u\n",
+      entry->pollbus, entry->txmoduleid, entry->rxmoduleid, entry->type, entry->pid,
+      interval, achieved,
+      st->sent ? st->jitter_sum / st->sent : 0, st->jitter_max,
+      st->responses ? st->latency_sum / st->responses : 0, st->latency_max,
+      st->responses ? st->rxdelay_sum / st->responses : 0, st->rxdelay_max,
+      st->sent, st->responses, st->errors, st->timeouts, st->skipped);
     }
   }
 
@@ -2468,23 +3100,83 @@ OvmsVehicle::vehicle_command_t OvmsVehicle::ProcessMsgCommand(std::string &resul
 
 // BMS helpers
 
+/**
+ * BmsAllocCells: allocate the cell store for one measurement type
+ *  All per cell arrays share a single block (structure of arrays), the block
+ *  begins with the values array, so it is freed by deleting that.
+ */
+static float* BmsAllocCells(float* block, int readings,
+  float** mins, float** maxs, float** devmaxs, short** alerts, uint8_t** bitset)
+  {
+  if (block != NULL) delete [] block;
+  size_t size = readings * (4*sizeof(float) + sizeof(short) + sizeof(uint8_t));
+  block = new float[(size + sizeof(float) - 1) / sizeof(float)];
+  memset(block, 0, size);
+  *mins = block + readings;
+  *maxs = block + 2*readings;
+  *devmaxs = block + 3*readings;
+  *alerts = (short*) (block + 4*readings);
+  *bitset = (uint8_t*) (*alerts + readings);
+  return block;
+  }
+
+/**
+ * BmsStatsAdd / BmsStatsReplace: update running sweep sums by a cell value
+ */
+static inline void BmsStatsAdd(OvmsVehicle::bms_cellstats_t& stats, int count, float value)
+  {
+  if (count == 0)
+    {
+    stats.ref = value;
+    stats.sum = stats.sqrsum = 0;
+    }
+  double d = value - stats.ref;
+  stats.sum += d;
+  stats.sqrsum += d * d;
+  }
+
+static inline void BmsStatsReplace(OvmsVehicle::bms_cellstats_t& stats, float oldvalue, float value)
+  {
+  double d0 = oldvalue - stats.ref, d1 = value - stats.ref;
+  stats.sum += d1 - d0;
+  stats.sqrsum += d1 * d1 - d0 * d0;
+  }
+
+/**
+ * BmsCheckDeviations: evaluate cell deviations of a complete sweep
+ *  Single branch free pass over the cell arrays, updates the deviation maxima
+ *  and alert levels and determines the pack min/max.
+ *  Returns the number of new alerts.
+ */
+static int BmsCheckDeviations(int readings, const float* values, float* devmaxs, short* alerts,
+  float avg, int prec, float thr_warn, float thr_alert, float* pmin, float* pmax)
+  {
+  float scale = pow(10, prec), unscale = 1.0f / scale;
+  float min = values[0], max = values[0];
+  int alerts_new = 0;
+  for (int i=0; i<readings; i++)
+    {
+    float value = values[i];
+    min = (value < min) ? value : min;
+    max = (value > max) ? value : max;
+    float dev = roundf((value - avg) * scale) * unscale;
+    float absdev = fabsf(dev);
+    devmaxs[i] = (absdev > fabsf(devmaxs[i])) ? dev : devmaxs[i];
+    short level = (absdev >= thr_alert) ? 2 : (absdev >= thr_warn) ? 1 : 0;
+    alerts_new += (level == 2 && alerts[i] < 2);
+    alerts[i] = (level > alerts[i]) ? level : alerts[i];
+    }
+  *pmin = min;
+  *pmax = max;
+  return alerts_new;
+  }
+
 void OvmsVehicle::BmsSetCellArrangementVoltage(int readings, int readingspermodule)
   {
-  if (m_bms_voltages != NULL) delete m_bms_voltages;
-  m_bms_voltages = new float[readings];
-  if (m_bms_vmins != NULL) delete m_bms_vmins;
-  m_bms_vmins = new float[readings];
-  if (m_bms_vmaxs != NULL) delete m_bms_vmaxs;
-  m_bms_vmaxs = new float[readings];
-  if (m_bms_vdevmaxs != NULL) delete m_bms_vdevmaxs;
-  m_bms_vdevmaxs = new float[readings];
-  if (m_bms_valerts != NULL) delete m_bms_valerts;
-  m_bms_valerts = new short[readings];
+  m_bms_voltages = BmsAllocCells(m_bms_voltages, readings,
+    &m_bms_vmins, &m_bms_vmaxs, &m_bms_vdevmaxs, &m_bms_valerts, &m_bms_bitset_v);
   m_bms_valerts_new = 0;
 
-  m_bms_bitset_v.clear();
-  m_bms_bitset_v.reserve(readings);
-
   m_bms_readings_v = readings;
   m_bms_readingspermodule_v = readingspermodule;
 
@@ -2493,21 +3185,10 @@ void OvmsVehicle::BmsSetCellArrangementVoltage(int readings, int readingspermodu
 
 void OvmsVehicle::BmsSetCellArrangementTemperature(int readings, int readingspermodule)
   {
-  if (m_bms_temperatures != NULL) delete m_bms_temperatures;
-  m_bms_temperatures = new float[readings];
-  if (m_bms_tmins != NULL) delete m_bms_tmins;
-  m_bms_tmins = new float[readings];
-  if (m_bms_tmaxs != NULL) delete m_bms_tmaxs;
-  m_bms_tmaxs = new float[readings];
-  if (m_bms_tdevmaxs != NULL) delete m_bms_tdevmaxs;
-  m_bms_tdevmaxs = new float[readings];
-  if (m_bms_talerts != NULL) delete m_bms_talerts;
-  m_bms_talerts = new short[readings];
+  m_bms_temperatures = BmsAllocCells(m_bms_temperatures, readings,
+    &m_bms_tmins, &m_bms_tmaxs, &m_bms_tdevmaxs, &m_bms_talerts, &m_bms_bitset_t);
   m_bms_talerts_new = 0;
 
-  m_bms_bitset_t.clear();
-  m_bms_bitset_t.reserve(readings);
-
   m_bms_readings_t = readings;
   m_bms_readingspermodule_t = readingspermodule;
 
@@ -2566,7 +3247,6 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
   // ESP_LOGI(TAG,"BmsSetCellVoltage(%d,%f) c=%d", index, value, m_bms_bitset_cv);
   if ((index<0)||(index>=m_bms_readings_v)) return;
   if ((value<m_bms_limit_vmin)||(value>m_bms_limit_vmax)) return;
-  m_bms_voltages[index] = value;
 
   if (! m_bms_has_voltages)
     {
@@ -2578,40 +3258,29 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
   else if (m_bms_vmaxs[index] < value)
     m_bms_vmaxs[index] = value;
 
-  if (m_bms_bitset_v[index] == false) m_bms_bitset_cv++;
+  // update running sweep sums:
+  if (m_bms_bitset_v[index])
+    BmsStatsReplace(m_bms_vstats, m_bms_voltages[index], value);
+  else
+    {
+    BmsStatsAdd(m_bms_vstats, m_bms_bitset_cv, value);
+    m_bms_bitset_v[index] = 1;
+    m_bms_bitset_cv++;
+    }
+  m_bms_voltages[index] = value;
+
   if (m_bms_bitset_cv == m_bms_readings_v)
     {
-    // get min, max, avg & standard deviation:
-    double sum=0, sqrsum=0, avg, stddev=0;
-    float min=0, max=0;
-    for (int i=0; i<m_bms_readings_v; i++)
-      {
-      sum += m_bms_voltages[i];
-      sqrsum += SQR(m_bms_voltages[i]);
-      if (min==0 || m_bms_voltages[i]<min)
-        min = m_bms_voltages[i];
-      if (max==0 || m_bms_voltages[i]>max)
-        max = m_bms_voltages[i];
-      }
-    avg = sum / m_bms_readings_v;
-    stddev = sqrt(LIMIT_MIN((sqrsum / m_bms_readings_v) - SQR(avg), 0));
-    // check cell deviations:
-    float dev;
-    float thr_warn  = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.warn", m_bms_defthr_vwarn);
-    float thr_alert = MyConfig.GetParamValueFloat("vehicle", "bms.dev.voltage.alert", m_bms_defthr_valert);
-    for (int i=0; i<m_bms_readings_v; i++)
-      {
-      dev = ROUNDPREC(m_bms_voltages[i] - avg, 5);
-      if (ABS(dev) > ABS(m_bms_vdevmaxs[i]))
-        m_bms_vdevmaxs[i] = dev;
-      if (ABS(dev) >= thr_alert && m_bms_valerts[i] < 2)
-        {
-        m_bms_valerts[i] = 2;
-        m_bms_valerts_new++; // trigger notification
-        }
-      else if (ABS(dev) >= thr_warn && m_bms_valerts[i] < 1)
-        m_bms_valerts[i] = 1;
-      }
+    // get avg & standard deviation from running sums:
+    double mean = m_bms_vstats.sum / m_bms_readings_v;
+    double avg = m_bms_vstats.ref + mean;
+    double stddev = sqrt(LIMIT_MIN((m_bms_vstats.sqrsum / m_bms_readings_v) - SQR(mean), 0));
+    // check cell deviations, get min & max:
+    float min, max;
+    float thr_warn  = cfg_bms_dev_vwarn.Get(m_bms_defthr_vwarn);
+    float thr_alert = cfg_bms_dev_valert.Get(m_bms_defthr_valert);
+    m_bms_valerts_new += BmsCheckDeviations(m_bms_readings_v, m_bms_voltages, m_bms_vdevmaxs, m_bms_valerts,
+      avg, 5, thr_warn, thr_alert, &min, &max);
     // publish to metrics:
     avg = ROUNDPREC(avg, 5);
     stddev = ROUNDPREC(stddev, 5);
@@ -2628,13 +3297,7 @@ void OvmsVehicle::BmsSetCellVoltage(int index, float value)
     StandardMetrics.ms_v_bat_cell_valert->SetElemValues(0, m_bms_readings_v, m_bms_valerts);
     // complete:
     m_bms_has_voltages = true;
-    m_bms_bitset_v.clear();
-    m_bms_bitset_v.resize(m_bms_readings_v);
-    m_bms_bitset_cv = 0;
-    }
-  else
-    {
-    m_bms_bitset_v[index] = true;
+    BmsRestartCellVoltages();
     }
   }
 
@@ -2643,7 +3306,6 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
   // ESP_LOGI(TAG,"BmsSetCellTemperature(%d,%f) c=%d", index, value, m_bms_bitset_ct);
   if ((index<0)||(index>=m_bms_readings_t)) return;
   if ((value<m_bms_limit_tmin)||(value>m_bms_limit_tmax)) return;
-  m_bms_temperatures[index] = value;
 
   if (! m_bms_has_temperatures)
     {
@@ -2655,40 +3317,29 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
   else if (m_bms_tmaxs[index] < value)
     m_bms_tmaxs[index] = value;
 
-  if (m_bms_bitset_t[index] == false) m_bms_bitset_ct++;
+  // update running sweep sums:
+  if (m_bms_bitset_t[index])
+    BmsStatsReplace(m_bms_tstats, m_bms_temperatures[index], value);
+  else
+    {
+    BmsStatsAdd(m_bms_tstats, m_bms_bitset_ct, value);
+    m_bms_bitset_t[index] = 1;
+    m_bms_bitset_ct++;
+    }
+  m_bms_temperatures[index] = value;
+
   if (m_bms_bitset_ct == m_bms_readings_t)
     {
-    // get min, max, avg & standard deviation:
-    double sum=0, sqrsum=0, avg, stddev=0;
-    float min=0, max=0;
-    for (int i=0; i<m_bms_readings_t; i++)
-      {
-      sum += m_bms_temperatures[i];
-      sqrsum += SQR(m_bms_temperatures[i]);
-      if (min==0 || m_bms_temperatures[i]<min)
-        min = m_bms_temperatures[i];
-      if (max==0 || m_bms_temperatures[i]>max)
-        max = m_bms_temperatures[i];
-      }
-    avg = sum / m_bms_readings_t;
-    stddev = sqrt(LIMIT_MIN((sqrsum / m_bms_readings_t) - SQR(avg), 0));
-    // check cell deviations:
-    float dev;
-    float thr_warn  = MyConfig.GetParamValueFloat("vehicle", "bms.dev.temp.warn", m_bms_defthr_twarn);
-    float thr_alert = MyConfig.GetParamValueFloat("vehicle", "bms.dev.temp.alert", m_bms_defthr_talert);
-    for (int i=0; i<m_bms_readings_t; i++)
-      {
-      dev = ROUNDPREC(m_bms_temperatures[i] - avg, 2);
-      if (ABS(dev) > ABS(m_bms_tdevmaxs[i]))
-        m_bms_tdevmaxs[i] = dev;
-      if (ABS(dev) >= thr_alert && m_bms_talerts[i] < 2)
-        {
-        m_bms_talerts[i] = 2;
-        m_bms_talerts_new++; // trigger notification
-        }
-      else if (ABS(dev) >= thr_warn && m_bms_valerts[i] < 1)
-        m_bms_talerts[i] = 1;
-      }
+    // get avg & standard deviation from running sums:
+    double mean = m_bms_tstats.sum / m_bms_readings_t;
+    double avg = m_bms_tstats.ref + mean;
+    double stddev = sqrt(LIMIT_MIN((m_bms_tstats.sqrsum / m_bms_readings_t) - SQR(mean), 0));
+    // check cell deviations, get min & max:
+    float min, max;
+    float thr_warn  = cfg_bms_dev_twarn.Get(m_bms_defthr_twarn);
+    float thr_alert = cfg_bms_dev_talert.Get(m_bms_defthr_talert);
+    m_bms_talerts_new += BmsCheckDeviations(m_bms_readings_t, m_bms_temperatures, m_bms_tdevmaxs, m_bms_talerts,
+      avg, 2, thr_warn, thr_alert, &min, &max);
     // publish to metrics:
     avg = ROUNDPREC(avg, 2);
     stddev = ROUNDPREC(stddev, 2);
@@ -2705,27 +3356,19 @@ void OvmsVehicle::BmsSetCellTemperature(int index, float value)
     StandardMetrics.ms_v_bat_cell_talert->SetElemValues(0, m_bms_readings_t, m_bms_talerts);
     // complete:
     m_bms_has_temperatures = true;
-    m_bms_bitset_t.clear();
-    m_bms_bitset_t.resize(m_bms_readings_t);
-    m_bms_bitset_ct = 0;
-    }
-  else
-    {
-    m_bms_bitset_t[index] = true;
+    BmsRestartCellTemperatures();
     }
   }
 
 void OvmsVehicle::BmsRestartCellVoltages()
   {
-  m_bms_bitset_v.clear();
-  m_bms_bitset_v.resize(m_bms_readings_v);
+  if (m_bms_bitset_v) memset(m_bms_bitset_v, 0, m_bms_readings_v);
   m_bms_bitset_cv = 0;
   }
 
 void OvmsVehicle::BmsRestartCellTemperatures()
   {
-  m_bms_bitset_t.clear();
-  m_bms_bitset_v.resize(m_bms_readings_t);
+  if (m_bms_bitset_t) memset(m_bms_bitset_t, 0, m_bms_readings_t);
   m_bms_bitset_ct = 0;
   }
 
@@ -2733,17 +3376,12 @@ void OvmsVehicle::BmsResetCellVoltages(bool full /*=false*/)
   {
   if (m_bms_readings_v > 0)
     {
-    m_bms_bitset_v.clear();
-    m_bms_bitset_v.resize(m_bms_readings_v);
-    m_bms_bitset_cv = 0;
+    BmsRestartCellVoltages();
     m_bms_has_voltages = false;
-    for (int k=0; k<m_bms_readings_v; k++)
-      {
-      m_bms_vmins[k] = 0;
-      m_bms_vmaxs[k] = 0;
-      m_bms_vdevmaxs[k] = 0;
-      m_bms_valerts[k] = 0;
-      }
+    memset(m_bms_vmins, 0, m_bms_readings_v * sizeof(float));
+    memset(m_bms_vmaxs, 0, m_bms_readings_v * sizeof(float));
+    memset(m_bms_vdevmaxs, 0, m_bms_readings_v * sizeof(float));
+    memset(m_bms_valerts, 0, m_bms_readings_v * sizeof(short));
     m_bms_valerts_new = 0;
     if (full) StandardMetrics.ms_v_bat_cell_voltage->ClearValue();
     StandardMetrics.ms_v_bat_cell_vmin->ClearValue();
@@ -2758,17 +3396,12 @@ void OvmsVehicle::BmsResetCellTemperatures(bool full /*=false*/)
   {
   if (m_bms_readings_t > 0)
     {
-    m_bms_bitset_t.clear();
-    m_bms_bitset_t.resize(m_bms_readings_t);
-    m_bms_bitset_ct = 0;
+    BmsRestartCellTemperatures();
     m_bms_has_temperatures = false;
-    for (int k=0; k<m_bms_readings_t; k++)
-      {
-      m_bms_tmins[k] = 0;
-      m_bms_tmaxs[k] = 0;
-      m_bms_tdevmaxs[k] = 0;
-      m_bms_talerts[k] = 0;
-      }
+    memset(m_bms_tmins, 0, m_bms_readings_t * sizeof(float));
+    memset(m_bms_tmaxs, 0, m_bms_readings_t * sizeof(float));
+    memset(m_bms_tdevmaxs, 0, m_bms_readings_t * sizeof(float));
+    memset(m_bms_talerts, 0, m_bms_readings_t * sizeof(short));
     m_bms_talerts_new = 0;
     if (full) StandardMetrics.ms_v_bat_cell_temp->ClearValue();
     StandardMetrics.ms_v_bat_cell_tmin->ClearValue();
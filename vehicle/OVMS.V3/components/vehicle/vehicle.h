@@ -117,6 +117,13 @@ struct DashboardConfig;
 // Number of polling states supported
 #define VEHICLE_POLL_NSTATES            4
 
+// Scheduled poller: max requests in flight (one per bus & ECU), default response timeout
+#define VEHICLE_POLL_MAX_SLOTS          16
+#define VEHICLE_POLL_TIMEOUT_MS         1000
+
+// Response reassembly buffer size (max ISO-TP payload)
+#define VEHICLE_POLL_RXBUF_SIZE         4095
+
 
 // Standard MSG protocol commands:
 
@@ -156,6 +163,17 @@ struct DashboardConfig;
 #define BMS_DEFTHR_TALERT   3.00    // [°C]
 
 
+/**
+ * OvmsVehicleRxTrace: RX pipeline instrumentation interface, called by the
+ *  vehicle RX task after each frame has been processed (see test canpipe)
+ */
+class OvmsVehicleRxTrace
+  {
+  public:
+    virtual ~OvmsVehicleRxTrace() {}
+    virtual void RxFrame(const CAN_frame_t* frame, int64_t started, int64_t finished, UBaseType_t waiting) = 0;
+  };
+
 class OvmsVehicle : public InternalRamAllocated
   {
   friend class OvmsVehicleFactory;
@@ -172,6 +190,12 @@ class OvmsVehicle : public InternalRamAllocated
     bool m_autonotifications;
     bool m_ready;
 
+  public:
+    void SetRxTrace(OvmsVehicleRxTrace* trace) { m_rxtrace = trace; }
+
+  protected:
+    OvmsVehicleRxTrace* volatile m_rxtrace; // NULL = no RX instrumentation
+
   public:
     canbus* m_can1;
     canbus* m_can2;
@@ -181,16 +205,20 @@ class OvmsVehicle : public InternalRamAllocated
   private:
     void VehicleTicker1(std::string event, void* data);
     void VehicleConfigChanged(std::string event, void* data);
+
+  protected:
     void PollerSend(bool fromTicker);
     void PollerReceive(CAN_frame_t* frame);
 
   protected:
+    // Note: p_frame->timestamp holds the capture time (esp_timer_get_time()) of the frame
     virtual void IncomingFrameCan1(CAN_frame_t* p_frame);
     virtual void IncomingFrameCan2(CAN_frame_t* p_frame);
     virtual void IncomingFrameCan3(CAN_frame_t* p_frame);
     virtual void IncomingFrameCan4(CAN_frame_t* p_frame);
     virtual void IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain);
     virtual void IncomingPollError(canbus* bus, uint16_t type, uint16_t pid, uint16_t code);
+    virtual void IncomingPollResponse(canbus* bus, uint16_t type, uint16_t pid, const uint8_t* payload, size_t length);
 
   protected:
     int m_minsoc;            // The minimum SOC level before alert
@@ -284,8 +312,13 @@ class OvmsVehicle : public InternalRamAllocated
 
   protected:
     void RegisterCanBus(int bus, CAN_mode_t mode, CAN_speed_t speed, dbcfile* dbcfile = NULL);
+    void RegisterCanId(int bus, CAN_frame_format_t format, uint32_t id);
+    void RegisterCanId(int bus, CAN_frame_format_t format, uint32_t id_from, uint32_t id_to);
     bool PinCheck(char* pin);
 
+  protected:
+    canidset m_rxids;                       // Opt-in RX subscriptions (empty = all frames)
+
   public:
     virtual void RxTask();
 
@@ -354,8 +387,50 @@ class OvmsVehicle : public InternalRamAllocated
         };
       uint16_t polltime[VEHICLE_POLL_NSTATES];
       uint8_t  pollbus;
+      uint16_t timeout_ms;                    // Scheduled poller response timeout, 0 = default
       } poll_pid_t;
 
+    typedef struct
+      {
+      canbus*  bus;                           // Bus the request was sent on, NULL = slot free
+      uint32_t moduleid_sent;
+      uint32_t moduleid_low;
+      uint32_t moduleid_high;
+      uint16_t type;
+      uint16_t pid;
+      uint16_t ml_remain;
+      uint16_t ml_offset;
+      uint16_t ml_frame;
+      uint16_t timeout_ms;                    // Response timeout (restarted on every response frame)
+      int64_t  deadline;                      // esp_timer_get_time() at which the request is abandoned
+      int64_t  sent;                          // esp_timer_get_time() at which the request was sent
+      uint16_t index;                         // Poll list entry index
+      uint8_t* rxbuf;                         // Response reassembly buffer (allocated on poller setup)
+      } poll_slot_t;
+
+    typedef struct
+      {
+      int64_t  due;                           // esp_timer_get_time() at which the entry is due
+      uint16_t index;                         // Poll list entry index
+      } poll_sched_t;
+
+    typedef struct
+      {
+      uint32_t sent;                          // Requests sent
+      uint32_t responses;                     // Requests completed (including negative responses)
+      uint32_t errors;                        // Negative responses
+      uint32_t timeouts;                      // Requests abandoned
+      uint32_t skipped;                       // Scheduled polls skipped (overrun)
+      uint32_t first_sent;                    // Time of first & last request [ms]
+      uint32_t last_sent;
+      uint32_t jitter_sum;                    // Send delay after the scheduled time [ms]
+      uint32_t jitter_max;
+      uint32_t latency_sum;                   // Response time [ms] (request sent to response captured)
+      uint32_t latency_max;
+      uint32_t rxdelay_sum;                   // Response RX processing delay after capture [us]
+      uint32_t rxdelay_max;
+      } poll_stats_t;
+
   protected:
     OvmsRecMutex      m_poll_mutex;           // Concurrency protection for recursive calls
     uint8_t           m_poll_state;           // Current poll state
@@ -387,13 +462,71 @@ class OvmsVehicle : public InternalRamAllocated
     uint8_t           m_poll_sequence_cnt;    // Polls already sent in the current time tick (second)
     uint8_t           m_poll_fc_septime;      // Flow control separation time for multi frame responses
 
+  private:
+    bool              m_poll_scheduled;       // Use the scheduler (concurrency > 1 or time base set)
+    uint8_t           m_poll_concurrency;     // Requests allowed in flight at once (max one per bus & ECU), 1 = sequential
+    uint16_t          m_poll_timeout_ms;      // Scheduled: default response timeout
+    uint16_t          m_poll_timebase;        // Scheduled: polltime unit [ms], 0 = seconds (not set)
+    poll_slot_t       m_poll_slots[VEHICLE_POLL_MAX_SLOTS];
+    uint8_t           m_poll_slots_busy;      // Scheduled: requests currently in flight
+    uint32_t          m_poll_slots_low;       // Scheduled: response ID range of all requests in flight
+    uint32_t          m_poll_slots_high;      //   (quick RX filter)
+    std::vector<poll_sched_t> m_poll_queue;   // Scheduled: min-heap of list entries by due time
+    std::vector<poll_sched_t> m_poll_deferred; // Scheduled: due entries waiting for their ECU
+    bool              m_poll_queue_valid;     // Scheduled: false = rebuild queue on next send
+    int64_t           m_poll_wakeup;          // Scheduled: next due time or deadline (RX task timer)
+    poll_slot_t*      m_poll_slot;            // Scheduled: slot of the response being processed
+    int64_t           m_poll_rxtime;          // Capture time of the response frame being processed
+    uint8_t*          m_poll_rxbuf;           // Sequential: response reassembly buffer (allocated on poller setup)
+    int               m_poll_index;           // Sequential: list index of the request in flight, -1 = none
+    int64_t           m_poll_sent_time;       // Sequential: time the request in flight was sent
+    bool              m_poll_error;           // Response processed is a negative response
+    int               m_poll_count;           // Number of poll list entries
+    poll_stats_t*     m_poll_stats;           // Per entry statistics (since list/state change)
+
+  private:
+    void PollerSelect(const poll_pid_t* entry);
+    void PollerTransmit(const poll_pid_t* entry);
+    void PollerProcessFrame(CAN_frame_t* frame);
+    uint8_t* PollerResponseBuffer();
+    void PollerAllocBuffers();
+    void PollerSendScheduled(bool fromTicker);
+    void PollerReceiveScheduled(CAN_frame_t* frame);
+    poll_slot_t* PollerFindSlot(canbus* bus, uint32_t moduleid_sent, uint32_t moduleid_low, uint32_t moduleid_high);
+    void PollerUpdateSlots();
+    void PollerResetSlots();
+    bool PollerCheckTimeouts();
+    TickType_t PollerTimeoutTicks();
+    void PollerResetStats();
+    void PollerStatsSent(int index, int64_t now, int64_t jitter);
+    void PollerStatsDone(int index, int64_t sent, bool timeout, int64_t received=0);
+
+  public:
+    void PollerStatus(int verbosity, OvmsWriter* writer);
+
   protected:
     void PollSetPidList(canbus* bus, const poll_pid_t* plist);
     void PollSetState(uint8_t state);
     void PollSetThrottling(uint8_t sequence_max) { m_poll_sequence_max = sequence_max; }
     void PollSetResponseSeparationTime(uint8_t septime);
+    void PollSetConcurrency(uint8_t slots, uint16_t timeout_ms=VEHICLE_POLL_TIMEOUT_MS);
+    void PollSetTimeBase(uint16_t timebase_ms);
 
   // BMS helpers
+  public:
+    /**
+     * bms_cellstats_t: running sums of the current BMS sweep
+     *  Sums are kept relative to the first value of the sweep (shifted data),
+     *  so the variance can be derived without cancellation issues. Cell
+     *  updates within a sweep replace their previous contribution.
+     */
+    typedef struct
+      {
+      float ref;                              // Shift reference (first value of sweep)
+      double sum;                             // Sum of (value - ref)
+      double sqrsum;                          // Sum of (value - ref)^2
+      } bms_cellstats_t;
+
   protected:
     float* m_bms_voltages;                    // BMS voltages (current value)
     float* m_bms_vmins;                       // BMS minimum voltages seen (since reset)
@@ -409,8 +542,10 @@ class OvmsVehicle : public InternalRamAllocated
     short* m_bms_talerts;                     // BMS temperature deviation alerts (since reset)
     int m_bms_talerts_new;                    // BMS new temperature alerts since last notification
     bool m_bms_has_temperatures;              // True if BMS has a complete set of temperature values
-    std::vector<bool> m_bms_bitset_v;         // BMS tracking: true if corresponding voltage set
-    std::vector<bool> m_bms_bitset_t;         // BMS tracking: true if corresponding temperature set
+    uint8_t* m_bms_bitset_v;                  // BMS tracking: 1 if corresponding voltage set
+    uint8_t* m_bms_bitset_t;                  // BMS tracking: 1 if corresponding temperature set
+    bms_cellstats_t m_bms_vstats;             // BMS tracking: running voltage sweep sums
+    bms_cellstats_t m_bms_tstats;             // BMS tracking: running temperature sweep sums
     int m_bms_bitset_cv;                      // BMS tracking: count of unique voltage values set
     int m_bms_bitset_ct;                      // BMS tracking: count of unique temperature values set
     int m_bms_readings_v;                     // Number of BMS voltage readings expected
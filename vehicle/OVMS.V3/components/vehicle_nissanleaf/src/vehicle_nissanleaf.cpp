@@ -43,7 +43,6 @@ static const char *TAG = "v-nissanleaf";
 #include "ovms_command.h"
 #include "ovms_config.h"
 
-#define MAX_POLL_DATA_LEN         196
 #define BMS_TXID                  0x79B
 #define BMS_RXID                  0x7BB
 #define CHARGER_TXID              0x797
@@ -487,7 +486,7 @@ bool OvmsVehicleNissanLeaf::ObdRequest(uint16_t txid, uint16_t rxid, uint32_t re
   return (rxok == pdTRUE);
   }
 
-void OvmsVehicleNissanLeaf::PollReply_Battery(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_Battery(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 39 &&    // 24 KWh Leafs
       reply_len != 41)      // 30 KWh Leafs with Nissan BMS fix
@@ -537,7 +536,7 @@ void OvmsVehicleNissanLeaf::PollReply_Battery(uint8_t reply_data[], uint16_t rep
     }
   }
 
-void OvmsVehicleNissanLeaf::PollReply_BMS_Volt(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_BMS_Volt(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 196)
     {
@@ -561,7 +560,7 @@ void OvmsVehicleNissanLeaf::PollReply_BMS_Volt(uint8_t reply_data[], uint16_t re
     }
   }
 
-void OvmsVehicleNissanLeaf::PollReply_BMS_Shunt(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_BMS_Shunt(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 24)
     {
@@ -585,7 +584,7 @@ void OvmsVehicleNissanLeaf::PollReply_BMS_Shunt(uint8_t reply_data[], uint16_t r
   }
 
 
-void OvmsVehicleNissanLeaf::PollReply_BMS_Temp(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_BMS_Temp(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 14)
     {
@@ -631,7 +630,7 @@ void OvmsVehicleNissanLeaf::PollReply_BMS_Temp(uint8_t reply_data[], uint16_t re
   m_bms_temp_int->SetElemValues(0, 6, temp_int);
   }
 
-void OvmsVehicleNissanLeaf::PollReply_QC(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_QC(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 2)
     {
@@ -649,7 +648,7 @@ void OvmsVehicleNissanLeaf::PollReply_QC(uint8_t reply_data[], uint16_t reply_le
     }
   }
 
-void OvmsVehicleNissanLeaf::PollReply_L0L1L2(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_L0L1L2(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 2)
     {
@@ -667,7 +666,7 @@ void OvmsVehicleNissanLeaf::PollReply_L0L1L2(uint8_t reply_data[], uint16_t repl
     }
   }
 
-void OvmsVehicleNissanLeaf::PollReply_VIN(uint8_t reply_data[], uint16_t reply_len)
+void OvmsVehicleNissanLeaf::PollReply_VIN(const uint8_t reply_data[], uint16_t reply_len)
   {
   if (reply_len != 19)
     {
@@ -685,55 +684,42 @@ void OvmsVehicleNissanLeaf::PollReply_VIN(uint8_t reply_data[], uint16_t reply_l
   StandardMetrics.ms_v_vin->SetValue(strbuf); //(char*)reply_data
   }
 
-// Reassemble all pieces of a multi-frame reply.
-void OvmsVehicleNissanLeaf::IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain)
+// Process a complete (reassembled) poll response.
+void OvmsVehicleNissanLeaf::IncomingPollResponse(canbus* bus, uint16_t type, uint16_t pid, const uint8_t* payload, size_t length)
   {
-  string& rxbuf = nl_obd_rxbuf;
-
-  // init / fill rx buffer:
-  if (m_poll_ml_frame == 0) {
-    rxbuf.clear();
-    rxbuf.reserve(length + mlremain);
-  }
-  rxbuf.append((char*)data, length);
-  if (mlremain)
-    return;
-
-  static uint8_t buf[MAX_POLL_DATA_LEN];
-  memcpy(buf, rxbuf.c_str(), rxbuf.size());
-
   uint32_t id_pid = m_poll_moduleid_low<<16 | pid;
     switch (id_pid)
       {
       case BMS_RXID<<16 | 0x01: // battery
-        PollReply_Battery(buf, rxbuf.size());
+        PollReply_Battery(payload, length);
         break;
       case BMS_RXID<<16 | 0x02:
-        PollReply_BMS_Volt(buf, rxbuf.size());
+        PollReply_BMS_Volt(payload, length);
         break;
       case BMS_RXID<<16 | 0x06:
-        PollReply_BMS_Shunt(buf, rxbuf.size());
+        PollReply_BMS_Shunt(payload, length);
         break;
       case BMS_RXID<<16 | 0x04:
-        PollReply_BMS_Temp(buf, rxbuf.size());
+        PollReply_BMS_Temp(payload, length);
         break;
       case CHARGER_RXID<<16 | QC_COUNT_PID: // QC
-        PollReply_QC(buf, rxbuf.size());
+        PollReply_QC(payload, length);
         break;
       case CHARGER_RXID<<16 | L1L2_COUNT_PID: // L0/L1/L2
-        PollReply_L0L1L2(buf, rxbuf.size());
+        PollReply_L0L1L2(payload, length);
         break;
       case CHARGER_RXID<<16 | VIN_PID: // VIN
-        PollReply_VIN(buf, rxbuf.size());
+        PollReply_VIN(payload, length);
         break;
       default:
-        ESP_LOGI(TAG, "IncomingPollReply: unknown reply module|pid=%#x len=%d", id_pid, rxbuf.size());
+        ESP_LOGI(TAG, "IncomingPollResponse: unknown reply module|pid=%#x len=%u", id_pid, length);
         break;
       }
 
     // single poll?
     if (!nl_obd_rxwait.IsAvail()) {
-      // yes: stop poller & signal response
+      // yes: copy response, stop poller & signal response
+      nl_obd_rxbuf.assign((const char*)payload, length);
       PollSetPidList(m_poll_bus, NULL);
       nl_obd_rxwait.Give();
     }
@@ -97,7 +97,7 @@ class OvmsVehicleNissanLeaf : public OvmsVehicle
 
   public:
     bool ObdRequest(uint16_t txid, uint16_t rxid, uint32_t request, string& response, int timeout_ms /*=3000*/, uint8_t bus);
-    void IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain);
+    void IncomingPollResponse(canbus* bus, uint16_t type, uint16_t pid, const uint8_t* payload, size_t length);
     void IncomingFrameCan1(CAN_frame_t* p_frame);
     void IncomingFrameCan2(CAN_frame_t* p_frame);
     vehicle_command_t CommandHomelink(int button, int durationms=1000);
@@ -140,13 +140,13 @@ class OvmsVehicleNissanLeaf : public OvmsVehicle
     virtual int GetNotifyChargeStateDelay(const char* state);
     RemoteCommand nl_remote_command; // command to send, see RemoteCommandTimer()
     uint8_t nl_remote_command_ticker; // number remaining remote command frames to send
-    void PollReply_Battery(uint8_t reply_data[], uint16_t reply_len);
-    void PollReply_QC(uint8_t reply_data[], uint16_t reply_len);
-    void PollReply_L0L1L2(uint8_t reply_data[], uint16_t reply_len);
-    void PollReply_VIN(uint8_t reply_data[], uint16_t reply_len);
-    void PollReply_BMS_Volt(uint8_t reply_data[], uint16_t reply_len);
-    void PollReply_BMS_Shunt(uint8_t reply_data[], uint16_t reply_len);
-    void PollReply_BMS_Temp(uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_Battery(const uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_QC(const uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_L0L1L2(const uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_VIN(const uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_BMS_Volt(const uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_BMS_Shunt(const uint8_t reply_data[], uint16_t reply_len);
+    void PollReply_BMS_Temp(const uint8_t reply_data[], uint16_t reply_len);
 
     TimerHandle_t m_remoteCommandTimer;
     TimerHandle_t m_ccDisableTimer;
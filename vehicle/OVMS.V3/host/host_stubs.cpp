@@ -0,0 +1,61 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: framework stubs
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * Stand-ins for framework modules not included in the host build
+ * (scripting, module/task accounting).
+ */
+
+#include "ovms_script.h"
+#include "ovms_module.h"
+
+// Scripting: event scripts are not executed on the host
+
+OvmsScripts MyScripts __attribute__ ((init_priority (1600)));
+
+OvmsScripts::OvmsScripts()
+  {
+  m_eventdirs_valid = false;
+  }
+
+OvmsScripts::~OvmsScripts()
+  {
+  }
+
+void OvmsScripts::EventScript(const char* event, void* data, bool interned)
+  {
+  }
+
+void OvmsScripts::AllScripts(std::string path)
+  {
+  }
+
+// Module: task map used for memory accounting on the device
+
+void AddTaskToMap(TaskHandle_t task)
+  {
+  }
@@ -0,0 +1,457 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: MCP2515 simulator
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#include "ovms_log.h"
+static const char *TAG = "mcp2515sim";
+
+#include <unistd.h>
+#include <string.h>
+#include <string>
+#include "mcp2515_sim.h"
+#include "mcp2515.h"
+#include "esp_timer.h"
+#include "ovms_command.h"
+#include "ovms_config.h"
+
+// Register addresses not defined by the driver:
+#define SIM_TXB0CTRL        0x30
+#define SIM_RXB0SIDH        0x61
+#define SIM_RXB1SIDH        0x71
+#define SIM_CMD_RX_STATUS   0b10110000
+
+// CANINTF / EFLG bits:
+#define SIM_RX0IF           0x01
+#define SIM_RX1IF           0x02
+#define SIM_ERRIF           0x20
+#define SIM_RX0OVR          0x40
+#define SIM_RX1OVR          0x80
+#define SIM_BUKT            0x04    // RXB0CTRL: rollover enable
+#define SIM_TXREQ           0x08    // TXBnCTRL: transmit request
+
+mcp2515sim::mcp2515sim(int intpin)
+  {
+  m_intpin = intpin;
+  m_spi_overhead_us = 15;
+  m_spi_byte_us = 0.8;
+  m_int = false;
+  m_traffic_start = 0;
+  m_traffic_rate = 0;
+  m_traffic_count = 0;
+  ResetStats();
+  Reset();
+  }
+
+mcp2515sim::~mcp2515sim()
+  {
+  }
+
+void mcp2515sim::ResetStats()
+  {
+  m_transactions = 0;
+  m_received = 0;
+  m_overflows = 0;
+  m_sent = 0;
+  }
+
+/**
+ * Reset: power on / RESET command state: configuration mode, all flags cleared
+ *  (called with the mutex held or from the constructor)
+ */
+void mcp2515sim::Reset()
+  {
+  memset(m_reg, 0, sizeof(m_reg));
+  m_reg[REG_CANSTAT] = 0x80;
+  m_reg[REG_CANCTRL] = 0x87;
+  UpdateInt();
+  }
+
+/**
+ * ReadReg / WriteReg: register access, CANSTAT & CANCTRL are mapped into
+ *  every register row, CANCTRL.REQOP switches the operation mode immediately
+ */
+uint8_t mcp2515sim::ReadReg(uint8_t reg)
+  {
+  reg &= 0x7f;
+  if ((reg & 0x0f) == 0x0e)
+    return m_reg[REG_CANSTAT];
+  if ((reg & 0x0f) == 0x0f)
+    return m_reg[REG_CANCTRL];
+  return m_reg[reg];
+  }
+
+void mcp2515sim::WriteReg(uint8_t reg, uint8_t value)
+  {
+  reg &= 0x7f;
+  if ((reg & 0x0f) == 0x0e)
+    return;  // CANSTAT is read only
+  if ((reg & 0x0f) == 0x0f)
+    {
+    m_reg[REG_CANCTRL] = value;
+    m_reg[REG_CANSTAT] = (m_reg[REG_CANSTAT] & 0x1f) | (value & 0xe0);
+    return;
+    }
+  m_reg[reg] = value;
+  if (reg == REG_CANINTF || reg == REG_CANINTE)
+    UpdateInt();
+  }
+
+uint8_t mcp2515sim::ReadStatus()
+  {
+  uint8_t intf = m_reg[REG_CANINTF];
+  return (intf & 0x03)                                        // RX0IF, RX1IF
+    | ((m_reg[SIM_TXB0CTRL] & SIM_TXREQ) ? 0x04 : 0) | ((intf & 0x04) << 1)
+    | ((m_reg[SIM_TXB0CTRL+0x10] & SIM_TXREQ) ? 0x10 : 0) | ((intf & 0x08) << 2)
+    | ((m_reg[SIM_TXB0CTRL+0x20] & SIM_TXREQ) ? 0x40 : 0) | ((intf & 0x10) << 3);
+  }
+
+/**
+ * UpdateInt: drive the INT output, a falling edge runs the driver ISR
+ */
+void mcp2515sim::UpdateInt()
+  {
+  bool active = (m_reg[REG_CANINTF] & m_reg[REG_CANINTE]) != 0;
+  if (active != m_int)
+    {
+    m_int = active;
+    host_gpio_input((gpio_num_t)m_intpin, active ? 0 : 1);
+    }
+  }
+
+/**
+ * Transfer: SPI transaction, executed when CS is released
+ */
+void mcp2515sim::Transfer(uint8_t* buf, int len)
+  {
+  int64_t done = esp_timer_get_time() + m_spi_overhead_us + (int64_t)(len * m_spi_byte_us);
+  while (esp_timer_get_time() < done) {}
+  m_transactions++;
+
+  if (len < 1)
+    return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ReceiveDue();
+  uint8_t cmd = buf[0];
+  buf[0] = 0;
+
+  if (cmd == CMD_RESET)
+    {
+    Reset();
+    }
+  else if (cmd == CMD_READ && len >= 2)
+    {
+    uint8_t reg = buf[1];
+    buf[1] = 0;
+    for (int k = 2; k < len; k++)
+      buf[k] = ReadReg(reg++);
+    }
+  else if (cmd == CMD_WRITE && len >= 2)
+    {
+    uint8_t reg = buf[1];
+    for (int k = 2; k < len; k++)
+      WriteReg(reg++, buf[k]);
+    memset(buf, 0, len);
+    }
+  else if (cmd == CMD_BITMODIFY && len >= 4)
+    {
+    uint8_t reg = buf[1];
+    WriteReg(reg, (ReadReg(reg) & ~buf[2]) | (buf[3] & buf[2]));
+    memset(buf, 0, len);
+    }
+  else if ((cmd & 0b11111001) == CMD_READ_RXBUF)
+    {
+    // 1001 0nm0: n = RX buffer, m = start at D0
+    uint8_t rxb = (cmd & 0x04) ? 1 : 0;
+    uint8_t reg = (rxb ? SIM_RXB1SIDH : SIM_RXB0SIDH) + ((cmd & 0x02) ? 5 : 0);
+    for (int k = 1; k < len; k++)
+      buf[k] = m_reg[reg++ & 0x7f];
+    m_reg[REG_CANINTF] &= ~(rxb ? SIM_RX1IF : SIM_RX0IF);
+    UpdateInt();
+    }
+  else if ((cmd & 0b11111000) == CMD_LOAD_TXBUF)
+    {
+    // 0100 0abc: TXB0/1/2, start at SIDH or D0
+    uint8_t abc = cmd & 0x07;
+    uint8_t reg = SIM_TXB0CTRL + 0x10*(abc >> 1) + ((abc & 1) ? 6 : 1);
+    for (int k = 1; k < len; k++)
+      m_reg[reg++ & 0x7f] = buf[k];
+    memset(buf, 0, len);
+    }
+  else if ((cmd & 0b11111000) == CMD_RTS)
+    {
+    // transmission is immediately successful:
+    for (int txb = 0; txb < 3; txb++)
+      {
+      if (cmd & (1 << txb))
+        m_reg[REG_CANINTF] |= (0x04 << txb);
+      }
+    UpdateInt();
+    }
+  else if (cmd == CMD_READ_STATUS)
+    {
+    uint8_t status = ReadStatus();
+    for (int k = 1; k < len; k++)
+      buf[k] = status;
+    }
+  else if (cmd == SIM_CMD_RX_STATUS)
+    {
+    uint8_t status = (m_reg[REG_CANINTF] & 0x03) << 6;
+    for (int k = 1; k < len; k++)
+      buf[k] = status;
+    }
+  else
+    {
+    ESP_LOGW(TAG, "Unknown SPI command 0x%02x", cmd);
+    }
+  }
+
+void mcp2515sim::LoadRxBuffer(uint8_t base, const CAN_frame_t* frame)
+  {
+  uint8_t* p = &m_reg[base];
+  uint32_t id = frame->MsgID;
+  if (frame->FIR.B.FF == CAN_frame_ext)
+    {
+    p[0] = id >> 21;
+    p[1] = (((id >> 18) & 0x07) << 5) | 0x08 | ((id >> 16) & 0x03);
+    p[2] = id >> 8;
+    p[3] = id;
+    }
+  else
+    {
+    p[0] = id >> 3;
+    p[1] = (id & 0x07) << 5;
+    p[2] = 0;
+    p[3] = 0;
+    }
+  p[4] = frame->FIR.B.DLC;
+  memcpy(p+5, frame->data.u8, 8);
+  }
+
+/**
+ * Receive: a frame has been received from the bus
+ *  Returns false if the frame is lost (controller not receiving, or both RX buffers full)
+ */
+bool mcp2515sim::Receive(const CAN_frame_t* frame)
+  {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return ReceiveFrame(frame);
+  }
+
+bool mcp2515sim::ReceiveFrame(const CAN_frame_t* frame)
+  {
+  uint8_t opmode = m_reg[REG_CANSTAT] & 0xe0;
+  if (opmode != CANSTAT_MODE_NORMAL && opmode != CANSTAT_MODE_LISTEN && opmode != CANSTAT_MODE_LOOPBACK)
+    return false;
+
+  uint8_t& intf = m_reg[REG_CANINTF];
+  bool rollover = (m_reg[REG_RXB0CTRL] & SIM_BUKT) != 0;
+  if ((intf & SIM_RX0IF) == 0)
+    {
+    LoadRxBuffer(SIM_RXB0SIDH, frame);
+    intf |= SIM_RX0IF;
+    }
+  else if (rollover && (intf & SIM_RX1IF) == 0)
+    {
+    LoadRxBuffer(SIM_RXB1SIDH, frame);
+    intf |= SIM_RX1IF;
+    }
+  else
+    {
+    m_reg[REG_EFLG] |= rollover ? SIM_RX1OVR : SIM_RX0OVR;
+    intf |= SIM_ERRIF;
+    m_overflows++;
+    UpdateInt();
+    return false;
+    }
+  m_received++;
+  UpdateInt();
+  return true;
+  }
+
+/**
+ * StartTraffic: schedule count frames at rate frames/s, starting now
+ */
+void mcp2515sim::StartTraffic(int rate, uint32_t count)
+  {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sent = 0;
+  m_traffic_rate = rate;
+  m_traffic_count = count;
+  m_traffic_start = esp_timer_get_time();
+  }
+
+/**
+ * ReceiveDue: receive all scheduled frames due by now (called with the mutex held)
+ *  Standard & extended IDs, data: sequence number & its complement
+ */
+void mcp2515sim::ReceiveDue()
+  {
+  if (m_sent >= m_traffic_count)
+    return;
+  int64_t now = esp_timer_get_time();
+  CAN_frame_t frame = {};
+  frame.FIR.B.DLC = 8;
+  while (m_sent < m_traffic_count &&
+         m_traffic_start + (int64_t)m_sent * 1000000 / m_traffic_rate <= now)
+    {
+    uint32_t seq = ++m_sent;
+    frame.FIR.B.FF = (seq & 3) ? CAN_frame_std : CAN_frame_ext;
+    frame.MsgID = (seq & 3) ? 0x100 + (seq & 0x0f) : 0x18daf100 + (seq & 0x0f);
+    frame.data.u32[0] = seq;
+    frame.data.u32[1] = ~seq;
+    ReceiveFrame(&frame);
+    }
+  }
+
+/**
+ * Generate: receive due frames, sleep until the next one is due
+ *  Returns false when all scheduled frames have been sent
+ */
+bool mcp2515sim::Generate()
+  {
+  int64_t due;
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ReceiveDue();
+    if (m_sent >= m_traffic_count)
+      return false;
+    due = m_traffic_start + (int64_t)m_sent * 1000000 / m_traffic_rate;
+    }
+  int64_t wait = due - esp_timer_get_time();
+  if (wait > 0)
+    usleep(wait);
+  return true;
+  }
+
+
+////////////////////////////////////////////////////////////////////////
+// test mcp2515: RX path benchmark, single frame vs. drain mode
+////////////////////////////////////////////////////////////////////////
+
+#define TEST_MCP2515_CS_PIN     5
+#define TEST_MCP2515_INT_PIN    35
+
+static mcp2515sim* test_mcp2515_sim = NULL;
+static mcp2515* test_mcp2515_bus = NULL;
+
+typedef struct
+  {
+  uint32_t received;
+  uint32_t reordered;
+  uint32_t lastseq;
+  int64_t delay_sum;
+  int64_t delay_max;
+  } test_mcp2515_rx_t;
+
+static void test_mcp2515(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int rate = (argc > 0) ? atoi(argv[0]) : 4000;
+  int seconds = (argc > 1) ? atoi(argv[1]) : 3;
+  int work = (argc > 2) ? atoi(argv[2]) : 0;
+  if (rate <= 0 || seconds <= 0 || work < 0)
+    {
+    writer->puts("Error: frame rate and duration must be positive");
+    return;
+    }
+
+  if (!test_mcp2515_sim)
+    {
+    test_mcp2515_sim = new mcp2515sim(TEST_MCP2515_INT_PIN);
+    host_spi_attach(TEST_MCP2515_CS_PIN, test_mcp2515_sim);
+    spi* spibus = new spi("spi", -1, -1, -1);
+    test_mcp2515_bus = new mcp2515("can4", spibus, VSPI_NODMA_HOST, 10000000,
+      TEST_MCP2515_CS_PIN, TEST_MCP2515_INT_PIN);
+    MyPcpApp.Register("can4", test_mcp2515_bus);
+    }
+  mcp2515sim* sim = test_mcp2515_sim;
+  mcp2515* bus = test_mcp2515_bus;
+
+  static test_mcp2515_rx_t rx;
+  MyCan.RegisterCallback("test_mcp2515", [bus,work](const CAN_frame_t* frame, bool tx)
+    {
+    if (frame->origin != bus) return;
+    // simulate the frame processing load (listeners, vehicle):
+    int64_t done = esp_timer_get_time() + work;
+    while (esp_timer_get_time() < done) {}
+    rx.received++;
+    if (frame->data.u32[0] <= rx.lastseq) rx.reordered++;
+    rx.lastseq = frame->data.u32[0];
+    int64_t delay = esp_timer_get_time() - frame->timestamp;
+    rx.delay_sum += delay;
+    if (delay > rx.delay_max) rx.delay_max = delay;
+    });
+
+  std::string saved = MyConfig.GetParamValue("can", "mcp2515.rxdrain");
+  writer->printf("MCP2515 RX: %d frames/s for %d s, %d us work/frame, SPI %d us + %.1f us/byte\n",
+    rate, seconds, work, sim->m_spi_overhead_us, sim->m_spi_byte_us);
+  writer->printf("%-7s %8s %8s %8s %8s %8s %8s %9s %8s %8s\n",
+    "Mode", "Sent", "Rcvd", "Lost", "CtrlOvr", "Reorder", "IRQs", "SPI/frame", "Delay_us", "Max_us");
+
+  for (int drain = 0; drain < 2; drain++)
+    {
+    MyConfig.SetParamValueBool("can", "mcp2515.rxdrain", drain);
+    if (bus->Start(CAN_MODE_LISTEN, CAN_SPEED_500KBPS) != ESP_OK)
+      {
+      writer->puts("Error: MCP2515 start failed");
+      break;
+      }
+    bus->ClearStatus();
+    sim->ResetStats();
+    memset(&rx, 0, sizeof(rx));
+
+    sim->StartTraffic(rate, rate * seconds);
+    while (sim->Generate()) {}
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    uint32_t sent = sim->m_sent;
+    uint32_t spi = sim->m_transactions;
+    writer->printf("%-7s %8u %8u %8u %8u %8u %8u %9.2f %8.0f %8lld\n",
+      drain ? "drain" : "single", sent, rx.received, sent - rx.received,
+      (uint32_t)sim->m_overflows, rx.reordered, bus->m_status.interrupts,
+      rx.received ? (float)spi / rx.received : 0.0f,
+      rx.received ? (float)rx.delay_sum / rx.received : 0.0f,
+      (long long)rx.delay_max);
+    bus->Stop();
+    }
+
+  MyCan.DeregisterCallback("test_mcp2515");
+  if (saved.empty())
+    MyConfig.DeleteInstance("can", "mcp2515.rxdrain");
+  else
+    MyConfig.SetParamValue("can", "mcp2515.rxdrain", saved);
+  }
+
+class TestMcp2515Init
+  {
+  public: TestMcp2515Init();
+  } TestMcp2515Init __attribute__ ((init_priority (5100)));
+
+TestMcp2515Init::TestMcp2515Init()
+  {
+  OvmsCommand* cmd_test = MyCommandApp.RegisterCommand("test","Test framework");
+  cmd_test->RegisterCommand("mcp2515","Benchmark MCP2515 RX modes on the register level simulator",
+    test_mcp2515,"[<frames/s>] [<seconds>] [<work_us>]",0,3);
+  }
@@ -0,0 +1,94 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: MCP2515 simulator
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#ifndef __MCP2515_SIM_H__
+#define __MCP2515_SIM_H__
+
+#include <stdint.h>
+#include <mutex>
+#include <atomic>
+#include "can.h"
+#include "spi.h"
+
+/**
+ * mcp2515sim: register level MCP2515 CAN controller simulation
+ *
+ *  Implements the SPI command set used by the mcp2515 driver (RESET, READ,
+ *  WRITE, BIT MODIFY, READ RX BUFFER, LOAD TX BUFFER, RTS, READ STATUS,
+ *  RX STATUS), the operation modes, RX buffer rollover & overflow, and the
+ *  INT output (low while any enabled interrupt flag is set).
+ *
+ *  SPI transactions take m_spi_overhead_us plus m_spi_byte_us per byte
+ *  (busy wait), to model the bus cost on the module.
+ *
+ *  Bus traffic: StartTraffic() schedules sequence numbered frames at a fixed
+ *  rate. Frames are received when due, checked before each SPI transaction
+ *  and by Generate(), so the controller state seen by the driver is exact
+ *  even if the generating thread is delayed.
+ */
+class mcp2515sim : public host_spi_device
+  {
+  public:
+    mcp2515sim(int intpin);
+    ~mcp2515sim();
+
+  public:
+    void Transfer(uint8_t* buf, int len);
+    bool Receive(const CAN_frame_t* frame);
+    void ResetStats();
+    void StartTraffic(int rate, uint32_t count);
+    bool Generate();
+
+  protected:
+    void Reset();
+    uint8_t ReadReg(uint8_t reg);
+    void WriteReg(uint8_t reg, uint8_t value);
+    uint8_t ReadStatus();
+    void LoadRxBuffer(uint8_t base, const CAN_frame_t* frame);
+    bool ReceiveFrame(const CAN_frame_t* frame);
+    void ReceiveDue();
+    void UpdateInt();
+
+  public:
+    int m_intpin;
+    int m_spi_overhead_us;            // per transaction: driver, bus lock, CS
+    float m_spi_byte_us;              // per byte: 0.8 µs at 10 MHz
+    std::atomic<uint32_t> m_transactions;
+    std::atomic<uint32_t> m_received;
+    std::atomic<uint32_t> m_overflows;
+    std::atomic<uint32_t> m_sent;     // traffic frames put on the bus
+
+  protected:
+    std::mutex m_mutex;
+    uint8_t m_reg[128];
+    bool m_int;
+    int64_t m_traffic_start;
+    int m_traffic_rate;
+    uint32_t m_traffic_count;
+  };
+
+#endif //#ifndef __MCP2515_SIM_H__
@@ -0,0 +1,113 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: mock CAN bus
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#include "ovms_log.h"
+static const char *TAG = "mockcan";
+
+#include <string.h>
+#include "mock_canbus.h"
+#include "pcp.h"
+#include "esp_timer.h"
+
+mockcan::mockcan(const char* name)
+  : canbus(name)
+  {
+  m_loopback = false;
+  MyPcpApp.Register(name, this);
+  }
+
+mockcan::~mockcan()
+  {
+  MyPcpApp.Deregister(m_name);
+  }
+
+esp_err_t mockcan::Start(CAN_mode_t mode, CAN_speed_t speed)
+  {
+  ClearStatus();
+  m_mode = mode;
+  m_speed = speed;
+  m_powermode = On;
+  ESP_LOGI(TAG, "%s started in %s mode at %d kbps", m_name,
+    (mode == CAN_MODE_ACTIVE) ? "active" : "listen", (int)speed);
+  return ESP_OK;
+  }
+
+esp_err_t mockcan::Stop()
+  {
+  canbus::Stop();
+  m_mode = CAN_MODE_OFF;
+  m_powermode = Off;
+  return ESP_OK;
+  }
+
+esp_err_t mockcan::Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait /*=0*/)
+  {
+  if (m_mode != CAN_MODE_ACTIVE)
+    {
+    ESP_LOGW(TAG,"Cannot write %s when not in ACTIVE mode",m_name);
+    return ESP_FAIL;
+    }
+
+  // stats & logging:
+  canbus::Write(p_frame, maxqueuewait);
+
+  // Request TxCallback:
+  CAN_queue_msg_t msg;
+  msg.type = CAN_txcallback;
+  msg.body.frame = m_tx_frame;
+  msg.body.bus = this;
+  if (xQueueSend(MyCan.m_rxqueue, &msg, maxqueuewait) != pdTRUE)
+    {
+    m_status.txbuf_overflow++;
+    return ESP_FAIL;
+    }
+
+  if (m_loopback)
+    InjectFrame(p_frame, maxqueuewait);
+
+  return ESP_OK;
+  }
+
+/**
+ * InjectFrame: simulate reception of a frame on this bus
+ *    - returns false on RX queue overflow
+ */
+bool mockcan::InjectFrame(const CAN_frame_t* p_frame, TickType_t maxqueuewait /*=0*/)
+  {
+  CAN_queue_msg_t msg;
+  msg.type = CAN_frame;
+  msg.timestamp = esp_timer_get_time();
+  msg.body.frame = *p_frame;
+  msg.body.frame.origin = this;
+  msg.body.frame.callback = NULL;
+  if (xQueueSend(MyCan.m_rxqueue, &msg, maxqueuewait) != pdTRUE)
+    {
+    m_status.rxbuf_overflow++;
+    return false;
+    }
+  return true;
+  }
@@ -0,0 +1,62 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: mock CAN bus
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+#ifndef __MOCK_CANBUS_H__
+#define __MOCK_CANBUS_H__
+
+#include "can.h"
+
+/**
+ * mockcan: CAN bus driver without hardware
+ *
+ *  Transmitted frames are confirmed via the CAN RX task (like a TX done
+ *  interrupt would), and optionally looped back as received frames.
+ *  Received frames are injected by the host runner or test code, and
+ *  take the same path as driver frames (MyCan.m_rxqueue).
+ */
+class mockcan : public canbus
+  {
+  public:
+    mockcan(const char* name);
+    ~mockcan();
+
+  public:
+    esp_err_t Start(CAN_mode_t mode, CAN_speed_t speed);
+    esp_err_t Stop();
+
+  public:
+    esp_err_t Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait=0);
+
+  public:
+    bool InjectFrame(const CAN_frame_t* p_frame, TickType_t maxqueuewait=0);
+    void SetLoopback(bool loopback) { m_loopback = loopback; }
+
+  public:
+    bool m_loopback;
+  };
+
+#endif //#ifndef __MOCK_CANBUS_H__
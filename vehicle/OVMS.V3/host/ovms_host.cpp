@@ -0,0 +1,276 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: runner
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * ovms_host: runs the OVMS core framework as a Linux process
+ *
+ * Usage: ovms_host [-d <dir>] [-l <level>] [<command> ...]
+ *
+ *  -d <dir>     working directory, the config store is kept in <dir>/store
+ *               (default: current directory)
+ *  -l <level>   log level: none, error, warn, info, debug, verbose
+ *
+ * Each <command> argument is executed as a shell command line, in order.
+ * Without command arguments, command lines are read from stdin.
+ *
+ * The host housekeeping ticker emits the "ticker.*" events like the device,
+ * the CAN buses "can1" … "can3" are mock drivers (see mock_canbus.h).
+ */
+
+#include "ovms_log.h"
+static const char *TAG = "host";
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "ovms.h"
+#include "ovms_command.h"
+#include "ovms_config.h"
+#include "ovms_events.h"
+#include "ovms_metrics.h"
+#include "metrics_standard.h"
+#include "mock_canbus.h"
+
+////////////////////////////////////////////////////////////////////////
+// Console writer: command output to stdout
+////////////////////////////////////////////////////////////////////////
+
+class HostWriter : public OvmsWriter
+  {
+  public:
+    HostWriter() { m_issecure = true; }
+
+  public:
+    int puts(const char* s)
+      {
+      return ::puts(s);
+      }
+    int printf(const char* fmt, ...)
+      {
+      va_list args;
+      va_start(args, fmt);
+      int ret = vprintf(fmt, args);
+      va_end(args);
+      return ret;
+      }
+    ssize_t write(const void *buf, size_t nbyte)
+      {
+      return fwrite(buf, 1, nbyte, stdout);
+      }
+    bool IsInteractive()
+      {
+      return false;
+      }
+  };
+
+////////////////////////////////////////////////////////////////////////
+// Housekeeping: monotonic time & ticker events
+////////////////////////////////////////////////////////////////////////
+
+static int tick = 0;
+static event_id_t ev_ticker_1, ev_ticker_10, ev_ticker_60, ev_ticker_300, ev_ticker_600, ev_ticker_3600;
+
+static void HostTicker1(TimerHandle_t timer)
+  {
+  monotonictime++;
+  StandardMetrics.ms_m_monotonic->SetValue((int)monotonictime);
+
+  MyEvents.SignalEvent(ev_ticker_1, NULL);
+
+  tick++;
+  if ((tick % 10)==0) MyEvents.SignalEvent(ev_ticker_10, NULL);
+  if ((tick % 60)==0) MyEvents.SignalEvent(ev_ticker_60, NULL);
+  if ((tick % 300)==0) MyEvents.SignalEvent(ev_ticker_300, NULL);
+  if ((tick % 600)==0) MyEvents.SignalEvent(ev_ticker_600, NULL);
+  if ((tick % 3600)==0)
+    {
+    tick = 0;
+    MyEvents.SignalEvent(ev_ticker_3600, NULL);
+    }
+  }
+
+static void HostStart()
+  {
+  ESP_LOGI(TAG, "Mounting CONFIG...");
+  MyConfig.mount();
+
+  ESP_LOGI(TAG, "Configure logging...");
+  MyCommandApp.ConfigureLogging();
+
+  ESP_LOGI(TAG, "Registering default configs...");
+  MyConfig.RegisterParam("vehicle", "Vehicle", true, true);
+
+  ESP_LOGI(TAG, "Creating mock CAN buses...");
+  new mockcan("can1");
+  new mockcan("can2");
+  new mockcan("can3");
+
+  ev_ticker_1 = MyEvents.GetEventId("ticker.1");
+  ev_ticker_10 = MyEvents.GetEventId("ticker.10");
+  ev_ticker_60 = MyEvents.GetEventId("ticker.60");
+  ev_ticker_300 = MyEvents.GetEventId("ticker.300");
+  ev_ticker_600 = MyEvents.GetEventId("ticker.600");
+  ev_ticker_3600 = MyEvents.GetEventId("ticker.3600");
+
+  TimerHandle_t timer = xTimerCreate("Housekeeping", 1000 / portTICK_PERIOD_MS, pdTRUE, NULL, HostTicker1);
+  xTimerStart(timer, 0);
+
+  MyEvents.SignalEvent("system.start",NULL);
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Command execution
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * HostSplitArgs: split a command line into arguments, honouring double quotes
+ */
+static std::vector<std::string> HostSplitArgs(const std::string& line)
+  {
+  std::vector<std::string> args;
+  std::string arg;
+  bool inarg = false, quoted = false;
+  for (char c : line)
+    {
+    if (c == '"')
+      {
+      quoted = !quoted;
+      inarg = true;
+      }
+    else if (!quoted && (c == ' ' || c == '\t' || c == '\r' || c == '\n'))
+      {
+      if (inarg) args.push_back(arg);
+      arg.clear();
+      inarg = false;
+      }
+    else
+      {
+      arg += c;
+      inarg = true;
+      }
+    }
+  if (inarg) args.push_back(arg);
+  return args;
+  }
+
+static void HostExecute(HostWriter* writer, const std::string& line)
+  {
+  std::vector<std::string> args = HostSplitArgs(line);
+  if (args.empty() || args[0][0] == '#')
+    return;
+  std::vector<const char*> argv;
+  for (auto& arg : args)
+    argv.push_back(arg.c_str());
+  MyCommandApp.Execute(COMMAND_RESULT_VERBOSE, writer, argv.size(), argv.data());
+  fflush(stdout);
+  }
+
+static void HostUsage(const char* name)
+  {
+  fprintf(stderr, "Usage: %s [-d <dir>] [-l <level>] [<command> ...]\n", name);
+  exit(1);
+  }
+
+int main(int argc, char* argv[])
+  {
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  const char* dir = NULL;
+  const char* level = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:l:h")) != -1)
+    {
+    switch (opt)
+      {
+      case 'd': dir = optarg; break;
+      case 'l': level = optarg; break;
+      default:  HostUsage(argv[0]);
+      }
+    }
+
+  if (dir)
+    {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+      {
+      fprintf(stderr, "Error: cannot create directory %s: %s\n", dir, strerror(errno));
+      return 1;
+      }
+    if (chdir(dir) != 0)
+      {
+      fprintf(stderr, "Error: cannot change to directory %s: %s\n", dir, strerror(errno));
+      return 1;
+      }
+    }
+
+  if (level)
+    {
+    static const char* levels[] = { "none", "error", "warn", "info", "debug", "verbose" };
+    int i;
+    for (i = 0; i < 6 && strcmp(level, levels[i]) != 0; i++) {}
+    if (i == 6) HostUsage(argv[0]);
+    esp_log_level_set("*", (esp_log_level_t)i);
+    }
+
+  HostStart();
+
+  HostWriter writer;
+  if (optind < argc)
+    {
+    for (int i = optind; i < argc; i++)
+      HostExecute(&writer, argv[i]);
+    }
+  else
+    {
+    bool tty = isatty(fileno(stdin));
+    char line[1024];
+    while (1)
+      {
+      if (tty)
+        {
+        fputs("OVMS# ", stdout);
+        fflush(stdout);
+        }
+      if (!fgets(line, sizeof(line), stdin))
+        break;
+      HostExecute(&writer, line);
+      }
+    }
+
+  MyConfig.unmount();
+
+  // The framework singletons are not designed for destruction (the device
+  // never exits), so skip the static destructors:
+  fflush(stdout);
+  fflush(stderr);
+  _exit(0);
+  }
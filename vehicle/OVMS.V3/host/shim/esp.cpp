@@ -0,0 +1,368 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: ESP-IDF shim
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * ESP-IDF system API subset: logging, heap, system & chip info, FAT
+ * mounts (mapped to local directories) and the system event loop hook.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+#include <map>
+#include <string>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_sleep.h"
+#include "esp_vfs_fat.h"
+#include "esp_event_loop.h"
+#include "rom/rtc.h"
+#include "rom/crc.h"
+#include "host_shim.h"
+
+////////////////////////////////////////////////////////////////////////
+// Logging
+////////////////////////////////////////////////////////////////////////
+
+static pthread_mutex_t host_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, esp_log_level_t>* host_log_levels = NULL;
+static esp_log_level_t host_log_default = (esp_log_level_t) CONFIG_LOG_DEFAULT_LEVEL;
+
+// Log output goes to stderr, so command output on stdout stays clean:
+static int host_log_stderr(const char* format, va_list args)
+  {
+  return vfprintf(stderr, format, args);
+  }
+
+static vprintf_like_t host_log_vprintf = host_log_stderr;
+
+static pthread_once_t host_log_once = PTHREAD_ONCE_INIT;
+
+/**
+ * host_log_init: the default level can be set by environment variable
+ *  OVMS_LOGLEVEL (0=none … 5=verbose), to also cover static initialisation
+ */
+static void host_log_init()
+  {
+  const char* level = getenv("OVMS_LOGLEVEL");
+  if (level && *level >= '0' && *level <= '5')
+    host_log_default = (esp_log_level_t)(*level - '0');
+  }
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+  {
+  pthread_once(&host_log_once, host_log_init);
+  pthread_mutex_lock(&host_log_mutex);
+  if (strcmp(tag, "*") == 0)
+    {
+    host_log_default = level;
+    if (host_log_levels) host_log_levels->clear();
+    }
+  else
+    {
+    if (!host_log_levels) host_log_levels = new std::map<std::string, esp_log_level_t>;
+    (*host_log_levels)[tag] = level;
+    }
+  pthread_mutex_unlock(&host_log_mutex);
+  }
+
+vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
+  {
+  pthread_mutex_lock(&host_log_mutex);
+  vprintf_like_t orig = host_log_vprintf;
+  host_log_vprintf = func;
+  pthread_mutex_unlock(&host_log_mutex);
+  return orig;
+  }
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+  {
+  pthread_once(&host_log_once, host_log_init);
+  pthread_mutex_lock(&host_log_mutex);
+  esp_log_level_t max = host_log_default;
+  if (host_log_levels)
+    {
+    auto it = host_log_levels->find(tag);
+    if (it != host_log_levels->end()) max = it->second;
+    }
+  vprintf_like_t func = host_log_vprintf;
+  pthread_mutex_unlock(&host_log_mutex);
+  if (level > max) return;
+  va_list args;
+  va_start(args, format);
+  func(format, args);
+  va_end(args);
+  }
+
+uint32_t esp_log_timestamp(void)
+  {
+  return (uint32_t)(host_time_us() / 1000);
+  }
+
+uint32_t esp_log_early_timestamp(void)
+  {
+  return esp_log_timestamp();
+  }
+
+void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level)
+  {
+  esp_log_buffer_hexdump_internal(tag, buffer, buff_len, level);
+  }
+
+void esp_log_buffer_hexdump_internal(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level)
+  {
+  const uint8_t* p = (const uint8_t*) buffer;
+  char line[16*3+1];
+  for (int ofs = 0; ofs < buff_len; ofs += 16)
+    {
+    int n = (buff_len - ofs < 16) ? buff_len - ofs : 16;
+    for (int i = 0; i < n; i++)
+      sprintf(line + i*3, "%02x ", p[ofs+i]);
+    esp_log_write(level, tag, "%s: %p: %s\n", tag, p+ofs, line);
+    }
+  }
+
+const char *esp_err_to_name(esp_err_t code)
+  {
+  switch (code)
+    {
+    case ESP_OK:                  return "ESP_OK";
+    case ESP_FAIL:                return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:          return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:     return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:   return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:    return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:       return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:   return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:         return "ESP_ERR_TIMEOUT";
+    default:                      return "UNKNOWN ERROR";
+    }
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Heap: all capabilities map to the process heap
+////////////////////////////////////////////////////////////////////////
+
+void* heap_caps_malloc(size_t size, uint32_t caps)           { return malloc(size); }
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) { return calloc(n, size); }
+void* heap_caps_realloc(void* ptr, size_t size, int caps)    { return realloc(ptr, size); }
+void heap_caps_free(void* ptr)                               { free(ptr); }
+size_t heap_caps_get_free_size(uint32_t caps)                { return 4*1024*1024; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps)        { return 4*1024*1024; }
+size_t heap_caps_get_largest_free_block(uint32_t caps)       { return 4*1024*1024; }
+bool heap_caps_check_integrity_all(bool print_errors)        { return true; }
+
+void heap_caps_get_info(multi_heap_info_t* info, uint32_t caps)
+  {
+  memset(info, 0, sizeof(*info));
+  info->total_free_bytes = heap_caps_get_free_size(caps);
+  info->largest_free_block = heap_caps_get_largest_free_block(caps);
+  info->minimum_free_bytes = heap_caps_get_minimum_free_size(caps);
+  }
+
+uint32_t esp_get_free_heap_size(void)           { return heap_caps_get_free_size(MALLOC_CAP_DEFAULT); }
+uint32_t esp_get_minimum_free_heap_size(void)   { return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT); }
+
+////////////////////////////////////////////////////////////////////////
+// System
+////////////////////////////////////////////////////////////////////////
+
+void (*host_restart_handler)(void) = NULL;
+
+void esp_restart(void)
+  {
+  if (host_restart_handler) host_restart_handler();
+  fflush(stdout);
+  _exit(0);
+  }
+
+uint32_t esp_random(void)
+  {
+  uint32_t r;
+  if (getrandom(&r, sizeof(r), 0) != sizeof(r))
+    r = (uint32_t) random();
+  return r;
+  }
+
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac)
+  {
+  static const uint8_t host_mac[6] = { 0x02, 0x00, 0x00, 0x4f, 0x56, 0x53 };
+  memcpy(mac, host_mac, 6);
+  return ESP_OK;
+  }
+
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type)
+  {
+  esp_efuse_mac_get_default(mac);
+  mac[5] += (uint8_t) type;
+  return ESP_OK;
+  }
+
+void esp_chip_info(esp_chip_info_t* out_info)
+  {
+  memset(out_info, 0, sizeof(*out_info));
+  out_info->model = CHIP_ESP32;
+  out_info->cores = 2;
+  }
+
+const char* esp_get_idf_version(void)
+  {
+  return "host";
+  }
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle)
+  {
+  return ESP_OK;
+  }
+
+esp_reset_reason_t esp_reset_reason(void)
+  {
+  return ESP_RST_POWERON;
+  }
+
+RESET_REASON rtc_get_reset_reason(int cpu_no)
+  {
+  return POWERON_RESET;
+  }
+
+uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+  {
+  crc = ~crc;
+  while (len--)
+    {
+    crc ^= *buf++;
+    for (int k = 0; k < 8; k++)
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+  return ~crc;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// FAT mounts: the base path is used as a local directory
+////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_vfs_fat_spiflash_mount(const char* base_path, const char* partition_label,
+  const esp_vfs_fat_mount_config_t* mount_config, wl_handle_t* wl_handle)
+  {
+  if (mkdir(base_path, 0755) != 0 && errno != EEXIST)
+    return ESP_FAIL;
+  if (wl_handle) *wl_handle = 0;
+  return ESP_OK;
+  }
+
+esp_err_t esp_vfs_fat_spiflash_unmount(const char* base_path, wl_handle_t wl_handle)
+  {
+  return ESP_OK;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// System event loop
+////////////////////////////////////////////////////////////////////////
+
+static system_event_cb_t host_event_cb = NULL;
+static void* host_event_ctx = NULL;
+
+esp_err_t esp_event_loop_init(system_event_cb_t cb, void *ctx)
+  {
+  host_event_cb = cb;
+  host_event_ctx = ctx;
+  return ESP_OK;
+  }
+
+esp_err_t host_event_dispatch(system_event_t* event)
+  {
+  if (!host_event_cb) return ESP_ERR_INVALID_STATE;
+  return host_event_cb(host_event_ctx, event);
+  }
+
+////////////////////////////////////////////////////////////////////////
+// newlib extensions missing in glibc
+////////////////////////////////////////////////////////////////////////
+
+extern "C" size_t strlcpy(char* dst, const char* src, size_t size)
+  {
+  size_t len = strlen(src);
+  if (size)
+    {
+    size_t n = (len >= size) ? size-1 : len;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+    }
+  return len;
+  }
+
+extern "C" size_t strlcat(char* dst, const char* src, size_t size)
+  {
+  size_t dlen = strnlen(dst, size);
+  if (dlen == size) return size + strlen(src);
+  return dlen + strlcpy(dst+dlen, src, size-dlen);
+  }
+
+static char* host_utoa(unsigned long value, char* str, int base, bool neg)
+  {
+  char buf[sizeof(unsigned long)*8+2];
+  char* p = buf + sizeof(buf);
+  *--p = 0;
+  if (base < 2 || base > 36) { *str = 0; return str; }
+  do
+    {
+    *--p = "0123456789abcdefghijklmnopqrstuvwxyz"[value % base];
+    value /= base;
+    } while (value);
+  if (neg) *--p = '-';
+  strcpy(str, p);
+  return str;
+  }
+
+extern "C" char* itoa(int value, char* str, int base)
+  {
+  if (value < 0 && base == 10)
+    return host_utoa(-(long)value, str, base, true);
+  return host_utoa((unsigned)value, str, base, false);
+  }
+
+extern "C" char* utoa(unsigned value, char* str, int base)
+  {
+  return host_utoa(value, str, base, false);
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Deep sleep: no wakeup on the host
+////////////////////////////////////////////////////////////////////////
+
+void esp_deep_sleep(uint64_t time_in_us)
+  {
+  fprintf(stderr, "esp_deep_sleep(%llu us): exiting\n", (unsigned long long)time_in_us);
+  esp_restart();
+  }
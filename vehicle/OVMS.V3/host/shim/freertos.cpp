@@ -0,0 +1,1029 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: FreeRTOS shim
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * FreeRTOS API subset on top of pthreads.
+ *
+ * Tasks are detached threads, queues & semaphores are mutex/condition
+ * variable based, software timers (FreeRTOS & esp_timer) are run by a
+ * single timer service thread. Priorities, core affinity & stack sizes
+ * are ignored. Blocking calls are cancellation points, so vTaskDelete()
+ * of a blocked task works as on the device.
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <list>
+#include <map>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include "esp_timer.h"
+#include "host_shim.h"
+
+////////////////////////////////////////////////////////////////////////
+// Time base
+////////////////////////////////////////////////////////////////////////
+
+static struct timespec host_start;
+static pthread_once_t host_start_once = PTHREAD_ONCE_INIT;
+
+static void host_start_init()
+  {
+  clock_gettime(CLOCK_MONOTONIC, &host_start);
+  }
+
+int64_t host_time_us()
+  {
+  pthread_once(&host_start_once, host_start_init);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)(now.tv_sec - host_start.tv_sec) * 1000000
+    + (now.tv_nsec - host_start.tv_nsec) / 1000;
+  }
+
+static TickType_t host_ticks()
+  {
+  return (TickType_t)(host_time_us() / (portTICK_PERIOD_MS * 1000));
+  }
+
+/**
+ * host_deadline: absolute CLOCK_MONOTONIC time for a tick timeout
+ */
+static struct timespec host_deadline(TickType_t wait)
+  {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t ns = (uint64_t)wait * portTICK_PERIOD_MS * 1000000ULL;
+  ts.tv_sec += ns / 1000000000ULL;
+  ts.tv_nsec += ns % 1000000000ULL;
+  if (ts.tv_nsec >= 1000000000L)
+    {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+    }
+  return ts;
+  }
+
+static void host_cond_init(pthread_cond_t* cond)
+  {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+  }
+
+/**
+ * host_wait: wait on cond until pred() is true or the timeout expires.
+ *  The mutex is released if the thread is cancelled while waiting.
+ *  Returns the final pred() result.
+ */
+template <typename Pred>
+static bool host_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, TickType_t wait, Pred pred)
+  {
+  if (pred()) return true;
+  if (wait == 0) return false;
+  struct timespec deadline = host_deadline(wait);
+  bool result = false;
+  pthread_cleanup_push((void (*)(void*))pthread_mutex_unlock, mutex);
+  while (!(result = pred()))
+    {
+    int err = (wait == portMAX_DELAY)
+      ? pthread_cond_wait(cond, mutex)
+      : pthread_cond_timedwait(cond, mutex, &deadline);
+    if (err == ETIMEDOUT)
+      {
+      result = pred();
+      break;
+      }
+    }
+  pthread_cleanup_pop(0);
+  return result;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Critical sections & scheduler lock
+////////////////////////////////////////////////////////////////////////
+
+static pthread_mutex_t host_critical;
+static pthread_once_t host_critical_once = PTHREAD_ONCE_INIT;
+
+static void host_critical_init()
+  {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&host_critical, &attr);
+  pthread_mutexattr_destroy(&attr);
+  }
+
+void vPortEnterCritical(portMUX_TYPE* mux)
+  {
+  pthread_once(&host_critical_once, host_critical_init);
+  pthread_mutex_lock(&host_critical);
+  }
+
+void vPortExitCritical(portMUX_TYPE* mux)
+  {
+  pthread_mutex_unlock(&host_critical);
+  }
+
+void vTaskSuspendAll(void)
+  {
+  vPortEnterCritical(NULL);
+  }
+
+BaseType_t xTaskResumeAll(void)
+  {
+  vPortExitCritical(NULL);
+  return pdFALSE;
+  }
+
+void vPortYield(void)
+  {
+  sched_yield();
+  }
+
+BaseType_t xPortGetCoreID(void)
+  {
+  return 0;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Tasks
+////////////////////////////////////////////////////////////////////////
+
+struct host_task
+  {
+  pthread_t thread;
+  char name[CONFIG_FREERTOS_MAX_TASK_NAME_LEN];
+  TaskFunction_t fn;
+  void* param;
+  UBaseType_t priority;
+  UBaseType_t number;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  uint32_t notify_value;
+  bool notify_pending;
+  bool terminated;
+  void* tls[CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS];
+  };
+
+static pthread_mutex_t host_tasks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<pthread_t, host_task*>* host_tasks = NULL;
+static UBaseType_t host_task_number = 0;
+static __thread host_task* host_current = NULL;
+
+static host_task* host_task_new(const char* name, TaskFunction_t fn, void* param, UBaseType_t prio)
+  {
+  host_task* t = new host_task;
+  memset(t->name, 0, sizeof(t->name));
+  strncpy(t->name, name, sizeof(t->name)-1);
+  t->fn = fn;
+  t->param = param;
+  t->priority = prio;
+  pthread_mutex_init(&t->mutex, NULL);
+  host_cond_init(&t->cond);
+  t->notify_value = 0;
+  t->notify_pending = false;
+  t->terminated = false;
+  memset(t->tls, 0, sizeof(t->tls));
+  pthread_mutex_lock(&host_tasks_mutex);
+  t->number = ++host_task_number;
+  pthread_mutex_unlock(&host_tasks_mutex);
+  return t;
+  }
+
+static void host_task_register(host_task* t)
+  {
+  pthread_mutex_lock(&host_tasks_mutex);
+  if (!host_tasks) host_tasks = new std::map<pthread_t, host_task*>;
+  (*host_tasks)[t->thread] = t;
+  pthread_mutex_unlock(&host_tasks_mutex);
+  }
+
+static void host_task_unregister(void* arg)
+  {
+  host_task* t = (host_task*) arg;
+  pthread_mutex_lock(&host_tasks_mutex);
+  if (host_tasks) host_tasks->erase(t->thread);
+  pthread_mutex_unlock(&host_tasks_mutex);
+  pthread_mutex_lock(&t->mutex);
+  t->terminated = true;
+  pthread_cond_broadcast(&t->cond);
+  pthread_mutex_unlock(&t->mutex);
+  // Note: the task struct is not freed, handles may still be in use
+  }
+
+static host_task* host_task_current()
+  {
+  if (host_current == NULL)
+    {
+    // Thread not created by xTaskCreate (i.e. main):
+    host_current = host_task_new("main", NULL, NULL, 1);
+    host_current->thread = pthread_self();
+    host_task_register(host_current);
+    }
+  return host_current;
+  }
+
+static void* host_task_run(void* arg)
+  {
+  host_task* t = (host_task*) arg;
+  host_current = t;
+  pthread_setname_np(pthread_self(), t->name);
+  pthread_cleanup_push(host_task_unregister, t);
+  t->fn(t->param);
+  pthread_cleanup_pop(1);
+  return NULL;
+  }
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* param,
+  UBaseType_t prio, TaskHandle_t* handle, BaseType_t core)
+  {
+  host_task* t = host_task_new(name, fn, param, prio);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  // Host stacks need more room than the device (64 bit, glibc):
+  pthread_attr_setstacksize(&attr, (stack < 16384 ? 16384 : stack) * 4);
+  pthread_mutex_lock(&host_tasks_mutex); // hold registration until thread id is known
+  int err = pthread_create(&t->thread, &attr, host_task_run, t);
+  pthread_mutex_unlock(&host_tasks_mutex);
+  pthread_attr_destroy(&attr);
+  if (err != 0)
+    {
+    delete t;
+    return pdFAIL;
+    }
+  host_task_register(t);
+  if (handle) *handle = (TaskHandle_t) t;
+  return pdPASS;
+  }
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* param,
+  UBaseType_t prio, TaskHandle_t* handle)
+  {
+  return xTaskCreatePinnedToCore(fn, name, stack, param, prio, handle, tskNO_AFFINITY);
+  }
+
+void vTaskDelete(TaskHandle_t handle)
+  {
+  host_task* t = (host_task*) handle;
+  if (t == NULL || t == host_current)
+    {
+    pthread_exit(NULL);
+    }
+  // Wait for the task to terminate, so the caller can free its resources:
+  pthread_cancel(t->thread);
+  pthread_mutex_lock(&t->mutex);
+  while (!t->terminated)
+    pthread_cond_wait(&t->cond, &t->mutex);
+  pthread_mutex_unlock(&t->mutex);
+  }
+
+void vTaskDelay(TickType_t ticks)
+  {
+  if (ticks == 0)
+    {
+    sched_yield();
+    return;
+    }
+  struct timespec ts = host_deadline(ticks);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+  }
+
+void vTaskDelayUntil(TickType_t* prev, TickType_t inc)
+  {
+  *prev += inc;
+  TickType_t now = host_ticks();
+  if ((int32_t)(*prev - now) > 0)
+    vTaskDelay(*prev - now);
+  }
+
+TickType_t xTaskGetTickCount(void)
+  {
+  return host_ticks();
+  }
+
+TickType_t xTaskGetTickCountFromISR(void)
+  {
+  return host_ticks();
+  }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+  {
+  return (TaskHandle_t) host_task_current();
+  }
+
+char* pcTaskGetTaskName(TaskHandle_t handle)
+  {
+  host_task* t = handle ? (host_task*) handle : host_task_current();
+  return t->name;
+  }
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t)
+  {
+  return 0;
+  }
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t handle)
+  {
+  host_task* t = handle ? (host_task*) handle : host_task_current();
+  return t->priority;
+  }
+
+void vTaskPrioritySet(TaskHandle_t handle, UBaseType_t prio)
+  {
+  host_task* t = handle ? (host_task*) handle : host_task_current();
+  t->priority = prio;
+  }
+
+void vTaskSuspend(TaskHandle_t t) {}
+void vTaskResume(TaskHandle_t t) {}
+
+eTaskState eTaskGetState(TaskHandle_t handle)
+  {
+  return (handle == (TaskHandle_t) host_current) ? eRunning : eBlocked;
+  }
+
+BaseType_t xTaskGetAffinity(TaskHandle_t t)
+  {
+  return tskNO_AFFINITY;
+  }
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+  {
+  pthread_mutex_lock(&host_tasks_mutex);
+  UBaseType_t n = host_tasks ? host_tasks->size() : 0;
+  pthread_mutex_unlock(&host_tasks_mutex);
+  return n;
+  }
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size, uint32_t* totalruntime)
+  {
+  UBaseType_t n = 0;
+  pthread_mutex_lock(&host_tasks_mutex);
+  if (host_tasks)
+    {
+    for (auto& it : *host_tasks)
+      {
+      if (n >= size) break;
+      host_task* t = it.second;
+      memset(&status[n], 0, sizeof(TaskStatus_t));
+      status[n].xHandle = (TaskHandle_t) t;
+      status[n].pcTaskName = t->name;
+      status[n].xTaskNumber = t->number;
+      status[n].eCurrentState = eBlocked;
+      status[n].uxCurrentPriority = t->priority;
+      status[n].uxBasePriority = t->priority;
+      status[n].xCoreID = tskNO_AFFINITY;
+      n++;
+      }
+    }
+  pthread_mutex_unlock(&host_tasks_mutex);
+  if (totalruntime) *totalruntime = (uint32_t) host_time_us();
+  return n;
+  }
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t handle, BaseType_t i)
+  {
+  host_task* t = handle ? (host_task*) handle : host_task_current();
+  return (i >= 0 && i < CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS) ? t->tls[i] : NULL;
+  }
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t handle, BaseType_t i, void* v)
+  {
+  host_task* t = handle ? (host_task*) handle : host_task_current();
+  if (i >= 0 && i < CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS) t->tls[i] = v;
+  }
+
+// Task notifications:
+
+BaseType_t xTaskNotify(TaskHandle_t handle, uint32_t value, eNotifyAction action)
+  {
+  host_task* t = (host_task*) handle;
+  BaseType_t result = pdPASS;
+  pthread_mutex_lock(&t->mutex);
+  switch (action)
+    {
+    case eSetBits:                  t->notify_value |= value; break;
+    case eIncrement:                t->notify_value++; break;
+    case eSetValueWithOverwrite:    t->notify_value = value; break;
+    case eSetValueWithoutOverwrite:
+      if (t->notify_pending) result = pdFAIL;
+      else t->notify_value = value;
+      break;
+    default: break;
+    }
+  t->notify_pending = true;
+  pthread_cond_broadcast(&t->cond);
+  pthread_mutex_unlock(&t->mutex);
+  return result;
+  }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+  {
+  return xTaskNotify(handle, 0, eIncrement);
+  }
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t handle, uint32_t value, eNotifyAction action, BaseType_t* woken)
+  {
+  if (woken) *woken = pdFALSE;
+  return xTaskNotify(handle, value, action);
+  }
+
+void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t* woken)
+  {
+  if (woken) *woken = pdFALSE;
+  xTaskNotify(handle, 0, eIncrement);
+  }
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+  {
+  host_task* t = host_task_current();
+  pthread_mutex_lock(&t->mutex);
+  host_wait(&t->cond, &t->mutex, wait, [t]{ return t->notify_value != 0; });
+  uint32_t value = t->notify_value;
+  if (value)
+    t->notify_value = clear ? 0 : value - 1;
+  t->notify_pending = false;
+  pthread_mutex_unlock(&t->mutex);
+  return value;
+  }
+
+BaseType_t xTaskNotifyWait(uint32_t clrentry, uint32_t clrexit, uint32_t* value, TickType_t wait)
+  {
+  host_task* t = host_task_current();
+  pthread_mutex_lock(&t->mutex);
+  if (!t->notify_pending) t->notify_value &= ~clrentry;
+  bool ok = host_wait(&t->cond, &t->mutex, wait, [t]{ return t->notify_pending; });
+  if (value) *value = t->notify_value;
+  if (ok)
+    {
+    t->notify_value &= ~clrexit;
+    t->notify_pending = false;
+    }
+  pthread_mutex_unlock(&t->mutex);
+  return ok ? pdTRUE : pdFALSE;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Queues
+////////////////////////////////////////////////////////////////////////
+
+struct host_queue
+  {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_recv;           // signalled on new items
+  pthread_cond_t cond_send;           // signalled on free space
+  UBaseType_t length;
+  UBaseType_t itemsize;
+  UBaseType_t head;
+  UBaseType_t count;
+  uint8_t* items;
+  };
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemsize)
+  {
+  host_queue* q = new host_queue;
+  pthread_mutex_init(&q->mutex, NULL);
+  host_cond_init(&q->cond_recv);
+  host_cond_init(&q->cond_send);
+  q->length = length;
+  q->itemsize = itemsize;
+  q->head = 0;
+  q->count = 0;
+  q->items = (uint8_t*) malloc(length * (itemsize ? itemsize : 1));
+  return (QueueHandle_t) q;
+  }
+
+void vQueueDelete(QueueHandle_t handle)
+  {
+  // Tasks may still be blocked on the queue (e.g. OvmsVehicle deletes its
+  // RX queue before the RX task), so the queue control block is kept:
+  host_queue* q = (host_queue*) handle;
+  pthread_mutex_lock(&q->mutex);
+  q->length = 1;
+  q->count = 0;
+  q->itemsize = 0;
+  free(q->items);
+  q->items = NULL;
+  pthread_mutex_unlock(&q->mutex);
+  }
+
+static BaseType_t host_queue_send(QueueHandle_t handle, const void* item, TickType_t wait, bool front, bool overwrite)
+  {
+  host_queue* q = (host_queue*) handle;
+  pthread_mutex_lock(&q->mutex);
+  if (!overwrite && !host_wait(&q->cond_send, &q->mutex, wait, [q]{ return q->count < q->length; }))
+    {
+    pthread_mutex_unlock(&q->mutex);
+    return errQUEUE_FULL;
+    }
+  UBaseType_t slot;
+  if (overwrite && q->count == q->length)
+    slot = (q->head + q->count - 1) % q->length;
+  else if (front)
+    {
+    q->head = (q->head + q->length - 1) % q->length;
+    slot = q->head;
+    q->count++;
+    }
+  else
+    {
+    slot = (q->head + q->count) % q->length;
+    q->count++;
+    }
+  if (q->itemsize) memcpy(q->items + slot * q->itemsize, item, q->itemsize);
+  pthread_cond_broadcast(&q->cond_recv);
+  pthread_mutex_unlock(&q->mutex);
+  return pdTRUE;
+  }
+
+static BaseType_t host_queue_receive(QueueHandle_t handle, void* item, TickType_t wait, bool peek)
+  {
+  host_queue* q = (host_queue*) handle;
+  pthread_mutex_lock(&q->mutex);
+  if (!host_wait(&q->cond_recv, &q->mutex, wait, [q]{ return q->count > 0; }))
+    {
+    pthread_mutex_unlock(&q->mutex);
+    return pdFALSE;
+    }
+  if (q->itemsize && item) memcpy(item, q->items + q->head * q->itemsize, q->itemsize);
+  if (!peek)
+    {
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    pthread_cond_broadcast(&q->cond_send);
+    }
+  pthread_mutex_unlock(&q->mutex);
+  return pdTRUE;
+  }
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait)
+  { return host_queue_send(q, item, wait, false, false); }
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t wait)
+  { return host_queue_send(q, item, wait, false, false); }
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void* item, TickType_t wait)
+  { return host_queue_send(q, item, wait, true, false); }
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken)
+  { if (woken) *woken = pdFALSE; return host_queue_send(q, item, 0, false, false); }
+BaseType_t xQueueSendToBackFromISR(QueueHandle_t q, const void* item, BaseType_t* woken)
+  { if (woken) *woken = pdFALSE; return host_queue_send(q, item, 0, false, false); }
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item)
+  { return host_queue_send(q, item, 0, false, true); }
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait)
+  { return host_queue_receive(q, item, wait, false); }
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void* item, BaseType_t* woken)
+  { if (woken) *woken = pdFALSE; return host_queue_receive(q, item, 0, false); }
+BaseType_t xQueuePeek(QueueHandle_t q, void* item, TickType_t wait)
+  { return host_queue_receive(q, item, wait, true); }
+
+BaseType_t xQueueReset(QueueHandle_t handle)
+  {
+  host_queue* q = (host_queue*) handle;
+  pthread_mutex_lock(&q->mutex);
+  q->head = 0;
+  q->count = 0;
+  pthread_cond_broadcast(&q->cond_send);
+  pthread_mutex_unlock(&q->mutex);
+  return pdPASS;
+  }
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle)
+  {
+  host_queue* q = (host_queue*) handle;
+  pthread_mutex_lock(&q->mutex);
+  UBaseType_t n = q->count;
+  pthread_mutex_unlock(&q->mutex);
+  return n;
+  }
+
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t q)
+  {
+  return uxQueueMessagesWaiting(q);
+  }
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t handle)
+  {
+  host_queue* q = (host_queue*) handle;
+  pthread_mutex_lock(&q->mutex);
+  UBaseType_t n = q->length - q->count;
+  pthread_mutex_unlock(&q->mutex);
+  return n;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Semaphores & mutexes
+////////////////////////////////////////////////////////////////////////
+
+struct host_sem
+  {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  UBaseType_t count;
+  UBaseType_t max;
+  bool is_mutex;
+  host_task* holder;
+  UBaseType_t depth;                  // recursive mutex nesting
+  };
+
+static SemaphoreHandle_t host_sem_new(UBaseType_t max, UBaseType_t init, bool is_mutex)
+  {
+  host_sem* s = new host_sem;
+  pthread_mutex_init(&s->mutex, NULL);
+  host_cond_init(&s->cond);
+  s->count = init;
+  s->max = max;
+  s->is_mutex = is_mutex;
+  s->holder = NULL;
+  s->depth = 0;
+  return (SemaphoreHandle_t) s;
+  }
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)                   { return host_sem_new(1, 1, true); }
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)          { return host_sem_new(1, 1, true); }
+SemaphoreHandle_t xSemaphoreCreateBinary(void)                  { return host_sem_new(1, 0, false); }
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init) { return host_sem_new(max, init, false); }
+
+void vSemaphoreDelete(SemaphoreHandle_t handle)
+  {
+  host_sem* s = (host_sem*) handle;
+  pthread_mutex_destroy(&s->mutex);
+  pthread_cond_destroy(&s->cond);
+  delete s;
+  }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t wait)
+  {
+  host_sem* s = (host_sem*) handle;
+  pthread_mutex_lock(&s->mutex);
+  bool ok = host_wait(&s->cond, &s->mutex, wait, [s]{ return s->count > 0; });
+  if (ok)
+    {
+    s->count--;
+    if (s->is_mutex) s->holder = host_task_current();
+    }
+  pthread_mutex_unlock(&s->mutex);
+  return ok ? pdTRUE : pdFALSE;
+  }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+  {
+  host_sem* s = (host_sem*) handle;
+  BaseType_t result = pdFALSE;
+  pthread_mutex_lock(&s->mutex);
+  if (s->count < s->max)
+    {
+    s->count++;
+    s->holder = NULL;
+    pthread_cond_signal(&s->cond);
+    result = pdTRUE;
+    }
+  pthread_mutex_unlock(&s->mutex);
+  return result;
+  }
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t handle, TickType_t wait)
+  {
+  host_sem* s = (host_sem*) handle;
+  host_task* me = host_task_current();
+  pthread_mutex_lock(&s->mutex);
+  if (s->holder == me)
+    {
+    s->depth++;
+    pthread_mutex_unlock(&s->mutex);
+    return pdTRUE;
+    }
+  bool ok = host_wait(&s->cond, &s->mutex, wait, [s]{ return s->count > 0; });
+  if (ok)
+    {
+    s->count--;
+    s->holder = me;
+    s->depth = 1;
+    }
+  pthread_mutex_unlock(&s->mutex);
+  return ok ? pdTRUE : pdFALSE;
+  }
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t handle)
+  {
+  host_sem* s = (host_sem*) handle;
+  BaseType_t result = pdFALSE;
+  pthread_mutex_lock(&s->mutex);
+  if (s->holder == host_current && s->depth > 0)
+    {
+    if (--s->depth == 0)
+      {
+      s->holder = NULL;
+      s->count = 1;
+      pthread_cond_signal(&s->cond);
+      }
+    result = pdTRUE;
+    }
+  pthread_mutex_unlock(&s->mutex);
+  return result;
+  }
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t* woken)
+  {
+  if (woken) *woken = pdFALSE;
+  return xSemaphoreGive(s);
+  }
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t s, BaseType_t* woken)
+  {
+  if (woken) *woken = pdFALSE;
+  return xSemaphoreTake(s, 0);
+  }
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t handle)
+  {
+  host_sem* s = (host_sem*) handle;
+  pthread_mutex_lock(&s->mutex);
+  host_task* holder = s->holder;
+  pthread_mutex_unlock(&s->mutex);
+  return (TaskHandle_t) holder;
+  }
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t handle)
+  {
+  host_sem* s = (host_sem*) handle;
+  pthread_mutex_lock(&s->mutex);
+  UBaseType_t n = s->count;
+  pthread_mutex_unlock(&s->mutex);
+  return n;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// Timer service (FreeRTOS software timers & esp_timer)
+////////////////////////////////////////////////////////////////////////
+
+struct host_timer
+  {
+  const char* name;
+  int64_t period_us;
+  bool autoreload;
+  bool active;
+  int64_t due;
+  void* id;
+  TimerCallbackFunction_t rtos_cb;    // FreeRTOS timer callback
+  esp_timer_cb_t esp_cb;              // esp_timer callback
+  void* esp_arg;
+  };
+
+static pthread_mutex_t host_timers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t host_timers_cond;
+static std::list<host_timer*>* host_timers = NULL;
+static pthread_once_t host_timers_once = PTHREAD_ONCE_INIT;
+
+static void* host_timer_service(void* arg)
+  {
+  host_task* t = host_task_new("Tmr Svc", NULL, NULL, 1);
+  t->thread = pthread_self();
+  host_current = t;
+  host_task_register(t);
+  pthread_setname_np(pthread_self(), t->name);
+
+  pthread_mutex_lock(&host_timers_mutex);
+  while (1)
+    {
+    int64_t now = host_time_us();
+    host_timer* next = NULL;
+    for (host_timer* tm : *host_timers)
+      {
+      if (tm->active && (!next || tm->due < next->due))
+        next = tm;
+      }
+    if (next == NULL)
+      {
+      pthread_cond_wait(&host_timers_cond, &host_timers_mutex);
+      continue;
+      }
+    if (next->due > now)
+      {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      int64_t ns = (next->due - now) * 1000 + ts.tv_nsec;
+      ts.tv_sec += ns / 1000000000LL;
+      ts.tv_nsec = ns % 1000000000LL;
+      pthread_cond_timedwait(&host_timers_cond, &host_timers_mutex, &ts);
+      continue;
+      }
+
+    // Timer due:
+    if (next->autoreload)
+      next->due += next->period_us;
+    else
+      next->active = false;
+    pthread_mutex_unlock(&host_timers_mutex);
+    if (next->rtos_cb)
+      next->rtos_cb((TimerHandle_t) next);
+    else if (next->esp_cb)
+      next->esp_cb(next->esp_arg);
+    pthread_mutex_lock(&host_timers_mutex);
+    }
+  return NULL;
+  }
+
+static void host_timers_init()
+  {
+  host_timers = new std::list<host_timer*>;
+  host_cond_init(&host_timers_cond);
+  pthread_t thread;
+  pthread_create(&thread, NULL, host_timer_service, NULL);
+  pthread_detach(thread);
+  }
+
+static host_timer* host_timer_new()
+  {
+  pthread_once(&host_timers_once, host_timers_init);
+  host_timer* tm = new host_timer;
+  memset(tm, 0, sizeof(*tm));
+  pthread_mutex_lock(&host_timers_mutex);
+  host_timers->push_back(tm);
+  pthread_mutex_unlock(&host_timers_mutex);
+  return tm;
+  }
+
+static void host_timer_start(host_timer* tm, int64_t delay_us)
+  {
+  pthread_mutex_lock(&host_timers_mutex);
+  tm->due = host_time_us() + delay_us;
+  tm->active = true;
+  pthread_cond_signal(&host_timers_cond);
+  pthread_mutex_unlock(&host_timers_mutex);
+  }
+
+static void host_timer_stop(host_timer* tm)
+  {
+  pthread_mutex_lock(&host_timers_mutex);
+  tm->active = false;
+  pthread_mutex_unlock(&host_timers_mutex);
+  }
+
+static void host_timer_delete(host_timer* tm)
+  {
+  pthread_mutex_lock(&host_timers_mutex);
+  host_timers->remove(tm);
+  pthread_mutex_unlock(&host_timers_mutex);
+  delete tm;
+  }
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoreload, void* id, TimerCallbackFunction_t cb)
+  {
+  host_timer* tm = host_timer_new();
+  tm->name = name;
+  tm->period_us = (int64_t)period * portTICK_PERIOD_MS * 1000;
+  tm->autoreload = autoreload;
+  tm->id = id;
+  tm->rtos_cb = cb;
+  return (TimerHandle_t) tm;
+  }
+
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t wait)
+  {
+  host_timer* tm = (host_timer*) t;
+  host_timer_start(tm, tm->period_us);
+  return pdPASS;
+  }
+
+BaseType_t xTimerStartFromISR(TimerHandle_t t, BaseType_t* woken)
+  {
+  if (woken) *woken = pdFALSE;
+  return xTimerStart(t, 0);
+  }
+
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t wait)
+  {
+  return xTimerStart(t, wait);
+  }
+
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t wait)
+  {
+  host_timer_stop((host_timer*) t);
+  return pdPASS;
+  }
+
+BaseType_t xTimerDelete(TimerHandle_t t, TickType_t wait)
+  {
+  host_timer_delete((host_timer*) t);
+  return pdPASS;
+  }
+
+BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t period, TickType_t wait)
+  {
+  host_timer* tm = (host_timer*) t;
+  pthread_mutex_lock(&host_timers_mutex);
+  tm->period_us = (int64_t)period * portTICK_PERIOD_MS * 1000;
+  pthread_mutex_unlock(&host_timers_mutex);
+  host_timer_start(tm, tm->period_us);
+  return pdPASS;
+  }
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t t)
+  {
+  host_timer* tm = (host_timer*) t;
+  pthread_mutex_lock(&host_timers_mutex);
+  bool active = tm->active;
+  pthread_mutex_unlock(&host_timers_mutex);
+  return active ? pdTRUE : pdFALSE;
+  }
+
+void* pvTimerGetTimerID(TimerHandle_t t)
+  {
+  return ((host_timer*) t)->id;
+  }
+
+void vTimerSetTimerID(TimerHandle_t t, void* id)
+  {
+  ((host_timer*) t)->id = id;
+  }
+
+TickType_t xTimerGetPeriod(TimerHandle_t t)
+  {
+  return ((host_timer*) t)->period_us / (portTICK_PERIOD_MS * 1000);
+  }
+
+const char* pcTimerGetTimerName(TimerHandle_t t)
+  {
+  return ((host_timer*) t)->name;
+  }
+
+// esp_timer:
+
+int64_t esp_timer_get_time(void)
+  {
+  return host_time_us();
+  }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle)
+  {
+  host_timer* tm = host_timer_new();
+  tm->name = args->name;
+  tm->esp_cb = args->callback;
+  tm->esp_arg = args->arg;
+  *out_handle = (esp_timer_handle_t) tm;
+  return ESP_OK;
+  }
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+  {
+  host_timer* tm = (host_timer*) timer;
+  tm->autoreload = false;
+  host_timer_start(tm, timeout_us);
+  return ESP_OK;
+  }
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+  {
+  host_timer* tm = (host_timer*) timer;
+  tm->autoreload = true;
+  tm->period_us = period;
+  host_timer_start(tm, period);
+  return ESP_OK;
+  }
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+  {
+  host_timer_stop((host_timer*) timer);
+  return ESP_OK;
+  }
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+  {
+  host_timer_delete((host_timer*) timer);
+  return ESP_OK;
+  }
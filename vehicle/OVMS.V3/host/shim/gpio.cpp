@@ -0,0 +1,101 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: GPIO shim
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * GPIO inputs & edge interrupts: input levels are set by simulated devices
+ * (host_gpio_input), a matching edge runs the ISR in the caller's thread
+ * like an interrupt would preempt the device.
+ */
+
+#include <pthread.h>
+#include "driver/gpio.h"
+
+static pthread_mutex_t host_gpio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int host_gpio_low[GPIO_NUM_MAX];     // inputs idle high (pull-ups)
+static gpio_int_type_t host_gpio_intr[GPIO_NUM_MAX];
+static gpio_isr_t host_gpio_isr[GPIO_NUM_MAX];
+static void* host_gpio_isr_arg[GPIO_NUM_MAX];
+
+#define HOST_GPIO_VALID(n) ((n) >= 0 && (n) < GPIO_NUM_MAX)
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+  {
+  if (!HOST_GPIO_VALID(gpio_num)) return ESP_ERR_INVALID_ARG;
+  pthread_mutex_lock(&host_gpio_mutex);
+  host_gpio_intr[gpio_num] = intr_type;
+  pthread_mutex_unlock(&host_gpio_mutex);
+  return ESP_OK;
+  }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args)
+  {
+  if (!HOST_GPIO_VALID(gpio_num)) return ESP_ERR_INVALID_ARG;
+  pthread_mutex_lock(&host_gpio_mutex);
+  host_gpio_isr[gpio_num] = isr_handler;
+  host_gpio_isr_arg[gpio_num] = args;
+  pthread_mutex_unlock(&host_gpio_mutex);
+  return ESP_OK;
+  }
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+  {
+  if (!HOST_GPIO_VALID(gpio_num)) return ESP_ERR_INVALID_ARG;
+  pthread_mutex_lock(&host_gpio_mutex);
+  host_gpio_isr[gpio_num] = NULL;
+  host_gpio_isr_arg[gpio_num] = NULL;
+  pthread_mutex_unlock(&host_gpio_mutex);
+  return ESP_OK;
+  }
+
+int gpio_get_level(gpio_num_t gpio_num)
+  {
+  if (!HOST_GPIO_VALID(gpio_num)) return 0;
+  return host_gpio_low[gpio_num] ? 0 : 1;
+  }
+
+void host_gpio_input(gpio_num_t gpio_num, int level)
+  {
+  if (!HOST_GPIO_VALID(gpio_num)) return;
+  gpio_isr_t isr = NULL;
+  void* arg = NULL;
+  pthread_mutex_lock(&host_gpio_mutex);
+  int oldlevel = host_gpio_low[gpio_num] ? 0 : 1;
+  host_gpio_low[gpio_num] = level ? 0 : 1;
+  gpio_int_type_t intr = host_gpio_intr[gpio_num];
+  if (level != oldlevel)
+    {
+    if ((level == 0 && (intr == GPIO_INTR_NEGEDGE || intr == GPIO_INTR_ANYEDGE)) ||
+        (level == 1 && (intr == GPIO_INTR_POSEDGE || intr == GPIO_INTR_ANYEDGE)))
+      {
+      isr = host_gpio_isr[gpio_num];
+      arg = host_gpio_isr_arg[gpio_num];
+      }
+    }
+  pthread_mutex_unlock(&host_gpio_mutex);
+  if (isr)
+    isr(arg);
+  }
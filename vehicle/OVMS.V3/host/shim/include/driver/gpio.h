@@ -0,0 +1,28 @@
+#pragma once
+// Host shim: GPIO input levels & edge interrupts, driven by simulated
+// devices via host_gpio_input() (see gpio.cpp)
+#include <stdint.h>
+#include "esp_err.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef int gpio_num_t;
+#define GPIO_NUM_MAX 40
+typedef enum {
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_POSEDGE = 1,
+  GPIO_INTR_NEGEDGE = 2,
+  GPIO_INTR_ANYEDGE = 3,
+  GPIO_INTR_LOW_LEVEL = 4,
+  GPIO_INTR_HIGH_LEVEL = 5,
+  } gpio_int_type_t;
+typedef void (*gpio_isr_t)(void* arg);
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args);
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num);
+int gpio_get_level(gpio_num_t gpio_num);
+/** host_gpio_input: set an input level, runs the ISR on a matching edge (inputs idle high) */
+void host_gpio_input(gpio_num_t gpio_num, int level);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+// Host shim: system events (no wifi/ethernet on the host)
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+typedef enum
+  {
+  SYSTEM_EVENT_WIFI_READY = 0, SYSTEM_EVENT_SCAN_DONE, SYSTEM_EVENT_STA_START, SYSTEM_EVENT_STA_STOP,
+  SYSTEM_EVENT_STA_CONNECTED, SYSTEM_EVENT_STA_DISCONNECTED, SYSTEM_EVENT_STA_AUTHMODE_CHANGE,
+  SYSTEM_EVENT_STA_GOT_IP, SYSTEM_EVENT_STA_LOST_IP, SYSTEM_EVENT_STA_WPS_ER_SUCCESS,
+  SYSTEM_EVENT_STA_WPS_ER_FAILED, SYSTEM_EVENT_STA_WPS_ER_TIMEOUT, SYSTEM_EVENT_STA_WPS_ER_PIN,
+  SYSTEM_EVENT_AP_START, SYSTEM_EVENT_AP_STOP, SYSTEM_EVENT_AP_STACONNECTED, SYSTEM_EVENT_AP_STADISCONNECTED,
+  SYSTEM_EVENT_AP_STAIPASSIGNED, SYSTEM_EVENT_AP_PROBEREQRECVED, SYSTEM_EVENT_GOT_IP6, SYSTEM_EVENT_AP_STA_GOT_IP6 = SYSTEM_EVENT_GOT_IP6,
+  SYSTEM_EVENT_ETH_START, SYSTEM_EVENT_ETH_STOP, SYSTEM_EVENT_ETH_CONNECTED, SYSTEM_EVENT_ETH_DISCONNECTED,
+  SYSTEM_EVENT_ETH_GOT_IP, SYSTEM_EVENT_MAX
+  } system_event_id_t;
+typedef struct { uint8_t raw[64]; } system_event_info_t;
+typedef struct { system_event_id_t event_id; system_event_info_t event_info; } system_event_t;
+typedef esp_err_t (*system_event_cb_t)(void *ctx, system_event_t *event);
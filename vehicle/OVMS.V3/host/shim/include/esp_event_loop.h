@@ -0,0 +1,9 @@
+#pragma once
+#include "esp_event.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t esp_event_loop_init(system_event_cb_t cb, void *ctx);
+#ifdef __cplusplus
+}
+#endif
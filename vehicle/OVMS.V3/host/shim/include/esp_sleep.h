@@ -0,0 +1,10 @@
+#pragma once
+// Host shim: deep sleep terminates the process
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+void esp_deep_sleep(uint64_t time_in_us) __attribute__((noreturn));
+#ifdef __cplusplus
+}
+#endif
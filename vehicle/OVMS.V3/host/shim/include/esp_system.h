@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef enum { ESP_MAC_WIFI_STA, ESP_MAC_WIFI_SOFTAP, ESP_MAC_BT, ESP_MAC_ETH } esp_mac_type_t;
+typedef enum { CHIP_ESP32 = 1 } esp_chip_model_t;
+typedef struct { esp_chip_model_t model; uint32_t features; uint8_t cores; uint8_t revision; } esp_chip_info_t;
+#define CHIP_FEATURE_EMB_FLASH (1<<0)
+#define CHIP_FEATURE_WIFI_BGN (1<<1)
+#define CHIP_FEATURE_BLE (1<<4)
+#define CHIP_FEATURE_BT (1<<5)
+typedef void (*shutdown_handler_t)(void);
+typedef struct { uint32_t dummy; } XtExcFrame;
+void esp_restart(void) __attribute__((noreturn));
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+uint32_t esp_random(void);
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac);
+esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type);
+void esp_chip_info(esp_chip_info_t* out_info);
+const char* esp_get_idf_version(void);
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle);
+#ifdef __cplusplus
+}
+#endif
+typedef enum { ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO } esp_reset_reason_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_reset_reason_t esp_reset_reason(void);
+#ifdef __cplusplus
+}
+#endif
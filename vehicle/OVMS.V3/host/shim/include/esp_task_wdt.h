@@ -0,0 +1,5 @@
+#pragma once
+#include "esp_err.h"
+static inline esp_err_t esp_task_wdt_add(void*) { return 0; }
+static inline esp_err_t esp_task_wdt_reset() { return 0; }
+static inline esp_err_t esp_task_wdt_delete(void*) { return 0; }
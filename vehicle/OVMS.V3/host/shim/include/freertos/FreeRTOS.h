@@ -0,0 +1,61 @@
+#pragma once
+// Host shim: FreeRTOS API on top of pthreads (see freertos.cpp)
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+typedef uint32_t TickType_t;
+typedef TickType_t portTickType;
+typedef int portBASE_TYPE_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void* TimerHandle_t;
+typedef void* QueueSetHandle_t;
+typedef void* QueueSetMemberHandle_t;
+typedef void (*TaskFunction_t)(void*);
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+typedef struct { volatile uint32_t owner; uint32_t count; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0,0}
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 10
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define configTICK_RATE_HZ 100
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define errQUEUE_FULL 0
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define CORE_ID_UNAVAILABLE -1
+#define portBASE_TYPE int
+#define portYIELD_FROM_ISR() do{}while(0)
+#define portENTER_CRITICAL(m) vPortEnterCritical(m)
+#define portEXIT_CRITICAL(m) vPortExitCritical(m)
+#define portENTER_CRITICAL_ISR(m) vPortEnterCritical(m)
+#define portEXIT_CRITICAL_ISR(m) vPortExitCritical(m)
+#define taskENTER_CRITICAL(m) vPortEnterCritical(m)
+#define taskEXIT_CRITICAL(m) vPortExitCritical(m)
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define ESP_INTR_FLAG_IRAM 0
+#define configMAX_PRIORITIES 25
+#define tskIDLE_PRIORITY 0
+#ifdef __cplusplus
+extern "C" {
+#endif
+void vPortYield(void);
+void vPortEnterCritical(portMUX_TYPE* mux);
+void vPortExitCritical(portMUX_TYPE* mux);
+BaseType_t xPortGetCoreID(void);
+#define xPortGetFreeHeapSize() esp_get_free_heap_size()
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef enum { eRunning=0, eReady, eBlocked, eSuspended, eDeleted } eTaskState;
+typedef enum { eNoAction=0, eSetBits, eIncrement, eSetValueWithOverwrite, eSetValueWithoutOverwrite } eNotifyAction;
+typedef struct { TaskHandle_t xHandle; const char* pcTaskName; UBaseType_t xTaskNumber; eTaskState eCurrentState; UBaseType_t uxCurrentPriority; UBaseType_t uxBasePriority; uint32_t ulRunTimeCounter; uint32_t usStackHighWaterMark; BaseType_t xCoreID; } TaskStatus_t;
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* param, UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* param, UBaseType_t prio, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t t);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* prev, TickType_t inc);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char* pcTaskGetTaskName(TaskHandle_t t);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t t);
+void vTaskPrioritySet(TaskHandle_t t, UBaseType_t p);
+void vTaskSuspend(TaskHandle_t t);
+void vTaskResume(TaskHandle_t t);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+eTaskState eTaskGetState(TaskHandle_t t);
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t v, eNotifyAction a);
+BaseType_t xTaskNotifyGive(TaskHandle_t t);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t v, eNotifyAction a, BaseType_t* woken);
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t* woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+BaseType_t xTaskNotifyWait(uint32_t clrentry, uint32_t clrexit, uint32_t* value, TickType_t wait);
+BaseType_t xTaskGetAffinity(TaskHandle_t t);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size, uint32_t* totalruntime);
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t t, BaseType_t i);
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t t, BaseType_t i, void* v);
+#ifdef __cplusplus
+}
+#endif
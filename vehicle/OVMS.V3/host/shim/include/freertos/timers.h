@@ -0,0 +1,20 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoreload, void* id, TimerCallbackFunction_t cb);
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerDelete(TimerHandle_t t, TickType_t wait);
+BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t period, TickType_t wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t t);
+BaseType_t xTimerStartFromISR(TimerHandle_t t, BaseType_t* woken);
+void* pvTimerGetTimerID(TimerHandle_t t);
+void vTimerSetTimerID(TimerHandle_t t, void* id);
+TickType_t xTimerGetPeriod(TimerHandle_t t);
+const char* pcTimerGetTimerName(TimerHandle_t t);
+#ifdef __cplusplus
+}
+#endif
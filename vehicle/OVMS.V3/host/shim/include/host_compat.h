@@ -0,0 +1,22 @@
+/*
+ * Host shim: forced include for all sources, covering the differences
+ * between the ESP-IDF newlib and glibc (implicit includes, non-standard
+ * functions).
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/param.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+size_t strlcpy(char* dst, const char* src, size_t size);
+size_t strlcat(char* dst, const char* src, size_t size);
+char* itoa(int value, char* str, int base);
+char* utoa(unsigned value, char* str, int base);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Host shim: internal interfaces between the shim modules and the
+ * host runner.
+ */
+#pragma once
+#include <stdint.h>
+#include "esp_event.h"
+
+/** host_time_us: monotonic time since process start in microseconds */
+int64_t host_time_us();
+
+/** host_event_dispatch: deliver a system event to the registered event loop callback */
+esp_err_t host_event_dispatch(system_event_t* event);
+
+/** host_restart_handler: called by esp_restart() instead of terminating, if set */
+extern void (*host_restart_handler)(void);
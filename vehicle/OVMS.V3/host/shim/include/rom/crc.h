@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+#ifdef __cplusplus
+}
+#endif
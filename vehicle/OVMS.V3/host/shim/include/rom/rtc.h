@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+typedef enum { NO_MEAN = 0, POWERON_RESET = 1, SW_RESET = 3, DEEPSLEEP_RESET = 5 } RESET_REASON;
+#ifdef __cplusplus
+extern "C" {
+#endif
+RESET_REASON rtc_get_reset_reason(int cpu_no);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Host build configuration: core framework only, no hardware drivers,
+ * networking or scripting.
+ */
+#pragma once
+
+#define CONFIG_OVMS_HOST 1
+
+#define CONFIG_FREERTOS_HZ 100
+#define CONFIG_FREERTOS_MAX_TASK_NAME_LEN 16
+#define CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS 1
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_SPIRAM_SUPPORT 1
+
+#define CONFIG_OVMS 1
+#define CONFIG_OVMS_VERSION_TAG "host"
+#define CONFIG_OVMS_HW_BASE_3_1 1
+#define CONFIG_OVMS_HW_CONSOLE_QUEUE_SIZE 100
+#define CONFIG_OVMS_HW_ASYNC_QUEUE_SIZE 100
+#define CONFIG_OVMS_HW_EVENT_QUEUE_SIZE 40
+#define CONFIG_OVMS_HW_CAN_RX_QUEUE_SIZE 60
+#define CONFIG_OVMS_HW_CAN_TX_QUEUE_SIZE 30
+#define CONFIG_OVMS_SYS_COMMAND_STACK_SIZE 6144
+#define CONFIG_OVMS_SC_JAVASCRIPT_NONE 1
+#define CONFIG_OVMS_VEHICLE_RXTASK_STACK 8192
+#define CONFIG_OVMS_VEHICLE_CAN_RX_QUEUE_SIZE 60
+#define CONFIG_OVMS_LOGFILE_QUEUE_SIZE 100
+#define CONFIG_OVMS_LOGFILE_TASK_PRIORITY 2
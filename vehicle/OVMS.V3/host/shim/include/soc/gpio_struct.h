@@ -0,0 +1,2 @@
+#pragma once
+// Host shim: no peripheral registers on the host
@@ -0,0 +1,43 @@
+#pragma once
+// Host shim: SPI bus with the components/spinodma interface, transactions
+// are delivered to simulated devices attached to the CS pin (see spi.cpp)
+#include <stdint.h>
+#include "pcp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "spi_master_nodma.h"
+
+class spi : public pcp
+  {
+  public:
+    spi(const char* name, int misopin, int mosipin, int clkpin);
+    virtual ~spi();
+
+  public:
+    bool LockBus(TickType_t delay = portMAX_DELAY);
+    void UnlockBus();
+    uint8_t* spi_cmd(spi_nodma_device_handle_t spi, uint8_t* buf, int rxlen, int txlen, ...);
+    esp_err_t spi_deselect(spi_nodma_device_handle_t spi);
+
+  public:
+    spi_nodma_bus_config_t m_buscfg;
+
+  protected:
+    SemaphoreHandle_t m_mtx;
+  };
+
+/**
+ * host_spi_device: simulated SPI device
+ *  Transfer() gets the complete transaction (CS low to high) and replaces
+ *  the transmitted bytes in place by the received ones (full duplex).
+ */
+class host_spi_device
+  {
+  public:
+    virtual ~host_spi_device() {}
+    virtual void Transfer(uint8_t* buf, int len) = 0;
+  };
+
+/** host_spi_attach: attach a simulated device to a CS pin (NULL = detach) */
+void host_spi_attach(int cspin, host_spi_device* device);
@@ -0,0 +1,60 @@
+#pragma once
+// Host shim: components/spinodma SPI master API subset (see spi.cpp)
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+typedef enum { SPI_NODMA_HOST=0, HSPI_NODMA_HOST=1, VSPI_NODMA_HOST=2 } spi_nodma_host_device_t;
+typedef struct {
+  int mosi_io_num;
+  int miso_io_num;
+  int sclk_io_num;
+  int quadwp_io_num;
+  int quadhd_io_num;
+  } spi_nodma_bus_config_t;
+typedef struct spi_nodma_transaction_t spi_nodma_transaction_t;
+typedef void (*nodma_transaction_cb_t)(spi_nodma_transaction_t* trans);
+typedef struct {
+  uint8_t command_bits;
+  uint8_t address_bits;
+  uint8_t dummy_bits;
+  uint8_t mode;
+  uint8_t duty_cycle_pos;
+  uint8_t cs_ena_pretrans;
+  uint8_t cs_ena_posttrans;
+  int clock_speed_hz;
+  int spics_io_num;
+  int spics_ext_io_num;
+  uint32_t flags;
+  int queue_size;
+  nodma_transaction_cb_t pre_cb;
+  nodma_transaction_cb_t post_cb;
+  uint8_t selected;
+  } spi_nodma_device_interface_config_t;
+struct spi_nodma_transaction_t {
+  uint32_t flags;
+  uint16_t command;
+  uint64_t address;
+  size_t length;
+  size_t rxlength;
+  void* user;
+  union { const void* tx_buffer; uint8_t tx_data[4]; };
+  union { void* rx_buffer; uint8_t rx_data[4]; };
+  };
+typedef struct spi_nodma_device_t {
+  spi_nodma_device_interface_config_t cfg;
+  spi_nodma_bus_config_t bus_config;
+  spi_nodma_host_device_t host_dev;
+  } spi_nodma_device_t;
+typedef spi_nodma_device_t* spi_nodma_device_handle_t;
+esp_err_t spi_nodma_bus_add_device(spi_nodma_host_device_t host, spi_nodma_bus_config_t* bus_config, spi_nodma_device_interface_config_t* dev_config, spi_nodma_device_handle_t* handle);
+esp_err_t spi_nodma_bus_remove_device(spi_nodma_device_handle_t handle);
+esp_err_t spi_nodma_device_select(spi_nodma_device_handle_t handle, int force);
+esp_err_t spi_nodma_device_deselect(spi_nodma_device_handle_t handle);
+esp_err_t spi_nodma_device_transmit(spi_nodma_device_handle_t handle, spi_nodma_transaction_t* trans_desc, TickType_t ticks_to_wait);
+#ifdef __cplusplus
+}
+#endif
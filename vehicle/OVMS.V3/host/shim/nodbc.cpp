@@ -0,0 +1,56 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: DBC parser stub
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * Replaces the flex/bison generated DBC tokeniser & parser if the host
+ * lacks these tools. The DBC framework is functional, but loading DBC
+ * files fails.
+ */
+
+#include "ovms_log.h"
+static const char *TAG = "dbc-parser";
+
+#include "dbc_tokeniser.hpp"
+
+void yyrestart(FILE *input_file)
+  {
+  }
+
+int yyparse(void *YYPARSE_PARAM)
+  {
+  ESP_LOGE(TAG, "DBC parser not available in this build (flex/bison missing)");
+  return 1;
+  }
+
+YY_BUFFER_STATE yy_scan_bytes(const char* bytes, int len)
+  {
+  return NULL;
+  }
+
+void yy_delete_buffer(YY_BUFFER_STATE buffer)
+  {
+  }
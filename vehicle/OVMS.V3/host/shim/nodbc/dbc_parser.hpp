@@ -0,0 +1,4 @@
+/*
+ * Host shim: DBC parser interface without bison (see nodbc.cpp)
+ */
+#pragma once
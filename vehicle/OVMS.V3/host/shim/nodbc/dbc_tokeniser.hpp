@@ -0,0 +1,9 @@
+/*
+ * Host shim: DBC tokeniser interface without flex (see nodbc.cpp)
+ */
+#pragma once
+#include <stdio.h>
+#include <stddef.h>
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+YY_BUFFER_STATE yy_scan_bytes(const char* bytes, int len);
+void yy_delete_buffer(YY_BUFFER_STATE buffer);
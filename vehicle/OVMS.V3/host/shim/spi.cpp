@@ -0,0 +1,179 @@
+/*
+;    Project:       Open Vehicle Monitor System
+;    Module:        Host build: SPI shim
+;
+;    (C) 2011       Michael Stegen / Stegen Electronics
+;    (C) 2011-2018  Mark Webb-Johnson
+;    (C) 2011        Sonny Chen @ EPRO/DX
+;
+; Permission is hereby granted, free of charge, to any person obtaining a copy
+; of this software and associated documentation files (the "Software"), to deal
+; in the Software without restriction, including without limitation the rights
+; to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+; copies of the Software, and to permit persons to whom the Software is
+; furnished to do so, subject to the following conditions:
+;
+; The above copyright notice and this permission notice shall be included in
+; all copies or substantial portions of the Software.
+;
+; THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+; IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+; FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+; AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+; LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+; OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+; THE SOFTWARE.
+*/
+
+/**
+ * SPI bus & spinodma master API subset: transactions are passed to the
+ * simulated device attached to the CS pin of the SPI device, devices
+ * without a simulation read all zeros.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <cstdarg>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "spi.h"
+
+static pthread_mutex_t host_spi_mutex = PTHREAD_MUTEX_INITIALIZER;
+static host_spi_device* host_spi_devices[GPIO_NUM_MAX];
+
+void host_spi_attach(int cspin, host_spi_device* device)
+  {
+  if (cspin < 0 || cspin >= GPIO_NUM_MAX) return;
+  pthread_mutex_lock(&host_spi_mutex);
+  host_spi_devices[cspin] = device;
+  pthread_mutex_unlock(&host_spi_mutex);
+  }
+
+static int host_spi_cspin(spi_nodma_device_handle_t handle)
+  {
+  return (handle->cfg.spics_io_num >= 0) ? handle->cfg.spics_io_num : handle->cfg.spics_ext_io_num;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// spinodma master API
+////////////////////////////////////////////////////////////////////////
+
+esp_err_t spi_nodma_bus_add_device(spi_nodma_host_device_t host, spi_nodma_bus_config_t* bus_config,
+  spi_nodma_device_interface_config_t* dev_config, spi_nodma_device_handle_t* handle)
+  {
+  spi_nodma_device_t* dev = new spi_nodma_device_t;
+  dev->cfg = *dev_config;
+  dev->bus_config = *bus_config;
+  dev->host_dev = host;
+  *handle = dev;
+  return ESP_OK;
+  }
+
+esp_err_t spi_nodma_bus_remove_device(spi_nodma_device_handle_t handle)
+  {
+  delete handle;
+  return ESP_OK;
+  }
+
+esp_err_t spi_nodma_device_select(spi_nodma_device_handle_t handle, int force)
+  {
+  handle->cfg.selected = 1;
+  return ESP_OK;
+  }
+
+esp_err_t spi_nodma_device_deselect(spi_nodma_device_handle_t handle)
+  {
+  handle->cfg.selected = 0;
+  return ESP_OK;
+  }
+
+esp_err_t spi_nodma_device_transmit(spi_nodma_device_handle_t handle, spi_nodma_transaction_t* trans_desc, TickType_t ticks_to_wait)
+  {
+  int len = trans_desc->length / 8;
+  uint8_t* buf = (uint8_t*)trans_desc->rx_buffer;
+  if (buf != trans_desc->tx_buffer)
+    memcpy(buf, trans_desc->tx_buffer, len);
+
+  int cspin = host_spi_cspin(handle);
+  pthread_mutex_lock(&host_spi_mutex);
+  host_spi_device* device = (cspin >= 0 && cspin < GPIO_NUM_MAX) ? host_spi_devices[cspin] : NULL;
+  pthread_mutex_unlock(&host_spi_mutex);
+
+  if (device)
+    device->Transfer(buf, len);
+  else
+    memset(buf, 0, len);
+  return ESP_OK;
+  }
+
+////////////////////////////////////////////////////////////////////////
+// spi bus (same as components/spinodma/spi.cpp)
+////////////////////////////////////////////////////////////////////////
+
+spi::spi(const char* name, int misopin, int mosipin, int clkpin)
+  : pcp(name)
+  {
+  m_mtx = xSemaphoreCreateMutex();
+  memset(&m_buscfg, 0, sizeof(spi_nodma_bus_config_t));
+  m_buscfg.miso_io_num=misopin;
+  m_buscfg.mosi_io_num=mosipin;
+  m_buscfg.sclk_io_num=clkpin;
+  m_buscfg.quadwp_io_num=-1;
+  m_buscfg.quadhd_io_num=-1;
+  }
+
+spi::~spi()
+  {
+  }
+
+bool spi::LockBus(TickType_t delay)
+  {
+  return (xSemaphoreTake(m_mtx, delay) == pdTRUE);
+  }
+
+void spi::UnlockBus()
+  {
+  xSemaphoreGive(m_mtx);
+  }
+
+uint8_t* spi::spi_cmd(spi_nodma_device_handle_t spi, uint8_t* buf, int rxlen, int txlen, ...)
+  {
+  va_list args;
+
+  memset(buf,0,rxlen+txlen);
+
+  va_start(args, txlen);
+  for (int k=0; k<txlen; k++)
+    {
+    buf[k] = va_arg(args,int);
+    }
+  va_end(args);
+
+  spi_nodma_transaction_t t;
+  memset(&t, 0, sizeof(t));
+  t.length=(txlen+rxlen)*8;
+  t.rxlength=(txlen+rxlen)*8;
+  t.tx_buffer=buf;
+  t.rx_buffer=buf;
+  if (LockBus(portMAX_DELAY))
+    {
+    if (spi->cfg.spics_io_num == -1)
+      spi_nodma_device_select(spi,0);
+    spi_nodma_device_transmit(spi, &t, portMAX_DELAY);
+    if (spi->cfg.spics_io_num == -1)
+      spi_nodma_device_deselect(spi);
+    UnlockBus();
+    }
+  return buf + txlen;
+  }
+
+esp_err_t spi::spi_deselect(spi_nodma_device_handle_t spi)
+  {
+  esp_err_t ret = ESP_OK;
+  if (LockBus(portMAX_DELAY))
+    {
+    ret = spi_nodma_device_deselect(spi);
+    UnlockBus();
+    }
+  return ret;
+  }
@@ -57,6 +57,16 @@ static void* ExternalRamAllocated::operator new[](std::size_t sz)
   return ExternalRamMalloc(sz);
   }
 
+static void ExternalRamAllocated::operator delete(void* p)
+  {
+  free(p);
+  }
+
+static void ExternalRamAllocated::operator delete[](void* p)
+  {
+  free(p);
+  }
+
 char* ExternalRamAllocated::strdup(const char* src)
   {
   if (!src)
@@ -119,6 +129,16 @@ static void* InternalRamAllocated::operator new[](std::size_t sz)
   return InternalRamMalloc(sz);
   }
 
+static void InternalRamAllocated::operator delete(void* p)
+  {
+  free(p);
+  }
+
+static void InternalRamAllocated::operator delete[](void* p)
+  {
+  free(p);
+  }
+
 char* InternalRamAllocated::strdup(const char* src)
   {
   if (!src)
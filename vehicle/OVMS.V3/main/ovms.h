@@ -54,6 +54,8 @@ class ExternalRamAllocated
   public:
     static void* operator new(std::size_t sz);
     static void* operator new[](std::size_t sz);
+    static void operator delete(void* p);
+    static void operator delete[](void* p);
     static char* strdup(const char* src);
     static int asprintf(char** strp, const char* fmt, ...);
     static int vasprintf(char** strp, const char* fmt, va_list ap);
@@ -64,6 +66,8 @@ class InternalRamAllocated
   public:
     static void* operator new(std::size_t sz);
     static void* operator new[](std::size_t sz);
+    static void operator delete(void* p);
+    static void operator delete[](void* p);
     static char* strdup(const char* src);
     static int asprintf(char** strp, const char* fmt, ...);
     static int vasprintf(char** strp, const char* fmt, va_list ap);
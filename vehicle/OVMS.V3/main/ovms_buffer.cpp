@@ -43,6 +43,7 @@ OvmsBuffer::OvmsBuffer(size_t size, void* userdata)
   m_tail = 0;
   m_size = size;
   m_used = 0;
+  m_scanned = 0;
   m_userdata = userdata;
   }
 
@@ -71,6 +72,7 @@ void OvmsBuffer::EmptyAll()
   m_head = 0;
   m_tail = 0;
   m_used = 0;
+  m_scanned = 0;
   }
 
 bool OvmsBuffer::Push(uint8_t byte)
@@ -88,13 +90,15 @@ bool OvmsBuffer::Push(uint8_t *byte, size_t count)
   {
   if ((m_size-m_used)<count) return false;
 
+  // copy in up to two chunks: head to buffer end, then wrapped to start
+  size_t chunk = m_size - m_head;
+  if (chunk > count) chunk = count;
+  memcpy(m_buffer + m_head, byte, chunk);
+  if (count > chunk)
+    memcpy(m_buffer, byte + chunk, count - chunk);
+  m_head += count;
+  if (m_head >= m_size) m_head -= m_size;
   m_used += count;
-  for (size_t k=0;k<count;k++)
-    {
-    // ESP_LOGI(TAG, "Push() %02x at %d",byte[k],m_head);
-    m_buffer[m_head++] = byte[k];
-    if (m_head >= m_size) m_head=0;
-    }
 
   return true;
   }
@@ -104,6 +108,7 @@ uint8_t OvmsBuffer::Pop()
   if (m_used==0) return 0;
 
   m_used--;
+  if (m_scanned) m_scanned--;
   uint8_t result = m_buffer[m_tail++];
   if (m_tail >= m_size) m_tail=0;
 
@@ -112,16 +117,29 @@ uint8_t OvmsBuffer::Pop()
 
 size_t OvmsBuffer::Pop(size_t count, uint8_t *dest)
   {
-  size_t done = 0;
+  size_t done = Peek(count, dest);
+  Skip(done);
+  return done;
+  }
+
+/**
+ * Skip: drop up to count bytes from the tail without copying
+ */
+size_t OvmsBuffer::Skip(size_t count)
+  {
+  if (count > m_used) count = m_used;
 
-  while ((m_used>0)&&(done < count))
+  m_tail += count;
+  if (m_tail >= m_size) m_tail -= m_size;
+  m_used -= count;
+  m_scanned = (m_scanned > count) ? m_scanned - count : 0;
+  if (m_used == 0)
     {
-    m_used--;
-    dest[done++] = m_buffer[m_tail++];
-    if (m_tail >= m_size) m_tail=0;
+    // restart at buffer start to maximize contiguous space:
+    m_head = m_tail = 0;
     }
 
-  return done;
+  return count;
   }
 
 uint8_t OvmsBuffer::Peek()
@@ -133,60 +151,133 @@ uint8_t OvmsBuffer::Peek()
 
 size_t OvmsBuffer::Peek(size_t count, uint8_t *dest)
   {
-  size_t done = 0;
-
-  size_t tail = m_tail;
-  while ((done<m_used)&&(done<count))
-    {
-    dest[done++] = m_buffer[tail++];
-    if (tail >= m_size) tail=0;
-    }
+  span_t span[2];
+  size_t done = PeekSpans(count, span);
+  memcpy(dest, span[0].data, span[0].length);
+  if (span[1].length)
+    memcpy(dest + span[0].length, span[1].data, span[1].length);
 
   return done;
   }
 
+/**
+ * PeekSpans: get a view of up to count bytes from the tail
+ *  Returns the total length, span[1].length is 0 unless the view wraps.
+ */
+size_t OvmsBuffer::PeekSpans(size_t count, span_t span[2])
+  {
+  if (count > m_used) count = m_used;
+
+  size_t chunk = m_size - m_tail;
+  if (chunk > count) chunk = count;
+  span[0].data = m_buffer + m_tail;
+  span[0].length = chunk;
+  span[1].data = m_buffer;
+  span[1].length = count - chunk;
+
+  return count;
+  }
+
 void OvmsBuffer::Diagnostics()
   {
   size_t hl = HasLine();
   ESP_LOGI(TAG, "OvmsBuffer has %d/%d bytes (head %d, tail %d), hasline %d",
-    m_used,m_size,m_head,m_tail,hl);
+    (int)m_used,(int)m_size,(int)m_head,(int)m_tail,(int)hl);
   }
 
-int OvmsBuffer::HasLine()
+/**
+ * ScanEOL: find first CR or LF in a contiguous range, return NULL if none
+ */
+static inline const uint8_t* ScanEOL(const uint8_t* data, size_t length)
   {
-  size_t tail = m_tail;
+  const uint8_t* lf = (const uint8_t*) memchr(data, '\n', length);
+  const uint8_t* cr = (const uint8_t*) memchr(data, '\r', lf ? lf - data : length);
+  return cr ? cr : lf;
+  }
 
+/**
+ * HasLine: get length of the first line, -1 if no line terminator present
+ *  The scan continues where the previous call stopped, so repeated calls
+ *  while data trickles in only scan the new data.
+ */
+int OvmsBuffer::HasLine()
+  {
   if (m_used==0) return -1;
+  if (m_scanned >= m_used) return -1;
 
-  // ESP_LOGI(TAG, "HasLine() with tail at %d (%d used)",m_tail,m_used);
-  for (size_t done=0;done<m_used;done++)
+  // scan the unscanned part in up to two contiguous chunks:
+  size_t start = m_tail + m_scanned;
+  if (start >= m_size) start -= m_size;
+  size_t remain = m_used - m_scanned;
+  while (remain > 0)
     {
-    // ESP_LOGI(TAG, "HasLine() at tail %d is %02x (%d done)",tail,m_buffer[tail],done);
-    if ((m_buffer[tail]=='\r')||(m_buffer[tail]=='\n'))
+    size_t chunk = m_size - start;
+    if (chunk > remain) chunk = remain;
+    const uint8_t* eol = ScanEOL(m_buffer + start, chunk);
+    if (eol)
       {
-      // ESP_LOGI(TAG, "HasLine() found a CR/LF at tail %d (done=%d)",tail,done);
-      return done;
+      m_scanned += eol - (m_buffer + start);
+      return m_scanned;
       }
-    tail++;
-    if (tail >= m_size) tail=0;
+    m_scanned += chunk;
+    remain -= chunk;
+    start = 0;
     }
 
-  // ESP_LOGI(TAG, "HasLine() didnt find a CR/LF");
   return -1;
   }
 
-std::string OvmsBuffer::ReadLine()
+/**
+ * PeekLine: get a view of the first line (excluding the terminator)
+ *  Returns the line length or -1 if no complete line is available.
+ *  Use SkipLine(length) to consume the line after processing.
+ */
+int OvmsBuffer::PeekLine(span_t span[2])
   {
   int hl = HasLine();
-  if (hl<0) return std::string("");
-
-  uint8_t result[hl+1];
-  Pop(hl, result);
+  if (hl<0) return -1;
+  PeekSpans(hl, span);
+  return hl;
+  }
 
+/**
+ * SkipLine: consume a line of the length returned by HasLine/PeekLine
+ *  including its terminator (CR, LF or CR LF)
+ */
+void OvmsBuffer::SkipLine(int length)
+  {
+  if (length > 0) Skip(length);
   if (Peek() == '\r') Pop();
   if (Peek() == '\n') Pop();
+  }
 
-  return std::string((char*)result,hl);
+std::string OvmsBuffer::ReadLine()
+  {
+  std::string line;
+  ReadLine(line);
+  return line;
+  }
+
+/**
+ * ReadLine: read & consume the first line into a (reused) string
+ *  Returns false if no complete line is available.
+ */
+bool OvmsBuffer::ReadLine(std::string& line)
+  {
+  span_t span[2];
+  int hl = PeekLine(span);
+  if (hl<0)
+    {
+    line.clear();
+    return false;
+    }
+
+  line.assign((const char*)span[0].data, span[0].length);
+  if (span[1].length)
+    line.append((const char*)span[1].data, span[1].length);
+  SkipLine(hl);
+
+  return true;
   }
 
 int OvmsBuffer::PollSocket(int sock, long timeoutms)
@@ -210,20 +301,32 @@ int OvmsBuffer::PollSocket(int sock, long timeoutms)
   // We have some data ready to read
   size_t avail = FreeSpace();
   if (avail==0) return 0;
-  // ESP_LOGI(TAG,"Polling Socket allocating %d bytes",avail);
-  uint8_t *buf = new uint8_t[avail];
-  size_t n = read(sock, buf, avail);
+
+  // read directly into the free space at the head, if that is split by
+  // the buffer end, try to continue at the buffer start without blocking:
+  size_t chunk = m_size - m_head;
+  if (chunk > avail) chunk = avail;
+  int n = read(sock, m_buffer + m_head, chunk);
   // ESP_LOGI(TAG,"Polling Socket read %d bytes",n);
-  // MyCommandApp.HexDump(TAG, "PollSocket", (const char*)buf, n);
   if (n == 0)
     {
     n = -1;
     }
   else if (n > 0)
     {
-    Push(buf,n);
+    m_head += n;
+    if (m_head >= m_size) m_head = 0;
+    m_used += n;
+    if (n == chunk && avail > chunk)
+      {
+      int n2 = recv(sock, m_buffer, avail - chunk, MSG_DONTWAIT);
+      if (n2 > 0)
+        {
+        m_head = n2;
+        m_used += n2;
+        n += n2;
+        }
+      }
     }
-  delete [] buf;
   return n;
   }
-
@@ -40,6 +40,18 @@ class OvmsBuffer
     OvmsBuffer(size_t size, void* userdata = 0);
     virtual ~OvmsBuffer();
 
+  public:
+    /**
+     * span_t: contiguous section of the ring buffer
+     *  Ring contents may wrap around the buffer end, so a view consists
+     *  of up to two spans. Views are valid until the next Pop/Skip/Push.
+     */
+    typedef struct
+      {
+      const uint8_t* data;
+      size_t length;
+      } span_t;
+
   public:
     size_t Size();
     size_t FreeSpace();
@@ -51,13 +63,18 @@ class OvmsBuffer
     bool Push(uint8_t *byte, size_t count);
     uint8_t Pop();
     size_t Pop(size_t count, uint8_t *dest);
+    size_t Skip(size_t count);
     uint8_t Peek();
     size_t Peek(size_t count, uint8_t *dest);
+    size_t PeekSpans(size_t count, span_t span[2]);
     void Diagnostics();
 
   public:
     int HasLine();
     std::string ReadLine();
+    bool ReadLine(std::string& line);
+    int PeekLine(span_t span[2]);
+    void SkipLine(int length);
 
   public:
     int PollSocket(int sock, long timeoutms);
@@ -71,6 +88,7 @@ class OvmsBuffer
     int m_tail;
     size_t m_size;
     size_t m_used;
+    size_t m_scanned;                         // HasLine: bytes from tail known to contain no CR/LF
   };
 
 #endif //#ifndef __OVMS_BUFFER_H__
@@ -38,7 +38,9 @@ static const char *TAG = "command";
 #include <functional>
 #include <esp_log.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <dirent.h>
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "ovms_command.h"
 #include "ovms_config.h"
@@ -277,7 +279,7 @@ void OvmsCommand::PutUsage(OvmsWriter* writer)
     if (parent->m_validate)
       {
       size_t len = strlen(parent->m_usage_template);
-      char* dollar = index(parent->m_usage_template, '$');
+      const char* dollar = index(parent->m_usage_template, '$');
       if (dollar)
         {
         len = dollar - parent->m_usage_template;
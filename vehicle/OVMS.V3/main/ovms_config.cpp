@@ -38,6 +38,7 @@ static const char *TAG = "config";
 #include <sstream>
 #include <dirent.h>
 #include "crypt_base64.h"
+#include "ovms.h"
 #include "ovms_config.h"
 #include "ovms_command.h"
 #include "ovms_events.h"
@@ -48,8 +49,9 @@ static const char *TAG = "config";
 #include "zip_archive.h"
 #endif // CONFIG_OVMS_SC_ZIP
 
-#define OVMS_CONFIGPATH "/store/ovms_config"
 #define OVMS_MAXVALSIZE 2500
+#define OVMS_CONFIG_WRITEDELAY 500    // write-behind delay [ms]
+#define OVMS_CONFIG_TXTIMEOUT 10      // max transaction duration before changes get written [s]
 //#define OVMS_PERSIST_METADATA
 
 
@@ -74,6 +76,7 @@ int config_validate(OvmsWriter* writer, OvmsCommand* cmd, int argc, const char*
   if (argc == 1)
     return MyConfig.m_map.Validate(writer, argc, argv[0], complete);
   OvmsConfigParam* p = MyConfig.m_map.FindUniquePrefix(argv[0]);
+  p->Load();
   return p->m_map.Validate(writer, argc, argv[1], complete);
   }
 
@@ -162,6 +165,17 @@ void config_rm(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
   writer->printf("Parameter %s has been removed.\n", argv[0]);
   }
 
+void config_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  MyConfig.Status(verbosity, writer);
+  }
+
+void config_flush(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  MyConfig.Flush();
+  writer->puts("Pending config changes written");
+  }
+
 #ifdef CONFIG_OVMS_SC_ZIP
 void config_backup(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
@@ -219,6 +233,15 @@ OvmsConfig::OvmsConfig()
   ESP_LOGI(TAG, "Initialising CONFIG (1400)");
 
   m_mounted = false;
+  m_transaction = 0;
+  m_transaction_time = 0;
+  m_flush_scheduled = false;
+  m_flush_time = 0;
+  m_frozen = false;
+  m_generation = 1;
+  m_stat_changes = 0;
+  m_stat_writes = 0;
+  m_stat_errors = 0;
 
   OvmsCommand* cmd_store = MyCommandApp.RegisterCommand("store","STORE framework");
   cmd_store->RegisterCommand("mount","Mount STORE",store_mount);
@@ -228,6 +251,8 @@ OvmsConfig::OvmsConfig()
   cmd_config->RegisterCommand("list","Show configuration parameters/instances",config_list,"[<param>]",0,1, true, config_validate);
   cmd_config->RegisterCommand("set","Set parameter:instance=value",config_set,"<param> <instance> <value>",3,3, true, config_validate);
   cmd_config->RegisterCommand("rm","Remove parameter:instance",config_rm,"<param> {<instance> | *}",2,2, true, config_validate);
+  cmd_config->RegisterCommand("status","Show config store write statistics",config_status);
+  cmd_config->RegisterCommand("flush","Write pending config changes",config_flush);
 
 #ifdef CONFIG_OVMS_SC_ZIP
   cmd_config->RegisterCommand("backup", "Backup to file", config_backup,
@@ -248,6 +273,13 @@ OvmsConfig::OvmsConfig()
   RegisterParam("password", "Password store", true, false);
   RegisterParam("module", "Module configuration", true, true);
   RegisterParam("usr", "Custom plugin configuration", true, true);
+
+  #undef bind  // Kludgy, but works
+  using std::placeholders::_1;
+  using std::placeholders::_2;
+  MyEvents.RegisterEvent(TAG, "config.flush", std::bind(&OvmsConfig::EventListener, this, _1, _2));
+  MyEvents.RegisterEvent(TAG, "ticker.10", std::bind(&OvmsConfig::EventListener, this, _1, _2));
+  MyEvents.RegisterEvent(TAG, "system.shuttingdown", std::bind(&OvmsConfig::EventListener, this, _1, _2));
   }
 
 OvmsConfig::~OvmsConfig()
@@ -268,14 +300,13 @@ esp_err_t OvmsConfig::mount()
   memset(&m_store_fat,0,sizeof(esp_vfs_fat_sdmmc_mount_config_t));
   m_store_fat.format_if_mount_failed = true;
   m_store_fat.max_files = 5;
-  esp_vfs_fat_spiflash_mount("/store", "store", &m_store_fat, &m_store_wlh);
-  m_mounted = true;
+  esp_vfs_fat_spiflash_mount(OVMS_STOREPATH, "store", &m_store_fat, &m_store_wlh);
 
   struct stat ds;
   if (stat(OVMS_CONFIGPATH, &ds) != 0)
     {
     ESP_LOGI(TAG, "Initialising OVMS CONFIG within STORE");
-    mkdir(OVMS_CONFIGPATH,0);
+    mkdir(OVMS_CONFIGPATH,0755);
     }
 
   DIR *dir;
@@ -283,21 +314,27 @@ esp_err_t OvmsConfig::mount()
   if ((dir = opendir(OVMS_CONFIGPATH)) == NULL)
     {
     ESP_LOGE(TAG, "Error: Cannot open config store directory");
+    m_mounted = true;
     return ESP_ERR_NOT_FOUND;
     }
   while ((dp = readdir(dir)) != NULL)
     {
+    // Temporary files of an interrupted write are recovered by LoadConfig():
+    std::string name = dp->d_name;
+    if (name.empty() || name[0] == '.')
+      continue;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0)
+      name.resize(name.size() - 4);
     // Register the param in case this was not already done
-    if (CachedParam(dp->d_name) == NULL)
-      RegisterParam(dp->d_name, "", true, false);
+    //  (lookup only, params are loaded on demand by CachedParam):
+    if (m_map.find(name) == m_map.end())
+      RegisterParam(name, "", true, false);
     }
   closedir(dir);
+  m_mounted = true;
 
-  // load & upgrade params:
-  for (ConfigMap::iterator it=MyConfig.m_map.begin(); it!=MyConfig.m_map.end(); ++it)
-    {
-    it->second->Load();
-    }
+  // upgrade:
+  m_generation++;
   upgrade();
 
   MyEvents.SignalEvent("config.mounted", NULL);
@@ -311,7 +348,8 @@ esp_err_t OvmsConfig::unmount()
 
   if (m_mounted)
     {
-    esp_vfs_fat_spiflash_unmount("/store", m_store_wlh);
+    Flush();
+    esp_vfs_fat_spiflash_unmount(OVMS_STOREPATH, m_store_wlh);
     m_mounted = false;
     MyEvents.SignalEvent("config.unmounted", NULL);
     }
@@ -324,6 +362,125 @@ bool OvmsConfig::ismounted()
   return m_mounted;
   }
 
+/**
+ * BeginTransaction / CommitTransaction: group param changes
+ *  Changes done within a transaction are written and signaled on the
+ *  final commit. Transactions may be nested and overlap across tasks,
+ *  the write is done when the last one commits. A transaction open for
+ *  more than OVMS_CONFIG_TXTIMEOUT seconds (i.e. a missing commit) no
+ *  longer holds back the write-behind.
+ */
+void OvmsConfig::BeginTransaction()
+  {
+  if (m_transaction.fetch_add(1) == 0)
+    m_transaction_time = monotonictime;
+  }
+
+void OvmsConfig::CommitTransaction()
+  {
+  int depth = m_transaction.load();
+  while (depth > 0 && !m_transaction.compare_exchange_weak(depth, depth-1)) {}
+  if (depth == 1)
+    Flush();
+  }
+
+bool OvmsConfig::TransactionExpired()
+  {
+  return (m_transaction > 0 && monotonictime - m_transaction_time >= OVMS_CONFIG_TXTIMEOUT);
+  }
+
+/**
+ * ScheduleFlush: start the write-behind window for changed params
+ *  Within a transaction, the flush is only marked pending for the commit
+ *  or the ticker fallback.
+ */
+void OvmsConfig::ScheduleFlush()
+  {
+  if (m_flush_scheduled || m_frozen)
+    return;
+  m_flush_scheduled = true;
+  m_flush_time = monotonictime;
+  if (m_transaction == 0)
+    MyEvents.SignalEvent("config.flush", NULL, (event_signal_done_fn)NULL, OVMS_CONFIG_WRITEDELAY);
+  }
+
+/**
+ * Flush: write all changed params & signal config.changed for each
+ */
+void OvmsConfig::Flush()
+  {
+  m_flush_scheduled = false;
+  if (m_frozen)
+    return;
+  for (ConfigMap::iterator it=m_map.begin(); it!=m_map.end(); ++it)
+    it->second->Flush();
+  }
+
+void OvmsConfig::EventListener(std::string event, void* data)
+  {
+  if (event == "config.flush")
+    {
+    // a transaction started within the window will flush on commit (or expire):
+    if (m_transaction == 0 || TransactionExpired())
+      Flush();
+    }
+  else if (event == "ticker.10")
+    {
+    // fallback in case the delayed signal got lost or a commit is missing:
+    if (m_flush_scheduled && monotonictime - m_flush_time >= 2)
+      {
+      if (m_transaction == 0)
+        Flush();
+      else if (TransactionExpired())
+        {
+        ESP_LOGW(TAG, "Transaction open for %us, writing pending changes",
+          monotonictime - m_transaction_time);
+        Flush();
+        }
+      }
+    }
+  else if (event == "system.shuttingdown")
+    {
+    Flush();
+    }
+  }
+
+void OvmsConfig::Status(int verbosity, OvmsWriter* writer)
+  {
+  int pending = 0;
+  for (ConfigMap::iterator it=m_map.begin(); it!=m_map.end(); ++it)
+    {
+    if (it->second->IsDirty()) pending++;
+    }
+  writer->printf("Param changes: %u\n", m_stat_changes);
+  writer->printf("File writes  : %u (%u saved by coalescing)\n", m_stat_writes,
+    (m_stat_changes > m_stat_writes + m_stat_errors) ? m_stat_changes - m_stat_writes - m_stat_errors : 0);
+  writer->printf("Write errors : %u\n", m_stat_errors);
+  writer->printf("Pending      : %d param(s)%s%s\n", pending,
+    (m_transaction > 0) ? ", transaction open" : "",
+    m_frozen ? ", store frozen by restore" : "");
+
+  if (verbosity <= COMMAND_RESULT_SMS)
+    return;
+
+  // Memory report:
+  int loaded = 0;
+  size_t instances = 0, memory = 0;
+  writer->printf("\n%-20s %6s %9s %7s\n", "Param", "Loaded", "Instances", "~Bytes");
+  for (ConfigMap::iterator it=m_map.begin(); it!=m_map.end(); ++it)
+    {
+    OvmsConfigParam* p = it->second;
+    size_t size = p->GetMemoryUsage();
+    writer->printf("%-20s %6s %9u %7u\n", it->first.c_str(),
+      p->IsLoaded() ? "yes" : "no", p->m_map.size(), size);
+    if (p->IsLoaded()) loaded++;
+    instances += p->m_map.size();
+    memory += size;
+    }
+  writer->printf("%d of %d params loaded, %u instances, ~%u bytes\n",
+    loaded, m_map.size(), instances, memory);
+  }
+
 void OvmsConfig::upgrade()
   {
   // Migrate password/changed → module/init:
@@ -372,6 +529,7 @@ void OvmsConfig::RegisterParam(std::string name, std::string title, bool writabl
     {
     OvmsConfigParam* p = new OvmsConfigParam(name, title, writable, readable);
     m_map[name] = p;
+    m_generation++;
     }
   else
     {
@@ -388,10 +546,11 @@ void OvmsConfig::DeregisterParam(std::string name)
     k->second->DeleteParam();
     delete k->second;
     m_map.erase(k);
+    m_generation++;
     }
   }
 
-void OvmsConfig::SetParamValue(std::string param, std::string instance, std::string value)
+void OvmsConfig::SetParamValue(const std::string& param, const std::string& instance, const std::string& value)
   {
   OvmsConfigParam *p = CachedParam(param);
   if (p)
@@ -400,7 +559,7 @@ void OvmsConfig::SetParamValue(std::string param, std::string instance, std::str
     }
   }
 
-void OvmsConfig::SetParamValueBinary(std::string param, std::string instance, std::string value, BinaryEncoding_t encoding /*=Encoding_HEX*/)
+void OvmsConfig::SetParamValueBinary(const std::string& param, const std::string& instance, const std::string& value, BinaryEncoding_t encoding /*=Encoding_HEX*/)
   {
   std::string encval;
   if (encoding == Encoding_BASE64)
@@ -414,26 +573,26 @@ void OvmsConfig::SetParamValueBinary(std::string param, std::string instance, st
   SetParamValue(param, instance, encval);
   }
 
-void OvmsConfig::SetParamValueInt(std::string param, std::string instance, int value)
+void OvmsConfig::SetParamValueInt(const std::string& param, const std::string& instance, int value)
   {
   std::ostringstream ss;
   ss << value;
   SetParamValue(param, instance, std::string(ss.str()));
   }
 
-void OvmsConfig::SetParamValueFloat(std::string param, std::string instance, float value)
+void OvmsConfig::SetParamValueFloat(const std::string& param, const std::string& instance, float value)
   {
   std::ostringstream ss;
   ss << value;
   SetParamValue(param, instance, std::string(ss.str()));
   }
 
-void OvmsConfig::SetParamValueBool(std::string param, std::string instance, bool value)
+void OvmsConfig::SetParamValueBool(const std::string& param, const std::string& instance, bool value)
   {
   SetParamValue(param, instance, std::string(value ? "yes" : "no"));
   }
 
-void OvmsConfig::DeleteInstance(std::string param, std::string instance)
+void OvmsConfig::DeleteInstance(const std::string& param, const std::string& instance)
   {
   OvmsConfigParam *p = CachedParam(param);
   if (p)
@@ -442,7 +601,7 @@ void OvmsConfig::DeleteInstance(std::string param, std::string instance)
     }
   }
 
-std::string OvmsConfig::GetParamValue(std::string param, std::string instance, std::string defvalue)
+std::string OvmsConfig::GetParamValue(const std::string& param, const std::string& instance, const std::string& defvalue)
   {
   OvmsConfigParam *p = CachedParam(param);
   if (p && p->IsDefined(instance))
@@ -455,7 +614,7 @@ std::string OvmsConfig::GetParamValue(std::string param, std::string instance, s
     }
   }
 
-std::string OvmsConfig::GetParamValueBinary(std::string param, std::string instance, std::string defvalue, BinaryEncoding_t encoding /*=Encoding_HEX*/)
+std::string OvmsConfig::GetParamValueBinary(const std::string& param, const std::string& instance, const std::string& defvalue, BinaryEncoding_t encoding /*=Encoding_HEX*/)
   {
   std::string encval = GetParamValue(param,instance);
   size_t len = encval.length();
@@ -477,39 +636,78 @@ std::string OvmsConfig::GetParamValueBinary(std::string param, std::string insta
     }
   }
 
-int OvmsConfig::GetParamValueInt(std::string param, std::string instance, int defvalue)
+int OvmsConfig::GetParamValueInt(const std::string& param, const std::string& instance, int defvalue)
   {
-  std::string value = GetParamValue(param,instance);
-  if (value.length() == 0) return defvalue;
-  return atoi(value.c_str());
+  int value;
+  return LookupParamValue(param, instance, &value) ? value : defvalue;
   }
 
-float OvmsConfig::GetParamValueFloat(std::string param, std::string instance, float defvalue)
+float OvmsConfig::GetParamValueFloat(const std::string& param, const std::string& instance, float defvalue)
   {
-  std::string value = GetParamValue(param,instance);
-  if (value.length() == 0) return defvalue;
-  return atof(value.c_str());
+  float value;
+  return LookupParamValue(param, instance, &value) ? value : defvalue;
+  }
+
+bool OvmsConfig::GetParamValueBool(const std::string& param, const std::string& instance, bool defvalue)
+  {
+  bool value;
+  return LookupParamValue(param, instance, &value) ? value : defvalue;
+  }
+
+/**
+ * LookupParamValue: typed value lookup without string copies
+ *  Returns false if the instance is undefined or empty.
+ */
+bool OvmsConfig::LookupParamValue(const std::string& param, const std::string& instance, int* value)
+  {
+  OvmsConfigParam *p = CachedParam(param);
+  const std::string* str = p ? p->FindValue(instance) : NULL;
+  if (!str || str->empty()) return false;
+  *value = atoi(str->c_str());
+  return true;
+  }
+
+bool OvmsConfig::LookupParamValue(const std::string& param, const std::string& instance, float* value)
+  {
+  OvmsConfigParam *p = CachedParam(param);
+  const std::string* str = p ? p->FindValue(instance) : NULL;
+  if (!str || str->empty()) return false;
+  *value = atof(str->c_str());
+  return true;
   }
 
-bool OvmsConfig::GetParamValueBool(std::string param, std::string instance, bool defvalue)
+bool OvmsConfig::LookupParamValue(const std::string& param, const std::string& instance, bool* value)
   {
-  std::string value = GetParamValue(param,instance);
-  if (value.length() == 0) return defvalue;
-  return strtobool(value);
+  OvmsConfigParam *p = CachedParam(param);
+  const std::string* str = p ? p->FindValue(instance) : NULL;
+  if (!str || str->empty()) return false;
+  *value = strtobool(*str);
+  return true;
   }
 
-bool OvmsConfig::IsDefined(std::string param, std::string instance)
+bool OvmsConfig::IsDefined(const std::string& param, const std::string& instance)
   {
   OvmsConfigParam *p = CachedParam(param);
   if (p == NULL) return false;
   return p->IsDefined(instance);
   }
 
-OvmsConfigParam* OvmsConfig::CachedParam(std::string param)
+OvmsConfigParam* OvmsConfig::CachedParam(const std::string& param)
   {
   if (!m_mounted) return NULL;
 
-  return m_map.FindUniquePrefix(param.c_str());
+  // exact match first, fall back to unique prefix:
+  OvmsConfigParam* p;
+  auto k = m_map.find(param);
+  if (k != m_map.end())
+    p = k->second;
+  else
+    p = m_map.FindUniquePrefix(param.c_str());
+
+  // load on first access:
+  if (p && !p->IsLoaded())
+    p->Load();
+  return p;
   }
 
 bool OvmsConfig::ProtectedPath(std::string path)
@@ -579,6 +777,7 @@ bool OvmsConfig::Backup(std::string path, std::string password, OvmsWriter* writ
   else
     ESP_LOGD(TAG, "Backup: creating '%s'...", path.c_str());
 
+  Flush();
   OvmsMutexLock store_lock(&m_store_lock);
   bool ok = true;
 
@@ -731,6 +930,10 @@ bool OvmsConfig::Restore(std::string path, std::string password, OvmsWriter* wri
     return false;
     }
 
+  // the store lock is kept until the reboot, in-memory changes must not
+  // overwrite the restored config:
+  m_frozen = true;
+
   if (writer)
     writer->puts("Done, rebooting now...");
   else
@@ -752,6 +955,7 @@ void OvmsConfig::SupportSummary(OvmsWriter* writer)
     {
     writer->printf("  [%s]\n",mi->first.c_str());
     OvmsConfigParam* p = mi->second;
+    p->Load();
     for (ConfigParamMap::iterator it=p->m_map.begin(); it!=p->m_map.end(); ++it)
       {
       if (p->Readable())
@@ -769,11 +973,8 @@ OvmsConfigParam::OvmsConfigParam(std::string name, std::string title, bool writa
   m_writable = writable;
   m_readable = readable;
   m_loaded = false;
-
-  if (MyConfig.ismounted())
-    {
-    LoadConfig();
-    }
+  m_dirty = false;
+  m_signal = false;
   }
 
 OvmsConfigParam::~OvmsConfigParam()
@@ -785,12 +986,23 @@ void OvmsConfigParam::LoadConfig()
   if (m_loaded) return;  // Protected against loading more than once
 
   OvmsMutexLock store_lock(&MyConfig.m_store_lock);
+  if (m_loaded) return;  // …also by a concurrent task
 
   std::string path(OVMS_CONFIGPATH);
   path.append("/");
   path.append(m_name);
   // ESP_LOGI(TAG, "Trying %s",path.c_str());
   FILE* f = fopen(path.c_str(), "r");
+  if (!f)
+    {
+    // recover from a RewriteConfig() interrupted between unlink & rename:
+    std::string temp = path + ".tmp";
+    if (rename(temp.c_str(), path.c_str()) == 0)
+      {
+      ESP_LOGW(TAG, "LoadConfig: recovered '%s' from temporary file", path.c_str());
+      f = fopen(path.c_str(), "r");
+      }
+    }
   if (f)
     {
     char* buf = new char[OVMS_MAXVALSIZE];
@@ -829,15 +1041,18 @@ void OvmsConfigParam::LoadConfig()
     fclose(f);
     }
   m_loaded = true;
+  MyConfig.m_generation++;
   }
 
-void OvmsConfigParam::SetValue(std::string instance, std::string value)
+void OvmsConfigParam::SetValue(const std::string& instance, const std::string& value)
   {
-  if (m_map.find(instance) == m_map.end() || m_map[instance] != value)
+  Load();
+  OvmsMutexLock store_lock(&MyConfig.m_store_lock);
+  auto k = m_map.find(instance);
+  if (k == m_map.end() || k->second != value)
     {
     m_map[instance] = value;
-    RewriteConfig();
-    MyEvents.SignalEvent("config.changed", this);
+    Changed();
     }
   }
 
@@ -845,6 +1060,9 @@ void OvmsConfigParam::DeleteParam()
   {
   OvmsMutexLock store_lock(&MyConfig.m_store_lock);
 
+  m_dirty = false;
+  m_signal = false;
+  MyConfig.m_generation++;
   std::string path(OVMS_CONFIGPATH);
   path.append("/");
   path.append(m_name);
@@ -852,31 +1070,49 @@ void OvmsConfigParam::DeleteParam()
   MyEvents.SignalEvent("config.changed", this);
   }
 
-bool OvmsConfigParam::DeleteInstance(std::string instance)
+bool OvmsConfigParam::DeleteInstance(const std::string& instance)
   {
+  Load();
+  OvmsMutexLock store_lock(&MyConfig.m_store_lock);
   bool ret = false;
   auto k = m_map.find(instance);
   if (k != m_map.end())
     {
     m_map.erase(k);
-    RewriteConfig();
+    Changed();
     ret = true;
     }
-  MyEvents.SignalEvent("config.changed", this);
   return ret;
   }
 
-std::string OvmsConfigParam::GetValue(std::string instance)
+/**
+ * GetValue: get instance value
+ *  Note: the reference is valid until the next change of the param
+ */
+const std::string& OvmsConfigParam::GetValue(const std::string& instance)
+  {
+  static const std::string empty;
+  const std::string* value = FindValue(instance);
+  return value ? *value : empty;
+  }
+
+/**
+ * FindValue: get pointer to instance value, NULL if undefined
+ *  Note: the pointer is valid until the next change of the param
+ */
+const std::string* OvmsConfigParam::FindValue(const std::string& instance)
   {
+  Load();
   auto k = m_map.find(instance);
   if (k == m_map.end())
-    return std::string("");
+    return NULL;
   else
-    return k->second;
+    return &k->second;
   }
 
-bool OvmsConfigParam::IsDefined(std::string instance)
+bool OvmsConfigParam::IsDefined(const std::string& instance)
   {
+  Load();
   if (instance.empty())
     return !m_map.empty();
   auto k = m_map.find(instance);
@@ -907,44 +1143,122 @@ std::string OvmsConfigParam::GetName()
   return m_name;
   }
 
-void OvmsConfigParam::RewriteConfig()
+/**
+ * Changed: mark param for write-behind
+ *  Note: caller holds the store lock
+ */
+void OvmsConfigParam::Changed()
   {
-  OvmsMutexLock store_lock(&MyConfig.m_store_lock);
+  m_dirty = true;
+  m_signal = true;
+  MyConfig.m_generation++;
+  MyConfig.m_stat_changes++;
+  MyConfig.ScheduleFlush();
+  }
+
+/**
+ * Flush: write param if changed, signal config.changed
+ *  Returns true if the param has been written. On a write error, the param
+ *  stays dirty and a retry is scheduled. config.changed is signaled once per
+ *  change anyway, as the new value is in effect in memory.
+ */
+bool OvmsConfigParam::Flush()
+  {
+  bool written, signal;
+    {
+    OvmsMutexLock store_lock(&MyConfig.m_store_lock);
+    if (!m_dirty)
+      return false;
+    written = RewriteConfig();
+    if (written)
+      m_dirty = false;
+    signal = m_signal;
+    m_signal = false;
+    }
+  if (!written)
+    {
+    ESP_LOGE(TAG, "Flush: param '%s' not written, retrying", m_name.c_str());
+    MyConfig.ScheduleFlush();
+    }
+  if (signal)
+    MyEvents.SignalEvent("config.changed", this);
+  return written;
+  }
 
+/**
+ * RewriteConfig: atomic write via temporary file
+ *  Note: caller holds the store lock
+ */
+bool OvmsConfigParam::RewriteConfig()
+  {
   std::string path(OVMS_CONFIGPATH);
   path.append("/");
   path.append(m_name);
-  FILE* f = fopen(path.c_str(), "w");
+  std::string temp = path + ".tmp";
+  FILE* f = fopen(temp.c_str(), "w");
   if (!f)
-    ESP_LOGE(TAG, "RewriteConfig: can't open '%s': %s", path.c_str(), strerror(errno));
-  else
     {
+    ESP_LOGE(TAG, "RewriteConfig: can't open '%s': %s", temp.c_str(), strerror(errno));
+    MyConfig.m_stat_errors++;
+    return false;
+    }
 #ifdef OVMS_PERSIST_METADATA
-    // write meta data:
-    fprintf(f, "#access=%s%s\n", m_readable ? "r" : "", m_writable ? "w" : "");
-    fprintf(f, "#title=%s\n", m_title.c_str());
+  // write meta data:
+  fprintf(f, "#access=%s%s\n", m_readable ? "r" : "", m_writable ? "w" : "");
+  fprintf(f, "#title=%s\n", m_title.c_str());
 #endif
-    // write instances:
-    for (ConfigParamMap::iterator it=m_map.begin(); it!=m_map.end(); ++it)
-      {
-      fprintf(f,"%s\t%s\n",it->first.c_str(),it->second.c_str());
-      }
-    if (fclose(f))
-      ESP_LOGE(TAG, "RewriteConfig: error writing '%s': %s", path.c_str(), strerror(errno));
+  // write instances:
+  for (ConfigParamMap::iterator it=m_map.begin(); it!=m_map.end(); ++it)
+    {
+    fprintf(f,"%s\t%s\n",it->first.c_str(),it->second.c_str());
     }
+  if (fclose(f))
+    {
+    ESP_LOGE(TAG, "RewriteConfig: error writing '%s': %s", temp.c_str(), strerror(errno));
+    unlink(temp.c_str());
+    MyConfig.m_stat_errors++;
+    return false;
+    }
+  // FAT cannot rename onto an existing file; an interruption after the unlink
+  // is recovered by LoadConfig():
+  unlink(path.c_str());
+  if (rename(temp.c_str(), path.c_str()) != 0)
+    {
+    ESP_LOGE(TAG, "RewriteConfig: can't rename '%s': %s", temp.c_str(), strerror(errno));
+    MyConfig.m_stat_errors++;
+    return false;
+    }
+  MyConfig.m_stat_writes++;
+  return true;
   }
 
 void OvmsConfigParam::Load()
   {
-  if (!m_loaded) LoadConfig();
+  if (!m_loaded && MyConfig.ismounted()) LoadConfig();
+  }
+
+/**
+ * GetMemoryUsage: approximate RAM usage of the loaded instances
+ *  (tree node overhead + string objects + string buffers)
+ */
+size_t OvmsConfigParam::GetMemoryUsage()
+  {
+  size_t size = 0;
+  for (ConfigParamMap::iterator it=m_map.begin(); it!=m_map.end(); ++it)
+    {
+    size += 4*sizeof(void*) + sizeof(*it);
+    size += it->first.capacity() + 1;
+    size += it->second.capacity() + 1;
+    }
+  return size;
   }
 
 void OvmsConfigParam::Save()
   {
   if (m_name != "")
     {
-    RewriteConfig();
-    MyEvents.SignalEvent("config.changed", this);
+    OvmsMutexLock store_lock(&MyConfig.m_store_lock);
+    Changed();
     }
   }
 
@@ -954,7 +1268,10 @@ void OvmsConfigParam::Save()
  */
 void OvmsConfigParam::SetMap(ConfigParamMap& map)
   {
+  OvmsMutexLock store_lock(&MyConfig.m_store_lock);
   m_map.clear();
   m_map = std::move(map);
-  Save();
+  m_loaded = true;
+  if (m_name != "")
+    Changed();
   }
@@ -33,12 +33,18 @@
 
 #include "string"
 #include "map"
+#include <atomic>
 #include "esp_err.h"
 #include "esp_vfs_fat.h"
 #include "wear_levelling.h"
 #include "ovms_mutex.h"
 #include "ovms_command.h"
 
+#ifndef OVMS_STOREPATH
+#define OVMS_STOREPATH "/store"
+#endif
+#define OVMS_CONFIGPATH OVMS_STOREPATH "/ovms_config"
+
 typedef NameStringMap ConfigParamMap;
 
 class OvmsConfigParam
@@ -48,11 +54,12 @@ class OvmsConfigParam
     ~OvmsConfigParam();
 
   public:
-    void SetValue(std::string instance, std::string value);
+    void SetValue(const std::string& instance, const std::string& value);
     void DeleteParam();
-    bool DeleteInstance(std::string instance);
-    std::string GetValue(std::string instance);
-    bool IsDefined(std::string instance);
+    bool DeleteInstance(const std::string& instance);
+    const std::string& GetValue(const std::string& instance);
+    const std::string* FindValue(const std::string& instance);
+    bool IsDefined(const std::string& instance);
     bool Writable();
     bool Readable();
     void SetAccess(bool writable, bool readable);
@@ -61,11 +68,16 @@ class OvmsConfigParam
     void SetTitle(std::string title) { m_title = title; }
     void Load();
     void Save();
-    const ConfigParamMap& GetMap() { return m_map; }
+    const ConfigParamMap& GetMap() { Load(); return m_map; }
     void SetMap(ConfigParamMap& map);
+    bool IsLoaded() { return m_loaded; }
+    bool IsDirty() { return m_dirty; }
+    size_t GetMemoryUsage();
+    bool Flush();
 
   protected:
-    void RewriteConfig();
+    void Changed();
+    bool RewriteConfig();
     void LoadConfig();
 
   protected:
@@ -74,6 +86,8 @@ class OvmsConfigParam
     bool m_writable;
     bool m_readable;
     bool m_loaded;
+    bool m_dirty;                             // changes pending for write-behind
+    bool m_signal;                            // config.changed pending
 
   public:
     ConfigParamMap m_map;
@@ -98,23 +112,37 @@ class OvmsConfig
     void DeregisterParam(std::string name);
 
   public:
-    void SetParamValue(std::string param, std::string instance, std::string value);
-    void SetParamValueBinary(std::string param, std::string instance, std::string value, BinaryEncoding_t encoding=Encoding_HEX);
-    void SetParamValueInt(std::string param, std::string instance, int value);
-    void SetParamValueFloat(std::string param, std::string instance, float value);
-    void SetParamValueBool(std::string param, std::string instance, bool value);
-    void DeleteInstance(std::string param, std::string instance);
-    std::string GetParamValue(std::string param, std::string instance, std::string defvalue = "");
-    std::string GetParamValueBinary(std::string param, std::string instance, std::string defvalue = "", BinaryEncoding_t encoding=Encoding_HEX);
-    int GetParamValueInt(std::string param, std::string instance, int defvalue = 0);
-    float GetParamValueFloat(std::string param, std::string instance, float defvalue = 0);
-    bool GetParamValueBool(std::string param, std::string instance, bool defvalue = false);
-    bool IsDefined(std::string param, std::string instance);
+    void SetParamValue(const std::string& param, const std::string& instance, const std::string& value);
+    void SetParamValueBinary(const std::string& param, const std::string& instance, const std::string& value, BinaryEncoding_t encoding=Encoding_HEX);
+    void SetParamValueInt(const std::string& param, const std::string& instance, int value);
+    void SetParamValueFloat(const std::string& param, const std::string& instance, float value);
+    void SetParamValueBool(const std::string& param, const std::string& instance, bool value);
+    void DeleteInstance(const std::string& param, const std::string& instance);
+    std::string GetParamValue(const std::string& param, const std::string& instance, const std::string& defvalue = "");
+    std::string GetParamValueBinary(const std::string& param, const std::string& instance, const std::string& defvalue = "", BinaryEncoding_t encoding=Encoding_HEX);
+    int GetParamValueInt(const std::string& param, const std::string& instance, int defvalue = 0);
+    float GetParamValueFloat(const std::string& param, const std::string& instance, float defvalue = 0);
+    bool GetParamValueBool(const std::string& param, const std::string& instance, bool defvalue = false);
+    bool LookupParamValue(const std::string& param, const std::string& instance, int* value);
+    bool LookupParamValue(const std::string& param, const std::string& instance, float* value);
+    bool LookupParamValue(const std::string& param, const std::string& instance, bool* value);
+    bool IsDefined(const std::string& param, const std::string& instance);
     bool ProtectedPath(std::string path);
-    OvmsConfigParam* CachedParam(std::string param);
+    OvmsConfigParam* CachedParam(const std::string& param);
     const ConfigParamMap* GetParamMap(std::string param);
     void SetParamMap(std::string param, ConfigParamMap& map);
 
+  public:
+    // Write-behind: param changes are coalesced and written after OVMS_CONFIG_WRITEDELAY
+    // or on CommitTransaction(), whichever comes first
+    void BeginTransaction();
+    void CommitTransaction();
+    bool TransactionExpired();
+    void ScheduleFlush();
+    void Flush();
+    void EventListener(std::string event, void* data);
+    void Status(int verbosity, OvmsWriter* writer);
+
 #ifdef CONFIG_OVMS_SC_ZIP
   public:
     bool Backup(std::string path, std::string password, OvmsWriter* writer=NULL, int verbosity=1024);
@@ -134,6 +162,17 @@ class OvmsConfig
 
   protected:
     bool m_mounted;
+    bool m_flush_scheduled;                   // write-behind flush pending
+    uint32_t m_flush_time;                    // monotonictime of flush scheduling
+    bool m_frozen;                            // store replaced by restore, writes disabled
+
+  public:
+    volatile uint32_t m_generation;           // incremented on any param change, see OvmsConfigValue
+    std::atomic_int m_transaction;            // transaction nesting depth (all tasks)
+    volatile uint32_t m_transaction_time;     // monotonictime of outermost BeginTransaction()
+    uint32_t m_stat_changes;                  // param changes requested
+    uint32_t m_stat_writes;                   // param files written
+    uint32_t m_stat_errors;                   // param file write errors
     esp_vfs_fat_mount_config_t m_store_fat;
     wl_handle_t m_store_wlh;
 
@@ -144,4 +183,61 @@ class OvmsConfig
 
 extern OvmsConfig MyConfig;
 
+/**
+ * OvmsConfigValue: cached typed config value
+ *  Parses the instance value only once after each config change, so it
+ *  can be read in hot paths (tickers, frame handlers) without the param
+ *  lookup and string conversion costs of GetParamValue*().
+ *  Example:
+ *    static OvmsConfigFloat cfg_12v_ref("vehicle", "12v.ref", 12.6);
+ *    float dref = cfg_12v_ref.Get();
+ */
+template <typename T> class OvmsConfigValue
+  {
+  public:
+    OvmsConfigValue(const char* param, const char* instance, T defvalue = T())
+      : m_param(param), m_instance(instance), m_default(defvalue)
+      {
+      m_value = defvalue;
+      m_defined = false;
+      m_generation = 0;
+      }
+
+  public:
+    T Get() { return Get(m_default); }
+    T Get(T defvalue)
+      {
+      uint32_t generation = MyConfig.m_generation;
+      if (generation != m_generation)
+        {
+        m_defined = MyConfig.LookupParamValue(m_param, m_instance, &m_value);
+        m_generation = generation;
+        }
+      return m_defined ? m_value : defvalue;
+      }
+
+  protected:
+    std::string m_param;
+    std::string m_instance;
+    T m_default;
+    T m_value;
+    bool m_defined;
+    uint32_t m_generation;
+  };
+
+typedef OvmsConfigValue<int> OvmsConfigInt;
+typedef OvmsConfigValue<float> OvmsConfigFloat;
+typedef OvmsConfigValue<bool> OvmsConfigBool;
+
+/**
+ * OvmsConfigTransaction: scope bound config transaction
+ *  Changes done within the scope are written on scope exit.
+ */
+class OvmsConfigTransaction
+  {
+  public:
+    OvmsConfigTransaction() { MyConfig.BeginTransaction(); }
+    ~OvmsConfigTransaction() { MyConfig.CommitTransaction(); }
+  };
+
 #endif //#ifndef __CONFIG_H__
@@ -32,6 +32,7 @@
 static const char *TAG = "events";
 
 #include <string.h>
+#include <algorithm>
 #include <stdio.h>
 #include <esp_event_loop.h>
 #include <esp_task_wdt.h>
@@ -69,10 +70,19 @@ void event_trace(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
 
 void event_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
-  writer->printf("Event map has %d listeners, and queue has %d/%d entries\n",
+  writer->printf("Event map has %d listeners, %d events known\n",
     MyEvents.Map().size(),
-    uxQueueMessagesWaiting(MyEvents.m_taskqueue),
-    CONFIG_OVMS_HW_EVENT_QUEUE_SIZE);
+    MyEvents.GetEntryCount());
+
+  writer->puts("Lane       Queue     Queued  Coalesced  Dropped");
+  for (int i = 0; i < EVENT_LANE_COUNT; i++)
+    {
+    event_lane_info_t* lane = &MyEvents.m_lanes[i];
+    writer->printf("%-8s %3u/%-3u %10u %10u %8u  (peak %u)\n",
+      lane->name,
+      uxQueueMessagesWaiting(lane->queue), CONFIG_OVMS_HW_EVENT_QUEUE_SIZE,
+      lane->queued, lane->coalesced, lane->dropped, lane->peak);
+    }
 
   EventCallbackEntry* cbe = MyEvents.m_current_callback;
   if (cbe != NULL)
@@ -82,6 +92,31 @@ void event_status(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
     writer->printf("  To:    %s\n",cbe->m_caller.c_str());
     writer->printf("  For:   %u second(s)\n",monotonictime-MyEvents.m_current_started);
     }
+
+  // Dispatch latency histograms:
+  int cnt = 0;
+  for (size_t id = 0; id < MyEvents.GetEntryCount(); id++)
+    {
+    OvmsEventEntry* e = MyEvents.GetEntry(id);
+    if (!e || e->m_count == 0)
+      continue;
+    if (argc > 0 && e->m_name.find(argv[0]) == std::string::npos)
+      continue;
+    if (cnt++ == 0)
+      writer->puts("\nEvent                            Count  Avg.us  Max.us  <100us   <1ms  <10ms <100ms    <1s   >=1s");
+    writer->printf("%-30.30s %7u %7u %7u %7u %6u %6u %6u %6u %6u\n",
+      e->m_name.c_str(), e->m_count,
+      (uint32_t)(e->m_time_sum / e->m_count), e->m_time_max,
+      e->m_hist[0], e->m_hist[1], e->m_hist[2], e->m_hist[3], e->m_hist[4], e->m_hist[5]);
+    }
+  OvmsEventEntry* e = MyEvents.GetOtherEntry();
+  if (argc == 0 && e->m_count)
+    {
+    writer->printf("%-30.30s %7u %7u %7u %7u %6u %6u %6u %6u %6u\n",
+      "(other)", e->m_count,
+      (uint32_t)(e->m_time_sum / e->m_count), e->m_time_max,
+      e->m_hist[0], e->m_hist[1], e->m_hist[2], e->m_hist[3], e->m_hist[4], e->m_hist[5]);
+    }
   }
 
 void event_list(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
@@ -136,11 +171,15 @@ void event_raise(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
     }
   }
 
+static const char* const event_lane_names[EVENT_LANE_COUNT] = { "system", "vehicle", "ticker", "bulk" };
+
 OvmsEvents::OvmsEvents()
+  : m_other(EVENT_ID_NONE, "")
   {
   ESP_LOGI(TAG, "Initialising EVENTS (1200)");
 
   m_current_callback = NULL;
+  m_autointerned = 0;
 
 #ifdef CONFIG_OVMS_DEV_DEBUGEVENTS
   m_trace = true;
@@ -152,14 +191,19 @@ OvmsEvents::OvmsEvents()
 
   // Register our commands
   OvmsCommand* cmd_event = MyCommandApp.RegisterCommand("event","EVENT framework");
-  cmd_event->RegisterCommand("status","Show status of event system",event_status);
+  cmd_event->RegisterCommand("status","Show status of event system",event_status,"[<key>]", 0, 1);
   cmd_event->RegisterCommand("list","List registered events",event_list,"[<key>]", 0, 1);
   cmd_event->RegisterCommand("raise","Raise a textual event",event_raise,"[-d<delay_ms>] <event>", 1, 2, true, event_validate);
   OvmsCommand* cmd_eventtrace = cmd_event->RegisterCommand("trace","EVENT trace framework");
   cmd_eventtrace->RegisterCommand("on","Turn event tracing ON",event_trace);
   cmd_eventtrace->RegisterCommand("off","Turn event tracing OFF",event_trace);
 
-  m_taskqueue = xQueueCreate(CONFIG_OVMS_HW_EVENT_QUEUE_SIZE,sizeof(event_queue_t));
+  for (int i = 0; i < EVENT_LANE_COUNT; i++)
+    {
+    memset(&m_lanes[i], 0, sizeof(event_lane_info_t));
+    m_lanes[i].name = event_lane_names[i];
+    m_lanes[i].queue = xQueueCreate(CONFIG_OVMS_HW_EVENT_QUEUE_SIZE,sizeof(event_queue_t));
+    }
   xTaskCreatePinnedToCore(EventLaunchTask, "OVMS Events", 8192, (void*)this, 8, &m_taskid, CORE(1));
   AddTaskToMap(m_taskid);
   }
@@ -168,6 +212,11 @@ OvmsEvents::~OvmsEvents()
   {
   }
 
+/**
+ * EventTask: dispatch the queued events
+ *  Senders notify the task after queueing. On wakeup, all lanes get drained,
+ *  always taking the next event from the highest priority lane.
+ */
 void OvmsEvents::EventTask()
   {
   event_queue_t msg;
@@ -175,26 +224,37 @@ void OvmsEvents::EventTask()
   esp_task_wdt_add(NULL); // WATCHDOG is active for this task
   while(1)
     {
-    if (xQueueReceive(m_taskqueue, &msg, pdMS_TO_TICKS(5000)) == pdTRUE)
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000)) > 0)
       {
       esp_task_wdt_reset(); // Reset WATCHDOG timer for this task
-      switch(msg.type)
+      while (1)
         {
-        case EVENT_none:
-          break;
-        case EVENT_signal:
-          m_current_event = msg.body.signal.event;
-          HandleQueueSignalEvent(&msg);
-          esp_task_wdt_reset(); // Reset WATCHDOG timer for this task
-          m_current_event.clear();
-          break;
-        default:
+        int lane;
+        for (lane = 0; lane < EVENT_LANE_COUNT; lane++)
+          {
+          if (xQueueReceive(m_lanes[lane].queue, &msg, 0) == pdTRUE)
+            break;
+          }
+        if (lane == EVENT_LANE_COUNT)
           break;
+        switch(msg.type)
+          {
+          case EVENT_none:
+            break;
+          case EVENT_signal:
+            m_current_event = msg.body.signal.event;
+            HandleQueueSignalEvent(&msg);
+            esp_task_wdt_reset(); // Reset WATCHDOG timer for this task
+            m_current_event.clear();
+            break;
+          default:
+            break;
+          }
         }
       }
     else
       {
-      // timeout on xQueueReceive means:
+      // timeout on the queue wait means:
       ESP_LOGE(TAG, "EventTask: [QueueTimeout] timer service / ticker timer has died => aborting");
       m_current_event = "[QueueTimeout]";
       m_current_started = monotonictime - 5;
@@ -216,40 +276,68 @@ void OvmsEvents::HandleQueueSignalEvent(event_queue_t* msg)
       ESP_LOGD(TAG, "Signal(%s)",m_current_event.c_str());
     }
 
-  auto k = m_map.find(m_current_event);
-  if (k != m_map.end())
+  OvmsEventEntry* entry;
+  m_mutex.Lock();
+  if (msg->body.signal.id != EVENT_ID_NONE)
+    entry = m_events[msg->body.signal.id];
+  else
+    entry = AutoInternEvent(m_current_event);
+  if (msg->body.signal.coalesce && entry)
     {
-    EventCallbackList* el = k->second;
-    if (el)
-      {
-      for (EventCallbackList::iterator itc=el->begin(); itc!=el->end(); ++itc)
-        {
-        m_current_started = monotonictime;
-        m_current_callback = *itc;
-        m_current_callback->m_callback(m_current_event, msg->body.signal.data);
-        m_current_callback = NULL;
-        }
-      }
+    // From here on, new signals need to be delivered again:
+    entry->m_queued--;
+    }
+  if (!entry)
+    {
+    // Not interned: resolve the listeners for this dispatch
+    entry = &m_other;
+    entry->m_name = m_current_event;
+    ResolveDispatch(entry);
+    }
+  m_mutex.Unlock();
+
+  int64_t started = esp_timer_get_time();
+
+  // Walk a snapshot of the resolved dispatch list. Callbacks may (de)register
+  // listeners, so each listener is checked to be still registered for the
+  // event before it is called; listeners added during the dispatch get the
+  // next signal:
+  EventCallbackEntry* local[16];
+  std::vector<EventCallbackEntry*> more;
+  EventCallbackEntry** snapshot = local;
+  m_mutex.Lock();
+  size_t count = entry->m_dispatch.size();
+  if (count > 16)
+    {
+    more = entry->m_dispatch;
+    snapshot = more.data();
     }
+  else if (count)
+    memcpy(local, entry->m_dispatch.data(), count * sizeof(EventCallbackEntry*));
+  m_mutex.Unlock();
 
-  k = m_map.find("*");
-  if (k != m_map.end())
+  for (size_t i = 0; i < count; i++)
     {
-    EventCallbackList* el = k->second;
-    if (el)
-      {
-      for (EventCallbackList::iterator itc=el->begin(); itc!=el->end(); ++itc)
-        {
-        m_current_started = monotonictime;
-        m_current_callback = *itc;
-        m_current_callback->m_callback(m_current_event, msg->body.signal.data);
-        m_current_callback = NULL;
-        }
-      }
+    m_mutex.Lock();
+    auto& dispatch = entry->m_dispatch;
+    bool registered = (i < dispatch.size() && dispatch[i] == snapshot[i])
+      || std::find(dispatch.begin(), dispatch.end(), snapshot[i]) != dispatch.end();
+    m_current_callback = registered ? snapshot[i] : NULL;
+    m_mutex.Unlock();
+    if (!m_current_callback)
+      continue;
+    m_current_started = monotonictime;
+    m_current_callback->m_callback(m_current_event, msg->body.signal.data);
+    m_current_callback = NULL;
     }
 
   m_current_started = monotonictime;
-  MyScripts.EventScript(m_current_event, msg->body.signal.data);
+  if (entry == &m_other)
+    MyScripts.EventScript(m_current_event.c_str(), msg->body.signal.data, false);
+  else
+    MyScripts.EventScript(entry->m_name.c_str(), msg->body.signal.data);
+
+  entry->AddTime(esp_timer_get_time() - started);
 
   FreeQueueSignalEvent(msg);
   }
@@ -260,16 +348,112 @@ void OvmsEvents::FreeQueueSignalEvent(event_queue_t* msg)
     {
     msg->body.signal.donefn(msg->body.signal.event, msg->body.signal.data);
     }
-  free(msg->body.signal.event);
+  if (msg->body.signal.id == EVENT_ID_NONE)
+    free(msg->body.signal.event);
   }
 
+/**
+ * InternEvent: get or create the entry for an event name
+ *  (call with m_mutex held; returns NULL if the id space is exhausted)
+ */
+OvmsEventEntry* OvmsEvents::InternEvent(const std::string& event)
+  {
+  auto it = m_ids.find(event);
+  if (it != m_ids.end())
+    return m_events[it->second];
+  if (m_events.size() >= EVENT_ID_NONE)
+    return NULL;
+  OvmsEventEntry* entry = new OvmsEventEntry(m_events.size(), event);
+  m_events.push_back(entry);
+  m_ids[event] = entry->m_id;
+  ResolveDispatch(entry);
+  return entry;
+  }
+
+/**
+ * AutoInternEvent: intern an event on signal
+ *  Limits the number of events interned this way, as some events have
+ *  dynamic names (i.e. clock.HHMM). Those are not interned at all.
+ *  (call with m_mutex held; returns NULL if not interned)
+ */
+OvmsEventEntry* OvmsEvents::AutoInternEvent(const std::string& event)
+  {
+  auto it = m_ids.find(event);
+  if (it != m_ids.end())
+    return m_events[it->second];
+  if (m_autointerned >= EVENT_MAX_AUTOINTERN || event.compare(0, 6, "clock.") == 0)
+    return NULL;
+  OvmsEventEntry* entry = InternEvent(event);
+  if (entry)
+    m_autointerned++;
+  return entry;
+  }
+
+/**
+ * ResolveDispatch: collect the listeners for an event
+ *  in order: exact registrations, prefix registrations, "*" registrations
+ *  (call with m_mutex held)
+ */
+void OvmsEvents::ResolveDispatch(OvmsEventEntry* entry)
+  {
+  entry->m_dispatch.clear();
+
+  auto k = m_map.find(entry->m_name);
+  if (k != m_map.end())
+    entry->m_dispatch.insert(entry->m_dispatch.end(), k->second->begin(), k->second->end());
+
+  for (const std::string& prefix : m_prefixes)
+    {
+    if (prefix != entry->m_name && entry->m_name.compare(0, prefix.size()-1, prefix, 0, prefix.size()-1) == 0)
+      {
+      k = m_map.find(prefix);
+      if (k != m_map.end())
+        entry->m_dispatch.insert(entry->m_dispatch.end(), k->second->begin(), k->second->end());
+      }
+    }
+
+  if (entry->m_name != "*")
+    {
+    k = m_map.find("*");
+    if (k != m_map.end())
+      entry->m_dispatch.insert(entry->m_dispatch.end(), k->second->begin(), k->second->end());
+    }
+  }
+
+/**
+ * GetEventId: intern an event name, i.e. to signal it by id
+ *  (returns EVENT_ID_NONE if the id space is exhausted)
+ */
+event_id_t OvmsEvents::GetEventId(const std::string& event)
+  {
+  OvmsMutexLock lock(&m_mutex);
+  OvmsEventEntry* entry = InternEvent(event);
+  return entry ? entry->m_id : EVENT_ID_NONE;
+  }
+
+OvmsEventEntry* OvmsEvents::GetEntry(event_id_t id)
+  {
+  OvmsMutexLock lock(&m_mutex);
+  return (id < m_events.size()) ? m_events[id] : NULL;
+  }
+
+/**
+ * RegisterEvent: register a listener for an event
+ *  event may be an event name, a prefix pattern ending in '*' (i.e.
+ *  "vehicle.charge.*") or "*" for all events. Patterns are resolved into the
+ *  dispatch lists of the matching events here, not on dispatch.
+ */
 void OvmsEvents::RegisterEvent(std::string caller, std::string event, EventCallback callback)
   {
+  OvmsMutexLock lock(&m_mutex);
+
   auto k = m_map.find(event);
   if (k == m_map.end())
     {
     m_map[event] = new EventCallbackList();
     k = m_map.find(event);
+    if (k != m_map.end() && event.size() > 1 && event.back() == '*')
+      m_prefixes.push_back(event);
     }
   if (k == m_map.end())
     {
@@ -279,10 +463,28 @@ void OvmsEvents::RegisterEvent(std::string caller, std::string event, EventCallb
 
   EventCallbackList *el = k->second;
   el->push_back(new EventCallbackEntry(caller,callback));
+
+  if (!event.empty() && event.back() == '*')
+    {
+    // Pattern: update all matching events
+    for (OvmsEventEntry* entry : m_events)
+      {
+      if (entry->m_name.compare(0, event.size()-1, event, 0, event.size()-1) == 0)
+        ResolveDispatch(entry);
+      }
+    }
+  else
+    {
+    OvmsEventEntry* entry = InternEvent(event);
+    if (entry)
+      ResolveDispatch(entry);
+    }
   }
 
 void OvmsEvents::DeregisterEvent(std::string caller)
   {
+  OvmsMutexLock lock(&m_mutex);
+
   EventMap::iterator itm=m_map.begin();
   while (itm!=m_map.end())
     {
@@ -303,6 +505,17 @@ void OvmsEvents::DeregisterEvent(std::string caller)
       }
     if (el->empty())
       {
+      if (itm->first.size() > 1 && itm->first.back() == '*')
+        {
+        for (auto itp = m_prefixes.begin(); itp != m_prefixes.end(); ++itp)
+          {
+          if (*itp == itm->first)
+            {
+            m_prefixes.erase(itp);
+            break;
+            }
+          }
+        }
       itm = m_map.erase(itm);
       delete el;
       }
@@ -311,15 +524,21 @@ void OvmsEvents::DeregisterEvent(std::string caller)
       ++itm;
       }
     }
+
+  for (OvmsEventEntry* entry : m_events)
+    ResolveDispatch(entry);
+  if (!m_current_event.empty())
+    ResolveDispatch(&m_other);  // may be dispatching right now
   }
 
-static void CheckQueueOverflow(const char* from, char* event)
+static void CheckQueueOverflow(const char* from, char* event, int lane)
   {
   EventCallbackEntry* cbe = MyEvents.m_current_callback;
   if (cbe != NULL)
     {
-    ESP_LOGE(TAG, "%s: queue overflow (running %s->%s for %u sec), event '%s' dropped",
+    ESP_LOGE(TAG, "%s: %s queue overflow (running %s->%s for %u sec), event '%s' dropped",
       from,
+      MyEvents.m_lanes[lane].name,
       MyEvents.m_current_event.c_str(),
       cbe->m_caller.c_str(),
       monotonictime-MyEvents.m_current_started,
@@ -327,9 +546,9 @@ static void CheckQueueOverflow(const char* from, char* event)
     }
   else
     {
-    ESP_LOGE(TAG, "%s: queue overflow, event '%s' dropped", from, event);
+    ESP_LOGE(TAG, "%s: %s queue overflow, event '%s' dropped", from, MyEvents.m_lanes[lane].name, event);
     }
-  if (strncmp(event, "ticker.", 7) != 0)
+  if (lane != EVENT_LANE_TICKER)
     {
     // We've dropped a potentially important event, system is instable now.
     // As the event queue is full, a normal reboot is no option, so…
@@ -340,14 +559,51 @@ static void CheckQueueOverflow(const char* from, char* event)
     }
   }
 
-static void SignalScheduledEvent(TimerHandle_t timer)
+/**
+ * GetLane: determine the queue lane for an event
+ */
+event_lane_t OvmsEvents::GetLane(const char* event)
   {
-  event_queue_t* msg = (event_queue_t*) pvTimerGetTimerID(timer);
-  if (xQueueSend(MyEvents.m_taskqueue, msg, 0) != pdTRUE)
+  if (strncmp(event, "ticker.", 7) == 0 || strncmp(event, "clock.", 6) == 0)
+    return EVENT_LANE_TICKER;
+  if (strncmp(event, "vehicle.", 8) == 0)
+    return EVENT_LANE_VEHICLE;
+  if (strcmp(event, "config.changed") == 0 || strncmp(event, "usr.", 4) == 0)
+    return EVENT_LANE_BULK;
+  return EVENT_LANE_SYSTEM;
+  }
+
+/**
+ * SendQueueSignalEvent: add a signal to its lane queue & wake up the event task
+ *  On overflow, the signal is dropped & freed.
+ */
+bool OvmsEvents::SendQueueSignalEvent(event_queue_t* msg, const char* from)
+  {
+  event_lane_info_t* lane = &m_lanes[msg->body.signal.lane];
+  if (xQueueSend(lane->queue, msg, 0) != pdTRUE)
     {
-    CheckQueueOverflow("SignalScheduledEvent", msg->body.signal.event);
-    MyEvents.FreeQueueSignalEvent(msg);
+    lane->dropped++;
+    if (msg->body.signal.coalesce)
+      {
+      OvmsMutexLock lock(&m_mutex);
+      m_events[msg->body.signal.id]->m_queued--;
+      }
+    CheckQueueOverflow(from, msg->body.signal.event, msg->body.signal.lane);
+    FreeQueueSignalEvent(msg);
+    return false;
     }
+  lane->queued++;
+  uint32_t fill = uxQueueMessagesWaiting(lane->queue);
+  if (fill > lane->peak)
+    lane->peak = fill;
+  xTaskNotifyGive(m_taskid);
+  return true;
+  }
+
+static void SignalScheduledEvent(TimerHandle_t timer)
+  {
+  event_queue_t* msg = (event_queue_t*) pvTimerGetTimerID(timer);
+  MyEvents.SendQueueSignalEvent(msg, "SignalScheduledEvent");
   delete msg;
   }
 
@@ -398,6 +654,29 @@ bool OvmsEvents::ScheduleEvent(event_queue_t* msg, uint32_t delay_ms)
   return true;
   }
 
+void OvmsEvents::QueueSignalEvent(event_queue_t* msg, uint32_t delay_ms)
+  {
+  if (delay_ms == 0)
+    {
+    SendQueueSignalEvent(msg, "SignalEvent");
+    }
+  else
+    {
+    if (ScheduleEvent(msg, delay_ms) != true)
+      {
+      ESP_LOGE(TAG, "SignalEvent: no timer available, event '%s' dropped", msg->body.signal.event);
+      FreeQueueSignalEvent(msg);
+      }
+    }
+  }
+
+/**
+ * SignalEvent: queue an event
+ *  Ticker events and config.changed without data to free (no callback) are
+ *  coalesced with an identical pending signal (same event & data), i.e. a
+ *  ticker missed by a busy event task or config.changed of the same parameter.
+ *  State events (e.g. vehicle.on/off) are never coalesced, as their order matters.
+ */
 void OvmsEvents::SignalEvent(std::string event, void* data, event_signal_done_fn callback /*=NULL*/,
                              uint32_t delay_ms /*=0*/)
   {
@@ -405,27 +684,40 @@ void OvmsEvents::SignalEvent(std::string event, void* data, event_signal_done_fn
   memset(&msg, 0, sizeof(msg));
 
   msg.type = EVENT_signal;
-  msg.body.signal.event = (char*)ExternalRamMalloc(event.size()+1);
-  strcpy(msg.body.signal.event, event.c_str());
   msg.body.signal.data = data;
   msg.body.signal.donefn = callback;
+  msg.body.signal.id = EVENT_ID_NONE;
+  msg.body.signal.lane = GetLane(event.c_str());
 
-  if (delay_ms == 0)
+  if (callback == NULL && delay_ms == 0)
     {
-    if (xQueueSend(m_taskqueue, &msg, 0) != pdTRUE)
+    OvmsMutexLock lock(&m_mutex);
+    OvmsEventEntry* entry = AutoInternEvent(event);
+    if (entry)
       {
-      CheckQueueOverflow("SignalEvent", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
+      if (entry->m_coalesce)
+        {
+        if (entry->m_queued && entry->m_queued_data == data)
+          {
+          m_lanes[msg.body.signal.lane].coalesced++;
+          return;
+          }
+        entry->m_queued++;
+        entry->m_queued_data = data;
+        msg.body.signal.coalesce = true;
+        }
+      msg.body.signal.id = entry->m_id;
+      msg.body.signal.event = (char*)entry->m_name.c_str();
       }
     }
-  else
+
+  if (msg.body.signal.id == EVENT_ID_NONE)
     {
-    if (ScheduleEvent(&msg, delay_ms) != true)
-      {
-      ESP_LOGE(TAG, "SignalEvent: no timer available, event '%s' dropped", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
-      }
+    msg.body.signal.event = (char*)ExternalRamMalloc(event.size()+1);
+    strcpy(msg.body.signal.event, event.c_str());
     }
+
+  QueueSignalEvent(&msg, delay_ms);
   }
 
 void OvmsEvents::SignalEvent(std::string event, void* data, size_t length,
@@ -437,6 +729,8 @@ void OvmsEvents::SignalEvent(std::string event, void* data, size_t length,
   msg.type = EVENT_signal;
   msg.body.signal.event = (char*)ExternalRamMalloc(event.size()+1);
   strcpy(msg.body.signal.event, event.c_str());
+  msg.body.signal.id = EVENT_ID_NONE;
+  msg.body.signal.lane = GetLane(event.c_str());
   if (data != NULL)
     {
     msg.body.signal.data = ExternalRamMalloc(length);
@@ -449,24 +743,52 @@ void OvmsEvents::SignalEvent(std::string event, void* data, size_t length,
     msg.body.signal.donefn = NULL;
     }
 
-  if (delay_ms == 0)
+  QueueSignalEvent(&msg, delay_ms);
+  }
+
+/**
+ * SignalEvent: signal an interned event (see GetEventId)
+ *  Avoids the name copy & lookup, use for frequent events.
+ */
+void OvmsEvents::SignalEvent(event_id_t id, void* data, event_signal_done_fn callback /*=NULL*/,
+                             uint32_t delay_ms /*=0*/)
+  {
+  event_queue_t msg;
+  memset(&msg, 0, sizeof(msg));
+
+  msg.type = EVENT_signal;
+  msg.body.signal.data = data;
+  msg.body.signal.donefn = callback;
+  msg.body.signal.id = id;
+
+  {
+  OvmsMutexLock lock(&m_mutex);
+  OvmsEventEntry* entry = (id < m_events.size()) ? m_events[id] : NULL;
+  if (!entry)
     {
-    if (xQueueSend(m_taskqueue, &msg, 0) != pdTRUE)
-      {
-      CheckQueueOverflow("SignalEvent", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
-      }
+    ESP_LOGE(TAG, "SignalEvent: invalid event id %u", id);
+    if (callback)
+      callback(NULL, data);
+    return;
     }
-  else
+  msg.body.signal.event = (char*)entry->m_name.c_str();
+  msg.body.signal.lane = entry->m_lane;
+  if (callback == NULL && delay_ms == 0 && entry->m_coalesce)
     {
-    if (ScheduleEvent(&msg, delay_ms) != true)
+    if (entry->m_queued && entry->m_queued_data == data)
       {
-      ESP_LOGE(TAG, "SignalEvent: no timer available, event '%s' dropped", msg.body.signal.event);
-      FreeQueueSignalEvent(&msg);
+      m_lanes[entry->m_lane].coalesced++;
+      return;
       }
+    entry->m_queued++;
+    entry->m_queued_data = data;
+    msg.body.signal.coalesce = true;
     }
   }
 
+  QueueSignalEvent(&msg, delay_ms);
+  }
+
 esp_err_t OvmsEvents::ReceiveSystemEvent(void *ctx, system_event_t *event)
   {
   OvmsEvents* e = (OvmsEvents*)ctx;
@@ -569,3 +891,29 @@ EventCallbackEntry::EventCallbackEntry(std::string caller, EventCallback callbac
 EventCallbackEntry::~EventCallbackEntry()
   {
   }
+
+OvmsEventEntry::OvmsEventEntry(event_id_t id, const std::string& name)
+  {
+  m_id = id;
+  m_name = name;
+  m_lane = OvmsEvents::GetLane(name.c_str());
+  m_coalesce = (name.compare(0, 7, "ticker.") == 0 || name == "config.changed");
+  m_queued = 0;
+  m_queued_data = NULL;
+  m_count = 0;
+  m_time_max = 0;
+  m_time_sum = 0;
+  memset(m_hist, 0, sizeof(m_hist));
+  }
+
+void OvmsEventEntry::AddTime(uint32_t us)
+  {
+  m_count++;
+  m_time_sum += us;
+  if (us > m_time_max)
+    m_time_max = us;
+  int bucket = 0;
+  for (uint32_t limit = 100; bucket < EVENT_LATENCY_BUCKETS-1 && us >= limit; limit *= 10)
+    bucket++;
+  m_hist[bucket]++;
+  }
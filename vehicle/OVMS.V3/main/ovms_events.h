@@ -35,6 +35,8 @@
 #include <functional>
 #include <map>
 #include <list>
+#include <vector>
+#include <unordered_map>
 #include <esp_event.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -59,6 +61,65 @@ class EventCallbackEntry
 typedef std::list<EventCallbackEntry*> EventCallbackList;
 typedef NameMap<EventCallbackList*> EventMap;
 
+typedef uint16_t event_id_t;
+#define EVENT_ID_NONE           0xffff
+#define EVENT_LATENCY_BUCKETS   6       // <100us, <1ms, <10ms, <100ms, <1s, >=1s
+#define EVENT_MAX_AUTOINTERN    512     // max events interned on signal (vs. by registration)
+
+/**
+ * Event queue lanes, in dispatch priority order.
+ *  Order of events is kept within a lane, not across lanes.
+ */
+typedef enum
+  {
+  EVENT_LANE_SYSTEM = 0,              // all other events
+  EVENT_LANE_VEHICLE,                 // vehicle.*
+  EVENT_LANE_TICKER,                  // ticker.*, clock.*
+  EVENT_LANE_BULK,                    // config.changed, usr.*
+  EVENT_LANE_COUNT
+  } event_lane_t;
+
+typedef struct
+  {
+  const char* name;
+  QueueHandle_t queue;
+  uint32_t queued;
+  uint32_t coalesced;                 // signals merged into a pending identical event
+  uint32_t dropped;                   // signals lost by queue overflow
+  uint32_t peak;                      // max queue fill level
+  } event_lane_info_t;
+
+/**
+ * OvmsEventEntry: interned event
+ *  Holds the resolved dispatch list (exact, prefix and "*" listeners) and
+ *  the dispatch statistics. Entries are never freed, so the name can be
+ *  referenced by pointer.
+ */
+class OvmsEventEntry
+  {
+  public:
+    OvmsEventEntry(event_id_t id, const std::string& name);
+
+  public:
+    void AddTime(uint32_t us);
+
+  public:
+    event_id_t m_id;
+    std::string m_name;
+    event_lane_t m_lane;
+    std::vector<EventCallbackEntry*> m_dispatch;
+    bool m_coalesce;                    // ticker.* & config.changed: coalesce identical pending signals
+    uint16_t m_queued;                  // coalescable signals pending in the queue
+    void* m_queued_data;                // data of the last pending signal
+    uint32_t m_count;
+    uint32_t m_time_max;                // us
+    uint64_t m_time_sum;                // us
+    uint32_t m_hist[EVENT_LATENCY_BUCKETS];
+  };
+
+typedef std::vector<OvmsEventEntry*> EventEntryVector;
+typedef std::unordered_map<std::string, event_id_t> EventIdMap;
+
 typedef void (*event_signal_done_fn)(const char* event, void* data);
 
 extern void EventStdFree(const char* event, void* data);
@@ -75,9 +136,12 @@ typedef struct
     {
     struct
       {
-      char* event;
+      char* event;                    // name, owned by the message if id == EVENT_ID_NONE
       void* data;
       event_signal_done_fn donefn;
+      event_id_t id;
+      uint8_t lane;
+      bool coalesce;                  // counted in OvmsEventEntry::m_queued
       } signal;
     } body;
   event_msg_t type;
@@ -96,27 +160,46 @@ class OvmsEvents
     void DeregisterEvent(std::string caller);
     void SignalEvent(std::string event, void* data, event_signal_done_fn callback = NULL, uint32_t delay_ms = 0);
     void SignalEvent(std::string event, void* data, size_t length, uint32_t delay_ms = 0);
+    void SignalEvent(event_id_t id, void* data, event_signal_done_fn callback = NULL, uint32_t delay_ms = 0);
+
+  public:
+    event_id_t GetEventId(const std::string& event);
+    OvmsEventEntry* GetEntry(event_id_t id);
+    size_t GetEntryCount() { return m_events.size(); }
+    OvmsEventEntry* GetOtherEntry() { return &m_other; }
 
   public:
     void EventTask();
     void HandleQueueSignalEvent(event_queue_t* msg);
     void FreeQueueSignalEvent(event_queue_t* msg);
+    bool SendQueueSignalEvent(event_queue_t* msg, const char* from);
+    static event_lane_t GetLane(const char* event);
     static esp_err_t ReceiveSystemEvent(void *ctx, system_event_t *event);
     void SignalSystemEvent(system_event_t *event);
     const EventMap& Map() { return m_map; }
 
   protected:
     bool ScheduleEvent(event_queue_t* msg, uint32_t delay_ms);
+    void QueueSignalEvent(event_queue_t* msg, uint32_t delay_ms);
+    OvmsEventEntry* InternEvent(const std::string& event);
+    OvmsEventEntry* AutoInternEvent(const std::string& event);
+    void ResolveDispatch(OvmsEventEntry* entry);
 
   protected:
-    EventMap m_map;
+    EventMap m_map;                     // registrations by event name or prefix pattern ("x.y.*")
+    std::vector<std::string> m_prefixes; // registered prefix patterns except "*"
+    EventEntryVector m_events;          // interned events by id
+    EventIdMap m_ids;                   // interned events by name
+    size_t m_autointerned;
+    OvmsEventEntry m_other;             // dispatch & statistics for events not interned
+    OvmsMutex m_mutex;                  // protects registrations & interned events
     TimerList m_timers;
     OvmsMutex m_timers_mutex;
 
   public:
     bool m_trace;
     TaskHandle_t m_taskid;
-    QueueHandle_t m_taskqueue;
+    event_lane_info_t m_lanes[EVENT_LANE_COUNT];
 
   public:
     EventCallbackEntry* m_current_callback;
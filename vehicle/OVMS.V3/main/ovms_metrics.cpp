@@ -39,7 +39,9 @@ static const char *TAG = "metrics";
 #include "ovms_command.h"
 #include "ovms_events.h"
 #include "ovms_script.h"
+#include "ovms_malloc.h"
 #include "rom/rtc.h"
+#include "esp_timer.h"
 #include "string.h"
 
 using namespace std;
@@ -250,6 +252,30 @@ void metrics_trace(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc
   writer->printf("Metric tracing is now %s\n",cmd->GetName());
   }
 
+void metrics_journal(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  writer->printf("Metrics: %u, journal slots used: %u/%u\n",
+    MyMetrics.Count(), MyMetrics.GetSlotsUsed(), METRICS_MAX_SLOTS);
+
+  int cnt = 0;
+  for (size_t modifier = 0; modifier < METRICS_MAX_MODIFIERS; modifier++)
+    {
+    OvmsMetricJournal* j = MyMetrics.GetJournal(modifier);
+    if (!j) continue;
+    if (cnt++ == 0)
+      writer->puts("Caller           Mod  Last: checked/sent    Rounds  Avg: checked/sent  Resyncs");
+    writer->printf("%-16.16s %3u  %13u/%-6u %7u  %12.1f/%-6.1f %7u\n",
+      j->m_caller, j->m_modifier,
+      j->m_last_checked, j->m_last_delivered,
+      j->m_rounds,
+      j->m_rounds ? (float)j->m_total_checked / j->m_rounds : 0.0f,
+      j->m_rounds ? (float)j->m_total_delivered / j->m_rounds : 0.0f,
+      j->m_resyncs);
+    }
+  if (cnt == 0)
+    writer->puts("No journals registered.");
+  }
+
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
 
 static duk_ret_t DukOvmsMetricValue(duk_context *ctx)
@@ -369,13 +395,23 @@ OvmsMetrics::OvmsMetrics()
 
   m_nextmodifier = 1;
   m_first = NULL;
+  m_generation = 0;
+  m_index = NULL;
+  m_index_used = 0;
+  m_index_deleted = 0;
   m_trace = false;
+  for (int i = 0; i < METRICS_MAX_MODIFIERS; i++)
+    m_journals[i] = NULL;
+  m_journalmask = 0;
+  m_slots = NULL;
+  m_slots_used = 0;
 
   // Register our commands
   OvmsCommand* cmd_metric = MyCommandApp.RegisterCommand("metrics","METRICS framework");
   cmd_metric->RegisterCommand("list","Show all metrics", metrics_list, "[<metric>] [-ps]", 0, 2);
   cmd_metric->RegisterCommand("persist","Show persistent metrics info", metrics_persist, "[-r]", 0, 1);
   cmd_metric->RegisterCommand("set","Set the value of a metric",metrics_set, "<metric> <value>", 2, 2);
+  cmd_metric->RegisterCommand("journal","Show metrics change journal statistics",metrics_journal);
   OvmsCommand* cmd_metrictrace = cmd_metric->RegisterCommand("trace","METRIC trace framework");
   cmd_metrictrace->RegisterCommand("on","Turn metric tracing ON",metrics_trace);
   cmd_metrictrace->RegisterCommand("off","Turn metric tracing OFF",metrics_trace);
@@ -394,7 +430,7 @@ OvmsMetrics::OvmsMetrics()
   if (rtc_get_reset_reason(0) == POWERON_RESET || !pmetrics_check())
     pmetrics_init();
   ESP_LOGI(TAG, "Persistent metrics serial %u using %d bytes",
-      pmetrics.serial++, sizeof(pmetrics));
+      pmetrics.serial++, (int)sizeof(pmetrics));
 
   // Register our event
   #undef bind  // Kludgy, but works
@@ -412,60 +448,242 @@ OvmsMetrics::~OvmsMetrics()
     m = m->m_next;
     delete c;
     }
+  if (m_index)
+    free(m_index);
+  for (auto& retired : m_index_retired)
+    free(retired.second);
+  if (m_slots)
+    free(m_slots);
   }
 
 void OvmsMetrics::RegisterMetric(OvmsMetric* metric)
   {
-  // Quick simple check for if we are the first metric.
-  if (m_first == NULL)
+  OvmsRecMutexLock lock(&m_mutex);
+
+  // Insert into the ordered list before the first metric with a name >= ours,
+  // locating the predecessor by binary search on the sorted mirror array:
+  size_t pos = SortedFind(metric->m_name);
+  if (pos == 0)
     {
+    metric->m_next = m_first;
     m_first = metric;
-    return;
     }
+  else
+    {
+    OvmsMetric* prev = m_sorted[pos-1];
+    metric->m_next = prev->m_next;
+    prev->m_next = metric;
+    }
+  m_sorted.insert(m_sorted.begin() + pos, metric);
+
+  IndexInsert(metric);
 
-  // Now, check if we are before the first
-  if (strcmp(m_first->m_name,metric->m_name)>=0)
+  // Assign a journal slot, reusing freed slots first:
+  if (!m_slots)
+    m_slots = (OvmsMetric**) ExternalRamCalloc(METRICS_MAX_SLOTS, sizeof(OvmsMetric*));
+  if (!m_slots_free.empty())
     {
-    metric->m_next = m_first;
-    m_first = metric;
-    return;
+    metric->m_slot = m_slots_free.back();
+    m_slots_free.pop_back();
+    }
+  else if (m_slots && m_slots_used < METRICS_MAX_SLOTS)
+    {
+    metric->m_slot = m_slots_used++;
     }
+  if (metric->m_slot >= 0)
+    m_slots[metric->m_slot] = metric;
+  }
 
-  // Search for the correct place to insert
-  for (OvmsMetric*m = m_first; m!=NULL; m=m->m_next)
+void OvmsMetrics::DeregisterMetric(OvmsMetric* metric)
+  {
+  OvmsRecMutexLock lock(&m_mutex);
+  size_t pos;
+  for (pos = SortedFind(metric->m_name); pos < m_sorted.size(); pos++)
     {
-    if (m->m_next == NULL)
-      {
-      m->m_next = metric;
-      return;
-      }
-    if (strcmp(m->m_next->m_name,metric->m_name)>=0)
+    if (m_sorted[pos] == metric)
+      break;
+    if (strcmp(m_sorted[pos]->m_name, metric->m_name) != 0)
+      return; // not registered
+    }
+  if (pos == m_sorted.size())
+    return; // not registered
+
+  if (pos == 0)
+    m_first = metric->m_next;
+  else
+    m_sorted[pos-1]->m_next = metric->m_next;
+  m_sorted.erase(m_sorted.begin() + pos);
+  m_generation++;
+
+  if (metric->m_slot >= 0)
+    {
+    m_slots[metric->m_slot] = NULL;
+    m_slots_free.push_back(metric->m_slot);
+    metric->m_slot = -1;
+    }
+
+  IndexRemove(metric);
+  delete metric;
+  }
+
+/**
+ * SortedFind: binary search for the first metric with a name >= name
+ *  (returns the index into m_sorted, m_sorted.size() if none)
+ */
+size_t OvmsMetrics::SortedFind(const char* name)
+  {
+  size_t lo = 0, hi = m_sorted.size();
+  while (lo < hi)
+    {
+    size_t mid = (lo + hi) / 2;
+    if (strcmp(m_sorted[mid]->m_name, name) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+    }
+  return lo;
+  }
+
+static inline uint32_t metric_hash(const char* name)
+  {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  while (*name)
+    {
+    h ^= (uint8_t) *name++;
+    h *= 16777619u;
+    }
+  return h;
+  }
+
+OvmsMetric* OvmsMetrics::GetByPosition(size_t pos)
+  {
+  OvmsRecMutexLock lock(&m_mutex);
+  return (pos < m_sorted.size()) ? m_sorted[pos] : NULL;
+  }
+
+/**
+ * Hash index: lookups by Find() run lock free, (de)registrations are
+ *  serialized by m_mutex. A slot only ever changes by a single pointer store,
+ *  removed metrics leave a deletion marker. Resizing builds a new table and
+ *  publishes it by swapping m_index; the old table is freed after a grace
+ *  period, so a concurrent lookup can finish probing it.
+ */
+static char metric_index_deleted;
+#define METRIC_INDEX_DELETED ((OvmsMetric*)&metric_index_deleted)
+
+/**
+ * IndexSlot: return the hash slot holding name, or the free slot it would take
+ */
+OvmsMetric** OvmsMetrics::IndexSlot(index_t* index, const char* name)
+  {
+  size_t mask = index->size - 1;
+  size_t i = metric_hash(name) & mask;
+  OvmsMetric** reuse = NULL;
+  OvmsMetric* m;
+  while ((m = index->slot[i]) != NULL)
+    {
+    if (m == METRIC_INDEX_DELETED)
       {
-      metric->m_next = m->m_next;
-      m->m_next = metric;
-      return;
+      if (!reuse) reuse = &index->slot[i];
       }
+    else if (strcmp(m->m_name, name) == 0)
+      return &index->slot[i];
+    i = (i + 1) & mask;
     }
+  return reuse ? reuse : &index->slot[i];
   }
 
-void OvmsMetrics::DeregisterMetric(OvmsMetric* metric)
+bool OvmsMetrics::IndexResize(size_t size)
   {
-  if (m_first == metric)
+  index_t* old = m_index.load();
+  index_t* index = (index_t*) ExternalRamCalloc(1, sizeof(index_t) + size * sizeof(OvmsMetric*));
+  if (index == NULL)
     {
-    m_first = metric->m_next;
-    delete metric;
-    return;
+    ESP_LOGE(TAG, "IndexResize: out of memory for %u slots", (unsigned)size);
+    return false;
     }
+  index->size = size;
 
-  for (OvmsMetric* m=m_first;m!=NULL;m=m->m_next)
+  if (old)
     {
-    if (m->m_next == metric)
+    for (size_t i = 0; i < old->size; i++)
       {
-      m->m_next = metric->m_next;
-      delete metric;
+      if (old->slot[i] && old->slot[i] != METRIC_INDEX_DELETED)
+        *IndexSlot(index, old->slot[i]->m_name) = old->slot[i];
+      }
+    }
+  m_index_deleted = 0;
+  m_index.store(index, std::memory_order_release);
+
+  // Retire the old table, free tables retired before the grace period:
+  int64_t now = esp_timer_get_time();
+  auto it = m_index_retired.begin();
+  while (it != m_index_retired.end())
+    {
+    if (now - it->first > METRICS_INDEX_GRACE)
+      {
+      free(it->second);
+      it = m_index_retired.erase(it);
+      }
+    else
+      ++it;
+    }
+  if (old)
+    m_index_retired.push_back(std::make_pair(now, old));
+  return true;
+  }
+
+void OvmsMetrics::IndexInsert(OvmsMetric* metric)
+  {
+  // Keep the load factor including deletion markers below 3/4; grow if the
+  //  metrics alone exceed half of that, else just rebuild without markers:
+  index_t* index = m_index.load();
+  size_t size = index ? index->size : 0;
+  if ((m_index_used + m_index_deleted + 1) * 4 > size * 3)
+    {
+    if (IndexResize(((m_index_used + 1) * 8 > size * 3) ? (size ? size * 2 : 256) : size))
+      index = m_index.load();
+    else if (!index || m_index_used + m_index_deleted + 1 >= size)
+      {
+      ESP_LOGE(TAG, "IndexInsert: metric '%s' not indexed", metric->m_name);
       return;
       }
     }
+
+  // Duplicate names: like the list scan did, Find() shall return the latest
+  OvmsMetric** slot = IndexSlot(index, metric->m_name);
+  if (*slot == NULL)
+    m_index_used++;
+  else if (*slot == METRIC_INDEX_DELETED)
+    {
+    m_index_used++;
+    m_index_deleted--;
+    }
+  __atomic_store_n(slot, metric, __ATOMIC_RELEASE);
+  }
+
+void OvmsMetrics::IndexRemove(OvmsMetric* metric)
+  {
+  index_t* index = m_index.load();
+  if (!index)
+    return;
+  OvmsMetric** slot = IndexSlot(index, metric->m_name);
+  if (*slot != metric)
+    return;
+
+  // Another metric registered under the same name takes over the slot:
+  size_t pos = SortedFind(metric->m_name);
+  if (pos < m_sorted.size() && strcmp(m_sorted[pos]->m_name, metric->m_name) == 0)
+    {
+    __atomic_store_n(slot, m_sorted[pos], __ATOMIC_RELEASE);
+    return;
+    }
+
+  // Leave a deletion marker to keep the probe sequences intact:
+  __atomic_store_n(slot, METRIC_INDEX_DELETED, __ATOMIC_RELEASE);
+  m_index_used--;
+  m_index_deleted++;
   }
 
 bool OvmsMetrics::Set(const char* metric, const char* value)
@@ -506,9 +724,16 @@ bool OvmsMetrics::SetFloat(const char* metric, float value)
 
 OvmsMetric* OvmsMetrics::Find(const char* metric)
   {
-  for (OvmsMetric* m=m_first; m != NULL; m=m->m_next)
+  index_t* index = m_index.load(std::memory_order_acquire);
+  if (!index) return NULL;
+  size_t mask = index->size - 1;
+  size_t i = metric_hash(metric) & mask;
+  OvmsMetric* m;
+  while ((m = __atomic_load_n(&index->slot[i], __ATOMIC_ACQUIRE)) != NULL)
     {
-    if (strcmp(m->m_name,metric)==0) return m;
+    if (m != METRIC_INDEX_DELETED && strcmp(m->m_name, metric) == 0)
+      return m;
+    i = (i + 1) & mask;
     }
   return NULL;
   }
@@ -669,6 +894,148 @@ size_t OvmsMetrics::RegisterModifier()
   return m_nextmodifier++;
   }
 
+/**
+ * RegisterJournal: get the change journal for a modifier, create if necessary
+ *  Journals live as long as their modifier, i.e. are never freed.
+ */
+OvmsMetricJournal* OvmsMetrics::RegisterJournal(const char* caller, size_t modifier)
+  {
+  if (modifier >= METRICS_MAX_MODIFIERS)
+    {
+    ESP_LOGE(TAG, "RegisterJournal: %s: invalid modifier %u", caller, (unsigned)modifier);
+    return NULL;
+    }
+  if (!m_journals[modifier])
+    {
+    m_journals[modifier] = new OvmsMetricJournal(caller, modifier);
+    m_journalmask.fetch_or(1u << modifier);
+    ESP_LOGD(TAG, "RegisterJournal: %s: modifier %u", caller, (unsigned)modifier);
+    }
+  return m_journals[modifier];
+  }
+
+void OvmsMetrics::JournalModified(OvmsMetric* metric)
+  {
+  uint32_t mask = m_journalmask;
+  while (mask)
+    {
+    int modifier = __builtin_ctz(mask);
+    mask &= mask - 1;
+    m_journals[modifier]->Mark(metric->m_slot);
+    }
+  }
+
+OvmsMetricJournal::OvmsMetricJournal(const char* caller, size_t modifier)
+  {
+  m_caller = caller;
+  m_modifier = modifier;
+  for (int i = 0; i < METRICS_MAX_SLOTS/32; i++)
+    m_bits[i] = 0;
+  m_resync = true;  // catch up on modifications done before registration
+  m_inround = false;
+  m_resyncing = false;
+  m_word = 0;
+  m_pending = 0;
+  m_round_checked = m_round_delivered = 0;
+  m_last_checked = m_last_delivered = 0;
+  m_rounds = m_total_checked = m_total_delivered = 0;
+  m_resyncs = 0;
+  }
+
+/**
+ * Clear: drop all journal entries, i.e. after a full transmission
+ *  Call before sending & clearing the modifier flags, so modifications
+ *  done in parallel will be caught by the next round.
+ */
+void OvmsMetricJournal::Clear()
+  {
+  m_resync = false;
+  for (int i = 0; i < METRICS_MAX_SLOTS/32; i++)
+    m_bits[i] = 0;
+  m_inround = false;
+  m_resyncing = false;
+  m_word = 0;
+  m_pending = 0;
+  }
+
+/**
+ * Next: get the next candidate metric of the current round
+ *  Returns NULL at the end of the round, the next call starts a new round.
+ */
+OvmsMetric* OvmsMetricJournal::Next()
+  {
+  if (!m_inround)
+    {
+    m_inround = true;
+    m_round_checked = m_round_delivered = 0;
+    if (m_resync.exchange(false))
+      {
+      for (int i = 0; i < METRICS_MAX_SLOTS/32; i++)
+        m_bits[i] = 0;
+      m_cursor.Reset();
+      m_resyncing = true;
+      m_resyncs++;
+      }
+    }
+
+  OvmsMetric* m = NULL;
+  if (m_resyncing)
+    {
+    m = m_cursor.Get();
+    if (m)
+      m_cursor.Next();
+    }
+  else
+    {
+    size_t words = (MyMetrics.GetSlotsUsed() + 31) / 32;
+    while (!m)
+      {
+      while (m_pending == 0 && m_word < words)
+        m_pending = m_bits[m_word++].exchange(0);
+      if (m_pending == 0)
+        break;
+      int bit = __builtin_ctz(m_pending);
+      m_pending &= m_pending - 1;
+      m = MyMetrics.GetBySlot((m_word-1) * 32 + bit);
+      }
+    }
+
+  if (m)
+    {
+    m_round_checked++;
+    return m;
+    }
+
+  // end of round:
+  m_inround = false;
+  m_resyncing = false;
+  m_word = 0;
+  m_last_checked = m_round_checked;
+  m_last_delivered = m_round_delivered;
+  m_rounds++;
+  m_total_checked += m_round_checked;
+  m_total_delivered += m_round_delivered;
+  return NULL;
+  }
+
+/**
+ * NextModified: get the next metric of the current round modified
+ *  for our modifier, clearing the modifier flag
+ */
+OvmsMetric* OvmsMetricJournal::NextModified()
+  {
+  OvmsMetric* m;
+  while ((m = Next()) != NULL)
+    {
+    if (m->IsModifiedAndClear(m_modifier))
+      {
+      m_round_delivered++;
+      return m;
+      }
+    }
+  return NULL;
+  }
+
 OvmsMetric::OvmsMetric(const char* name, uint16_t autostale, metric_unit_t units, bool persist)
   {
   m_defined = NeverDefined;
@@ -679,6 +1046,7 @@ OvmsMetric::OvmsMetric(const char* name, uint16_t autostale, metric_unit_t units
   m_units = units;
   m_next = NULL;
   m_persist = persist;
+  m_slot = -1;
   MyMetrics.RegisterMetric(this);
   }
 
@@ -711,6 +1079,15 @@ std::string OvmsMetric::AsJSON(const char* defvalue, metric_unit_t units, int pr
   return buf;
   }
 
+/**
+ * AppendJSON: append the default JSON representation to buf
+ *  (overloaded by the scalar types to avoid temporary strings)
+ */
+void OvmsMetric::AppendJSON(std::string& buf)
+  {
+  buf.append(AsJSON());
+  }
+
 float OvmsMetric::AsFloat(const float defvalue, metric_unit_t units)
   {
   return defvalue;
@@ -756,6 +1133,7 @@ void OvmsMetric::SetModified(bool changed)
   if (changed)
     {
     m_modified = ULONG_MAX;
+    MyMetrics.JournalModified(this);
     MyMetrics.NotifyModified(this);
     }
   }
@@ -871,6 +1249,18 @@ std::string OvmsMetricInt::AsJSON(const char* defvalue, metric_unit_t units, int
     return std::string((defvalue && *defvalue) ? defvalue : "0");
   }
 
+void OvmsMetricInt::AppendJSON(std::string& buf)
+  {
+  if (IsDefined())
+    {
+    char buffer[33];
+    itoa(m_value, buffer, 10);
+    buf.append(buffer);
+    }
+  else
+    buf.append("0");
+  }
+
 float OvmsMetricInt::AsFloat(const float defvalue, metric_unit_t units)
   {
   return (float)AsInt((int)defvalue, units);
@@ -973,6 +1363,11 @@ std::string OvmsMetricBool::AsJSON(const char* defvalue, metric_unit_t units, in
     }
   }
 
+void OvmsMetricBool::AppendJSON(std::string& buf)
+  {
+  buf.append((IsDefined() && m_value) ? "true" : "false");
+  }
+
 float OvmsMetricBool::AsFloat(const float defvalue, metric_unit_t units)
   {
   return (float)AsBool((bool)defvalue);
@@ -1096,6 +1491,19 @@ std::string OvmsMetricFloat::AsJSON(const char* defvalue, metric_unit_t units, i
     return std::string((defvalue && *defvalue) ? defvalue : "0");
   }
 
+void OvmsMetricFloat::AppendJSON(std::string& buf)
+  {
+  if (IsDefined())
+    {
+    // %g matches the default std::ostream float format used by AsString()
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%g", m_value);
+    buf.append(buffer);
+    }
+  else
+    buf.append("0");
+  }
+
 float OvmsMetricFloat::AsFloat(const float defvalue, metric_unit_t units)
   {
   if (IsDefined())
@@ -1180,6 +1588,17 @@ std::string OvmsMetricString::AsString(const char* defvalue, metric_unit_t units
     }
   }
 
+void OvmsMetricString::AppendJSON(std::string& buf)
+  {
+  buf.append("\"");
+  if (IsDefined())
+    {
+    OvmsMutexLock lock(&m_mutex);
+    json_encode_append(buf, m_value);
+    }
+  buf.append("\"");
+  }
+
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
 void OvmsMetricString::DukPush(DukContext &dc)
   {
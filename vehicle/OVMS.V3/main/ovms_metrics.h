@@ -49,6 +49,8 @@
 #endif
 
 #define METRICS_MAX_MODIFIERS 32
+#define METRICS_MAX_SLOTS     4096      // journal slots; metrics beyond this force a journal resync
+#define METRICS_INDEX_GRACE   1000000   // replaced hash tables are freed after this time [us]
 
 using namespace std;
 
@@ -126,6 +128,7 @@ class OvmsMetric
     virtual std::string AsString(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
     std::string AsUnitString(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
     virtual std::string AsJSON(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
+    virtual void AppendJSON(std::string& buf);
     virtual float AsFloat(const float defvalue = 0, metric_unit_t units = Other);
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
     virtual void DukPush(DukContext &dc);
@@ -158,6 +161,7 @@ class OvmsMetric
     metric_defined_t m_defined;
     bool m_stale;
     bool m_persist;
+    int m_slot;                         // journal slot, -1 = none
   };
 
 class OvmsMetricBool : public OvmsMetric
@@ -169,6 +173,7 @@ class OvmsMetricBool : public OvmsMetric
   public:
     std::string AsString(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
     virtual std::string AsJSON(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
+    void AppendJSON(std::string& buf);
     float AsFloat(const float defvalue = 0, metric_unit_t units = Other);
     int AsBool(const bool defvalue = false);
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
@@ -193,6 +198,7 @@ class OvmsMetricInt : public OvmsMetric
   public:
     std::string AsString(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
     virtual std::string AsJSON(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
+    void AppendJSON(std::string& buf);
     float AsFloat(const float defvalue = 0, metric_unit_t units = Other);
     int AsInt(const int defvalue = 0, metric_unit_t units = Other);
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
@@ -217,6 +223,7 @@ class OvmsMetricFloat : public OvmsMetric
   public:
     std::string AsString(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
     virtual std::string AsJSON(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
+    void AppendJSON(std::string& buf);
     float AsFloat(const float defvalue = 0, metric_unit_t units = Other);
     int AsInt(const int defvalue = 0, metric_unit_t units = Other);
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
@@ -243,6 +250,7 @@ class OvmsMetricString : public OvmsMetric
 
   public:
     std::string AsString(const char* defvalue = "", metric_unit_t units = Other, int precision = -1);
+    void AppendJSON(std::string& buf);
 #ifdef CONFIG_OVMS_SC_JAVASCRIPT_DUKTAPE
     void DukPush(DukContext &dc);
 #endif
@@ -676,6 +684,8 @@ class MetricCallbackEntry
 typedef std::list<MetricCallbackEntry*> MetricCallbackList;
 typedef std::map<const char*, MetricCallbackList*, CmpStrOp> MetricCallbackMap;
 
+class OvmsMetricJournal;
+
 class OvmsMetrics
   {
   public:
@@ -742,11 +752,144 @@ class OvmsMetrics
   protected:
     size_t m_nextmodifier;
 
+  public:
+    OvmsMetricJournal* RegisterJournal(const char* caller, size_t modifier);
+    OvmsMetricJournal* GetJournal(size_t modifier)
+      { return (modifier < METRICS_MAX_MODIFIERS) ? m_journals[modifier] : NULL; }
+    void JournalModified(OvmsMetric* metric);
+    OvmsMetric* GetBySlot(size_t slot) { return (slot < m_slots_used) ? m_slots[slot] : NULL; }
+    size_t GetSlotsUsed() { return m_slots_used; }
+
+  protected:
+    OvmsMetricJournal* m_journals[METRICS_MAX_MODIFIERS];
+    std::atomic<uint32_t> m_journalmask;  // bit set = journal registered for modifier
+    OvmsMetric** m_slots;               // slot → metric, NULL = free
+    size_t m_slots_used;                // slot high water mark
+    std::vector<uint16_t> m_slots_free;
+
+  protected:
+    typedef struct
+      {
+      size_t size;                      // number of slots (power of 2)
+      OvmsMetric* slot[];               // open addressing: name → metric
+      } index_t;
+    static OvmsMetric** IndexSlot(index_t* index, const char* name);
+    void IndexInsert(OvmsMetric* metric);
+    void IndexRemove(OvmsMetric* metric);
+    bool IndexResize(size_t size);
+    size_t SortedFind(const char* name);
+
+  protected:
+    OvmsRecMutex m_mutex;               // serializes (de)registrations & m_sorted access
+    std::atomic<index_t*> m_index;      // hash table, replaced by a single pointer swap
+    size_t m_index_used;                // slots holding a metric
+    size_t m_index_deleted;             // slots holding a deletion marker
+    std::vector< std::pair<int64_t, index_t*> > m_index_retired; // replaced tables & retire time
+    std::vector<OvmsMetric*> m_sorted;  // metrics ordered by name (mirrors m_first list)
+
+  public:
+    size_t Count() { return m_sorted.size(); }
+    OvmsMetric* GetByPosition(size_t pos);
+
   public:
     OvmsMetric* m_first;
+    uint32_t m_generation;              // incremented on every metric deregistration
     bool m_trace;
   };
 
 extern OvmsMetrics MyMetrics;
 
+/**
+ * OvmsMetricCursor: resumable position in the metrics list
+ *  Can be kept across chunked transmissions, so a full walk stays linear.
+ *  After a metric deregistration, the cursor re-seeks by position instead of
+ *  following a possibly deleted metric.
+ */
+class OvmsMetricCursor
+  {
+  public:
+    OvmsMetricCursor() { Reset(); }
+
+  public:
+    void Reset()
+      {
+      m_metric = MyMetrics.m_first;
+      m_pos = 0;
+      m_generation = MyMetrics.m_generation;
+      }
+    OvmsMetric* Get()
+      {
+      if (m_generation != MyMetrics.m_generation)
+        {
+        m_metric = MyMetrics.GetByPosition(m_pos);
+        m_generation = MyMetrics.m_generation;
+        }
+      return m_metric;
+      }
+    void Next()
+      {
+      if (Get())
+        {
+        m_metric = m_metric->m_next;
+        m_pos++;
+        }
+      }
+    size_t GetPosition() { return m_pos; }
+
+  protected:
+    OvmsMetric* m_metric;
+    size_t m_pos;
+    uint32_t m_generation;
+  };
+
+/**
+ * OvmsMetricJournal: per modifier change journal
+ *  OvmsMetric::SetModified() marks the metric slot in the journal bitmap of
+ *  every registered modifier, so a consumer only needs to check the metrics
+ *  marked since its last round instead of scanning the full metrics list.
+ *  Marking is lock free; there must only be one consumer per journal.
+ *  The modifier flags stay authoritative: NextModified() still checks and
+ *  clears them, journal entries are just candidates.
+ */
+class OvmsMetricJournal
+  {
+  public:
+    OvmsMetricJournal(const char* caller, size_t modifier);
+
+  public:
+    void Mark(int slot)
+      {
+      if (slot < 0)
+        m_resync = true;
+      else
+        m_bits[slot >> 5].fetch_or(1u << (slot & 31));
+      }
+    void Clear();
+    OvmsMetric* Next();
+    OvmsMetric* NextModified();
+
+  public:
+    const char* m_caller;
+    size_t m_modifier;
+
+  protected:
+    std::atomic<uint32_t> m_bits[METRICS_MAX_SLOTS/32];
+    std::atomic<bool> m_resync;         // full scan needed (initially or on slot shortage)
+    bool m_inround;
+    bool m_resyncing;
+    size_t m_word;                      // next bitmap word to fetch
+    uint32_t m_pending;                 // fetched but unprocessed bits of word m_word-1
+    OvmsMetricCursor m_cursor;          // full scan position while resyncing
+
+  public:
+    uint32_t m_round_checked;           // current round statistics
+    uint32_t m_round_delivered;
+    uint32_t m_last_checked;            // last completed round statistics
+    uint32_t m_last_delivered;
+    uint32_t m_rounds;                  // totals
+    uint32_t m_total_checked;
+    uint32_t m_total_delivered;
+    uint32_t m_resyncs;
+  };
+
 #endif //#ifndef __METRICS_H__
@@ -286,7 +286,7 @@ uint32_t OvmsNotifyType::QueueEntry(OvmsNotifyEntry* entry)
     event.append(m_name);
     event.append(".");
     event.append(entry->m_subtype);
-    MyEvents.SignalEvent(event, (void*)id);
+    MyEvents.SignalEvent(event, (void*)(intptr_t)id);
     }
 
   // Dispatch the callbacks...
@@ -589,7 +589,7 @@ uint32_t OvmsNotify::NotifyString(const char* type, const char* subtype, const c
     }
   if (readers.count() == 0)
     {
-    ESP_LOGD(TAG, "Abort: no readers for type '%s' subtype '%s' size %d", type, subtype, size);
+    ESP_LOGD(TAG, "Abort: no readers for type '%s' subtype '%s' size %d", type, subtype, (int)size);
     return 0;
     }
 
@@ -597,7 +597,7 @@ uint32_t OvmsNotify::NotifyString(const char* type, const char* subtype, const c
   OvmsNotifyEntry* msg = (OvmsNotifyEntry*) new OvmsNotifyEntryString(subtype, value);
   msg->m_pendingreaders = readers.to_ulong();
 
-  ESP_LOGD(TAG, "Created entry type '%s' subtype '%s' size %d has %d readers pending", type, subtype, size, readers.count());
+  ESP_LOGD(TAG, "Created entry type '%s' subtype '%s' size %d has %d readers pending", type, subtype, (int)size, (int)readers.count());
 
   return mt->QueueEntry(msg);
   }
@@ -157,13 +157,12 @@ std::string hexdecode(const std::string encval);
 
 /**
  * json_encode: encode string for JSON transport (see http://www.json.org/)
+ *  json_encode_append() appends to an existing buffer.
  */
 template <class src_string>
-std::string json_encode(const src_string text)
+void json_encode_append(std::string& buf, const src_string& text)
   {
-  std::string buf;
   char hex[10];
-  buf.reserve(text.size() + (text.size() >> 3));
   for (int i=0; i<text.size(); i++)
     {
     switch(text[i])
@@ -188,6 +187,14 @@ std::string json_encode(const src_string text)
         break;
       }
     }
+  }
+
+template <class src_string>
+std::string json_encode(const src_string text)
+  {
+  std::string buf;
+  buf.reserve(text.size() + (text.size() >> 3));
+  json_encode_append(buf, text);
 	return buf;
   }
 
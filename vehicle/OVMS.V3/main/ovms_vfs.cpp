@@ -44,6 +44,7 @@ static const char *TAG = "vfs";
 #include "ovms_vfs.h"
 #include "ovms_config.h"
 #include "ovms_command.h"
+#include "ovms_events.h"
 #include "ovms_peripherals.h"
 #include "crypt_md5.h"
 
@@ -240,7 +241,10 @@ void vfs_mv(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const
     return;
     }
   if (rename(argv[0],argv[1]) == 0)
-    { writer->puts("VFS File renamed"); }
+    {
+    writer->puts("VFS File renamed");
+    MyEvents.SignalEvent("system.vfs.file.changed", (void*)argv[1], strlen(argv[1])+1);
+    }
   else
     { writer->puts("Error: Could not rename VFS file"); }
   }
@@ -254,7 +258,10 @@ void vfs_mkdir(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
     }
 
   if (mkdir(argv[0],0) == 0)
-    { writer->puts("VFS directory created"); }
+    {
+    writer->puts("VFS directory created");
+    MyEvents.SignalEvent("system.vfs.file.changed", (void*)argv[0], strlen(argv[0])+1);
+    }
   else
     { writer->puts("Error: Could not create VFS directory"); }
   }
@@ -268,7 +275,10 @@ void vfs_rmdir(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, co
     }
 
   if (rmdir(argv[0]) == 0)
-    { writer->puts("VFS directory removed"); }
+    {
+    writer->puts("VFS directory removed");
+    MyEvents.SignalEvent("system.vfs.file.changed", (void*)argv[0], strlen(argv[0])+1);
+    }
   else
     { writer->puts("Error: Could not remove VFS directory"); }
   }
@@ -34,6 +34,10 @@ static const char *TAG = "test";
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <math.h>
+#include <algorithm>
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_event_loop.h"
@@ -44,8 +48,24 @@ static const char *TAG = "test";
 #include "ovms_script.h"
 #include "metrics_standard.h"
 #include "ovms_config.h"
+#include "ovms_malloc.h"
+#include "ovms_buffer.h"
+#include "string_writer.h"
 #include "can.h"
+#include "canformat.h"
+#include "canformat_crtd.h"
+#include "canformat_raw.h"
+#include "canlog.h"
+#include "canlog_vfs.h"
+#include "canplay_vfs.h"
+#include "dbc.h"
 #include "strverscmp.h"
+#include "vehicle.h"
+
+#ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
+#include "lwip/sockets.h"
+#include "canlog_tcpserver.h"
+#endif // #ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
 
 void test_deepsleep(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
   {
@@ -231,8 +251,8 @@ void test_spiram(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
   {
   writer->printf("Metrics (%p) are in %s RAM (%d bytes for a base metric)\n",
     StandardMetrics.ms_m_version,
-    (((unsigned int)StandardMetrics.ms_m_version >= 0x3f800000)&&
-     ((unsigned int)StandardMetrics.ms_m_version <= 0x3fbfffff))?
+    (((uintptr_t)StandardMetrics.ms_m_version >= 0x3f800000)&&
+     ((uintptr_t)StandardMetrics.ms_m_version <= 0x3fbfffff))?
      "SPI":"INTERNAL",
      sizeof(OvmsMetric));
   }
@@ -359,6 +379,2457 @@ void test_string(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc,
   writer->puts("finished");
   }
 
+typedef struct
+  {
+  std::vector<const char*> keys;      // names of metrics staying registered
+  volatile bool run;
+  volatile bool done;
+  uint32_t lookups;
+  uint32_t misses;
+  } test_metrics_reader_t;
+
+static void test_metrics_readertask(void* context)
+  {
+  test_metrics_reader_t* t = (test_metrics_reader_t*) context;
+  size_t k = 0;
+  while (t->run)
+    {
+    if (MyMetrics.Find(t->keys[k]) == NULL)
+      t->misses++;
+    t->lookups++;
+    if (++k == t->keys.size())
+      k = 0;
+    }
+  t->done = true;
+  vTaskDelete(NULL);
+  }
+
+void test_metrics(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  std::vector<int> sizes;
+  if (argc > 0)
+    {
+    for (int i = 0; i < argc; i++)
+      sizes.push_back(atoi(argv[i]));
+    }
+  else
+    {
+    sizes = { 200, 1000, 3000 };
+    }
+  const int lookups = 20000;
+
+  // Concurrent lookups of the existing metrics while the registry grows,
+  //  shrinks & resizes its hash table:
+  test_metrics_reader_t reader;
+  for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+    reader.keys.push_back(m->m_name);
+  reader.run = true;
+  reader.done = false;
+  reader.lookups = reader.misses = 0;
+  if (!reader.keys.empty())
+    xTaskCreatePinnedToCore(test_metrics_readertask, "OVMS TestMetrics", 4096, &reader, 5, NULL, CORE(0));
+  else
+    reader.done = true;
+
+  for (int size : sizes)
+    {
+    // Fill up the registry with dummy metrics:
+    int extra = size - (int)MyMetrics.Count();
+    if (extra < 0) extra = 0;
+    char* names = (char*) ExternalRamMalloc(extra * 16 + 1);
+    std::vector<OvmsMetric*> dummies;
+    for (int i = 0; i < extra; i++)
+      {
+      char* name = names + i * 16;
+      snprintf(name, 16, "x.test.m%05d", i % 100000);
+      dummies.push_back(new OvmsMetricInt(name));
+      }
+
+    std::vector<const char*> keys;
+    for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+      keys.push_back(m->m_name);
+    int nkeys = keys.size();
+    int found = 0;
+
+    // Hash index lookup:
+    int64_t started = esp_timer_get_time();
+    for (int k = 0; k < lookups; k++)
+      {
+      if (MyMetrics.Find(keys[(k * 7919) % nkeys]))
+        found++;
+      }
+    int64_t elapsed_index = esp_timer_get_time() - started;
+
+    // Reference: linear list scan as done previously:
+    int scans = lookups / 20;
+    started = esp_timer_get_time();
+    for (int k = 0; k < scans; k++)
+      {
+      const char* key = keys[(k * 7919) % nkeys];
+      for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+        {
+        if (strcmp(m->m_name, key) == 0) { found++; break; }
+        }
+      }
+    int64_t elapsed_scan = esp_timer_get_time() - started;
+
+    writer->printf("%5d metrics: Find %lld ns/op, list scan %lld ns/op (%d/%d found)\n",
+      nkeys, elapsed_index * 1000 / lookups, elapsed_scan * 1000 / scans,
+      found, lookups + scans);
+
+    for (OvmsMetric* m : dummies)
+      MyMetrics.DeregisterMetric(m);
+    free(names);
+    }
+
+  reader.run = false;
+  while (!reader.done)
+    vTaskDelay(1);
+  writer->printf("Concurrent reader: %u lookups, %u misses\n", reader.lookups, reader.misses);
+  if (reader.misses)
+    writer->printf("Error: %u lookups of registered metrics failed during (de)registrations\n", reader.misses);
+  }
+
+void test_metricsjson(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int size = (argc > 0) ? atoi(argv[0]) : 2000;
+  int clients = (argc > 1) ? atoi(argv[1]) : 5;
+  const size_t chunksize = 1024;   // = XFER_CHUNK_SIZE of the websocket handler
+  if (clients < 1) clients = 1;
+
+  // Fill up the registry with dummy metrics of all scalar types:
+  int extra = size - (int)MyMetrics.Count();
+  if (extra < 0) extra = 0;
+  char* names = (char*) ExternalRamMalloc(extra * 16 + 1);
+  std::vector<OvmsMetric*> dummies;
+  for (int i = 0; i < extra; i++)
+    {
+    char* name = names + i * 16;
+    snprintf(name, 16, "x.test.j%05d", i % 100000);
+    switch (i % 4)
+      {
+      case 0: { OvmsMetricInt* m = new OvmsMetricInt(name); m->SetValue(i); dummies.push_back(m); break; }
+      case 1: { OvmsMetricFloat* m = new OvmsMetricFloat(name); m->SetValue(i * 0.37f); dummies.push_back(m); break; }
+      case 2: { OvmsMetricBool* m = new OvmsMetricBool(name); m->SetValue((bool)(i & 8)); dummies.push_back(m); break; }
+      default: { OvmsMetricString* m = new OvmsMetricString(name); m->SetValue("test \"value\""); dummies.push_back(m); break; }
+      }
+    }
+  writer->printf("Dumping %d metrics to %d clients in %u byte chunks...\n",
+    (int)MyMetrics.Count(), clients, chunksize);
+
+  // Reference: index skip from list head per chunk & AsJSON():
+  size_t bytes_ref = 0;
+  int chunks_ref = 0;
+  int64_t started = esp_timer_get_time();
+  for (int c = 0; c < clients; c++)
+    {
+    int sent = 0, i;
+    OvmsMetric* m;
+    do
+      {
+      for (i=0, m=MyMetrics.m_first; i < sent && m != NULL; m=m->m_next, i++);
+      std::string msg;
+      msg.reserve(2*chunksize+128);
+      msg = "{\"metrics\":{";
+      for (i=0; m && msg.size() < chunksize; m=m->m_next, i++)
+        {
+        if (i) msg += ',';
+        msg += '\"';
+        msg += m->m_name;
+        msg += "\":";
+        msg += m->AsJSON();
+        }
+      msg += "}}";
+      sent += i;
+      bytes_ref += msg.size();
+      chunks_ref++;
+      } while (m);
+    }
+  int64_t elapsed_ref = esp_timer_get_time() - started;
+
+  // Cursor & AppendJSON():
+  size_t bytes_cur = 0;
+  int chunks_cur = 0;
+  started = esp_timer_get_time();
+  for (int c = 0; c < clients; c++)
+    {
+    OvmsMetricCursor cursor;
+    OvmsMetric* m = cursor.Get();
+    do
+      {
+      std::string msg;
+      msg.reserve(2*chunksize+128);
+      msg = "{\"metrics\":{";
+      for (int i=0; m && msg.size() < chunksize; cursor.Next(), m=cursor.Get(), i++)
+        {
+        if (i) msg += ',';
+        msg += '\"';
+        msg += m->m_name;
+        msg += "\":";
+        m->AppendJSON(msg);
+        }
+      msg += "}}";
+      bytes_cur += msg.size();
+      chunks_cur++;
+      } while (m);
+    }
+  int64_t elapsed_cur = esp_timer_get_time() - started;
+
+  writer->printf("Index & AsJSON:      %lld ms, %d chunks, %u bytes\n", elapsed_ref / 1000, chunks_ref, bytes_ref);
+  writer->printf("Cursor & AppendJSON: %lld ms, %d chunks, %u bytes\n", elapsed_cur / 1000, chunks_cur, bytes_cur);
+
+  for (OvmsMetric* m : dummies)
+    MyMetrics.DeregisterMetric(m);
+  free(names);
+  }
+
+void test_metricsjournal(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int size = (argc > 0) ? atoi(argv[0]) : 2000;
+  int changes = (argc > 1) ? atoi(argv[1]) : 20;
+  int loops = (argc > 2) ? atoi(argv[2]) : 100;
+  if (changes < 1) changes = 1;
+  if (loops < 1) loops = 1;
+
+  // Use a private modifier, kept across test runs (modifiers are a limited resource):
+  static size_t modifier = 0;
+  if (modifier == 0)
+    modifier = MyMetrics.RegisterModifier();
+  OvmsMetricJournal* journal = MyMetrics.RegisterJournal("test", modifier);
+  if (!journal)
+    {
+    writer->puts("ERROR: no journal available");
+    return;
+    }
+
+  int extra = size - (int)MyMetrics.Count();
+  if (extra < 0) extra = 0;
+  char* names = (char*) ExternalRamMalloc(extra * 16 + 1);
+  std::vector<OvmsMetricInt*> dummies;
+  for (int i = 0; i < extra; i++)
+    {
+    char* name = names + i * 16;
+    snprintf(name, 16, "x.test.k%05d", i % 100000);
+    dummies.push_back(new OvmsMetricInt(name));
+    }
+  if (dummies.empty())
+    {
+    writer->puts("ERROR: registry already holds the requested number of metrics");
+    free(names);
+    return;
+    }
+  if (changes > (int)dummies.size())
+    changes = dummies.size();
+  writer->printf("Collecting %d changes from %d metrics, %d rounds...\n",
+    changes, (int)MyMetrics.Count(), loops);
+
+  // Expected deliveries: distinct dummies changed per round (values are
+  //  unique over the run, so every SetValue() is a modification):
+  int expected = 0;
+  std::vector<bool> hit(dummies.size());
+  for (int k = 0; k < loops; k++)
+    {
+    std::fill(hit.begin(), hit.end(), false);
+    for (int i = 0; i < changes; i++)
+      {
+      size_t pos = (k * 7919 + i * 104729) % dummies.size();
+      if (!hit[pos])
+        expected++;
+      hit[pos] = true;
+      }
+    }
+
+  // Settle: clear all pending modifications for our modifier
+  for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+    m->ClearModified(modifier);
+  journal->Clear();
+
+  // Reference: full list scan per round:
+  int found_scan = 0;
+  int64_t elapsed_scan = 0;
+  for (int k = 0; k < loops; k++)
+    {
+    for (int i = 0; i < changes; i++)
+      dummies[(k * 7919 + i * 104729) % dummies.size()]->SetValue(k * changes + i + 1);
+    int64_t started = esp_timer_get_time();
+    for (OvmsMetric* m = MyMetrics.m_first; m != NULL; m = m->m_next)
+      {
+      // Only count our dummies, system metrics may change concurrently:
+      if (m->IsModifiedAndClear(modifier) && strncmp(m->m_name, "x.test.k", 8) == 0)
+        found_scan++;
+      }
+    elapsed_scan += esp_timer_get_time() - started;
+    }
+  journal->Clear();
+
+  // Journal:
+  int found_journal = 0;
+  int64_t elapsed_journal = 0;
+  for (int k = 0; k < loops; k++)
+    {
+    for (int i = 0; i < changes; i++)
+      dummies[(k * 7919 + i * 104729) % dummies.size()]->SetValue(-(k * changes + i + 1));
+    int64_t started = esp_timer_get_time();
+    OvmsMetric* m;
+    while ((m = journal->NextModified()) != NULL)
+      {
+      if (strncmp(m->m_name, "x.test.k", 8) == 0)
+        found_journal++;
+      }
+    elapsed_journal += esp_timer_get_time() - started;
+    }
+
+  writer->printf("List scan: %lld us/round, %d metrics delivered\n", elapsed_scan / loops, found_scan);
+  writer->printf("Journal:   %lld us/round, %d metrics delivered, last round %u checked\n",
+    elapsed_journal / loops, found_journal, journal->m_last_checked);
+  if (found_scan != expected || found_journal != expected)
+    writer->printf("ERROR: %d metric changes expected\n", expected);
+
+  for (OvmsMetric* m : dummies)
+    MyMetrics.DeregisterMetric(m);
+  free(names);
+  }
+
+/**
+ * test_load_crtd: load up to <maxframes> frames from a CRTD trace file
+ */
+static bool test_load_crtd(const char* path, std::vector<CAN_log_message_t>& trace, size_t maxframes)
+  {
+  FILE* f = fopen(path, "r");
+  if (f == NULL)
+    return false;
+  canformat* crtd = MyCanFormatFactory.NewFormat("crtd");
+  crtd->SetServeMode(canformat::Simulate);
+  CAN_log_message_t msg;
+  uint8_t buf[256];
+  size_t len = 0, pos = 0;
+  while (trace.size() < maxframes)
+    {
+    memset(&msg, 0, sizeof(msg));
+    size_t used = crtd->put(&msg, buf + pos, len - pos);
+    pos += used;
+    if (msg.frame.origin != NULL)
+      trace.push_back(msg);
+    else if (used == 0)
+      {
+      len = fread(buf, 1, sizeof(buf), f);
+      pos = 0;
+      if (len == 0) break;
+      }
+    }
+  fclose(f);
+  delete crtd;
+  return true;
+  }
+
+/**
+ * test_canformat_crtd_legacy: the CRTD formatter as it was before the
+ *  buffer API (std::string per message), kept as the benchmark reference
+ */
+static std::string test_canformat_crtd_legacy(CAN_log_message_t* message)
+  {
+  char buf[CANFORMAT_CRTD_MAXLEN];
+  char *p;
+
+  char busnumber;
+  if (message->origin != NULL)
+    { busnumber = message->origin->m_busnumber + '1'; }
+  else
+    { busnumber = '1'; }
+
+  switch (message->type)
+    {
+    case CAN_LogFrame_RX:
+    case CAN_LogFrame_TX:
+      snprintf(buf,sizeof(buf),"%ld.%06ld %c%c%s %0*X",
+        message->timestamp.tv_sec, message->timestamp.tv_usec,
+        busnumber,
+        (message->type == CAN_LogFrame_RX) ? 'R' : 'T',
+        (message->frame.FIR.B.FF == CAN_frame_std) ? "11":"29",
+        (message->frame.FIR.B.FF == CAN_frame_std) ? 3 : 8,
+        message->frame.MsgID);
+      p = buf+strlen(buf);
+      for (int k=0; k<message->frame.FIR.B.DLC; k++)
+        {
+        *p++ = ' ';
+        p = HexByte(p,message->frame.data.u8[k]);
+        }
+      *p = 0;
+      break;
+
+    case CAN_LogInfo_Comment:
+    case CAN_LogInfo_Config:
+    case CAN_LogInfo_Event:
+      snprintf(buf,sizeof(buf),"%ld.%06ld %c%s %s %s",
+        message->timestamp.tv_sec, message->timestamp.tv_usec,
+        busnumber,
+        (message->type == CAN_LogInfo_Event) ? "CEV" : "CXX",
+        GetCanLogTypeName(message->type),
+        message->text);
+      break;
+
+    default:
+      buf[0] = 0;
+      break;
+    }
+
+  strcat(buf,"\n");
+  return std::string(buf);
+  }
+
+void test_canformat(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loops = (argc > 2) ? atoi(argv[2]) : 10;
+  canformat* fmt = MyCanFormatFactory.NewFormat(argv[0]);
+  if (fmt == NULL)
+    {
+    writer->printf("Error: unknown format '%s'\n", argv[0]);
+    return;
+    }
+  canbus* bus = MyCan.GetBus(0);
+  if (bus == NULL)
+    {
+    writer->puts("Error: can1 not available");
+    delete fmt;
+    return;
+    }
+
+  // Load trace (CRTD) or generate synthetic frames:
+  std::vector<CAN_log_message_t> trace;
+  CAN_log_message_t msg;
+  if (argc > 1)
+    {
+    if (!test_load_crtd(argv[1], trace, 2000))
+      {
+      writer->printf("Error: cannot open '%s'\n", argv[1]);
+      delete fmt;
+      return;
+      }
+    }
+  else
+    {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    for (int k = 0; k < 1000; k++)
+      {
+      memset(&msg, 0, sizeof(msg));
+      msg.type = CAN_LogFrame_RX;
+      msg.timestamp = tv;
+      msg.timestamp.tv_usec = (k * 500) % 1000000;
+      msg.frame.origin = bus;
+      msg.frame.FIR.B.FF = CAN_frame_std;
+      msg.frame.FIR.B.DLC = 8;
+      msg.frame.MsgID = 0x100 + (k % 64);
+      msg.frame.data.u64 = 0x0123456789abcdefULL * k;
+      trace.push_back(msg);
+      }
+    }
+  if (trace.empty())
+    {
+    writer->puts("Error: no frames loaded");
+    delete fmt;
+    return;
+    }
+  int frames = trace.size() * loops;
+  writer->printf("Formatting %d frames as %s...\n", frames, argv[0]);
+
+  // Pre-change reference: std::string result per message (CRTD only):
+  bool legacy = (strcmp(argv[0], "crtd") == 0);
+  size_t bytes_str = 0;
+  int mismatches = 0;
+  int64_t started, elapsed_str = 0;
+  if (legacy)
+    {
+    started = esp_timer_get_time();
+    for (int l = 0; l < loops; l++)
+      {
+      for (CAN_log_message_t& m : trace)
+        {
+        std::string result = test_canformat_crtd_legacy(&m);
+        bytes_str += result.length();
+        }
+      }
+    elapsed_str = esp_timer_get_time() - started;
+    char buf[CANFORMAT_GET_MAXLEN];
+    for (CAN_log_message_t& m : trace)
+      {
+      size_t len = fmt->get(&m, buf, sizeof(buf));
+      if (test_canformat_crtd_legacy(&m) != std::string(buf, len))
+        mismatches++;
+      }
+    }
+
+  // Formatting into a reusable batch buffer:
+  size_t bytes_buf = 0;
+  char* batch = (char*) ExternalRamMalloc(CANLOG_BATCH_SIZE);
+  size_t batchlen = 0;
+  started = esp_timer_get_time();
+  for (int l = 0; l < loops; l++)
+    {
+    for (CAN_log_message_t& m : trace)
+      {
+      if (CANLOG_BATCH_SIZE - batchlen < CANFORMAT_GET_MAXLEN)
+        batchlen = 0;
+      size_t len = fmt->get(&m, batch + batchlen, CANLOG_BATCH_SIZE - batchlen);
+      batchlen += len;
+      bytes_buf += len;
+      }
+    }
+  int64_t elapsed_buf = esp_timer_get_time() - started;
+  free(batch);
+
+  // Raw: records must round trip with the fixed record size:
+  int roundtrip_errors = 0;
+  if (strcmp(argv[0], "raw") == 0)
+    {
+    char rec[sizeof(canformat_raw_record_t)+1];
+    fmt->SetServeMode(canformat::Simulate);
+    for (CAN_log_message_t& m : trace)
+      {
+      // Store at an odd offset to verify unaligned access:
+      size_t len = fmt->get(&m, rec+1, sizeof(rec)-1);
+      memset(&msg, 0, sizeof(msg));
+      if (len != sizeof(canformat_raw_record_t)
+        || fmt->put(&msg, (uint8_t*)rec+1, len) != len
+        || msg.type != m.type
+        || msg.timestamp.tv_sec != m.timestamp.tv_sec
+        || msg.timestamp.tv_usec != m.timestamp.tv_usec
+        || msg.frame.origin != m.frame.origin
+        || msg.frame.MsgID != m.frame.MsgID
+        || msg.frame.data.u64 != m.frame.data.u64)
+        roundtrip_errors++;
+      }
+    writer->printf("raw record: %u bytes, %d round trip errors\n",
+      (unsigned)sizeof(canformat_raw_record_t), roundtrip_errors);
+    }
+  delete fmt;
+
+  if (legacy)
+    writer->printf("pre-change:  %lld ms = %lld frames/s (%u bytes)\n",
+      elapsed_str / 1000, (int64_t)frames * 1000000 / (elapsed_str ? elapsed_str : 1), bytes_str);
+  else
+    writer->puts("pre-change:  reference only available for crtd");
+  writer->printf("buffer:      %lld ms = %lld frames/s (%u bytes)\n",
+    elapsed_buf / 1000, (int64_t)frames * 1000000 / (elapsed_buf ? elapsed_buf : 1), bytes_buf);
+  if (mismatches)
+    writer->printf("Error: %d frames formatted differently from the pre-change path\n", mismatches);
+  if (roundtrip_errors)
+    writer->printf("Error: %d raw records did not round trip\n", roundtrip_errors);
+  }
+
+void test_canplay(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  const char* path = (argc > 0) ? argv[0] : "/store/canplaytest.crtd";
+  int frames = (argc > 1) ? atoi(argv[1]) : 200;
+  if (frames < 10) frames = 10;
+  const uint32_t gap = 3000; // frame spacing [us]
+
+  // Write a CRTD trace with comment & event runs exceeding the formatter
+  //  buffer between the frames, ending with frames still buffered at EOF:
+  FILE* f = fopen(path, "w");
+  if (f == NULL)
+    {
+    writer->printf("Error: cannot write '%s'\n", path);
+    return;
+    }
+  fprintf(f, "1000000000.000000 CXX OVMS CRTD\n");
+  for (int k = 0; k < frames; k++)
+    {
+    if ((k % 50) == 25)
+      {
+      for (int c = 0; c < 30; c++)
+        fprintf(f, "1000000000.000000 CXX comment line %02d of a run exceeding the formatter buffer\n", c);
+      fprintf(f, "1000000000.000000 CEV vehicle.test.event\n");
+      }
+    uint64_t ts = 1000000000ULL * 1000000 + (uint64_t)k * gap;
+    fprintf(f, "%u.%06u 1R11 %03x %02x %02x\n", (uint32_t)(ts / 1000000), (uint32_t)(ts % 1000000),
+      k & 0x7ff, k & 0xff, (k >> 8) & 0xff);
+    }
+  fclose(f);
+
+  // Parse: every frame must be delivered in order:
+  canplay_vfs* player = new canplay_vfs(path, "crtd");
+  int got = 0, bad = 0;
+  CAN_log_message_t msg;
+  if (player->Open())
+    {
+    while (player->InputMsg(&msg))
+      {
+      uint64_t ts = 1000000000ULL * 1000000 + (uint64_t)got * gap;
+      if (msg.frame.MsgID != (uint32_t)(got & 0x7ff) ||
+          msg.frame.data.u8[0] != (got & 0xff) ||
+          (uint64_t)msg.timestamp.tv_sec * 1000000 + msg.timestamp.tv_usec != ts)
+        bad++;
+      got++;
+      }
+    player->Close();
+    }
+  writer->printf("Replay parse: %d/%d frames, %d mismatched\n", got, frames, bad);
+  if (got != frames || bad)
+    writer->puts("Error: replay lost or corrupted frames");
+
+  // Pace: replay in real time through the player task:
+  if (player->Open())
+    {
+    player->Start();
+    int64_t timeout = esp_timer_get_time() + (int64_t)frames * gap + 5000000;
+    while (player->m_endtime == 0 && esp_timer_get_time() < timeout)
+      vTaskDelay(10 / portTICK_PERIOD_MS);
+    writer->printf("Replay pacing: %s\n", player->GetStats().c_str());
+    if (player->m_msgcount != (uint32_t)frames)
+      writer->printf("Error: %u of %d frames played\n", player->m_msgcount, frames);
+    // Rounding to the nearest tick gives an average deviation of a quarter tick,
+    //  truncating gives half a tick:
+    uint32_t jitteravg = player->m_jittercount ? player->m_jittersum / player->m_jittercount : 0;
+    if (jitteravg > CANPLAY_TICK_US*3/8 + 500)
+      writer->printf("Error: avg pacing jitter %u us exceeds %u us\n",
+        jitteravg, CANPLAY_TICK_US*3/8 + 500);
+    }
+  delete player;
+
+  // Stop: a 60 second gap in the trace must not delay stopping the player:
+  f = fopen(path, "w");
+  if (f == NULL)
+    {
+    writer->printf("Error: cannot write '%s'\n", path);
+    return;
+    }
+  for (int k = 0; k < 10; k++)
+    fprintf(f, "%u.%06u 1R11 100 %02x\n", 1000000000 + ((k < 5) ? 0 : 60), k * 1000, k);
+  fclose(f);
+  player = new canplay_vfs(path, "crtd");
+  if (player->Open())
+    {
+    player->Start();
+    int64_t timeout = esp_timer_get_time() + 1000000;
+    while (player->m_msgcount < 5 && esp_timer_get_time() < timeout)
+      vTaskDelay(10 / portTICK_PERIOD_MS);
+    vTaskDelay(100 / portTICK_PERIOD_MS);
+    int64_t started = esp_timer_get_time();
+    player->Stop();
+    int64_t elapsed = esp_timer_get_time() - started;
+    writer->printf("Replay stop : %u of 10 frames played, stopped in %lld ms, file %s\n",
+      player->m_msgcount, elapsed / 1000, player->IsOpen() ? "open" : "closed");
+    if (player->m_msgcount != 5 || elapsed > 100000 || player->IsOpen())
+      writer->puts("Error: expected 5 frames, stop within 100 ms, file closed");
+    }
+  delete player;
+  unlink(path);
+  }
+
+static void test_dbc_count(void* param, dbcSignal* signal, dbcNumber& value)
+  {
+  double* sum = (double*) param;
+  *sum += value.GetDouble();
+  }
+
+static void test_dbc_collect(void* param, dbcSignal* signal, dbcNumber& value)
+  {
+  std::map<std::string, double>* values = (std::map<std::string, double>*) param;
+  (*values)[signal->GetName()] = value.GetDouble();
+  }
+
+/**
+ * Value range check: scaled results exceeding 32 bits must not take the
+ *  integer path of the decode plan. Built without the parser, so it also
+ *  runs in builds without flex/bison.
+ */
+static void test_dbc_range(OvmsWriter* writer)
+  {
+  static const struct { const char* name; int start, size; char type; int32_t factor, offset; double expect; } sigs[] =
+    {
+    { "U32", 0, 32, '+', 4, 100, 4.0 * 0xffffffffULL + 100 },
+    { "S16", 32, 16, '-', 100000, 0, -32768.0 * 100000 },
+    { "U8", 48, 8, '+', 2, 1, 511 },
+    };
+  dbcfile* dbc = new dbcfile();
+  dbcMessage* msg = new dbcMessage(2047);
+  msg->SetSize(8);
+  for (auto& s : sigs)
+    {
+    dbcSignal* signal = new dbcSignal(s.name);
+    signal->SetStartSize(s.start, s.size);
+    signal->SetByteOrder(DBC_BYTEORDER_LITTLE_ENDIAN);
+    signal->SetValueType((dbcValueType_t)s.type);
+    signal->SetFactorOffset(dbcNumber(s.factor), dbcNumber(s.offset));
+    msg->AddSignal(signal);
+    }
+  dbc->m_messages.AddMessage(2047, msg);
+  dbc->m_messages.Compile();
+
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.FIR.B.FF = CAN_frame_std;
+  frame.FIR.B.DLC = 8;
+  frame.MsgID = 2047;
+  frame.data.u64 = 0x00ff8000ffffffffULL;
+  std::map<std::string, double> values;
+  msg = dbc->m_messages.FindMessage(frame.FIR.B.FF, frame.MsgID);
+  if (msg && msg->GetPlan())
+    msg->GetPlan()->Decode(&frame, test_dbc_collect, &values);
+  delete dbc;
+
+  int errors = 0;
+  writer->printf("Range check:");
+  for (auto& s : sigs)
+    {
+    writer->printf(" %s=%.0f", s.name, values[s.name]);
+    if (values[s.name] != s.expect) errors++;
+    }
+  writer->puts("");
+  if (errors)
+    writer->printf("Error: %d scaled values decoded wrong by the decode plan\n", errors);
+  }
+
+void test_dbc(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int nmessages = (argc > 0) ? atoi(argv[0]) : 256;
+  int loops = (argc > 2) ? atoi(argv[2]) : 10;
+  if (nmessages < 1 || nmessages > 1024) nmessages = 256;
+
+  test_dbc_range(writer);
+
+  // Generate DBC: 8 signals per message, mixed byte order, sign & scaling,
+  //  every 4th message multiplexed into 4 groups
+  std::string src = "VERSION \"test\"\n\n";
+  char line[160];
+  for (int k = 0; k < nmessages; k++)
+    {
+    uint32_t id = 0x100 + k;
+    snprintf(line, sizeof(line), "BO_ %u M%03X: 8 ECU\n", id, id);
+    src.append(line);
+    bool muxed = (k % 4) == 0;
+    if (muxed)
+      src.append(" SG_ MUX M : 0|2@1+ (1,0) [0|3] \"\" X\n");
+    for (int s = 0; s < 8; s++)
+      {
+      const char* mux = "";
+      char muxbuf[8];
+      if (muxed && s >= 2)
+        {
+        snprintf(muxbuf, sizeof(muxbuf), " m%d", s % 4);
+        mux = muxbuf;
+        }
+      if (s & 1)
+        snprintf(line, sizeof(line), " SG_ S%d%s : %d|8@0- (0.5,-40) [0|0] \"\" X\n", s, mux, s*8+7);
+      else
+        snprintf(line, sizeof(line), " SG_ S%d%s : %d|%d@1+ (1,0) [0|0] \"\" X\n", s, mux, s*8 + (muxed && s==0 ? 2 : 0), (muxed && s==0) ? 6 : 8);
+      src.append(line);
+      }
+    src.append("\n");
+    }
+  dbcfile* dbc = new dbcfile();
+  int64_t started = esp_timer_get_time();
+  bool loaded = dbc->LoadString("test", src.c_str(), src.length());
+  int64_t elapsed_load = esp_timer_get_time() - started;
+  src.clear();
+  src.shrink_to_fit();
+  if (!loaded)
+    {
+    writer->puts("Error: DBC parsing failed");
+    delete dbc;
+    return;
+    }
+  writer->printf("DBC: %d messages loaded & compiled in %lld ms\n", nmessages, elapsed_load / 1000);
+
+  // Load trace (CRTD) or generate synthetic frames:
+  std::vector<CAN_log_message_t> trace;
+  if (argc > 1)
+    {
+    if (!test_load_crtd(argv[1], trace, 2000))
+      {
+      writer->printf("Error: cannot open '%s'\n", argv[1]);
+      delete dbc;
+      return;
+      }
+    }
+  else
+    {
+    CAN_log_message_t msg;
+    for (int k = 0; k < 1000; k++)
+      {
+      memset(&msg, 0, sizeof(msg));
+      msg.type = CAN_LogFrame_RX;
+      msg.frame.FIR.B.FF = CAN_frame_std;
+      msg.frame.FIR.B.DLC = 8;
+      msg.frame.MsgID = 0x100 + (esp_random() % nmessages);
+      msg.frame.data.u64 = ((uint64_t)esp_random() << 32) | esp_random();
+      trace.push_back(msg);
+      }
+    }
+  if (trace.empty())
+    {
+    writer->puts("Error: no frames loaded");
+    delete dbc;
+    return;
+    }
+  writer->printf("Decoding %d frames...\n", (int)trace.size() * loops);
+
+  // Signal by signal decoding via map lookup:
+  int signals_sig = 0;
+  double sum_sig = 0;
+  started = esp_timer_get_time();
+  for (int l = 0; l < loops; l++)
+    {
+    for (CAN_log_message_t& m : trace)
+      {
+      CAN_frame_t* frame = &m.frame;
+      uint32_t key = (frame->FIR.B.FF == CAN_frame_ext) ? (frame->MsgID | 0x80000000) : frame->MsgID;
+      auto it = dbc->m_messages.m_entrymap.find(key);
+      if (it == dbc->m_messages.m_entrymap.end())
+        continue;
+      dbcMessage* msg = it->second;
+      dbcSignal* mux = msg->GetMultiplexorSignal();
+      uint32_t muxval = 0;
+      if (mux)
+        muxval = mux->Decode(frame).GetSignedInteger();
+      for (dbcSignal* sig : msg->m_signals)
+        {
+        if ((mux==NULL)||(!sig->IsMultiplexSwitch())||(sig->GetMultiplexSwitchvalue() == muxval))
+          {
+          sum_sig += sig->Decode(frame).GetDouble();
+          signals_sig++;
+          }
+        }
+      }
+    }
+  int64_t elapsed_sig = esp_timer_get_time() - started;
+
+  // Precompiled decode plans via index lookup:
+  int signals_plan = 0;
+  double sum_plan = 0;
+  started = esp_timer_get_time();
+  for (int l = 0; l < loops; l++)
+    {
+    for (CAN_log_message_t& m : trace)
+      {
+      dbcMessage* msg = dbc->m_messages.FindMessage(m.frame.FIR.B.FF, m.frame.MsgID);
+      if (msg)
+        signals_plan += msg->GetPlan()->Decode(&m.frame, test_dbc_count, &sum_plan);
+      }
+    }
+  int64_t elapsed_plan = esp_timer_get_time() - started;
+
+  delete dbc;
+
+  writer->printf("Signal::Decode: %lld ms = %lld signals/s (%d signals)\n",
+    elapsed_sig / 1000, (int64_t)signals_sig * 1000000 / (elapsed_sig ? elapsed_sig : 1), signals_sig);
+  writer->printf("Decode plan:    %lld ms = %lld signals/s (%d signals)\n",
+    elapsed_plan / 1000, (int64_t)signals_plan * 1000000 / (elapsed_plan ? elapsed_plan : 1), signals_plan);
+  writer->printf("Checksums: %.1f / %.1f (differ on signed signals)\n", sum_sig, sum_plan);
+
+  }
+
+/**
+ * Poller sweep test: simulated ECUs on a virtual bus answer every 16 bit PID
+ *  request with a two frame ISO-TP response after a fixed latency.
+ */
+class PollSimBus : public canbus
+  {
+  public:
+    PollSimBus() : canbus("simcan") { m_latency = 20; }
+
+  public:
+    esp_err_t Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait=0);
+
+  public:
+    std::multimap<int64_t, CAN_frame_t> m_responses;  // Scheduled ECU responses by due time
+    int m_latency;                                    // ECU response latency [ms]
+  };
+
+esp_err_t PollSimBus::Write(const CAN_frame_t* p_frame, TickType_t maxqueuewait)
+  {
+  CAN_frame_t rx;
+  memset(&rx, 0, sizeof(rx));
+  rx.origin = this;
+  rx.MsgID = p_frame->MsgID + 8;
+  rx.FIR.B.FF = CAN_frame_std;
+  rx.FIR.B.DLC = 8;
+  int64_t due = esp_timer_get_time();
+  if ((p_frame->data.u8[0] >> 4) == ISOTP_FT_FLOWCTRL)
+    {
+    // Consecutive frame: remaining 3 payload bytes
+    rx.data.u8[0] = (ISOTP_FT_CONSECUTIVE << 4) + 1;
+    rx.data.u8[1] = 0x44;
+    rx.data.u8[2] = 0x55;
+    rx.data.u8[3] = 0x66;
+    due += 1000;
+    }
+  else
+    {
+    // First frame: 9 bytes = response type, PID, 6 data bytes
+    rx.data.u8[0] = ISOTP_FT_FIRST << 4;
+    rx.data.u8[1] = 9;
+    rx.data.u8[2] = 0x40 + p_frame->data.u8[1];
+    rx.data.u8[3] = p_frame->data.u8[2];
+    rx.data.u8[4] = p_frame->data.u8[3];
+    rx.data.u8[5] = 0x11;
+    rx.data.u8[6] = 0x22;
+    rx.data.u8[7] = 0x33;
+    due += m_latency * 1000LL;
+    }
+  m_responses.insert(std::make_pair(due, rx));
+  return ESP_OK;
+  }
+
+class PollSimVehicle : public OvmsVehicle
+  {
+  public:
+    PollSimVehicle() { m_replies = 0; }
+
+  public:
+    int64_t Sweep(PollSimBus* bus, const poll_pid_t* plist, uint8_t concurrency);
+    int64_t Feed(PollSimBus* bus, const poll_pid_t* plist, const uint8_t* payload, int length, int* frames);
+    int Buffers(PollSimBus* bus, const poll_pid_t* plist, uint8_t concurrency);
+
+  protected:
+    void IncomingPollReply(canbus* bus, uint16_t type, uint16_t pid, uint8_t* data, uint8_t length, uint16_t mlremain)
+      {
+      if (mlremain == 0) m_replies++;
+      }
+    void IncomingPollResponse(canbus* bus, uint16_t type, uint16_t pid, const uint8_t* payload, size_t length)
+      {
+      m_response.assign((const char*)payload, length);
+      }
+
+  public:
+    int m_replies;
+    std::string m_response;
+  };
+
+int64_t PollSimVehicle::Sweep(PollSimBus* bus, const poll_pid_t* plist, uint8_t concurrency)
+  {
+  // Note: the vehicle is not ready, so neither the ticker nor the RX task interferes;
+  // the responses are fed to the poller directly when due.
+  bus->m_responses.clear();
+  PollSetPidList(bus, plist);
+  PollSetThrottling(0);
+  PollSetConcurrency(concurrency);
+  m_replies = 0;
+
+  int64_t started = esp_timer_get_time();
+  PollerSend(true);
+  while (!bus->m_responses.empty())
+    {
+    auto it = bus->m_responses.begin();
+    int64_t wait = it->first - esp_timer_get_time();
+    if (wait > 0)
+      vTaskDelay(pdMS_TO_TICKS(wait / 1000) + 1);
+    CAN_frame_t frame = it->second;
+    frame.timestamp = it->first;        // simulated capture time
+    bus->m_responses.erase(it);
+    PollerReceive(&frame);
+    }
+  int64_t elapsed = esp_timer_get_time() - started;
+
+  PollSetPidList(NULL, NULL);
+  return elapsed;
+  }
+
+/**
+ * Buffers: set up the poller & get the number of reassembly buffers available
+ *  before any response has been received (from the poller status)
+ */
+int PollSimVehicle::Buffers(PollSimBus* bus, const poll_pid_t* plist, uint8_t concurrency)
+  {
+  PollSetPidList(bus, plist);
+  PollSetConcurrency(concurrency);
+  StringWriter status;
+  PollerStatus(COMMAND_RESULT_MINIMAL, &status);
+  PollSetPidList(NULL, NULL);
+  size_t pos = status.rfind(", ");
+  return (pos != std::string::npos) ? atoi(status.c_str() + pos + 2) : -1;
+  }
+
+int64_t PollSimVehicle::Feed(PollSimBus* bus, const poll_pid_t* plist, const uint8_t* payload, int length, int* frames)
+  {
+  // Send the request, then replace the simulated response by a synthetic ISO-TP stream
+  // carrying the payload:
+  PollSetPidList(bus, plist);
+  PollSetThrottling(0);
+  PollSetConcurrency(1);
+  PollerSend(true);
+  bus->m_responses.clear();
+  m_replies = 0;
+  m_response.clear();
+
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.origin = bus;
+  frame.MsgID = plist->rxmoduleid;
+  frame.FIR.B.FF = CAN_frame_std;
+  frame.FIR.B.DLC = 8;
+
+  uint8_t header[3] = { (uint8_t)(0x40 + plist->type), (uint8_t)(plist->pid >> 8), (uint8_t)(plist->pid & 0xff) };
+  int tp_len = length + 3;
+  int pos, cnt;
+  int64_t elapsed = 0, started;
+  *frames = 1;
+  if (tp_len <= 7)
+    {
+    frame.data.u8[0] = (ISOTP_FT_SINGLE << 4) + tp_len;
+    memcpy(&frame.data.u8[1], header, 3);
+    memcpy(&frame.data.u8[4], payload, length);
+    started = esp_timer_get_time();
+    PollerReceive(&frame);
+    elapsed += esp_timer_get_time() - started;
+    }
+  else
+    {
+    frame.data.u8[0] = (ISOTP_FT_FIRST << 4) + (tp_len >> 8);
+    frame.data.u8[1] = tp_len & 0xff;
+    memcpy(&frame.data.u8[2], header, 3);
+    memcpy(&frame.data.u8[5], payload, 3);
+    started = esp_timer_get_time();
+    PollerReceive(&frame);
+    elapsed += esp_timer_get_time() - started;
+    for (pos = 3; pos < length; pos += cnt)
+      {
+      cnt = (length - pos > 7) ? 7 : length - pos;
+      memset(frame.data.u8, 0, 8);
+      frame.data.u8[0] = (ISOTP_FT_CONSECUTIVE << 4) + ((*frames) & 0x0f);
+      memcpy(&frame.data.u8[1], payload + pos, cnt);
+      started = esp_timer_get_time();
+      PollerReceive(&frame);
+      elapsed += esp_timer_get_time() - started;
+      (*frames)++;
+      }
+    }
+
+  bus->m_responses.clear();
+  PollSetPidList(NULL, NULL);
+  return elapsed;
+  }
+
+static PollSimBus* test_pollsimbus()
+  {
+  // The simulation bus is kept across test runs (buses cannot be unregistered):
+  static PollSimBus* bus = NULL;
+  if (!bus)
+    bus = new PollSimBus();
+  return bus;
+  }
+
+void test_pollsweep(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int entries = (argc > 0) ? atoi(argv[0]) : 40;
+  int ecus = (argc > 1) ? atoi(argv[1]) : 8;
+  int latency = (argc > 2) ? atoi(argv[2]) : 20;
+  if (entries < 1) entries = 1;
+  if (ecus < 1) ecus = 1;
+  if (ecus > VEHICLE_POLL_MAX_SLOTS) ecus = VEHICLE_POLL_MAX_SLOTS;
+  if (latency < 0) latency = 0;
+
+  if (MyVehicleFactory.ActiveVehicle())
+    {
+    writer->puts("Error: a vehicle module is loaded, please clear it first");
+    return;
+    }
+
+  PollSimBus* bus = test_pollsimbus();
+  bus->m_latency = latency;
+
+  // Poll list: entries distributed round robin across the ECUs, all due every tick:
+  OvmsVehicle::poll_pid_t* plist = (OvmsVehicle::poll_pid_t*) ExternalRamCalloc(entries + 1, sizeof(OvmsVehicle::poll_pid_t));
+  for (int i = 0; i < entries; i++)
+    {
+    OvmsVehicle::poll_pid_t* entry = &plist[i];
+    entry->txmoduleid = 0x700 + (i % ecus) * 0x10;
+    entry->rxmoduleid = entry->txmoduleid + 8;
+    entry->type = VEHICLE_POLL_TYPE_OBDIIEXTENDED;
+    entry->pid = 0x1000 + i;
+    for (int k = 0; k < VEHICLE_POLL_NSTATES; k++)
+      entry->polltime[k] = 1;
+    }
+
+  writer->printf("Sweeping %d poll entries across %d ECUs, %d ms response latency...\n",
+    entries, ecus, latency);
+
+  PollSimVehicle* vehicle = new PollSimVehicle();
+  int buffers_seq = vehicle->Buffers(bus, plist, 1);
+  int buffers_con = vehicle->Buffers(bus, plist, ecus);
+  int64_t elapsed_seq = vehicle->Sweep(bus, plist, 1);
+  int replies_seq = vehicle->m_replies;
+  int64_t elapsed_con = vehicle->Sweep(bus, plist, ecus);
+  int replies_con = vehicle->m_replies;
+  delete vehicle;
+  free(plist);
+
+  writer->printf("Sequential: %lld ms, %d responses\n", elapsed_seq / 1000, replies_seq);
+  writer->printf("Concurrent: %lld ms, %d responses (%d in flight max)\n", elapsed_con / 1000, replies_con, ecus);
+  writer->printf("Reassembly buffers on setup: %d sequential, %d concurrent\n", buffers_seq, buffers_con);
+  if (buffers_seq != 1 || buffers_con != ecus)
+    writer->printf("Error: expected 1 sequential and %d concurrent buffers\n", ecus);
+  }
+
+void test_isotp(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loops = (argc > 0) ? atoi(argv[0]) : 10;
+  if (loops < 1) loops = 1;
+
+  if (MyVehicleFactory.ActiveVehicle())
+    {
+    writer->puts("Error: a vehicle module is loaded, please clear it first");
+    return;
+    }
+
+  OvmsVehicle::poll_pid_t plist[2];
+  memset(plist, 0, sizeof(plist));
+  plist[0].txmoduleid = 0x7e0;
+  plist[0].rxmoduleid = 0x7e8;
+  plist[0].type = VEHICLE_POLL_TYPE_OBDIIEXTENDED;
+  plist[0].pid = 0x1234;
+  for (int k = 0; k < VEHICLE_POLL_NSTATES; k++)
+    plist[0].polltime[k] = 1;
+
+  // Payload lengths, excluding the 3 byte response header (4092 = ISO-TP maximum of 4095):
+  const int lengths[] = { 1, 4, 5, 6, 7, 13, 62, 255, 1000, 4092 };
+  uint8_t* payload = (uint8_t*) ExternalRamMalloc(4092);
+  PollSimBus* bus = test_pollsimbus();
+  PollSimVehicle* vehicle = new PollSimVehicle();
+  int failed = 0;
+
+  for (int length : lengths)
+    {
+    for (int i = 0; i < length; i++)
+      payload[i] = (i * 7 + length) & 0xff;
+    int frames = 0, ok = 0;
+    int64_t elapsed = 0;
+    for (int k = 0; k < loops; k++)
+      {
+      elapsed += vehicle->Feed(bus, plist, payload, length, &frames);
+      if (vehicle->m_replies == 1 && vehicle->m_response.size() == (size_t)length &&
+          memcmp(vehicle->m_response.data(), payload, length) == 0)
+        ok++;
+      }
+    writer->printf("%4d bytes, %3d frames: %s, %lld us/response\n",
+      length, frames, (ok == loops) ? "OK" : "FAILED", elapsed / loops);
+    if (ok != loops) failed++;
+    }
+
+  delete vehicle;
+  free(payload);
+  writer->printf("%s\n", failed ? "ERROR: reassembly failed" : "All payloads reassembled correctly");
+  }
+
+class BmsSimVehicle : public OvmsVehicle
+  {
+  public:
+    BmsSimVehicle(int cells)
+      {
+      BmsSetCellArrangementVoltage(cells, 12);
+      BmsSetCellLimitsVoltage(2.0, 5.0);
+      }
+    ~BmsSimVehicle()
+      {
+      BmsResetCellVoltages(true);
+      }
+
+  public:
+    void SetCellVoltage(int index, float value) { BmsSetCellVoltage(index, value); }
+    int AlertsNew() { return m_bms_valerts_new; }
+  };
+
+void test_bms(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int cells = (argc > 0) ? atoi(argv[0]) : 192;
+  int sweeps = (argc > 1) ? atoi(argv[1]) : 50;
+  if (cells < 2) cells = 2;
+  if (sweeps < 1) sweeps = 1;
+
+  if (MyVehicleFactory.ActiveVehicle())
+    {
+    writer->puts("Error: a vehicle module is loaded, please clear it first");
+    return;
+    }
+
+  writer->printf("Driving %d cells at 10 Hz for %d sweeps...\n", cells, sweeps);
+
+  BmsSimVehicle* vehicle = new BmsSimVehicle(cells);
+  float* values = (float*) ExternalRamMalloc(cells * sizeof(float));
+  int64_t total = 0, maxtime = 0, start, elapsed;
+  double sum = 0, sqrsum = 0;
+  int errors = 0;
+
+  for (int sweep = 0; sweep < sweeps; sweep++)
+    {
+    // Cell voltages around 3.9V with a slow drift, cell 0 deviating from sweep 10 on:
+    sum = sqrsum = 0;
+    for (int i = 0; i < cells; i++)
+      {
+      values[i] = 3.9f + 0.001f * ((i * 7 + sweep) % 13) + ((i == 0 && sweep >= 10) ? 0.1f : 0);
+      sum += values[i];
+      sqrsum += (double)values[i] * values[i];
+      }
+    start = esp_timer_get_time();
+    for (int i = 0; i < cells; i++)
+      vehicle->SetCellVoltage(i, values[i]);
+    elapsed = esp_timer_get_time() - start;
+    total += elapsed;
+    if (elapsed > maxtime) maxtime = elapsed;
+
+    // Cross check the incremental statistics against the full computation:
+    double avg = sum / cells;
+    double stddev = sqrt(std::max(sqrsum / cells - avg * avg, 0.0));
+    if (fabs(StdMetrics.ms_v_bat_pack_vavg->AsFloat() - avg) > 0.00002 ||
+        fabs(StdMetrics.ms_v_bat_pack_vstddev->AsFloat() - stddev) > 0.00002)
+      errors++;
+
+    vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+  writer->printf("CPU time per sweep: %lld us avg, %lld us max (%.2f us/cell, %.3f%% CPU at 10 Hz)\n",
+    total / sweeps, maxtime, (float)total / sweeps / cells, (float)total / sweeps / 1000);
+  writer->printf("Pack: avg %.5fV, stddev %.5fV, %d new alerts\n",
+    StdMetrics.ms_v_bat_pack_vavg->AsFloat(), StdMetrics.ms_v_bat_pack_vstddev->AsFloat(),
+    vehicle->AlertsNew());
+  writer->printf("%s\n", errors ? "ERROR: statistics mismatch" : "Statistics match full computation");
+
+  delete vehicle;
+  free(values);
+  }
+
+typedef struct
+  {
+  int task;
+  int changes;
+  volatile bool done;
+  } test_config_tx_t;
+
+static void test_config_txtask(void* context)
+  {
+  test_config_tx_t* t = (test_config_tx_t*) context;
+  for (int i = 0; i < t->changes; i++)
+    {
+    OvmsConfigTransaction transaction;
+    MyConfig.SetParamValueInt("test.config", "task." + std::to_string(t->task), i);
+    if ((i % 10) == 9)
+      vTaskDelay(1);
+    }
+  t->done = true;
+  while (1)
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+  }
+
+void test_config(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int changes = (argc > 0) ? atoi(argv[0]) : 10;
+  if (changes < 1) changes = 1;
+
+  if (!MyConfig.ismounted())
+    {
+    writer->puts("ERROR: config store not mounted");
+    return;
+    }
+
+  MyConfig.Flush();
+  MyConfig.RegisterParam("test.config", "Config write coalescing test", true, true);
+  uint32_t changes0, writes0;
+  int64_t started;
+
+  // Write-behind: a burst of changes within the write delay window
+  changes0 = MyConfig.m_stat_changes;
+  writes0 = MyConfig.m_stat_writes;
+  started = esp_timer_get_time();
+  for (int i = 0; i < changes; i++)
+    MyConfig.SetParamValueInt("test.config", "value", i);
+  int64_t elapsed_burst = esp_timer_get_time() - started;
+  MyConfig.Flush();
+  writer->printf("Write-behind: %u changes, %u file writes, %lld us/change\n",
+    MyConfig.m_stat_changes - changes0, MyConfig.m_stat_writes - writes0, elapsed_burst / changes);
+
+  // Transaction: changes to multiple instances
+  changes0 = MyConfig.m_stat_changes;
+  writes0 = MyConfig.m_stat_writes;
+  started = esp_timer_get_time();
+    {
+    OvmsConfigTransaction transaction;
+    for (int i = 0; i < changes; i++)
+      MyConfig.SetParamValueInt("test.config", "value." + std::to_string(i), i);
+    }
+  int64_t elapsed_trans = esp_timer_get_time() - started;
+  writer->printf("Transaction : %u changes, %u file writes, %lld us total\n",
+    MyConfig.m_stat_changes - changes0, MyConfig.m_stat_writes - writes0, elapsed_trans);
+
+  // Reference: one write per change
+  changes0 = MyConfig.m_stat_changes;
+  writes0 = MyConfig.m_stat_writes;
+  started = esp_timer_get_time();
+  for (int i = 0; i < changes; i++)
+    {
+    MyConfig.SetParamValueInt("test.config", "value", changes + i);
+    MyConfig.Flush();
+    }
+  int64_t elapsed_sync = esp_timer_get_time() - started;
+  writer->printf("Immediate   : %u changes, %u file writes, %lld us/change\n",
+    MyConfig.m_stat_changes - changes0, MyConfig.m_stat_writes - writes0, elapsed_sync / changes);
+
+  // Hot path read: lookup & parse vs. cached typed value
+  const int reads = 10000;
+  volatile int sum = 0;
+  started = esp_timer_get_time();
+  for (int i = 0; i < reads; i++)
+    sum += MyConfig.GetParamValueInt("test.config", "value", 0);
+  int64_t elapsed_lookup = esp_timer_get_time() - started;
+  OvmsConfigInt cfg_value("test.config", "value", 0);
+  started = esp_timer_get_time();
+  for (int i = 0; i < reads; i++)
+    sum += cfg_value.Get();
+  int64_t elapsed_cached = esp_timer_get_time() - started;
+  writer->printf("Read        : %.2f us/lookup, %.3f us/cached (value %d)\n",
+    (float)elapsed_lookup / reads, (float)elapsed_cached / reads, cfg_value.Get());
+
+  // Overlapping transactions from two tasks: depth must return to 0
+  int errors = 0;
+  test_config_tx_t tx[2];
+  TaskHandle_t task[2];
+  for (int k = 0; k < 2; k++)
+    {
+    tx[k].task = k;
+    tx[k].changes = changes * 10;
+    tx[k].done = false;
+    xTaskCreatePinnedToCore(test_config_txtask, "OVMS TestConfig", 4096, &tx[k], 5, &task[k], CORE(k));
+    }
+  while (!tx[0].done || !tx[1].done)
+    vTaskDelay(1);
+  for (int k = 0; k < 2; k++)
+    vTaskDelete(task[k]);
+  writer->printf("Concurrent  : 2 tasks x %d transactions, depth %d after commits\n",
+    changes * 10, MyConfig.m_transaction.load());
+  if (MyConfig.m_transaction != 0)
+    {
+    writer->puts("ERROR: transaction depth not 0");
+    errors++;
+    MyConfig.m_transaction = 0;
+    }
+
+  // Missing commit: changes are held back until the transaction expires
+  MyConfig.Flush();
+  writes0 = MyConfig.m_stat_writes;
+  MyConfig.BeginTransaction();
+  MyConfig.SetParamValueInt("test.config", "value", -1);
+  MyConfig.EventListener("config.flush", NULL);
+  uint32_t writes_open = MyConfig.m_stat_writes - writes0;
+  MyConfig.m_transaction_time -= 3600;
+  MyConfig.EventListener("config.flush", NULL);
+  uint32_t writes_expired = MyConfig.m_stat_writes - writes0;
+  MyConfig.CommitTransaction();
+  writer->printf("Expiry      : %u file writes while open, %u after expiry\n", writes_open, writes_expired);
+  if (writes_open != 0 || writes_expired != 1)
+    {
+    writer->puts("ERROR: expected 0 writes while open, 1 after expiry");
+    errors++;
+    }
+
+  // Write error: the param stays dirty & is retried, config.changed is signaled once
+  static uint32_t signals;
+  signals = 0;
+  MyEvents.RegisterEvent("test.config", "config.changed", [](std::string event, void* data)
+    {
+    if (data == MyConfig.CachedParam("test.config")) signals++;
+    });
+  const char* blocker = OVMS_CONFIGPATH "/test.config.tmp";
+  mkdir(blocker, 0755);   // the temporary file cannot be created
+  uint32_t errors0 = MyConfig.m_stat_errors;
+  MyConfig.SetParamValueInt("test.config", "value", -2);
+  MyConfig.Flush();
+  bool dirty_failed = MyConfig.CachedParam("test.config")->IsDirty();
+  rmdir(blocker);
+  MyConfig.Flush();
+  bool dirty_retried = MyConfig.CachedParam("test.config")->IsDirty();
+  vTaskDelay(100 / portTICK_PERIOD_MS);
+  MyEvents.DeregisterEvent("test.config");
+  writer->printf("Write error : %u errors, dirty %s after failure, %s after retry, %u config.changed\n",
+    MyConfig.m_stat_errors - errors0, dirty_failed ? "yes" : "no", dirty_retried ? "yes" : "no", signals);
+  if (MyConfig.m_stat_errors == errors0 || !dirty_failed || dirty_retried || signals != 1)
+    {
+    writer->puts("ERROR: expected a write error, dirty until retried, 1 config.changed");
+    errors++;
+    }
+
+  MyConfig.DeregisterParam("test.config");
+  if (errors == 0)
+    writer->puts("Config transactions OK");
+  }
+
+void test_buffer(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int kbytes = (argc > 0) ? atoi(argv[0]) : 1024;
+  int chunksize = (argc > 1) ? atoi(argv[1]) : 256;
+  if (kbytes < 1) kbytes = 1;
+  if (chunksize < 1) chunksize = 1;
+  if (chunksize > 2048) chunksize = 2048;
+
+  // Synthetic modem stream: NMEA sentences mixed with AT responses
+  static const char* lines[] =
+    {
+    "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n",
+    "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n",
+    "+CSQ: 21,99\r\n",
+    "\r\n",
+    "OK\r\n",
+    "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n",
+    "+CREG: 1,5\r\n",
+    };
+  const int numlines = sizeof(lines) / sizeof(lines[0]);
+  size_t total = kbytes * 1024;
+  char* stream = (char*) ExternalRamMalloc(total);
+  if (!stream)
+    {
+    writer->puts("ERROR: out of memory");
+    return;
+    }
+  size_t len = 0;
+  int expected = 0;
+  for (int i = 0; len < total; i++)
+    {
+    size_t n = strlen(lines[i % numlines]);
+    if (len + n > total) break;
+    memcpy(stream + len, lines[i % numlines], n);
+    len += n;
+    expected++;
+    }
+
+  writer->printf("Framing %u bytes (%d lines) in %d byte chunks...\n", len, expected, chunksize);
+
+  OvmsBuffer buf(4096);
+  for (int mode = 0; mode < 3; mode++)
+    {
+    buf.EmptyAll();
+    std::string line;
+    OvmsBuffer::span_t span[2];
+    int count = 0;
+    size_t bytes = 0;
+    int64_t started = esp_timer_get_time();
+    for (size_t pos = 0; pos < len; pos += chunksize)
+      {
+      size_t n = (len - pos < (size_t)chunksize) ? len - pos : chunksize;
+      if (!buf.Push((uint8_t*)stream + pos, n))
+        {
+        writer->puts("ERROR: buffer overflow");
+        break;
+        }
+      if (mode == 0)
+        {
+        while (buf.HasLine() >= 0)
+          {
+          line = buf.ReadLine();
+          bytes += line.size();
+          count++;
+          }
+        }
+      else if (mode == 1)
+        {
+        while (buf.ReadLine(line))
+          {
+          bytes += line.size();
+          count++;
+          }
+        }
+      else
+        {
+        int hl;
+        while ((hl = buf.PeekLine(span)) >= 0)
+          {
+          bytes += span[0].length + span[1].length;
+          buf.SkipLine(hl);
+          count++;
+          }
+        }
+      }
+    int64_t elapsed = esp_timer_get_time() - started;
+    static const char* modename[] = { "ReadLine() copy ", "ReadLine(string&)", "PeekLine() view " };
+    writer->printf("%s: %6lld us, %6.2f MB/s, %d lines, %u payload bytes\n",
+      modename[mode], elapsed, (elapsed > 0) ? (float)len / elapsed : 0.0f, count, bytes);
+    }
+
+  free(stream);
+  }
+
+/**
+ * test_canpipe: end-to-end CAN RX pipeline benchmark
+ *
+ *  Frames are injected into MyCan.m_rxqueue like the driver ISR does, and
+ *  pass the CanRx task (callbacks, loggers, listeners) and the vehicle RX
+ *  task (poller, IncomingFrameCanN, metric updates). Each frame is tagged
+ *  via its (for RX unused) callback pointer, so the stages can match it
+ *  without changing the frame content.
+ */
+
+#define TEST_CANPIPE_TAGS     512     // frame tags in flight (> both RX queue sizes)
+#define TEST_CANPIPE_SAMPLES  20000   // latency samples per stage
+
+typedef struct
+  {
+  const char* name;
+  uint32_t* samples;
+  uint32_t count;
+  uint32_t max;
+  } test_canpipe_stage_t;
+
+class CanPipeSimVehicle : public OvmsVehicle
+  {
+  public:
+    CanPipeSimVehicle()
+      {
+      RegisterCanBus(1, CAN_MODE_LISTEN, CAN_SPEED_500KBPS);
+      m_ready = true;
+      }
+
+  protected:
+    // Typical decoder workload: some metrics per frame, most IDs ignored
+    void IncomingFrameCan1(CAN_frame_t* p_frame)
+      {
+      uint8_t* d = p_frame->data.u8;
+      switch (p_frame->MsgID & 0x0f)
+        {
+        case 0x0:
+          StdMetrics.ms_v_bat_soc->SetValue((float)d[0] / 2);
+          break;
+        case 0x1:
+          StdMetrics.ms_v_bat_voltage->SetValue((float)(d[0] << 8 | d[1]) / 10);
+          StdMetrics.ms_v_bat_current->SetValue((float)(int16_t)(d[2] << 8 | d[3]) / 10);
+          break;
+        case 0x2:
+          StdMetrics.ms_v_pos_speed->SetValue(d[4]);
+          break;
+        case 0x3:
+          StdMetrics.ms_v_mot_temp->SetValue((int)d[5] - 40);
+          break;
+        default:
+          break;
+        }
+      }
+  };
+
+class CanPipeBench : public OvmsVehicleRxTrace
+  {
+  public:
+    CanPipeBench();
+    ~CanPipeBench();
+
+  public:
+    bool Inject(const CAN_frame_t* frame);
+    void RxCallback(const CAN_frame_t* frame);
+    void RxFrame(const CAN_frame_t* frame, int64_t started, int64_t finished, UBaseType_t waiting);
+    void Report(OvmsWriter* writer);
+    bool Ok();
+
+  protected:
+    int Tag(const CAN_frame_t* frame);
+    void Sample(int stage, int64_t latency);
+
+  public:
+    CanFrameCallback* m_tags;
+    int64_t m_t_inject[TEST_CANPIPE_TAGS];
+    int64_t m_t_canrx[TEST_CANPIPE_TAGS];
+    test_canpipe_stage_t m_stage[4];
+    volatile uint32_t m_injected;
+    volatile uint32_t m_overflows;
+    volatile uint32_t m_canrx;
+    volatile uint32_t m_vehicle;
+    volatile uint32_t m_metrics;
+    UBaseType_t m_canrx_hwm;
+    UBaseType_t m_vehicle_hwm;
+  };
+
+CanPipeBench::CanPipeBench()
+  {
+  static const char* names[4] = { "driver queue", "CanRx > vehicle", "vehicle handler", "end-to-end" };
+  m_tags = new CanFrameCallback[TEST_CANPIPE_TAGS];
+  for (int i = 0; i < TEST_CANPIPE_TAGS; i++)
+    m_tags[i] = [](const CAN_frame_t* frame, bool success) {};
+  for (int i = 0; i < 4; i++)
+    {
+    m_stage[i].name = names[i];
+    m_stage[i].samples = (uint32_t*) ExternalRamMalloc(TEST_CANPIPE_SAMPLES * sizeof(uint32_t));
+    m_stage[i].count = 0;
+    m_stage[i].max = 0;
+    }
+  m_injected = m_overflows = m_canrx = m_vehicle = m_metrics = 0;
+  m_canrx_hwm = m_vehicle_hwm = 0;
+  }
+
+CanPipeBench::~CanPipeBench()
+  {
+  for (int i = 0; i < 4; i++)
+    free(m_stage[i].samples);
+  delete [] m_tags;
+  }
+
+/**
+ * Ok: all sample buffers allocated
+ */
+bool CanPipeBench::Ok()
+  {
+  for (int i = 0; i < 4; i++)
+    {
+    if (m_stage[i].samples == NULL)
+      return false;
+    }
+  return true;
+  }
+
+int CanPipeBench::Tag(const CAN_frame_t* frame)
+  {
+  if (frame->callback < m_tags || frame->callback >= m_tags + TEST_CANPIPE_TAGS)
+    return -1;
+  return frame->callback - m_tags;
+  }
+
+void CanPipeBench::Sample(int stage, int64_t latency)
+  {
+  test_canpipe_stage_t* s = &m_stage[stage];
+  uint32_t us = (latency > 0) ? latency : 0;
+  if (s->count < TEST_CANPIPE_SAMPLES)
+    s->samples[s->count] = us;
+  s->count++;
+  if (us > s->max) s->max = us;
+  }
+
+/**
+ * Inject: driver stage, queue the frame for the CanRx task (non-blocking like the ISR)
+ */
+bool CanPipeBench::Inject(const CAN_frame_t* frame)
+  {
+  int tag = m_injected % TEST_CANPIPE_TAGS;
+  CAN_queue_msg_t msg;
+  msg.type = CAN_frame;
+  msg.body.frame = *frame;
+  msg.body.frame.callback = &m_tags[tag];
+  msg.timestamp = m_t_inject[tag] = esp_timer_get_time();
+  if (xQueueSend(MyCan.m_rxqueue, &msg, 0) != pdTRUE)
+    {
+    m_overflows++;
+    return false;
+    }
+  m_injected++;
+  UBaseType_t waiting = uxQueueMessagesWaiting(MyCan.m_rxqueue);
+  if (waiting > m_canrx_hwm) m_canrx_hwm = waiting;
+  return true;
+  }
+
+/**
+ * RxCallback: CanRx task stage (called from can::IncomingFrame)
+ */
+void CanPipeBench::RxCallback(const CAN_frame_t* frame)
+  {
+  int tag = Tag(frame);
+  if (tag < 0) return;
+  int64_t now = esp_timer_get_time();
+  m_t_canrx[tag] = now;
+  m_canrx++;
+  Sample(0, now - m_t_inject[tag]);
+  }
+
+/**
+ * RxFrame: vehicle RX task stage (called after IncomingFrameCanN)
+ */
+void CanPipeBench::RxFrame(const CAN_frame_t* frame, int64_t started, int64_t finished, UBaseType_t waiting)
+  {
+  int tag = Tag(frame);
+  if (tag < 0) return;
+  m_vehicle++;
+  if (waiting + 1 > m_vehicle_hwm) m_vehicle_hwm = waiting + 1;
+  Sample(1, started - m_t_canrx[tag]);
+  Sample(2, finished - started);
+  Sample(3, finished - m_t_inject[tag]);
+  }
+
+void CanPipeBench::Report(OvmsWriter* writer)
+  {
+  writer->printf("Stage latency [us]     samples    p50    p90    p99    max\n");
+  for (int i = 0; i < 4; i++)
+    {
+    test_canpipe_stage_t* s = &m_stage[i];
+    uint32_t n = std::min(s->count, (uint32_t)TEST_CANPIPE_SAMPLES);
+    if (n == 0) continue;
+    std::sort(s->samples, s->samples + n);
+    writer->printf("  %-18s %9u %6u %6u %6u %6u\n", s->name, s->count,
+      s->samples[n * 50 / 100], s->samples[n * 90 / 100], s->samples[n * 99 / 100], s->max);
+    }
+  }
+
+void test_canpipe(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  const char* type = argv[0];
+  int rate = (argc > 2) ? atoi(argv[2]) : 2000;
+  int seconds = (argc > 3) ? atoi(argv[3]) : 10;
+  if (rate < 100) rate = 100;
+  if (seconds < 1) seconds = 1;
+
+  canbus* bus = MyCan.GetBus(0);
+  if (bus == NULL)
+    {
+    writer->puts("Error: can1 not available");
+    return;
+    }
+
+  // Load trace (CRTD) or generate synthetic frames:
+  std::vector<CAN_log_message_t> trace;
+  const char* source = (argc > 1) ? argv[1] : "synth";
+  if (strcmp(source, "synth") != 0)
+    {
+    if (!test_load_crtd(source, trace, 5000))
+      {
+      writer->printf("Error: cannot open '%s'\n", source);
+      return;
+      }
+    trace.erase(std::remove_if(trace.begin(), trace.end(),
+      [](const CAN_log_message_t& m) { return m.type != CAN_LogFrame_RX; }), trace.end());
+    }
+  else
+    {
+    CAN_log_message_t msg;
+    for (int k = 0; k < 1000; k++)
+      {
+      memset(&msg, 0, sizeof(msg));
+      msg.type = CAN_LogFrame_RX;
+      msg.frame.origin = bus;
+      msg.frame.FIR.B.FF = CAN_frame_std;
+      msg.frame.FIR.B.DLC = 8;
+      msg.frame.MsgID = 0x100 + (k * 37) % 0x600;
+      msg.frame.data.u64 = 0x0123456789abcdefULL * (k + 1);
+      trace.push_back(msg);
+      }
+    }
+  if (trace.empty())
+    {
+    writer->puts("Error: no RX frames loaded");
+    return;
+    }
+
+  CanPipeBench* bench = new CanPipeBench();
+  if (!bench->Ok())
+    {
+    writer->puts("Error: out of memory for latency samples");
+    delete bench;
+    return;
+    }
+
+  // Set up the vehicle stage:
+  std::string prevtype = MyVehicleFactory.ActiveVehicleType();
+  OvmsVehicle* vehicle = NULL;
+  CanPipeSimVehicle* simvehicle = NULL;
+  if (strcmp(type, "sim") == 0)
+    {
+    if (MyVehicleFactory.ActiveVehicle())
+      {
+      writer->puts("Error: a vehicle module is loaded, please clear it first");
+      delete bench;
+      return;
+      }
+    vehicle = simvehicle = new CanPipeSimVehicle();
+    }
+  else if (strcmp(type, "-") == 0)
+    {
+    vehicle = MyVehicleFactory.ActiveVehicle();
+    }
+  else
+    {
+    MyVehicleFactory.SetVehicle(type);
+    vehicle = MyVehicleFactory.ActiveVehicle();
+    if (vehicle == NULL)
+      {
+      writer->printf("Error: cannot load vehicle type '%s'\n", type);
+      if (!prevtype.empty()) MyVehicleFactory.SetVehicle(prevtype.c_str());
+      delete bench;
+      return;
+      }
+    }
+
+  MyCan.RegisterCallback("test.canpipe",
+    [bench](const CAN_frame_t* frame, bool success) { bench->RxCallback(frame); });
+  MyMetrics.RegisterListener("test.canpipe", "*",
+    [bench](OvmsMetric* metric) { bench->m_metrics++; });
+  if (vehicle) vehicle->SetRxTrace(bench);
+
+  writer->printf("Vehicle %s, %s (%d frames), %d frames/s for %d seconds, %d logger(s)...\n",
+    vehicle ? (simvehicle ? "sim" : MyVehicleFactory.ActiveVehicleType()) : "none",
+    source, (int)trace.size(), rate, seconds, (int)MyCan.m_loggermap.size());
+
+  // Drive the pipeline in 10 ms bursts:
+  int pertick = rate / 100;
+  size_t pos = 0;
+  TickType_t wake = xTaskGetTickCount();
+  int64_t started = esp_timer_get_time();
+  for (int t = 0; t < seconds * 100; t++)
+    {
+    for (int k = 0; k < pertick; k++)
+      {
+      bench->Inject(&trace[pos].frame);
+      if (++pos == trace.size()) pos = 0;
+      }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(10));
+    }
+  int64_t elapsed = esp_timer_get_time() - started;
+
+  // Wait for the pipeline to drain:
+  uint32_t progress;
+  do
+    {
+    progress = bench->m_canrx + bench->m_vehicle;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    } while (progress != bench->m_canrx + bench->m_vehicle);
+
+  if (vehicle) vehicle->SetRxTrace(NULL);
+  MyMetrics.DeregisterListener("test.canpipe");
+  MyCan.DeregisterCallback("test.canpipe");
+
+  writer->printf("Injected %u frames in %lld ms = %.0f frames/s, %u driver queue overflows\n",
+    bench->m_injected, elapsed / 1000, (float)bench->m_injected * 1000000 / elapsed, bench->m_overflows);
+  writer->printf("Processed: CanRx %u frames, vehicle %u frames, %u metric updates (%.0f/s)\n",
+    bench->m_canrx, bench->m_vehicle, bench->m_metrics, (float)bench->m_metrics * 1000000 / elapsed);
+  writer->printf("Queue high-water: CanRx %u/%d, vehicle %u/%d\n",
+    bench->m_canrx_hwm, CONFIG_OVMS_HW_CAN_RX_QUEUE_SIZE,
+    bench->m_vehicle_hwm, CONFIG_OVMS_VEHICLE_CAN_RX_QUEUE_SIZE);
+  bench->Report(writer);
+
+  // Restore the vehicle configuration:
+  if (simvehicle)
+    delete simvehicle;
+  else if (strcmp(type, "-") != 0)
+    {
+    if (prevtype.empty())
+      MyVehicleFactory.ClearVehicle();
+    else
+      MyVehicleFactory.SetVehicle(prevtype.c_str());
+    }
+  delete bench;
+  }
+
+/**
+ * test_canlogring: CanRx task cost of CAN logging with 1, 2 and 4 loggers
+ *
+ *  Measures the producer side (MyCan.LogFrame, executed by the CanRx task
+ *  per frame) using the shared log ring, and compares it to the former
+ *  per-logger queue delivery (one timestamp, copy & queue send per logger).
+ */
+
+class TestNullLogger : public canlog
+  {
+  public:
+    TestNullLogger() : canlog("null", "crtd") { m_open = true; m_bytes = 0; }
+    ~TestNullLogger() {}
+
+  public:
+    bool Open() { m_open = true; return true; }
+    void Close() { m_open = false; }
+    bool IsOpen() { return m_open; }
+    void OutputBatch(const char* data, size_t len, uint32_t msgcount) { m_bytes += len; }
+
+  public:
+    bool m_open;
+    size_t m_bytes;
+  };
+
+static void test_canlogring_legacytask(void* context)
+  {
+  QueueHandle_t queue = (QueueHandle_t) context;
+  CAN_log_message_t msg;
+  while (1)
+    xQueueReceive(queue, &msg, portMAX_DELAY);
+  }
+
+/**
+ * Lapped reader stress: the reader stays exactly one ring behind the producer,
+ *  so every slot it reads is the next one to be overwritten. Messages carry
+ *  their sequence number in all fields, a torn (half overwritten) message
+ *  accepted by Read() is detected by inconsistent fields.
+ */
+typedef struct
+  {
+  canlogring* ring;
+  volatile bool run;
+  volatile bool done;
+  uint32_t reads;
+  uint32_t torn;
+  uint32_t dropped;
+  } test_canlogring_lapped_t;
+
+static void test_canlogring_lappedtask(void* context)
+  {
+  test_canlogring_lapped_t* t = (test_canlogring_lapped_t*) context;
+  CAN_log_message_t msg;
+  char text[CANLOG_TEXT_MAXLEN];
+  while (t->run)
+    {
+    uint32_t cursor = t->ring->GetHead() - t->ring->GetSize();
+    if (t->ring->Read(cursor, msg, text, t->dropped))
+      {
+      uint32_t seq = cursor - 1;
+      t->reads++;
+      if (msg.frame.MsgID != (seq & 0x1fffffff) || msg.frame.data.u32[0] != seq ||
+          msg.frame.data.u32[1] != ~seq || msg.timestamp.tv_usec != (suseconds_t)(seq % 1000000))
+        t->torn++;
+      }
+    }
+  t->done = true;
+  vTaskDelete(NULL);
+  }
+
+static void test_canlogring_lapped(OvmsWriter* writer, uint32_t pushes)
+  {
+  canlogring ring(16);
+  CAN_log_message_t msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.type = CAN_LogFrame_RX;
+  msg.frame.FIR.B.FF = CAN_frame_ext;
+  msg.frame.FIR.B.DLC = 8;
+
+  test_canlogring_lapped_t t;
+  t.ring = &ring;
+  t.run = true;
+  t.done = false;
+  t.reads = t.torn = t.dropped = 0;
+
+  for (uint32_t seq = 0; seq < pushes; seq++)
+    {
+    if (seq == ring.GetSize())
+      xTaskCreatePinnedToCore(test_canlogring_lappedtask, "OVMS TestRing", 4096, &t, 5, NULL, CORE(0));
+    msg.frame.MsgID = seq & 0x1fffffff;
+    msg.frame.data.u32[0] = seq;
+    msg.frame.data.u32[1] = ~seq;
+    msg.timestamp.tv_sec = seq;
+    msg.timestamp.tv_usec = seq % 1000000;
+    ring.Push(msg);
+    if ((seq % 10000) == 9999)
+      vTaskDelay(1);
+    }
+  t.run = false;
+  while (!t.done)
+    vTaskDelay(1);
+
+  writer->printf("Lapped reader: %u pushes, %u reads, %u dropped, %u torn\n",
+    pushes, t.reads, t.dropped, t.torn);
+  if (t.torn)
+    writer->printf("Error: %u torn messages accepted by the lapped reader\n", t.torn);
+  }
+
+static std::string test_canlogvfs_path(const char* path, int seq)
+  {
+  // Rotation file name, see canlog_vfs::GetFilePath():
+  std::string p = path;
+  char num[8];
+  snprintf(num, sizeof(num), "-%04d", seq);
+  size_t dot = p.find_last_of('.');
+  size_t slash = p.find_last_of('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return p + num;
+  p.insert(dot, num);
+  return p;
+  }
+
+void test_canlogvfs(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  const char* path = (argc > 0) ? argv[0] : "/sd/canlogtest.crtd";
+  int lines = (argc > 1) ? atoi(argv[1]) : 20000;
+  const int rounds = 4;
+  if (lines < 1000) lines = 1000;
+
+  // Small blocks, rotation every 8 KB (user settings restored afterwards):
+  const char* params[] = { "log.vfs.blocksize", "log.vfs.maxsize", "log.vfs.flushtime" };
+  const int values[] = { 4, 8, 1 };
+  std::string saved[3];
+  for (int i = 0; i < 3; i++)
+    {
+    saved[i] = MyConfig.GetParamValue("can", params[i]);
+    MyConfig.SetParamValueInt("can", params[i], values[i]);
+    }
+  for (int seq = 1; seq < 1000; seq++)
+    unlink(test_canlogvfs_path(path, seq).c_str());
+
+  // Feed numbered lines, close right after the last batch switched blocks,
+  //  i.e. while the writer task is busy with the pending block:
+  canlog_vfs* logger = new canlog_vfs(path, "crtd");
+  char batch[64*9+1];
+  uint32_t n = 0;
+  for (int round = 0; round < rounds; round++)
+    {
+    if (!logger->Open())
+      {
+      writer->printf("Error: cannot open '%s'\n", path);
+      break;
+      }
+    uint32_t end = (uint32_t)lines * (round + 1) / rounds;
+    while (n < end)
+      {
+      size_t len = 0;
+      uint32_t count = 0;
+      while (count < 64 && n < end)
+        {
+        len += sprintf(batch + len, "%08u\n", n++);
+        count++;
+        }
+      logger->OutputBatch(batch, len, count);
+      if ((n % 1024) == 0)
+        vTaskDelay(1);
+      }
+    logger->Close();
+    }
+  uint32_t dropped = logger->m_dropcount;
+  std::string stats = logger->GetStats();
+  delete logger;
+
+  // Check: all lines present once & in order, apart from counted drops:
+  uint32_t read = 0, duplicates = 0, disorder = 0;
+  int64_t last = -1;
+  int files = 0;
+  char line[64];
+  for (int seq = 1; seq < 1000; seq++)
+    {
+    std::string fp = test_canlogvfs_path(path, seq);
+    FILE* f = fopen(fp.c_str(), "r");
+    if (f == NULL)
+      break;
+    files++;
+    while (fgets(line, sizeof(line), f))
+      {
+      if (strstr(line, "CXX"))
+        continue; // file header
+      int64_t v = strtol(line, NULL, 10);
+      if (v == last)
+        duplicates++;
+      else if (v < last)
+        disorder++;
+      last = v;
+      read++;
+      }
+    fclose(f);
+    unlink(fp.c_str());
+    }
+
+  for (int i = 0; i < 3; i++)
+    {
+    if (saved[i].empty())
+      MyConfig.DeleteInstance("can", params[i]);
+    else
+      MyConfig.SetParamValue("can", params[i], saved[i]);
+    }
+
+  writer->printf("VFS log: %d files, %u/%u lines read, %u dropped, %u duplicate, %u out of order\n",
+    files, read, n, dropped, duplicates, disorder);
+  writer->printf("Stats: %s\n", stats.c_str());
+  if (duplicates || disorder || read + dropped != n)
+    writer->puts("Error: log lines lost, duplicated or out of order");
+  if (files < 2)
+    writer->puts("Error: log not rotated");
+  }
+
+void test_canlogring(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int frames = (argc > 0) ? atoi(argv[0]) : 20000;
+  if (frames < 1000) frames = 1000;
+  const int burst = 32;
+
+  canbus* bus = MyCan.GetBus(0);
+  if (bus == NULL)
+    {
+    writer->puts("Error: can1 not available");
+    return;
+    }
+  if (MyCan.HasLogger())
+    {
+    writer->puts("Error: loggers active, please stop them first (can log stop)");
+    return;
+    }
+
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.origin = bus;
+  frame.FIR.B.DLC = 8;
+
+  writer->printf("Producer cost per frame, %d frames in bursts of %d:\n", frames, burst);
+  writer->printf("Loggers  legacy [us]  ring [us]  saved   dropped\n");
+
+  static const int loggers[3] = { 1, 2, 4 };
+  for (int li = 0; li < 3; li++)
+    {
+    int n = loggers[li];
+
+    // Former delivery: per logger timestamp, copy & queue send:
+    QueueHandle_t queue[4];
+    TaskHandle_t task[4];
+    OvmsMutex mutex;
+    for (int k = 0; k < n; k++)
+      {
+      queue[k] = xQueueCreate(100, sizeof(CAN_log_message_t));
+      xTaskCreatePinnedToCore(test_canlogring_legacytask, "OVMS CanLog", 4096, (void*)queue[k], 10, &task[k], CORE(1));
+      }
+    int64_t legacy = 0;
+    CAN_log_message_t msg;
+    for (int i = 0; i < frames; i += burst)
+      {
+      int64_t start = esp_timer_get_time();
+      for (int j = 0; j < burst; j++)
+        {
+        frame.MsgID = 0x100 + ((i + j) & 0x3ff);
+        OvmsMutexLock lock(&mutex);
+        for (int k = 0; k < n; k++)
+          {
+          msg.type = CAN_LogFrame_RX;
+          gettimeofday(&msg.timestamp, NULL);
+          memcpy(&msg.frame, &frame, sizeof(CAN_frame_t));
+          msg.frame.origin = bus;
+          xQueueSend(queue[k], &msg, 0);
+          }
+        }
+      legacy += esp_timer_get_time() - start;
+      vTaskDelay(1);
+      }
+    for (int k = 0; k < n; k++)
+      {
+      vTaskDelete(task[k]);
+      vQueueDelete(queue[k]);
+      }
+
+    // Shared ring:
+    uint32_t ids[4];
+    TestNullLogger* logger[4];
+    for (int k = 0; k < n; k++)
+      {
+      logger[k] = new TestNullLogger();
+      ids[k] = MyCan.AddLogger(logger[k]);
+      }
+    int64_t ring = 0;
+    for (int i = 0; i < frames; i += burst)
+      {
+      int64_t start = esp_timer_get_time();
+      for (int j = 0; j < burst; j++)
+        {
+        frame.MsgID = 0x100 + ((i + j) & 0x3ff);
+        MyCan.LogFrame(bus, CAN_LogFrame_RX, &frame);
+        }
+      ring += esp_timer_get_time() - start;
+      vTaskDelay(1);
+      }
+    vTaskDelay(pdMS_TO_TICKS(100));
+    uint32_t dropped = 0;
+    for (int k = 0; k < n; k++)
+      dropped += logger[k]->m_dropcount;
+    for (int k = 0; k < n; k++)
+      MyCan.RemoveLogger(ids[k]);
+
+    writer->printf("%7d  %11.2f  %9.2f  %4.0f%%  %8u\n", n,
+      (float)legacy / frames, (float)ring / frames,
+      (legacy > 0) ? (float)(legacy - ring) * 100 / legacy : 0, dropped);
+    }
+
+  test_canlogring_lapped(writer, frames * 50);
+  }
+
+/**
+ * Registry stress: registers & deregisters a listener and adds ID subscriptions
+ *  while the test feeds frames through the CAN dispatch.
+ */
+typedef struct
+  {
+  canidset* ids;
+  QueueHandle_t queue;
+  volatile bool run;
+  volatile bool done;
+  uint32_t rounds;
+  } test_canidset_reg_t;
+
+static void test_canidset_regtask(void* context)
+  {
+  test_canidset_reg_t* t = (test_canidset_reg_t*) context;
+  while (t->run)
+    {
+    MyCan.RegisterListener(t->queue, false, t->ids);
+    t->ids->Add(1, CAN_frame_ext, 0x18da0100 + (t->rounds & 0xff));
+    if ((++t->rounds % 2) == 0)
+      vTaskDelay(1);
+    MyCan.DeregisterListener(t->queue);
+    xQueueReset(t->queue);
+    }
+  t->done = true;
+  vTaskDelete(NULL);
+  }
+
+void test_canidset(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int loops = (argc > 0) ? atoi(argv[0]) : 100;
+  if (loops < 1) loops = 1;
+
+  canbus* bus = MyCan.GetBus(0);
+  if (bus == NULL)
+    {
+    writer->puts("Error: can1 not available");
+    return;
+    }
+  if (MyVehicleFactory.ActiveVehicle())
+    {
+    writer->puts("Error: a vehicle module is loaded, please clear it first");
+    return;
+    }
+
+  // Subscriptions are keyed by frame format:
+  canidset ids;
+  ids.Add(1, CAN_frame_std, 0x100, 0x1ff);
+  ids.Add(1, CAN_frame_ext, 0x18daf110);
+  ids.Add(2, CAN_frame_ext, 0x100);
+  ids.Add(0, CAN_frame_std, 0x7e8, 0x7ef);
+  ids.Add(1, CAN_frame_std, 0x700, 0x900);    // clipped to 0x7ff
+  const struct { int bus; CAN_frame_format_t format; uint32_t id; bool match; } cases[] =
+    {
+    { 0, CAN_frame_std, 0x100, true },
+    { 0, CAN_frame_ext, 0x100, false },
+    { 0, CAN_frame_std, 0x1ff, true },
+    { 0, CAN_frame_std, 0x200, false },
+    { 0, CAN_frame_ext, 0x18daf110, true },
+    { 0, CAN_frame_ext, 0x18daf111, false },
+    { 1, CAN_frame_ext, 0x100, true },
+    { 1, CAN_frame_std, 0x100, false },
+    { 1, CAN_frame_std, 0x7e8, true },
+    { 3, CAN_frame_std, 0x7ef, true },
+    { 3, CAN_frame_ext, 0x7ef, false },
+    { 0, CAN_frame_std, 0x7ff, true },
+    { 0, CAN_frame_ext, 0x7ff, false },
+    { 0, CAN_frame_ext, 0x800, false },
+    };
+  int errors = 0;
+  for (auto& c : cases)
+    {
+    if (ids.Contains(c.bus, c.format, c.id) != c.match)
+      {
+      writer->printf("Error: can%d %s %x: expected %s\n", c.bus+1,
+        (c.format == CAN_frame_std) ? "std" : "ext", c.id, c.match ? "match" : "no match");
+      errors++;
+      }
+    }
+  writer->printf("Subscriptions: %s\n", ids.Info().c_str());
+  writer->printf("Format keying: %d cases, %d errors\n", (int)(sizeof(cases)/sizeof(cases[0])), errors);
+
+  // Dispatch counts per frame, not per subscriber:
+  //  listener A: 0x100-0x17f, listener B: 0x140-0x1ff, callback: empty set = all, not counted
+  canidset ids_a, ids_b, ids_all;
+  ids_a.Add(1, CAN_frame_std, 0x100, 0x17f);
+  ids_b.Add(1, CAN_frame_std, 0x140, 0x1ff);
+  QueueHandle_t queue_a = xQueueCreate(256, sizeof(CAN_frame_t));
+  QueueHandle_t queue_b = xQueueCreate(256, sizeof(CAN_frame_t));
+  QueueHandle_t queue_r = xQueueCreate(16, sizeof(CAN_frame_t));
+  MyCan.RegisterListener(queue_a, false, &ids_a);
+  MyCan.RegisterListener(queue_b, false, &ids_b);
+  uint32_t callbacks = 0;
+  MyCan.RegisterCallback("test.canidset", [&callbacks](const CAN_frame_t* frame, bool success)
+    { callbacks++; }, false, &ids_all);
+
+  uint32_t delivered = MyCan.m_dispatch_delivered[0];
+  uint32_t skipped = MyCan.m_dispatch_skipped[0];
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.origin = bus;
+  frame.FIR.B.DLC = 8;
+  for (uint32_t id = 0x100; id < 0x300; id++)
+    {
+    frame.MsgID = id;
+    frame.FIR.B.FF = CAN_frame_std;
+    MyCan.IncomingFrame(&frame);
+    frame.FIR.B.FF = CAN_frame_ext;
+    MyCan.IncomingFrame(&frame);
+    }
+  delivered = MyCan.m_dispatch_delivered[0] - delivered;
+  skipped = MyCan.m_dispatch_skipped[0] - skipped;
+  int queued_a = uxQueueMessagesWaiting(queue_a);
+  int queued_b = uxQueueMessagesWaiting(queue_b);
+  writer->printf("Dispatch: 1024 frames, %u delivered, %u skipped, A %d, B %d, callback %u\n",
+    delivered, skipped, queued_a, queued_b, callbacks);
+  if (delivered != 256 || skipped != 768 || queued_a != 128 || queued_b != 192 || callbacks != 1024)
+    {
+    writer->puts("Error: expected 256 delivered, 768 skipped, A 128, B 192, callback 1024");
+    errors++;
+    }
+
+  // Concurrent registry changes while frames are dispatched:
+  canidset ids_r;
+  test_canidset_reg_t t;
+  t.ids = &ids_r;
+  t.queue = queue_r;
+  t.run = true;
+  t.done = false;
+  t.rounds = 0;
+  xTaskCreatePinnedToCore(test_canidset_regtask, "OVMS TestCanId", 4096, &t, 5, NULL, CORE(1));
+  delivered = MyCan.m_dispatch_delivered[0];
+  skipped = MyCan.m_dispatch_skipped[0];
+  uint32_t frames = 0;
+  for (int k = 0; k < loops; k++)
+    {
+    for (uint32_t id = 0x100; id < 0x200; id++)
+      {
+      xQueueReset(queue_a);
+      xQueueReset(queue_b);
+      frame.MsgID = id;
+      frame.FIR.B.FF = CAN_frame_std;
+      MyCan.IncomingFrame(&frame);
+      frame.MsgID = 0x18da0000 + id;
+      frame.FIR.B.FF = CAN_frame_ext;
+      MyCan.IncomingFrame(&frame);
+      frames += 2;
+      }
+    vTaskDelay(1);
+    }
+  t.run = false;
+  while (!t.done)
+    vTaskDelay(1);
+  delivered = MyCan.m_dispatch_delivered[0] - delivered;
+  skipped = MyCan.m_dispatch_skipped[0] - skipped;
+  writer->printf("Registry: %u frames, %u registrations, %u delivered, %u skipped\n",
+    frames, t.rounds, delivered, skipped);
+  if (delivered + skipped != frames || delivered < frames/2)
+    {
+    writer->puts("Error: frames lost or counted twice during registry changes");
+    errors++;
+    }
+
+  MyCan.DeregisterCallback("test.canidset");
+  MyCan.DeregisterListener(queue_a);
+  MyCan.DeregisterListener(queue_b);
+  vQueueDelete(queue_a);
+  vQueueDelete(queue_b);
+  vQueueDelete(queue_r);
+  writer->printf("%s\n", errors ? "ERROR: CAN ID dispatch test failed" : "CAN ID dispatch OK");
+  }
+
+#ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
+
+#define TEST_CANLOGTCP_PORT 3099
+
+typedef struct
+  {
+  int delay_ms;                       // read delay (slow client simulation)
+  volatile bool run;
+  volatile bool done;
+  volatile uint32_t received;
+  } test_canlogtcp_client_t;
+
+static void test_canlogtcp_client(void* param)
+  {
+  test_canlogtcp_client_t* tc = (test_canlogtcp_client_t*) param;
+  char buf[1024];
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock >= 0)
+    {
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(TEST_CANLOGTCP_PORT);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = { 0, 100000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(sock, (struct sockaddr*)&sa, sizeof(sa)) == 0)
+      {
+      while (tc->run)
+        {
+        int n = recv(sock, buf, sizeof(buf), 0);
+        if (n > 0)
+          tc->received += n;
+        else if (n == 0)
+          break;
+        if (tc->delay_ms)
+          vTaskDelay(pdMS_TO_TICKS(tc->delay_ms));
+        }
+      }
+    close(sock);
+    }
+  tc->done = true;
+  vTaskDelete(NULL);
+  }
+
+/**
+ * test_canlogtcp: load test of the CAN log TCP server fan-out with
+ *  local (loopback) clients; client #1 can be slowed down by a read
+ *  delay to check the other clients are not affected.
+ */
+void test_canlogtcp(int verbosity, OvmsWriter* writer, OvmsCommand* cmd, int argc, const char* const* argv)
+  {
+  int clients = (argc > 0) ? atoi(argv[0]) : 4;
+  int rate = (argc > 1) ? atoi(argv[1]) : 5000;
+  int seconds = (argc > 2) ? atoi(argv[2]) : 10;
+  int slow_ms = (argc > 3) ? atoi(argv[3]) : 0;
+  if (clients < 1) clients = 1;
+  if (clients > 8) clients = 8;
+  if (rate < 100) rate = 100;
+  if (seconds < 1) seconds = 1;
+
+  canbus* bus = MyCan.GetBus(0);
+  if (bus == NULL)
+    {
+    writer->puts("Error: can1 not available");
+    return;
+    }
+  if (MyCanLogTcpServer != NULL)
+    {
+    writer->puts("Error: a TCP server logger is already running");
+    return;
+    }
+
+  char port[8];
+  snprintf(port, sizeof(port), "%d", TEST_CANLOGTCP_PORT);
+  canlog_tcpserver* logger = new canlog_tcpserver(port, "crtd", canformat::Discard);
+  if (!logger->Open() || !logger->IsOpen())
+    {
+    writer->puts("Error: cannot open TCP server (network up?)");
+    delete logger;
+    return;
+    }
+
+  test_canlogtcp_client_t tc[8];
+  for (int i = 0; i < clients; i++)
+    {
+    tc[i].delay_ms = (i == 0) ? slow_ms : 0;
+    tc[i].run = true;
+    tc[i].done = false;
+    tc[i].received = 0;
+    xTaskCreatePinnedToCore(test_canlogtcp_client, "OVMS TestTCP", 3072, &tc[i], 5, NULL, CORE(0));
+    }
+  for (int i = 0; i < 50 && logger->m_smap.size() < (size_t)clients; i++)
+    vTaskDelay(pdMS_TO_TICKS(20));
+  writer->printf("%d clients connected, logging %d frames/s for %d seconds...\n",
+    (int)logger->m_smap.size(), rate, seconds);
+
+  CAN_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.origin = bus;
+  frame.FIR.B.FF = CAN_frame_std;
+  frame.FIR.B.DLC = 8;
+  int pertick = rate / 100;
+  uint32_t frames = 0;
+  TickType_t wake = xTaskGetTickCount();
+  int64_t started = esp_timer_get_time();
+  for (int t = 0; t < seconds * 100; t++)
+    {
+    for (int k = 0; k < pertick; k++, frames++)
+      {
+      frame.MsgID = 0x100 + (frames % 64);
+      frame.data.u64 = 0x0123456789abcdefULL * frames;
+      logger->LogFrame(bus, CAN_LogFrame_RX, &frame);
+      }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(10));
+    }
+  int64_t elapsed = esp_timer_get_time() - started;
+
+  vTaskDelay(pdMS_TO_TICKS(1000)); // let clients catch up
+  writer->printf("Generated %u frames in %lld ms = %.0f frames/s\n",
+    frames, elapsed / 1000, (float)frames * 1000000 / elapsed);
+  writer->printf("Statistics: %s\n", logger->GetStats().c_str());
+  for (int i = 0; i < clients; i++)
+    {
+    writer->printf("Client #%d%s: received %u bytes = %.1f kB/s\n", i + 1,
+      (tc[i].delay_ms) ? " (slow)" : "", tc[i].received,
+      (float)tc[i].received * 1000 / elapsed);
+    tc[i].run = false;
+    }
+  delete logger;
+  for (int i = 0; i < clients; i++)
+    {
+    for (int k = 0; k < 50 && !tc[i].done; k++)
+      vTaskDelay(pdMS_TO_TICKS(20));
+    }
+  }
+
+#endif // #ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
+
 class TestFrameworkInit
   {
   public: TestFrameworkInit();
@@ -385,4 +2856,24 @@ TestFrameworkInit::TestFrameworkInit()
   cmd_test->RegisterCommand("mkstemp", "Test mkstemp function", test_mkstemp, "<file>", 1, 1);
   cmd_test->RegisterCommand("string", "Test std::string memory corruption", test_string, "<loopcnt> <mode>\n"
     "mode: 1=m.AsJSON, 2=m.AsString, 3=m.name, 4=const cfg string, 5=const local cstr, 6=const local string", 2, 2);
+  cmd_test->RegisterCommand("canformat", "Test CAN log formatting performance", test_canformat, "<format> [<crtd-trace>] [<loops>]", 1, 3);
+  cmd_test->RegisterCommand("canplay", "Test CAN replay from VFS", test_canplay, "[<path>] [<#frames>]", 0, 2);
+  cmd_test->RegisterCommand("metricsjson", "Test metrics JSON serialization performance", test_metricsjson, "[<#metrics>] [<#clients>]", 0, 2);
+  cmd_test->RegisterCommand("metricsjournal", "Test metrics change journal performance", test_metricsjournal, "[<#metrics>] [<#changes>] [<loops>]", 0, 3);
+  cmd_test->RegisterCommand("dbc", "Test DBC decoding performance", test_dbc, "[<#messages>] [<crtd-trace>] [<loops>]", 0, 3);
+#ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
+  cmd_test->RegisterCommand("canlogtcp", "Test CAN log TCP server fan-out with local clients", test_canlogtcp, "[<#clients>] [<frames/s>] [<seconds>] [<slow_ms>]", 0, 4);
+#endif // #ifdef CONFIG_OVMS_SC_GPL_MONGOOSE
+  cmd_test->RegisterCommand("buffer", "Test OvmsBuffer line framing throughput", test_buffer, "[<kbytes>] [<chunksize>]", 0, 2);
+  cmd_test->RegisterCommand("config", "Test config write coalescing & read performance", test_config, "[<#changes>]", 0, 1);
+  cmd_test->RegisterCommand("bms", "Test BMS cell statistics performance", test_bms, "[<#cells>] [<#sweeps>]", 0, 2);
+  cmd_test->RegisterCommand("isotp", "Test vehicle poller ISO-TP response reassembly", test_isotp, "[<loops>]", 0, 1);
+  cmd_test->RegisterCommand("pollsweep", "Test vehicle poller sweep time on simulated ECUs", test_pollsweep, "[<#entries>] [<#ecus>] [<latency_ms>]", 0, 3);
+  cmd_test->RegisterCommand("canpipe", "Test CAN RX pipeline throughput & latency", test_canpipe,
+    "<vehicle> [<crtd-trace>|synth] [<frames/s>] [<seconds>]\n"
+    "<vehicle>: vehicle type code, 'sim' = built-in decoder, '-' = current vehicle", 1, 4);
+  cmd_test->RegisterCommand("canlogvfs", "Test CAN logging to VFS with rotation", test_canlogvfs, "[<path>] [<#lines>]", 0, 2);
+  cmd_test->RegisterCommand("canlogring", "Test CAN logging cost with 1, 2 and 4 loggers", test_canlogring, "[<frames>]", 0, 1);
+  cmd_test->RegisterCommand("canidset", "Test CAN ID dispatch index & listener registry", test_canidset, "[<loops>]", 0, 1);
+  cmd_test->RegisterCommand("metrics", "Test metrics registry lookup performance", test_metrics, "[<#metrics> ...]", 0, 5);
   }